@@ -0,0 +1,39 @@
+#version 450
+// Pixel distance to the conic from its implicit form and screen-space gradient.
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uParams;   // x world size of a pixel per unit clip w, y line width (px)
+    uint uPickBase;
+} pc;
+
+layout(location = 0) in vec2 vLocal;
+layout(location = 1) flat in vec3 vShape;   // a, b, y limit (0 = ellipse)
+layout(location = 2) in vec4 vColor;
+layout(location = 3) flat in uint vId;
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+void main() {
+    bool hyperbola = vShape.z > 0.0;
+    vec2 inv2 = 1.0 / (vShape.xy * vShape.xy);
+    float s = hyperbola ? -1.0 : 1.0;
+
+    // f = x^2/a^2 + s*y^2/b^2 - 1, gradient taken analytically in the plane and mapped to
+    // the screen through the derivatives of the plane coordinates.
+    float f = vLocal.x * vLocal.x * inv2.x + s * vLocal.y * vLocal.y * inv2.y - 1.0;
+    vec2 g = 2.0 * vec2(vLocal.x * inv2.x, s * vLocal.y * inv2.y);
+    vec2 gs = vec2(dot(g, dFdx(vLocal)), dot(g, dFdy(vLocal)));
+    float distPx = abs(f) / max(length(gs), 1e-20);
+
+    float cov = 1.0 - clamp(distPx - 0.5 * pc.uParams.y + 0.5, 0.0, 1.0);
+    if (hyperbola) {
+        // Only the branch around the focus, ending (antialiased) at the |y| limit
+        if (vLocal.x < 0.0) discard;
+        cov *= clamp((vShape.z - abs(vLocal.y)) / max(fwidth(vLocal.y), 1e-20) + 0.5, 0.0, 1.0);
+    }
+    float alpha = cov * vColor.a;
+    if (alpha <= 0.0) discard;
+    outCol = vec4(vColor.rgb, alpha);
+    outId = vId;
+}
@@ -0,0 +1,41 @@
+#version 450
+// MSDF glyph: median of the RGB distances for the fill, the true distance in alpha for
+// the outline, both antialiased over one screen pixel.
+
+layout(set = 0, binding = 0) uniform sampler2D uAtlas;
+
+layout(push_constant) uniform Push {
+    mat4  uViewProj;
+    vec2  uViewport;
+    float uOutlineWidth;
+    uint  uOutlineColor;
+} pc;
+
+layout(location = 0) in vec2 vUv;
+layout(location = 1) in vec4 vColor;
+layout(location = 2) flat in float vPxRange;
+layout(location = 3) flat in uint vId;
+
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+float median(vec3 v) {
+    return max(min(v.r, v.g), min(max(v.r, v.g), v.b));
+}
+
+void main() {
+    vec4 msd = texture(uAtlas, vUv);
+    // Screen pixels from the edge, positive inside; at least one pixel of AA ramp.
+    float range = max(vPxRange, 1.0);
+    float fill = clamp(range * (median(msd.rgb) - 0.5) + 0.5, 0.0, 1.0);
+    vec4 col = vec4(vColor.rgb, vColor.a * fill);
+    if (pc.uOutlineWidth > 0.0) {
+        float outline = clamp(range * (msd.a - 0.5) + pc.uOutlineWidth + 0.5, 0.0, 1.0);
+        vec4 oc = unpackUnorm4x8(pc.uOutlineColor);
+        float a = max(fill * vColor.a, outline * oc.a);
+        col = vec4(mix(oc.rgb, vColor.rgb, fill), a);
+    }
+    if (col.a < 0.02) discard;   // keep the quad's empty corners out of the pick attachment
+    outCol = col;
+    outId = vId;
+}
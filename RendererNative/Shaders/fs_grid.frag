@@ -0,0 +1,44 @@
+#version 450
+// Analytic grid lines with derivative-based antialiasing and distance fade.
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uAnchor;   // xyz quad centre (camera-relative), w minor spacing
+    vec4 uAxisU;    // xyz u * extent, w major_every
+    vec4 uAxisV;    // xyz v * extent, w line width (px)
+    vec4 uColor;
+} pc;
+
+layout(location = 0) in vec2 vPlane;
+layout(location = 1) in vec2 vCorner;
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+// Coverage of the nearest line of a lattice with the given spacing, `width` pixels wide.
+// Also returns the lattice's cell size in pixels via `cellPx` for LOD fading.
+float line_coverage(vec2 p, float spacing, float width, out float cellPx) {
+    vec2 g = p / spacing;
+    vec2 dg = max(fwidth(g), vec2(1e-6));
+    vec2 distPx = abs(fract(g - 0.5) - 0.5) / dg;
+    cellPx = 1.0 / max(dg.x, dg.y);
+    return 1.0 - clamp(min(distPx.x, distPx.y) - 0.5 * width + 0.5, 0.0, 1.0);
+}
+
+void main() {
+    float spacing = pc.uAnchor.w;
+    float width = pc.uAxisV.w;
+
+    float minorPx, majorPx;
+    float minor = line_coverage(vPlane, spacing, width, minorPx);
+    float major = line_coverage(vPlane, spacing * pc.uAxisU.w, width * 1.5, majorPx);
+
+    // Lattices denser than a few pixels per cell turn into moire; fade them out.
+    minor *= smoothstep(4.0, 8.0, minorPx) * 0.5;
+    major *= smoothstep(2.0, 4.0, majorPx);
+
+    float fade = 1.0 - smoothstep(0.5, 1.0, length(vCorner));
+    float a = max(minor, major) * fade * pc.uColor.a;
+    if (a <= 0.0) discard;
+    outCol = vec4(pc.uColor.rgb, a);
+    outId = 0u;   // backdrop, not pickable
+}
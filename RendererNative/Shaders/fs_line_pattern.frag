@@ -0,0 +1,43 @@
+#version 450
+// Dash / stipple pattern and two-colour gradient evaluated from interpolated arc length.
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uColor0;
+    vec4 uColor1;
+    vec4 uGradDash;   // x gradient start arc, y gradient end arc, z dash, w gap
+    float uPhase;
+    uint  uPickId;    // object ID of the whole polyline
+} pc;
+
+layout(location = 0) in float vArc;
+layout(location = 1) in vec4 vColor;
+layout(location = 2) flat in vec2 vPattern;   // segment start arc modulo the period, segment length
+layout(location = 3) in float vSide;
+layout(location = 4) flat in float vFlip;
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+void main() {
+    float g0 = pc.uGradDash.x, g1 = pc.uGradDash.y;
+    float t = g1 > g0 ? clamp((vArc - g0) / (g1 - g0), 0.0, 1.0) : 0.0;
+    vec4 col = mix(pc.uColor0, pc.uColor1, t) * vColor;
+
+    float dash = pc.uGradDash.z, gap = pc.uGradDash.w;
+    if (dash > 0.0 && gap > 0.0) {
+        float period = dash + gap;
+        // Rebuilt per segment from small values: exact however far along the path
+        float along = abs(vSide - vFlip) * vPattern.y;
+        float m = mod(vPattern.x + along + pc.uPhase, period);
+        float aa = max(fwidth(along), 1e-20);
+        // Signed distance (arc units) to the nearest dash edge, positive inside a dash
+        float dist = m < dash ? min(m, dash - m) : -min(m - dash, period - m);
+        float cov = clamp(dist / aa + 0.5, 0.0, 1.0);
+        // Pattern finer than a pixel: converge to its average instead of shimmering
+        cov = mix(cov, dash / period, clamp(aa / period - 0.5, 0.0, 1.0));
+        col.a *= cov;
+    }
+    if (col.a <= 0.0) discard;
+    outCol = col;
+    outId = pc.uPickId;
+}
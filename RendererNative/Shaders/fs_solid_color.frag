@@ -1,7 +1,9 @@
 #version 450
 layout(push_constant) uniform PC { vec4 color; } pc;
 layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
 void main()
 {
     outCol = pc.color;
+    outId = 0u;
 }
\ No newline at end of file
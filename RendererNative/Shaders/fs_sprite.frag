@@ -0,0 +1,21 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+// Sprite texel from the bindless texture table, tinted. The slot varies per instance within
+// the draw, hence nonuniformEXT.
+
+layout(set = 0, binding = 0) uniform sampler2D uTextures[];
+
+layout(location = 0) in vec2 vUv;
+layout(location = 1) in vec4 vColor;
+layout(location = 2) flat in uint vTexture;
+layout(location = 3) flat in uint vId;
+
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+void main() {
+    vec4 col = texture(uTextures[nonuniformEXT(vTexture)], vUv) * vColor;
+    if (col.a < 0.02) discard;   // transparent texels stay out of the pick attachment
+    outCol = col;
+    outId = vId;
+}
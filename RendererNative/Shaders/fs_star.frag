@@ -0,0 +1,13 @@
+#version 450
+// Gaussian star disc over the point sprite, blended additively.
+
+layout(location = 0) in vec4 vColor;
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+
+void main() {
+    vec2 c = gl_PointCoord * 2.0 - 1.0;
+    float a = exp(-4.0 * dot(c, c)) * vColor.a;
+    outCol = vec4(vColor.rgb, a);
+    outId = 0u;   // the sky is not pickable
+}
@@ -0,0 +1,25 @@
+#version 450
+// Composites the bloom level over the HDR scene and maps the result to display range
+// (ACES filmic fit). The scene is fetched per pixel; the half-resolution bloom is filtered.
+
+layout(set = 0, binding = 0) uniform sampler2D uScene;
+layout(set = 0, binding = 1) uniform sampler2D uBloom;
+
+layout(push_constant) uniform Push {
+    float exposure;
+    float intensity;   // 0 when no blur level ran this frame
+} pc;
+
+layout(location = 0) in vec2 vUV;
+layout(location = 0) out vec4 outCol;
+
+vec3 aces(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main() {
+    vec3 c = texelFetch(uScene, ivec2(gl_FragCoord.xy), 0).rgb;
+    if (pc.intensity > 0.0) c += texture(uBloom, vUV).rgb * pc.intensity;
+    outCol = vec4(aces(c * pc.exposure), 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+layout(location = 0) in vec4 vColor;
+layout(location = 1) flat in uint vId;
+layout(location = 0) out vec4 outCol;
+layout(location = 1) out uint outId;   // object ID (pick attachment, if bound)
+void main()
+{
+    outCol = vColor;
+    outId = vId;
+}
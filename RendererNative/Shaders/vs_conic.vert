@@ -0,0 +1,48 @@
+#version 450
+// Bounding quad of one conic in its orbital plane, padded by the line width in pixels.
+
+layout(location = 0) in vec4 iCenterA;   // xyz centre (camera-relative), w semi-major a
+layout(location = 1) in vec4 iAxisUB;    // xyz +x axis, w semi-minor b
+layout(location = 2) in vec4 iAxisVY;    // xyz +y axis, w hyperbola |y| limit (0 = ellipse)
+layout(location = 3) in vec4 iColor;
+layout(location = 4) in uint iIndex;     // caller's conic index (undrawable ones are compacted out)
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uParams;   // x world size of a pixel per unit clip w, y line width (px)
+    uint uPickBase; // object ID of conic 0
+} pc;
+
+layout(location = 0) out vec2 vLocal;            // plane coordinates relative to the centre
+layout(location = 1) flat out vec3 vShape;       // a, b, y limit
+layout(location = 2) out vec4 vColor;
+layout(location = 3) flat out uint vId;
+
+const vec2 kCorner[4] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+vec3 plane_to_world(vec2 l) {
+    return iCenterA.xyz + l.x * iAxisUB.xyz + l.y * iAxisVY.xyz;
+}
+
+void main() {
+    float a = iCenterA.w, b = iAxisUB.w, yMax = iAxisVY.w;
+    vec2 lo = vec2(-a, -b), hi = vec2(a, b);
+    if (yMax > 0.0) {
+        // x > 0 branch from the vertex (a, 0) out to the arc ends at |y| = yMax
+        lo = vec2(a, -yMax);
+        hi = vec2(a * sqrt(1.0 + (yMax * yMax) / (b * b)), yMax);
+    }
+    vec2 c = kCorner[gl_VertexIndex];
+    vec2 mid = 0.5 * (lo + hi), halfSize = 0.5 * (hi - lo);
+
+    // Pad by the line width plus an AA pixel, sized at this corner's depth.
+    float w = abs((pc.uViewProj * vec4(plane_to_world(mid + c * halfSize), 1.0)).w);
+    float pad = (pc.uParams.y + 2.0) * w * pc.uParams.x;
+    vec2 l = mid + c * (halfSize + vec2(pad));
+
+    gl_Position = pc.uViewProj * vec4(plane_to_world(l), 1.0);
+    vLocal = l;
+    vShape = vec3(a, b, yMax);
+    vColor = iColor;
+    vId = pc.uPickBase + iIndex;
+}
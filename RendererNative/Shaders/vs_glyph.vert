@@ -0,0 +1,42 @@
+#version 450
+// One glyph quad of a label, sized in pixels around the projected anchor.
+
+layout(location = 0) in vec3  iAnchor;   // camera-relative
+layout(location = 1) in uint  iId;       // object ID of the label
+layout(location = 2) in vec4  iRect;     // x0, y0, x1, y1 in pixels from the anchor, y up
+layout(location = 3) in vec4  iUv;       // atlas uv at (x0, y0) and (x1, y1)
+layout(location = 4) in vec4  iColor;
+layout(location = 5) in float iPxRange;  // distance range in screen pixels
+
+layout(push_constant) uniform Push {
+    mat4  uViewProj;
+    vec2  uViewport;       // pixels
+    float uOutlineWidth;   // pixels
+    uint  uOutlineColor;   // RGBA8
+} pc;
+
+layout(location = 0) out vec2 vUv;
+layout(location = 1) out vec4 vColor;
+layout(location = 2) flat out float vPxRange;
+layout(location = 3) flat out uint vId;
+
+const vec2 kCorner[4] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    vec4 a = pc.uViewProj * vec4(iAnchor, 1.0);
+    vId = iId;
+    vColor = iColor;
+    vPxRange = iPxRange;
+    vec2 c = kCorner[gl_VertexIndex];
+    vUv = mix(iUv.xy, iUv.zw, c);
+    if (a.w <= 0.0) {   // anchor behind the camera: the whole label is dropped
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        return;
+    }
+
+    // Snap the anchor to the pixel grid so moving labels do not shimmer.
+    vec2 px = floor((a.xy / a.w * 0.5 + 0.5) * pc.uViewport + 0.5);
+    vec2 off = mix(iRect.xy, iRect.zw, c);
+    px += vec2(off.x, -off.y);
+    gl_Position = vec4(px / pc.uViewport * 2.0 - 1.0, a.z / a.w, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 450
+// Plane quad for the procedural grid; corners come from gl_VertexIndex (4-vertex strip).
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uAnchor;   // xyz quad centre (camera-relative), w minor spacing
+    vec4 uAxisU;    // xyz u * extent, w major_every
+    vec4 uAxisV;    // xyz v * extent, w line width (px)
+    vec4 uColor;
+} pc;
+
+layout(location = 0) out vec2 vPlane;    // plane coordinates relative to the anchor
+layout(location = 1) out vec2 vCorner;   // [-1,1]^2 across the quad, for the radial fade
+
+const vec2 kCorner[4] = vec2[](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    vec2 c = kCorner[gl_VertexIndex];
+    vec3 p = pc.uAnchor.xyz + c.x * pc.uAxisU.xyz + c.y * pc.uAxisV.xyz;
+    gl_Position = pc.uViewProj * vec4(p, 1.0);
+    vPlane = c * vec2(length(pc.uAxisU.xyz), length(pc.uAxisV.xyz));
+    vCorner = c;
+}
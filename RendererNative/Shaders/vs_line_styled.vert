@@ -0,0 +1,32 @@
+#version 450
+// World-space polyline vertex with cumulative arc length for fs_line_pattern.
+
+layout(location = 0) in vec4 in_posArc;   // xyz camera-relative, w arc length
+layout(location = 1) in vec4 in_color;    // RGBA8 unorm, multiplies the style colour
+layout(location = 2) in vec2 in_pattern;  // x arc modulo the dash period, y length of the segment this vertex starts
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec4 uColor0;
+    vec4 uColor1;
+    vec4 uGradDash;   // x gradient start arc, y gradient end arc, z dash, w gap
+    float uPhase;
+    uint  uPickId;    // object ID of the whole polyline
+} pc;
+
+layout(location = 0) out float vArc;
+layout(location = 1) out vec4 vColor;
+// The segment's first (provoking) vertex supplies the flat values. The strip's vertices
+// alternate 0/1 in vSide, so with vFlip (its own parity) it runs 0 -> 1 along every segment.
+layout(location = 2) flat out vec2 vPattern;
+layout(location = 3) out float vSide;
+layout(location = 4) flat out float vFlip;
+
+void main() {
+    gl_Position = pc.uViewProj * vec4(in_posArc.xyz, 1.0);
+    vArc = in_posArc.w;
+    vColor = in_color;
+    vPattern = in_pattern;
+    vSide = float(gl_VertexIndex & 1);
+    vFlip = vSide;
+}
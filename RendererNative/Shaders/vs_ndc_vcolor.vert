@@ -0,0 +1,11 @@
+#version 450
+layout(location = 0) in vec2 in_pos;     // input vertex position in NDC
+layout(location = 1) in vec4 in_color;   // RGBA8 unorm, per vertex
+layout(location = 0) out vec4 vColor;
+layout(location = 1) flat out uint vId;
+void main()
+{
+    gl_Position = vec4(in_pos, 0.0, 1.0);
+    vColor = in_color;
+    vId = 0u;   // screen-space overlay, not pickable
+}
@@ -0,0 +1,24 @@
+#version 450
+// Shared unit-circle strip mapped through a per-orbit 3x4 affine transform.
+
+layout(location = 0) in vec2 inCircle;   // (cos t, sin t)
+layout(location = 1) in vec4 iRow0;      // row-major 3x4, translation camera-relative
+layout(location = 2) in vec4 iRow1;
+layout(location = 3) in vec4 iRow2;
+layout(location = 4) in vec4 iColor;
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    uint uPickBase;   // object ID of orbit 0
+} pc;
+
+layout(location = 0) out vec4 vColor;
+layout(location = 1) flat out uint vId;
+
+void main() {
+    vec4 c = vec4(inCircle, 0.0, 1.0);
+    vec3 p = vec3(dot(iRow0, c), dot(iRow1, c), dot(iRow2, c));
+    gl_Position = pc.uViewProj * vec4(p, 1.0);
+    vColor = iColor;
+    vId = pc.uPickBase + uint(gl_InstanceIndex);
+}
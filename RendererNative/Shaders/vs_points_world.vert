@@ -0,0 +1,19 @@
+#version 450
+layout(location = 0) in vec3 in_pos;   // per-instance position (vec4 stride), relative to the camera origin
+
+layout(push_constant) uniform Push {
+    mat4  uViewProj;
+    vec4  uColor;
+    float uPointSize;
+    uint  uPickBase;   // object ID of instance 0
+} pc;
+
+layout(location = 0) out vec4 vColor;
+layout(location = 1) flat out uint vId;
+
+void main() {
+    gl_Position = pc.uViewProj * vec4(in_pos, 1.0);
+    gl_PointSize = pc.uPointSize;
+    vColor = pc.uColor;
+    vId = pc.uPickBase + uint(gl_InstanceIndex);
+}
@@ -0,0 +1,40 @@
+#version 450
+// One sprite: a screen-aligned quad sized in pixels around the projected anchor.
+
+layout(location = 0) in vec3 iAnchor;   // camera-relative
+layout(location = 1) in uint iId;       // object ID of the sprite
+layout(location = 2) in vec2 iSize;     // pixels
+layout(location = 3) in uint iTexture;  // texture table slot
+layout(location = 4) in vec4 iColor;
+layout(location = 5) in vec4 iUv;       // u0, v0 (top left), u1, v1 (bottom right)
+
+layout(push_constant) uniform Push {
+    mat4 uViewProj;
+    vec2 uViewport;   // pixels
+} pc;
+
+layout(location = 0) out vec2 vUv;
+layout(location = 1) out vec4 vColor;
+layout(location = 2) flat out uint vTexture;
+layout(location = 3) flat out uint vId;
+
+const vec2 kCorner[4] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    vec4 a = pc.uViewProj * vec4(iAnchor, 1.0);
+    vId = iId;
+    vColor = iColor;
+    vTexture = iTexture;
+    vec2 c = kCorner[gl_VertexIndex];
+    vUv = vec2(mix(iUv.x, iUv.z, c.x), mix(iUv.w, iUv.y, c.y));
+    if (a.w <= 0.0) {   // behind the camera
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        return;
+    }
+
+    // Snapped like labels, so sprites and their labels move together.
+    vec2 px = floor((a.xy / a.w * 0.5 + 0.5) * pc.uViewport + 0.5);
+    vec2 off = (c - 0.5) * iSize;
+    px += vec2(off.x, -off.y);
+    gl_Position = vec4(px / pc.uViewport * 2.0 - 1.0, a.z / a.w, 1.0);
+}
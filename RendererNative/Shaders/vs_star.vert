@@ -0,0 +1,37 @@
+#version 450
+// Catalog star as a point sprite on the celestial sphere. w = 0: only the camera rotation
+// and projection apply, so the sky never moves with the camera position.
+
+layout(location = 0) in vec4 iStar;    // xyz unit direction, w apparent magnitude
+layout(location = 1) in vec4 iColor;   // from the B-V colour index
+
+layout(push_constant) uniform Push {
+    mat4  uViewProj;
+    float uLimit;       // limiting magnitude
+    float uSize;        // sprite diameter (px) of a star at the limit
+    float uMaxSize;
+    float uIntensity;
+} pc;
+
+layout(location = 0) out vec4 vColor;
+
+void main() {
+    // The draw covers whole magnitude buckets; stars of the last one past the limit drop here.
+    if (iStar.w > pc.uLimit) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        gl_PointSize = 1.0;
+        vColor = vec4(0.0);
+        return;
+    }
+
+    vec4 p = pc.uViewProj * vec4(iStar.xyz, 0.0);
+    p.z = p.w * 0.9999;   // at the far plane; behind the camera w < 0 clips it
+
+    // Flux relative to a star at the limit: 10^(0.4 dm). The sprite grows with its square
+    // root (constant surface brightness); clamped sprites carry the rest in alpha.
+    float flux = exp2((pc.uLimit - iStar.w) * 1.3287712);
+    float size = clamp(pc.uSize * sqrt(flux), 1.0, pc.uMaxSize);
+    gl_Position = p;
+    gl_PointSize = size;
+    vColor = vec4(iColor.rgb, min(1.0, pc.uIntensity * flux * pc.uSize * pc.uSize / (size * size)));
+}
@@ -0,0 +1,489 @@
+// bloom_pass.cpp
+// HDR scene target, compute bloom and tonemap (see bloom_pass.h)
+
+#include "bloom_pass.h"
+#include "native_common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+static const uint32_t CS_BLOOM_DOWN_SPV[] = {
+#   include "shaders/cs_bloom_down.spv.inc"
+};
+static const uint32_t CS_BLOOM_UP_SPV[] = {
+#   include "shaders/cs_bloom_up.spv.inc"
+};
+static const uint32_t VS_FULLSCREEN_SPV[] = {
+#   include "shaders/vs_fullscreen.spv.inc"
+};
+static const uint32_t FS_TONEMAP_SPV[] = {
+#   include "shaders/fs_tonemap.spv.inc"
+};
+static_assert((sizeof(CS_BLOOM_DOWN_SPV) % 4) == 0, "CS_BLOOM_DOWN_SPV must be dword aligned");
+static_assert((sizeof(CS_BLOOM_UP_SPV) % 4) == 0, "CS_BLOOM_UP_SPV must be dword aligned");
+static_assert((sizeof(VS_FULLSCREEN_SPV) % 4) == 0, "VS_FULLSCREEN_SPV must be dword aligned");
+static_assert((sizeof(FS_TONEMAP_SPV) % 4) == 0, "FS_TONEMAP_SPV must be dword aligned");
+
+static const VkFormat kHdrFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+static const uint32_t kGroupSize = 8;              // local_size_x/y of the bloom shaders
+static const uint32_t kCalmFramesToRestore = 120;  // under half the budget before adding a level back
+
+// Push blocks of cs_bloom_down.comp / cs_bloom_up.comp / fs_tonemap.frag
+struct DownPush
+{
+    float    texel[2];
+    float    threshold;
+    float    knee;
+    uint32_t prefilter;
+};
+struct UpPush
+{
+    float texel[2];
+    float weight;
+    float pad;
+};
+struct TonemapPush
+{
+    float exposure;
+    float intensity;
+};
+
+// ===== creation / teardown =====
+static bool create_scene_pass(Device* d, BloomPass* b)
+{
+    VkAttachmentDescription color{};
+    color.format = kHdrFormat;
+    color.samples = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkAttachmentReference cref{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription sub{}; sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 1; sub.pColorAttachments = &cref;
+
+    // The previous frame's tonemap reads must finish before the clear. The barrier to the
+    // blur/tonemap reads after the pass comes from the render graph.
+    VkSubpassDependency dep{};
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL; dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    rpci.attachmentCount = 1; rpci.pAttachments = &color;
+    rpci.subpassCount = 1;    rpci.pSubpasses = &sub;
+    rpci.dependencyCount = 1; rpci.pDependencies = &dep;
+    return vkCreateRenderPass(d->device, &rpci, nullptr, &b->sceneRp) == VK_SUCCESS;
+}
+
+static bool create_objects(Device* d, BloomPass* b)
+{
+    if (!create_scene_pass(d, b)) return false;
+
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_LINEAR; sci.minFilter = VK_FILTER_LINEAR;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.maxLod = 0.0f;
+    if (vkCreateSampler(d->device, &sci, nullptr, &b->sampler) != VK_SUCCESS) return false;
+
+    VkDescriptorSetLayoutBinding bl[2]{};
+    bl[0].binding = 0; bl[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bl[0].descriptorCount = 1; bl[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bl[1].binding = 1; bl[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bl[1].descriptorCount = 1; bl[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo dlci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    dlci.bindingCount = 2; dlci.pBindings = bl;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &b->blurDsl) != VK_SUCCESS) return false;
+
+    bl[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bl[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bl[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &b->tonemapDsl) != VK_SUCCESS) return false;
+
+    const uint32_t blurSets = kBloomLevels + (kBloomLevels - 1);
+    VkDescriptorPoolSize ps[2]{
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, blurSets + 2 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, blurSets } };
+    VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dpci.maxSets = blurSets + 1; dpci.poolSizeCount = 2; dpci.pPoolSizes = ps;
+    if (vkCreateDescriptorPool(d->device, &dpci, nullptr, &b->pool) != VK_SUCCESS) return false;
+
+    std::vector<VkDescriptorSetLayout> layouts(blurSets, b->blurDsl);
+    layouts.push_back(b->tonemapDsl);
+    std::vector<VkDescriptorSet> sets(layouts.size());
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = b->pool; dsai.descriptorSetCount = (uint32_t)layouts.size(); dsai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(d->device, &dsai, sets.data()) != VK_SUCCESS) return false;
+    for (uint32_t k = 0; k < kBloomLevels; ++k) b->downSets[k] = sets[k];
+    for (uint32_t k = 0; k + 1 < kBloomLevels; ++k) b->upSets[k] = sets[kBloomLevels + k];
+    b->tonemapSet = sets.back();
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcr.offset = 0; pcr.size = sizeof(DownPush);
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.setLayoutCount = 1; plci.pSetLayouts = &b->blurDsl;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &b->blurLayout) != VK_SUCCESS) return false;
+    b->downPipe = create_compute_pipeline(d, b->blurLayout, CS_BLOOM_DOWN_SPV, sizeof(CS_BLOOM_DOWN_SPV));
+    b->upPipe = create_compute_pipeline(d, b->blurLayout, CS_BLOOM_UP_SPV, sizeof(CS_BLOOM_UP_SPV));
+    if (!b->downPipe || !b->upPipe) return false;
+
+    pcr.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.size = sizeof(TonemapPush);
+    plci.pSetLayouts = &b->tonemapDsl;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &b->tonemapLayout) != VK_SUCCESS) return false;
+
+    // Fullscreen triangle from gl_VertexIndex, written through the swapchain pass.
+    GfxPipelineDesc pd{};
+    pd.vs = VS_FULLSCREEN_SPV; pd.vsBytes = sizeof(VS_FULLSCREEN_SPV);
+    pd.fs = FS_TONEMAP_SPV; pd.fsBytes = sizeof(FS_TONEMAP_SPV);
+    pd.layout = b->tonemapLayout;
+    pd.renderPass = d->swapRp;
+    if (!create_graphics_pipeline(d, pd, &b->tonemapPipe)) return false;
+
+    // Timestamps are optional: without them the chain runs at full quality and ignores the budget.
+    uint32_t famCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(d->phys, &famCount, nullptr);
+    std::vector<VkQueueFamilyProperties> fams(famCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(d->phys, &famCount, fams.data());
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(d->phys, &props);
+    const uint32_t bits = d->gfxFam < famCount ? fams[d->gfxFam].timestampValidBits : 0;
+    if (bits) {
+        VkQueryPoolCreateInfo qci{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        qci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        qci.queryCount = 2;
+        if (vkCreateQueryPool(d->device, &qci, nullptr, &b->queries) == VK_SUCCESS) {
+            b->tsPeriodNs = props.limits.timestampPeriod;
+            b->tsMask = bits >= 64 ? ~0ull : ((1ull << bits) - 1);
+        }
+    }
+    return true;
+}
+
+static void destroy_targets(Device* d, BloomPass* b)
+{
+    if (b->sceneFb) vkDestroyFramebuffer(d->device, b->sceneFb, nullptr);
+    b->sceneFb = VK_NULL_HANDLE;
+    destroy_image(d, b->hdr);
+}
+
+// Points the blur and tonemap sets at this frame's level transients. Runs in the first
+// bloom pass callback (placement is done by then, the previous frame has finished) and only
+// when the graph rebuilt its transients or the level count changed.
+static void update_sets(Device* d, BloomPass* b)
+{
+    const RenderGraph* g = d->graph;
+    const uint32_t run = b->active;
+    if (b->setsPool == g->poolGeneration && b->setsRun == run) return;
+
+    VkDescriptorImageInfo src[kBloomLevels * 2]{}, dst[kBloomLevels * 2]{}, tone[2]{};
+    VkWriteDescriptorSet w[kBloomLevels * 4 + 2]{};
+    uint32_t n = 0, i = 0;
+
+    auto add = [&](VkDescriptorSet set, uint32_t binding, VkDescriptorType type, const VkDescriptorImageInfo* info) {
+        w[n].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w[n].dstSet = set; w[n].dstBinding = binding;
+        w[n].descriptorCount = 1; w[n].descriptorType = type;
+        w[n].pImageInfo = info;
+        ++n;
+    };
+    auto blur = [&](VkDescriptorSet set, VkImageView from, VkImageLayout fromLayout, uint32_t to) {
+        src[i] = { b->sampler, from, fromLayout };
+        dst[i] = { VK_NULL_HANDLE, rg_view(g, b->levels[to]), VK_IMAGE_LAYOUT_GENERAL };
+        add(set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &src[i]);
+        add(set, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, &dst[i]);
+        ++i;
+    };
+    for (uint32_t k = 0; k < run; ++k) {
+        if (k == 0) blur(b->downSets[0], b->hdr.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0);
+        else blur(b->downSets[k], rg_view(g, b->levels[k - 1]), VK_IMAGE_LAYOUT_GENERAL, k);
+    }
+    for (uint32_t k = 0; k + 1 < run; ++k)
+        blur(b->upSets[k], rg_view(g, b->levels[k + 1]), VK_IMAGE_LAYOUT_GENERAL, k);
+
+    // With every level dropped the bloom input is never written; the tonemap samples the
+    // scene there instead (at zero intensity) rather than undefined texels.
+    tone[0] = { b->sampler, b->hdr.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    tone[1] = run ? VkDescriptorImageInfo{ b->sampler, rg_view(g, b->levels[0]), VK_IMAGE_LAYOUT_GENERAL } : tone[0];
+    add(b->tonemapSet, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &tone[0]);
+    add(b->tonemapSet, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &tone[1]);
+    vkUpdateDescriptorSets(d->device, n, w, 0, nullptr);
+
+    b->setsPool = g->poolGeneration;
+    b->setsRun = run;
+}
+
+// Sized to the swapchain extent; device must be idle.
+static bool create_targets(Device* d, BloomPass* b)
+{
+    const uint32_t w = d->extent.width, h = d->extent.height;
+    if (!create_image(d, w, h, kHdrFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, &b->hdr))
+        return false;
+    for (uint32_t k = 0; k < kBloomLevels; ++k)
+        b->levelExtent[k] = { std::max(1u, w >> (k + 1)), std::max(1u, h >> (k + 1)) };
+
+    VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+    fbci.renderPass = b->sceneRp;
+    fbci.attachmentCount = 1; fbci.pAttachments = &b->hdr.view;
+    fbci.width = w; fbci.height = h; fbci.layers = 1;
+    if (vkCreateFramebuffer(d->device, &fbci, nullptr, &b->sceneFb) != VK_SUCCESS) return false;
+
+    b->setsPool = b->setsRun = UINT32_MAX;   // new hdr view
+    return true;
+}
+
+void bloom_release(Device* d)
+{
+    BloomPass* b = d->bloom;
+    if (!b) return;
+    destroy_targets(d, b);
+    if (b->queries)       vkDestroyQueryPool(d->device, b->queries, nullptr);
+    destroy_graphics_pipeline(d, &b->tonemapPipe);
+    if (b->tonemapLayout) vkDestroyPipelineLayout(d->device, b->tonemapLayout, nullptr);
+    if (b->downPipe)      vkDestroyPipeline(d->device, b->downPipe, nullptr);
+    if (b->upPipe)        vkDestroyPipeline(d->device, b->upPipe, nullptr);
+    if (b->blurLayout)    vkDestroyPipelineLayout(d->device, b->blurLayout, nullptr);
+    if (b->pool)          vkDestroyDescriptorPool(d->device, b->pool, nullptr);
+    if (b->tonemapDsl)    vkDestroyDescriptorSetLayout(d->device, b->tonemapDsl, nullptr);
+    if (b->blurDsl)       vkDestroyDescriptorSetLayout(d->device, b->blurDsl, nullptr);
+    if (b->sampler)       vkDestroySampler(d->device, b->sampler, nullptr);
+    if (b->sceneRp)       vkDestroyRenderPass(d->device, b->sceneRp, nullptr);
+    delete b;
+    d->bloom = nullptr;
+    d->rp = d->swapRp;   // the caller rebuilds the scene pipelines if the device lives on
+}
+
+// Swapchain was recreated (device idle). On failure bloom is switched off rather than
+// leaving the scene pass without a target.
+bool bloom_resize(Device* d)
+{
+    BloomPass* b = d->bloom;
+    if (!b) return true;
+    if (b->hdr.extent.width == d->extent.width && b->hdr.extent.height == d->extent.height) return true;
+
+    destroy_targets(d, b);
+    if (create_targets(d, b)) return true;
+
+    bloom_release(d);
+    rebuild_graphics_pipelines(d);
+    native_log(2, "Vulkan: bloom targets could not be resized; bloom disabled.");
+    return false;
+}
+
+// ===== frame hook =====
+// Called after the fence wait, so last frame's timestamps are final if they were written.
+static void collect_timing(Device* d, BloomPass* b)
+{
+    if (!b->queries || !b->queryPending) return;
+    uint64_t ts[2]{};
+    if (vkGetQueryPoolResults(d->device, b->queries, 0, 2, sizeof(ts), ts, sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) return;
+    b->queryPending = false;
+
+    const float ms = (float)((double)((ts[1] - ts[0]) & b->tsMask) * b->tsPeriodNs * 1e-6);
+    b->gpuMs = b->gpuMs < 0 ? ms : b->gpuMs * 0.9f + ms * 0.1f;
+
+    if (!(b->budgetMs > 0)) { b->active = kBloomLevels; b->calmFrames = 0; return; }
+    if (b->gpuMs > b->budgetMs && b->active > 0) {
+        --b->active;
+        b->gpuMs = -1.0f;
+        b->calmFrames = 0;
+    }
+    else if (b->gpuMs < 0.5f * b->budgetMs && b->active < kBloomLevels) {
+        if (++b->calmFrames >= kCalmFramesToRestore) {
+            ++b->active;
+            b->gpuMs = -1.0f;
+            b->calmFrames = 0;
+        }
+    }
+    else b->calmFrames = 0;
+}
+
+// Opens the GPU timing bracket; called from whichever bloom pass records first.
+static void begin_chain(Device* d, BloomPass* b, VkCommandBuffer cb)
+{
+    update_sets(d, b);
+    if (b->queries) {
+        vkCmdResetQueryPool(cb, b->queries, 0, 2);
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, b->queries, 0);
+    }
+}
+
+// user = target level
+static void record_down(Device* d, VkCommandBuffer cb, void* user)
+{
+    BloomPass* b = d->bloom;
+    const uint32_t k = (uint32_t)(uintptr_t)user;
+    if (k == 0) begin_chain(d, b, cb);
+
+    const VkExtent2D se = k == 0 ? b->hdr.extent : b->levelExtent[k - 1];
+    const VkExtent2D de = b->levelExtent[k];
+    DownPush p{ { 1.0f / se.width, 1.0f / se.height }, b->threshold, b->knee, k == 0 ? 1u : 0u };
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, b->downPipe);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, b->blurLayout, 0, 1, &b->downSets[k], 0, nullptr);
+    vkCmdPushConstants(cb, b->blurLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(p), &p);
+    vkCmdDispatch(cb, (de.width + kGroupSize - 1) / kGroupSize, (de.height + kGroupSize - 1) / kGroupSize, 1);
+}
+
+// user = target level, added to in place
+static void record_up(Device* d, VkCommandBuffer cb, void* user)
+{
+    BloomPass* b = d->bloom;
+    const uint32_t k = (uint32_t)(uintptr_t)user;
+    const VkExtent2D se = b->levelExtent[k + 1];
+    const VkExtent2D de = b->levelExtent[k];
+    UpPush p{ { 1.0f / se.width, 1.0f / se.height }, 1.0f, 0.0f };
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, b->upPipe);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, b->blurLayout, 0, 1, &b->upSets[k], 0, nullptr);
+    vkCmdPushConstants(cb, b->blurLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(p), &p);
+    vkCmdDispatch(cb, (de.width + kGroupSize - 1) / kGroupSize, (de.height + kGroupSize - 1) / kGroupSize, 1);
+}
+
+static void record_tonemap(Device* d, VkCommandBuffer cb, void*)
+{
+    BloomPass* b = d->bloom;
+    const uint32_t run = b->active;
+    if (!run) begin_chain(d, b, cb);
+
+    VkRenderPassBeginInfo rbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    VkClearValue clear{};
+    rbi.renderPass = d->swapRp; rbi.framebuffer = d->fbs[d->curImg];
+    rbi.renderArea = { {0,0}, d->extent };
+    rbi.clearValueCount = 1; rbi.pClearValues = &clear;
+    vkCmdBeginRenderPass(cb, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport vp{ 0.f, 0.f, (float)d->extent.width, (float)d->extent.height, 0.f, 1.f };
+    VkRect2D   sc{ {0,0}, d->extent };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    TonemapPush tp{ b->exposure, run ? b->intensity : 0.0f };
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, b->tonemapPipe);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, b->tonemapLayout, 0, 1, &b->tonemapSet, 0, nullptr);
+    vkCmdPushConstants(cb, b->tonemapLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(tp), &tp);
+    vkCmdDraw(cb, 3, 1, 0, 0);
+    vkCmdEndRenderPass(cb);
+
+    if (b->queries) {
+        vkCmdWriteTimestamp(cb, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, b->queries, 1);
+        b->queryPending = true;
+    }
+}
+
+RgRes bloom_import_scene(Device* d, RenderGraph* g)
+{
+    const GpuImage& hdr = d->bloom->hdr;
+    return rg_import_image(g, hdr.img, hdr.view, hdr.fmt, hdr.extent,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, false);
+}
+
+// Levels dropped by the budget are simply not declared, so they take no memory either.
+void bloom_add_pass(Device* d, RenderGraph* g, RgRes scene, RgRes target)
+{
+    BloomPass* b = d->bloom;
+    if (!b) return;
+    collect_timing(d, b);
+
+    const uint32_t run = b->active;
+    for (uint32_t k = 0; k < kBloomLevels; ++k)
+        b->levels[k] = k < run ? rg_create_image(g, b->levelExtent[k].width, b->levelExtent[k].height, kHdrFormat,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT) : kRgNone;
+
+    const VkPipelineStageFlags2 cs = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    for (uint32_t k = 0; k < run; ++k) {
+        rg_add_pass(g, "bloom down", &record_down, (void*)(uintptr_t)k);
+        if (k == 0) rg_use(g, scene, cs, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        else rg_use(g, b->levels[k - 1], cs, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+        rg_use(g, b->levels[k], cs, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL);
+    }
+    for (uint32_t k = run ? run - 1 : 0; k-- > 0;) {
+        rg_add_pass(g, "bloom up", &record_up, (void*)(uintptr_t)k);
+        rg_use(g, b->levels[k + 1], cs, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL);
+        rg_use(g, b->levels[k], cs, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    rg_add_pass(g, "tonemap", &record_tonemap, nullptr);
+    rg_use(g, scene, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    if (run) rg_use(g, b->levels[0], VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        VK_IMAGE_LAYOUT_GENERAL);
+    rg_use(g, target, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+// ===== ABI =====
+// desc == NULL switches the post chain off and renders straight to the swapchain again.
+int FM_CALL bloom_set(fw_handle dev, const fw_bloom_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("bloom_set: null device"); return FM_E_BADARGS; }
+    if (d->inFrame && (desc != nullptr) != (d->bloom != nullptr)) {   // turning it on/off waits for the device
+        native_set_error("bloom_set: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (!desc) {
+        if (!d->bloom) return FM_OK;
+        vkDeviceWaitIdle(d->device);
+        bloom_release(d);
+        if (!rebuild_graphics_pipelines(d)) {
+            native_set_error("bloom_set: pipeline rebuild failed"); return FM_E_DEVICE;
+        }
+        return FM_OK;
+    }
+    if (!(desc->threshold >= 0) || !(desc->knee >= 0) || !(desc->intensity >= 0) ||
+        !(desc->exposure > 0) || !(desc->budget_ms >= 0)) {
+        native_set_error("bloom_set: invalid parameters"); return FM_E_BADARGS;
+    }
+    if (!d->swapRp || d->fbs.empty()) { native_set_error("bloom_set: no swapchain"); return FM_E_UNSUPPORTED; }
+    if (!d->windows.empty() || d->pick) {
+        // Extra windows render through the swapchain pass the scene pipelines would leave;
+        // the pick IDs live in that pass.
+        native_set_error("bloom_set: not available with extra windows or picking"); return FM_E_UNSUPPORTED;
+    }
+
+    if (!d->bloom) {
+        vkDeviceWaitIdle(d->device);
+        auto* b = new BloomPass();
+        d->bloom = b;
+        if (!create_objects(d, b) || !create_targets(d, b)) {
+            bloom_release(d);
+            native_set_error("bloom_set: target/pipeline creation failed");
+            return FM_E_DEVICE;
+        }
+        d->rp = b->sceneRp;
+        if (!rebuild_graphics_pipelines(d)) {
+            bloom_release(d);
+            rebuild_graphics_pipelines(d);
+            native_set_error("bloom_set: scene pipelines could not be rebuilt for the HDR target");
+            return FM_E_DEVICE;
+        }
+    }
+
+    BloomPass* b = d->bloom;
+    b->threshold = desc->threshold;
+    b->knee = desc->knee;
+    b->intensity = desc->intensity;
+    b->exposure = desc->exposure;
+    if (desc->budget_ms != b->budgetMs) {
+        b->budgetMs = desc->budget_ms;
+        b->active = kBloomLevels;
+        b->calmFrames = 0;
+        b->gpuMs = -1.0f;
+    }
+    return FM_OK;
+}
+
+int FM_CALL bloom_get_stats(fw_handle dev, fw_bloom_stats* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("bloom_get_stats: null argument"); return FM_E_BADARGS; }
+    out->gpu_ms = d->bloom ? d->bloom->gpuMs : -1.0f;
+    out->levels = d->bloom ? d->bloom->active : 0;
+    return FM_OK;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "renderer_device.h"
+#include "render_graph.h"
+
+/*
+    HDR scene target with a compute bloom chain and a tonemap into the swapchain.
+    - While enabled the scene pass (d->rp) renders into an RGBA16F image instead of the
+      swapchain; registered scene pipelines are rebuilt against it on enable/disable, so the
+      direct path costs nothing while bloom is off.
+    - Bloom runs at half and quarter resolution: thresholded 13-tap downsample, downsample,
+      tent upsample back into the half level. The tonemap pass adds it to the scene and
+      writes the swapchain image through d->swapRp.
+    - Each blur step is its own render-graph pass and the levels are graph transients: the
+      graph places them, orders the steps with barriers and skips levels that are dropped.
+      The descriptor sets are rewritten whenever placement hands out new views.
+    - The chain is bracketed by GPU timestamps read back one frame late (after the fence
+      wait). With a budget set, blur levels are dropped while the smoothed cost exceeds it
+      and restored once it has stayed well under for a while.
+*/
+
+static const uint32_t kBloomLevels = 2;   // half, quarter
+
+struct BloomPass
+{
+    VkRenderPass  sceneRp = VK_NULL_HANDLE;    // RGBA16F, ends in SHADER_READ_ONLY_OPTIMAL
+    GpuImage      hdr;                         // full resolution scene colour
+    VkFramebuffer sceneFb = VK_NULL_HANDLE;
+    VkExtent2D    levelExtent[kBloomLevels]{};
+    RgRes         levels[kBloomLevels]{ kRgNone, kRgNone };   // this frame's transients
+    uint32_t      setsPool = UINT32_MAX;       // graph pool generation the sets were written for
+    uint32_t      setsRun = UINT32_MAX;        // ... and the level count; UINT32_MAX = rewrite
+
+    VkSampler             sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout blurDsl = VK_NULL_HANDLE;      // 0 sampled source, 1 storage target
+    VkDescriptorSetLayout tonemapDsl = VK_NULL_HANDLE;   // 0 scene, 1 bloom
+    VkDescriptorPool      pool = VK_NULL_HANDLE;
+    VkDescriptorSet       downSets[kBloomLevels]{};      // [k] level k-1 (or hdr) -> level k
+    VkDescriptorSet       upSets[kBloomLevels - 1]{};    // [k] level k+1 -> level k, in place
+    VkDescriptorSet       tonemapSet = VK_NULL_HANDLE;
+
+    VkPipelineLayout blurLayout = VK_NULL_HANDLE;
+    VkPipeline       downPipe = VK_NULL_HANDLE;
+    VkPipeline       upPipe = VK_NULL_HANDLE;
+    VkPipelineLayout tonemapLayout = VK_NULL_HANDLE;
+    VkPipeline       tonemapPipe = VK_NULL_HANDLE;     // registered, bound to d->swapRp
+
+    float    threshold = 1.0f;
+    float    knee = 0.5f;
+    float    intensity = 0.6f;
+    float    exposure = 1.0f;
+    float    budgetMs = 0.0f;       // 0 = no limit
+    uint32_t active = kBloomLevels; // blur levels run this frame
+    uint32_t calmFrames = 0;        // consecutive frames well under budget
+
+    // GPU timing: [0] after the scene pass, [1] after the tonemap pass
+    VkQueryPool queries = VK_NULL_HANDLE;
+    float       tsPeriodNs = 0.0f;
+    uint64_t    tsMask = 0;
+    bool        queryPending = false;
+    float       gpuMs = -1.0f;      // smoothed; -1 until sampled at the current level count
+};
+
+// Frame hooks (renderer_api.cpp), after the fence wait. The scene pass writes the imported
+// HDR target; the blur passes and the tonemap sample it, and the tonemap writes `target`
+// (the swapchain image) through d->swapRp.
+RgRes bloom_import_scene(Device* d, RenderGraph* g);
+void bloom_add_pass(Device* d, RenderGraph* g, RgRes scene, RgRes target);
+bool bloom_resize(Device* d);
+void bloom_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL bloom_set(fw_handle dev, const fw_bloom_desc* desc);
+int  FM_CALL bloom_get_stats(fw_handle dev, fw_bloom_stats* out);
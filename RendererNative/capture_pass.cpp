@@ -0,0 +1,300 @@
+// capture_pass.cpp
+// Frame readback ring (see capture_pass.h)
+
+#include "capture_pass.h"
+#include "native_common.h"
+
+static const uint32_t CS_CAPTURE_YUV_SPV[] = {
+#   include "shaders/cs_capture_yuv.spv.inc"
+};
+static_assert((sizeof(CS_CAPTURE_YUV_SPV) % 4) == 0, "CS_CAPTURE_YUV_SPV must be dword aligned");
+
+static const uint32_t kGroupSize = 8;   // local_size_x/y of cs_capture_yuv.comp
+
+// Push block of cs_capture_yuv.comp
+struct YuvPush
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t srgbView;
+};
+
+// ===== creation / teardown =====
+static bool create_yuv_objects(Device* d, CapturePass* c)
+{
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_NEAREST; sci.minFilter = VK_FILTER_NEAREST;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vkCreateSampler(d->device, &sci, nullptr, &c->sampler) != VK_SUCCESS) return false;
+
+    VkDescriptorSetLayoutBinding bl[2]{};
+    bl[0].binding = 0; bl[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bl[0].descriptorCount = 1; bl[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bl[1].binding = 1; bl[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bl[1].descriptorCount = 1; bl[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo dlci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    dlci.bindingCount = 2; dlci.pBindings = bl;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &c->dsl) != VK_SUCCESS) return false;
+
+    VkDescriptorPoolSize ps[2]{
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, c->slotCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, c->slotCount },
+    };
+    VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dpci.maxSets = c->slotCount; dpci.poolSizeCount = 2; dpci.pPoolSizes = ps;
+    if (vkCreateDescriptorPool(d->device, &dpci, nullptr, &c->pool) != VK_SUCCESS) return false;
+
+    VkDescriptorSetLayout layouts[kCaptureMaxSlots];
+    VkDescriptorSet sets[kCaptureMaxSlots]{};
+    for (uint32_t i = 0; i < c->slotCount; ++i) layouts[i] = c->dsl;
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = c->pool; dsai.descriptorSetCount = c->slotCount; dsai.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(d->device, &dsai, sets) != VK_SUCCESS) return false;
+    for (uint32_t i = 0; i < c->slotCount; ++i) c->slots[i].set = sets[i];
+
+    VkPushConstantRange pcr{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(YuvPush) };
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.setLayoutCount = 1; plci.pSetLayouts = &c->dsl;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &c->layout) != VK_SUCCESS) return false;
+
+    c->pipe = create_compute_pipeline(d, c->layout, CS_CAPTURE_YUV_SPV, sizeof(CS_CAPTURE_YUV_SPV));
+    return c->pipe != VK_NULL_HANDLE;
+}
+
+static void release_slot_buffer(Device* d, CaptureSlot& s)
+{
+    if (s.mapped) vkUnmapMemory(d->device, s.mem);
+    if (s.buf)    vkDestroyBuffer(d->device, s.buf, nullptr);
+    if (s.mem)    vkFreeMemory(d->device, s.mem, nullptr);
+    s.buf = VK_NULL_HANDLE; s.mem = VK_NULL_HANDLE; s.mapped = nullptr; s.cap = 0;
+}
+
+// Slot is free, so the GPU no longer touches it. Cached memory first: the host reads
+// every byte of it.
+static bool reserve_slot(Device* d, CaptureSlot& s, VkDeviceSize bytes)
+{
+    if (s.buf && s.cap >= bytes) return true;
+    release_slot_buffer(d, s);
+
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!create_buffer(d, bytes, usage, host | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &s.buf, &s.mem) &&
+        !create_buffer(d, bytes, usage, host, &s.buf, &s.mem))
+        return false;
+    if (vkMapMemory(d->device, s.mem, 0, VK_WHOLE_SIZE, 0, &s.mapped) != VK_SUCCESS) {
+        release_slot_buffer(d, s);
+        return false;
+    }
+    s.cap = bytes;
+    return true;
+}
+
+void capture_release(Device* d)
+{
+    CapturePass* c = d->capture;
+    if (!c) return;
+    for (uint32_t i = 0; i < c->slotCount; ++i) release_slot_buffer(d, c->slots[i]);
+    if (c->pipe)    vkDestroyPipeline(d->device, c->pipe, nullptr);
+    if (c->layout)  vkDestroyPipelineLayout(d->device, c->layout, nullptr);
+    if (c->pool)    vkDestroyDescriptorPool(d->device, c->pool, nullptr);
+    if (c->dsl)     vkDestroyDescriptorSetLayout(d->device, c->dsl, nullptr);
+    if (c->sampler) vkDestroySampler(d->device, c->sampler, nullptr);
+    delete c;
+    d->capture = nullptr;
+}
+
+// ===== frame hooks =====
+static void fill_frame(const CapturePass* c, const CaptureSlot& s, fw_capture_frame* out)
+{
+    out->frame = s.frame;
+    out->dropped = c->dropped;
+    out->data = static_cast<const uint8_t*>(s.mapped);
+    out->bytes = s.bytes;
+    out->width = s.width;
+    out->height = s.height;
+    out->row_pitch = s.rowPitch;
+    out->format = s.format;
+}
+
+// The fence covering every pending copy has just been waited on.
+void capture_retire(Device* d)
+{
+    CapturePass* c = d->capture;
+    if (!c) return;
+    for (uint32_t i = 0; i < c->slotCount; ++i)
+        if (c->slots[i].state == CAPTURE_PENDING) c->slots[i].state = CAPTURE_READY;
+    if (!c->callback) return;
+
+    // Oldest first; each slot is free again once the callback returns.
+    for (;;) {
+        CaptureSlot* next = nullptr;
+        for (uint32_t i = 0; i < c->slotCount; ++i) {
+            CaptureSlot& s = c->slots[i];
+            if (s.state == CAPTURE_READY && (!next || s.frame < next->frame)) next = &s;
+        }
+        if (!next) break;
+        fw_capture_frame f{};
+        fill_frame(c, *next, &f);
+        c->callback(&f, c->user);
+        next->state = CAPTURE_FREE;
+    }
+}
+
+static void record_copy(Device* d, VkCommandBuffer cb, void* user)
+{
+    auto* c = static_cast<CapturePass*>(user);
+    const CaptureSlot& s = c->slots[c->recording];
+
+    VkPipelineStageFlags srcStage;
+    if (c->yuv) {
+        YuvPush p{ s.width, s.height, d->swapFmt == VK_FORMAT_B8G8R8A8_SRGB || d->swapFmt == VK_FORMAT_R8G8B8A8_SRGB };
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, c->pipe);
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, c->layout, 0, 1, &s.set, 0, nullptr);
+        vkCmdPushConstants(cb, c->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(p), &p);
+        const uint32_t bx = s.width / 8, by = s.height / 2;
+        vkCmdDispatch(cb, (bx + kGroupSize - 1) / kGroupSize, (by + kGroupSize - 1) / kGroupSize, 1);
+        srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    else {
+        VkBufferImageCopy r{};
+        r.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        r.imageExtent = { s.width, s.height, 1 };
+        vkCmdCopyImageToBuffer(cb, d->images[d->curImg], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, s.buf, 1, &r);
+        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+
+    // Host reads after the fence; make the writes visible to it.
+    VkBufferMemoryBarrier bb{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    bb.srcAccessMask = c->yuv ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+    bb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bb.srcQueueFamilyIndex = bb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bb.buffer = s.buf; bb.offset = 0; bb.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cb, srcStage, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bb, 0, nullptr);
+}
+
+void capture_add_pass(Device* d, RenderGraph* g, RgRes source)
+{
+    CapturePass* c = d->capture;
+    if (!c) return;
+    c->recording = kCaptureMaxSlots;
+    if (c->frame++ % c->interval) return;
+
+    CaptureSlot* s = nullptr;
+    for (uint32_t i = 0; i < c->slotCount && !s; ++i)
+        if (c->slots[i].state == CAPTURE_FREE) s = &c->slots[i];
+    if (!s) { ++c->dropped; return; }
+
+    uint32_t w = d->extent.width, h = d->extent.height;
+    VkDeviceSize bytes;
+    if (c->yuv) {
+        w &= ~7u; h &= ~1u;
+        bytes = (VkDeviceSize)w * h * 3 / 2;
+    }
+    else bytes = (VkDeviceSize)w * h * 4;
+    if (!bytes) return;
+    if (!reserve_slot(d, *s, bytes)) {
+        ++c->dropped;
+        native_log(2, "capture: readback buffer allocation failed; frame dropped.");
+        return;
+    }
+
+    s->state = CAPTURE_PENDING;
+    s->frame = c->frame - 1;
+    s->width = w; s->height = h;
+    s->bytes = bytes;
+    s->rowPitch = c->yuv ? w : w * 4;
+    s->format = c->yuv ? FW_CAPTURE_I420
+        : (d->swapFmt == VK_FORMAT_R8G8B8A8_UNORM || d->swapFmt == VK_FORMAT_R8G8B8A8_SRGB) ? FW_CAPTURE_RGBA8
+        : FW_CAPTURE_BGRA8;
+    c->recording = (uint32_t)(s - c->slots);
+
+    if (c->yuv) {
+        // The slot's previous dispatch retired with the last fence, so the set is idle.
+        VkDescriptorImageInfo ii{ c->sampler, d->views[d->curImg], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkDescriptorBufferInfo bi{ s->buf, 0, bytes };
+        VkWriteDescriptorSet w2[2]{};
+        w2[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w2[0].dstSet = s->set; w2[0].dstBinding = 0; w2[0].descriptorCount = 1;
+        w2[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w2[0].pImageInfo = &ii;
+        w2[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w2[1].dstSet = s->set; w2[1].dstBinding = 1; w2[1].descriptorCount = 1;
+        w2[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; w2[1].pBufferInfo = &bi;
+        vkUpdateDescriptorSets(d->device, 2, w2, 0, nullptr);
+    }
+
+    const RgRes dst = rg_import_buffer(g, s->buf, bytes, true);
+    rg_add_pass(g, "capture", &record_copy, c);
+    if (c->yuv) {
+        rg_use(g, source, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        rg_use(g, dst, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    }
+    else {
+        rg_use(g, source, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        rg_use(g, dst, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    }
+}
+
+// ===== ABI =====
+// desc == NULL stops capturing and frees the ring (frames not yet delivered are lost).
+int FM_CALL capture_start(fw_handle dev, const fw_capture_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("capture_start: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) {   // the open frame may already record a copy into the ring
+        native_set_error("capture_start: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (d->capture) {
+        vkDeviceWaitIdle(d->device);
+        capture_release(d);
+    }
+    if (!desc) return FM_OK;
+
+    const uint32_t ring = desc->ring_size ? desc->ring_size : 3;
+    if (ring < 2 || ring > kCaptureMaxSlots) {
+        native_set_error("capture_start: ring_size must be 2..8"); return FM_E_BADARGS;
+    }
+    const VkImageUsageFlags need = desc->yuv420 ? VK_IMAGE_USAGE_SAMPLED_BIT : VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if (!(d->swapUsage & need)) {
+        native_set_error("capture_start: swapchain images cannot be read back on this surface");
+        return FM_E_UNSUPPORTED;
+    }
+
+    auto* c = new CapturePass();
+    d->capture = c;
+    c->slotCount = ring;
+    c->yuv = desc->yuv420 != 0;
+    c->interval = desc->interval ? desc->interval : 1;
+    c->callback = desc->callback;
+    c->user = desc->user;
+    if (c->yuv && !create_yuv_objects(d, c)) {
+        capture_release(d);
+        native_set_error("capture_start: I420 conversion pipeline creation failed");
+        return FM_E_DEVICE;
+    }
+    return FM_OK;
+}
+
+// Returns 1 and fills *out with the oldest finished frame, FM_E_NOTREADY if none is ready
+// (or frames go to the callback). The previous polled frame is released by the call.
+int FM_CALL capture_poll(fw_handle dev, fw_capture_frame* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("capture_poll: null argument"); return FM_E_BADARGS; }
+    CapturePass* c = d->capture;
+    if (!c) { native_set_error("capture_poll: capture not started"); return FM_E_NOTREADY; }
+
+    CaptureSlot* next = nullptr;
+    for (uint32_t i = 0; i < c->slotCount; ++i) {
+        CaptureSlot& s = c->slots[i];
+        if (s.state == CAPTURE_HELD) s.state = CAPTURE_FREE;
+        else if (s.state == CAPTURE_READY && (!next || s.frame < next->frame)) next = &s;
+    }
+    if (!next) { native_set_error("capture_poll: no frame ready"); return FM_E_NOTREADY; }
+    next->state = CAPTURE_HELD;
+    fill_frame(c, *next, out);
+    return 1;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "renderer_device.h"
+#include "render_graph.h"
+
+/*
+    Frame readback ring for screenshots and video export.
+    - Each captured frame is copied (or converted to I420 in compute) into one of N
+      persistently mapped host buffers as the last pass of the frame graph. Nothing waits:
+      a slot is read only after the frame fence that covers its copy has been waited on
+      by the next begin_frame anyway.
+    - Finished slots go to the callback right there, or queue for capture_poll. A polled
+      slot stays valid until the next poll; when no slot is free the frame is skipped and
+      counted in `dropped` rather than stalling the renderer.
+    - Slots are sized for the current swapchain extent and grown lazily while free.
+*/
+
+static const uint32_t kCaptureMaxSlots = 8;
+
+enum CaptureSlotState
+{
+    CAPTURE_FREE = 0,
+    CAPTURE_PENDING,   // copy recorded, frame not yet retired
+    CAPTURE_READY,     // data valid, waiting for poll
+    CAPTURE_HELD,      // returned by the last poll
+};
+
+struct CaptureSlot
+{
+    VkBuffer        buf = VK_NULL_HANDLE;
+    VkDeviceMemory  mem = VK_NULL_HANDLE;
+    void*           mapped = nullptr;
+    VkDeviceSize    cap = 0;
+    VkDescriptorSet set = VK_NULL_HANDLE;   // I420 conversion: source view + this buffer
+
+    uint32_t        state = CAPTURE_FREE;
+    uint64_t        frame = 0;
+    uint32_t        width = 0, height = 0;
+    uint32_t        format = 0;              // FW_CAPTURE_*
+    uint32_t        rowPitch = 0;
+    VkDeviceSize    bytes = 0;
+};
+
+struct CapturePass
+{
+    CaptureSlot  slots[kCaptureMaxSlots];
+    uint32_t     slotCount = 0;
+    bool         yuv = false;
+    uint32_t     interval = 1;
+    fw_capture_fn callback = nullptr;
+    void*        user = nullptr;
+
+    uint64_t     frame = 0;         // frames seen since start
+    uint64_t     dropped = 0;
+    uint32_t     recording = kCaptureMaxSlots;   // slot written this frame, if any
+
+    // I420 conversion
+    VkSampler             sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout dsl = VK_NULL_HANDLE;
+    VkDescriptorPool      pool = VK_NULL_HANDLE;
+    VkPipelineLayout      layout = VK_NULL_HANDLE;
+    VkPipeline            pipe = VK_NULL_HANDLE;
+};
+
+// Frame hooks (renderer_api.cpp). retire runs right after the frame fence wait; add_pass
+// appends the copy of `source` (the swapchain image, final layout) to the frame graph.
+void capture_retire(Device* d);
+void capture_add_pass(Device* d, RenderGraph* g, RgRes source);
+void capture_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL capture_start(fw_handle dev, const fw_capture_desc* desc);
+int  FM_CALL capture_poll(fw_handle dev, fw_capture_frame* out);
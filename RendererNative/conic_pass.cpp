@@ -0,0 +1,172 @@
+// conic_pass.cpp
+// Per-pixel analytic ellipse / hyperbola rendering (see conic_pass.h)
+
+#include "conic_pass.h"
+#include "native_common.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static const uint32_t VS_CONIC_SPV[] = {
+#   include "shaders/vs_conic.spv.inc"
+};
+static const uint32_t FS_CONIC_SPV[] = {
+#   include "shaders/fs_conic.spv.inc"
+};
+static_assert((sizeof(VS_CONIC_SPV) % 4) == 0, "VS_CONIC_SPV must be dword aligned");
+static_assert((sizeof(FS_CONIC_SPV) % 4) == 0, "FS_CONIC_SPV must be dword aligned");
+
+static const double kParabolicBand = 1e-6;   // |e - 1| below this has no finite centre
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, ConicPass* c)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0; pcr.size = sizeof(ConicPush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &c->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription bind{}; bind.binding = 0; bind.stride = sizeof(ConicInstance); bind.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[5]{};
+    for (uint32_t i = 0; i < 4; ++i) {
+        attrs[i].location = i; attrs[i].binding = 0;
+        attrs[i].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[i].offset = i * sizeof(float) * 4;
+    }
+    attrs[4].location = 4; attrs[4].binding = 0; attrs[4].format = VK_FORMAT_R32_UINT;
+    attrs[4].offset = offsetof(ConicInstance, index);
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_CONIC_SPV; pd.vsBytes = sizeof(VS_CONIC_SPV);
+    pd.fs = FS_CONIC_SPV; pd.fsBytes = sizeof(FS_CONIC_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = attrs; pd.attrCount = 5;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    pd.blend = BLEND_ALPHA;
+    pd.layout = c->layout;
+    return create_graphics_pipeline(d, pd, &c->pipe);
+}
+
+void conic_release(Device* d)
+{
+    ConicPass* c = d->conics;
+    if (!c) return;
+    host_buffer_release(d, c->inst);
+    destroy_graphics_pipeline(d, &c->pipe);
+    if (c->layout) vkDestroyPipelineLayout(d->device, c->layout, nullptr);
+    delete c;
+    d->conics = nullptr;
+}
+
+// ===== frame hook =====
+void conic_record_draw(Device* d, VkCommandBuffer cb)
+{
+    ConicPass* c = d->conics;
+    if (!c || !c->count) return;
+
+    // World size of one pixel at clip w = 1: 2 / (height * |row 1 of view-proj|), which
+    // holds for perspective (row 1 = P11 * view row) and orthographic projections alike.
+    const float* m = d->viewProj;
+    const double row1 = std::sqrt((double)m[1] * m[1] + (double)m[5] * m[5] + (double)m[9] * m[9]);
+    const double h = d->extent.height ? (double)d->extent.height : 1.0;
+
+    ConicPush cp{};
+    std::memcpy(cp.viewProj, d->viewProj, sizeof(cp.viewProj));
+    cp.params[0] = row1 > 0 ? (float)(2.0 / (h * row1)) : 0.0f;
+    cp.params[1] = c->lineWidth;
+    cp.pickBase = pick_id(FW_PICK_CONIC, 0);
+
+    VkDeviceSize off = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, c->pipe);
+    vkCmdBindVertexBuffers(cb, 0, 1, &c->inst.buf, &off);
+    vkCmdPushConstants(cb, c->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(ConicPush), &cp);
+    vkCmdDraw(cb, 4, c->count, 0, 0);
+}
+
+// ===== conversion =====
+static inline double dot3(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+// Orbit elements -> centred plane frame. Returns false for conics that cannot be drawn
+// (degenerate frame, near-parabolic, hyperbola with max_radius inside periapsis).
+static bool make_instance(const fw_conic& k, const double origin[3], ConicInstance& out)
+{
+    const double e = k.eccentricity;
+    const double a = std::fabs(k.semi_major);
+    if (!(a > 0) || !(e >= 0) || std::fabs(e - 1.0) < kParabolicBand) return false;
+
+    const double nl = std::sqrt(dot3(k.normal, k.normal));
+    if (!(nl > 0)) return false;
+    const double n[3]{ k.normal[0] / nl, k.normal[1] / nl, k.normal[2] / nl };
+    const double pn = dot3(k.periapsis, n);
+    double p[3]{ k.periapsis[0] - pn * n[0], k.periapsis[1] - pn * n[1], k.periapsis[2] - pn * n[2] };
+    const double pl = std::sqrt(dot3(p, p));
+    if (!(pl > 0)) return false;
+    p[0] /= pl; p[1] /= pl; p[2] /= pl;
+    const double q[3]{ n[1] * p[2] - n[2] * p[1], n[2] * p[0] - n[0] * p[2], n[0] * p[1] - n[1] * p[0] };
+
+    double center[3], u[3], b, yMax = 0;
+    if (e < 1) {
+        // Ellipse: centre sits a*e behind the focus; +x points at periapsis.
+        b = a * std::sqrt(1 - e * e);
+        for (int i = 0; i < 3; ++i) { center[i] = k.focus[i] - a * e * p[i]; u[i] = p[i]; }
+    }
+    else {
+        // Hyperbola: centre a*e beyond the periapsis side of the focus, +x = -p so the
+        // branch around the focus is the x > 0 one; the arc ends where r = max_radius.
+        b = a * std::sqrt(e * e - 1);
+        for (int i = 0; i < 3; ++i) { center[i] = k.focus[i] + a * e * p[i]; u[i] = -p[i]; }
+        const double coshH = (k.max_radius / a + 1) / e;
+        if (!(coshH > 1)) return false;
+        yMax = b * std::sqrt(coshH * coshH - 1);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        out.centerA[i] = (float)(center[i] - origin[i]);
+        out.axisUB[i] = (float)u[i];
+        out.axisVY[i] = (float)q[i];
+    }
+    out.centerA[3] = (float)a;
+    out.axisUB[3] = (float)b;
+    out.axisVY[3] = (float)yMax;
+    std::memcpy(out.color, k.color, sizeof(out.color));
+    return true;
+}
+
+// ===== ABI =====
+// Replaces this frame's conics; returns how many were drawable (see make_instance).
+int FM_CALL conics_upload(fw_handle dev, const fw_conic* conics, uint32_t count, float line_width)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("conics_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("conics_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !conics) { native_set_error("conics_upload: null conics"); return FM_E_BADARGS; }
+
+    if (!d->conics) {
+        auto* c = new ConicPass();
+        d->conics = c;
+        if (!create_objects(d, c)) {
+            conic_release(d);
+            native_set_error("conics_upload: pipeline creation failed");
+            return FM_E_DEVICE;
+        }
+    }
+
+    ConicPass* c = d->conics;
+    c->count = 0;
+    if (!count) return 0;
+    if (!host_buffer_reserve(d, c->inst, (size_t)count * sizeof(ConicInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        return FM_E_NOMEM;
+
+    auto* dst = static_cast<ConicInstance*>(c->inst.mapped);
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; ++i)
+        if (make_instance(conics[i], d->origin, dst[n])) dst[n++].index = i;
+
+    c->count = n;
+    c->lineWidth = line_width > 0 ? line_width : 1.0f;
+    return (int)n;
+}
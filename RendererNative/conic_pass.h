@@ -0,0 +1,49 @@
+#pragma once
+#include "renderer_device.h"
+
+/*
+    Analytic conic orbits (ellipses and hyperbolic arcs).
+    - Each conic is one instanced quad bounding the curve in its orbital plane; the fragment
+      shader evaluates the implicit conic f(x, y) = x^2/a^2 +- y^2/b^2 - 1 in plane
+      coordinates and divides by its screen-space gradient to get the pixel distance to the
+      curve, so lines are resolution independent at 4 vertices per orbit.
+    - Quads are padded by the line width in pixels (estimated per corner from clip w), so the
+      tangent points at the quad edges are not clipped.
+    - Plane coordinates are relative to the conic centre, so float precision scales with the
+      orbit size (~1e-7 a); orbits seen almost edge-on collapse with their quad and thin out.
+*/
+
+struct ConicPass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    HostBuffer       inst;
+    uint32_t         count = 0;        // instances uploaded for this frame
+    float            lineWidth = 1.0f;
+};
+
+// Per-instance data of vs_conic.vert (4 x vec4)
+struct ConicInstance
+{
+    float centerA[4];   // xyz centre relative to the camera origin, w semi-major a
+    float axisUB[4];    // xyz unit +x axis (towards the drawn vertex), w semi-minor b
+    float axisVY[4];    // xyz unit +y axis, w hyperbola |y| limit (0 = ellipse)
+    float color[4];
+    uint32_t index;     // caller's conic index: undrawable conics are skipped, the pick ID is not
+};
+
+// Push block of vs_conic.vert / fs_conic.frag
+struct ConicPush
+{
+    float    viewProj[16];
+    float    params[4];    // x world size of a pixel per unit clip w, y line width (px)
+    uint32_t pickBase;     // pick_id of conic 0 (plus ConicInstance::index)
+};
+
+// Frame hooks (renderer_api.cpp)
+void conic_record_draw(Device* d, VkCommandBuffer cb);
+void conic_release(Device* d);
+
+// ABI entry point (see fw_renderer_api)
+int  FM_CALL conics_upload(fw_handle dev, const fw_conic* conics, uint32_t count, float line_width);
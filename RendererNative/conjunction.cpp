@@ -0,0 +1,381 @@
+// conjunction.cpp
+// Spatial-hash broad phase + swept-sphere narrow phase (see conjunction.h)
+
+#include "conjunction.h"
+#include "nbody.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const uint32_t kBoxGrain = 4096;
+static const uint32_t kSortGrain = 16384;
+static const uint32_t kPairGrain = 1024;
+static const double   kMaxCellCoord = 1073741824.0;   // 2^30, keeps cell coords in int32
+static const double   kCellPercentile = 0.9;          // automatic cell = this swept extent
+static const double   kMaxCellsPerAxis = 4.0;         // bodies spanning more skip the grid
+
+struct SoA
+{
+    const double *x, *y, *z, *vx, *vy, *vz;
+};
+
+static inline int32_t cell_of(double v, double lo, double inv)
+{
+    return (int32_t)std::floor((v - lo) * inv);
+}
+
+static inline uint32_t cell_hash(int32_t cx, int32_t cy, int32_t cz, uint32_t mask)
+{
+    return ((uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u ^ (uint32_t)cz * 83492791u) & mask;
+}
+
+// ===== broad phase =====
+struct BoxStats { double lo[3]; double hi[3]; };
+
+// Swept box of each body over [0, dt], inflated by radius + margin/2: if two spheres come
+// within margin of each other at some t, both centres are inside their boxes then and the
+// inflated spheres touch, so the boxes overlap.
+static BoxStats build_boxes(Conjunctions* c, const SoA& s, uint32_t n, double dt)
+{
+    c->lo.resize((size_t)n * 3);
+    c->hi.resize((size_t)n * 3);
+    c->ext.resize(n);
+    const uint32_t chunks = (n + kBoxGrain - 1) / kBoxGrain;
+    std::vector<BoxStats> part(chunks);
+    const double* r = c->radius.data();
+    const uint32_t nr = (uint32_t)c->radius.size();
+    const double halfMargin = 0.5 * c->margin;
+
+    parallel_for(n, kBoxGrain, [&](uint32_t b, uint32_t e) {
+        BoxStats st{ { HUGE_VAL, HUGE_VAL, HUGE_VAL }, { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL } };
+        for (uint32_t i = b; i < e; ++i) {
+            const double pad = (i < nr ? r[i] : 0.0) + halfMargin;
+            const double p0[3] = { s.x[i], s.y[i], s.z[i] };
+            const double p1[3] = { s.x[i] + s.vx[i] * dt, s.y[i] + s.vy[i] * dt, s.z[i] + s.vz[i] * dt };
+            double* lo = &c->lo[3 * (size_t)i];
+            double* hi = &c->hi[3 * (size_t)i];
+            double ext = 0.0;
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(p0[k], p1[k]) - pad;
+                hi[k] = std::max(p0[k], p1[k]) + pad;
+                st.lo[k] = std::min(st.lo[k], lo[k]);
+                st.hi[k] = std::max(st.hi[k], hi[k]);
+                ext = std::max(ext, hi[k] - lo[k]);
+            }
+            c->ext[i] = ext;
+        }
+        part[b / kBoxGrain] = st;
+        });
+
+    BoxStats out = part[0];
+    for (uint32_t k = 1; k < chunks; ++k) {
+        for (int a = 0; a < 3; ++a) {
+            out.lo[a] = std::min(out.lo[a], part[k].lo[a]);
+            out.hi[a] = std::max(out.hi[a], part[k].hi[a]);
+        }
+    }
+    return out;
+}
+
+// Parallel LSD radix sort of entries by bucket, 8 bits per pass over the used bits only.
+// Per-chunk histograms keep the scatter stable, so the result is deterministic.
+static void sort_entries(Conjunctions* c, uint32_t bits)
+{
+    const uint32_t n = (uint32_t)c->entries.size();
+    const uint32_t chunks = (n + kSortGrain - 1) / kSortGrain;
+    c->sorted.resize(n);
+    c->hist.resize((size_t)chunks * 256);
+
+    ConjEntry* in = c->entries.data();
+    ConjEntry* out = c->sorted.data();
+    for (uint32_t shift = 0; shift < bits; shift += 8) {
+        uint32_t* hist = c->hist.data();
+        parallel_for(n, kSortGrain, [&](uint32_t b, uint32_t e) {
+            uint32_t* h = hist + (size_t)(b / kSortGrain) * 256;
+            std::fill(h, h + 256, 0u);
+            for (uint32_t i = b; i < e; ++i) ++h[(in[i].bucket >> shift) & 0xff];
+            });
+
+        // Exclusive prefix in (digit, chunk) order
+        uint32_t sum = 0;
+        for (uint32_t d = 0; d < 256; ++d)
+            for (uint32_t k = 0; k < chunks; ++k) {
+                uint32_t v = hist[(size_t)k * 256 + d];
+                hist[(size_t)k * 256 + d] = sum;
+                sum += v;
+            }
+
+        parallel_for(n, kSortGrain, [&](uint32_t b, uint32_t e) {
+            uint32_t* h = hist + (size_t)(b / kSortGrain) * 256;
+            for (uint32_t i = b; i < e; ++i) out[h[(in[i].bucket >> shift) & 0xff]++] = in[i];
+            });
+        std::swap(in, out);
+    }
+    if (in != c->entries.data()) c->entries.swap(c->sorted);
+}
+
+// ===== narrow phase =====
+// Relative motion d(t) = d + w t over [0, dt]; R = contact distance (sum of radii).
+static bool swept_spheres(const double d[3], const double w[3], double R, double margin, double dt,
+    fw_conj_event& ev)
+{
+    const double ww = w[0] * w[0] + w[1] * w[1] + w[2] * w[2];
+    const double dw = d[0] * w[0] + d[1] * w[1] + d[2] * w[2];
+    const double dd = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+    double tc = ww > 0 ? -dw / ww : 0.0;
+    tc = tc < 0 ? 0 : (tc > dt ? dt : tc);
+    const double m2 = std::max(0.0, dd + 2 * dw * tc + ww * tc * tc);
+    const double lim = R + margin;
+    if (m2 > lim * lim) return false;
+
+    ev.t_closest = tc;
+    ev.min_dist = std::sqrt(m2);
+    ev.t_contact = -1.0;
+    ev.flags = FW_CONJ_CLOSE_APPROACH;
+
+    const double c0 = dd - R * R;
+    if (c0 <= 0) {
+        ev.t_contact = 0.0;                      // already touching at the start of the tick
+    }
+    else if (ww > 0) {
+        const double disc = dw * dw - ww * c0;
+        if (disc >= 0) {
+            const double t = (-dw - std::sqrt(disc)) / ww;
+            if (t >= 0 && t <= dt) ev.t_contact = t;
+        }
+    }
+    if (ev.t_contact >= 0) ev.flags |= FW_CONJ_COLLISION;
+    return true;
+}
+
+// ===== detection =====
+static int detect(Conjunctions* c, const SoA& s, uint32_t n, double dt)
+{
+    c->events.clear();
+    if (n < 2) return 0;
+
+    const BoxStats st = build_boxes(c, s, n, dt);
+
+    // Cells the size of a typical swept box (a high percentile, so one fast or large body
+    // cannot inflate every cell); bodies spanning more than kMaxCellsPerAxis cells stay out
+    // of the grid and are tested against every body instead.
+    double cs = c->cellSize;
+    if (!(cs > 0)) {
+        c->extSorted.assign(c->ext.begin(), c->ext.end());
+        auto at = c->extSorted.begin() + (size_t)((n - 1) * kCellPercentile);
+        std::nth_element(c->extSorted.begin(), at, c->extSorted.end());
+        cs = *at;
+    }
+    double span = 0;
+    for (int k = 0; k < 3; ++k) span = std::max(span, st.hi[k] - st.lo[k]);
+    if (!(cs > 0)) cs = 1.0;
+    if (span / cs > kMaxCellCoord) cs = span / kMaxCellCoord;
+    const double inv = 1.0 / cs;
+    const double* glo = st.lo;
+    const double largeExt = kMaxCellsPerAxis * cs;
+
+    c->large.clear();
+    for (uint32_t i = 0; i < n; ++i)
+        if (c->ext[i] > largeExt) c->large.push_back(i);
+
+    // Cell ranges -> entry counts -> offsets
+    c->firstEntry.resize((size_t)n + 1);
+    uint32_t* first = c->firstEntry.data();
+    parallel_for(n, kBoxGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            if (c->ext[i] > largeExt) { first[i] = 0; continue; }
+            const double* lo = &c->lo[3 * (size_t)i];
+            const double* hi = &c->hi[3 * (size_t)i];
+            uint32_t cells = 1;
+            for (int k = 0; k < 3; ++k)
+                cells *= (uint32_t)(cell_of(hi[k], glo[k], inv) - cell_of(lo[k], glo[k], inv) + 1);
+            first[i] = cells;
+        }
+        });
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < n; ++i) { uint32_t k = first[i]; first[i] = (uint32_t)total; total += k; }
+    if (total > UINT32_MAX / 2) { native_set_error("conj_detect: too many hash entries"); return FM_E_NOMEM; }
+    first[n] = (uint32_t)total;
+
+    uint32_t bits = 10;
+    while ((1ull << bits) < 2 * total) ++bits;
+    const uint32_t mask = (uint32_t)((1ull << bits) - 1);
+
+    c->entries.resize((size_t)total);
+    ConjEntry* ent = c->entries.data();
+    parallel_for(n, kBoxGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            if (c->ext[i] > largeExt) continue;
+            const double* lo = &c->lo[3 * (size_t)i];
+            const double* hi = &c->hi[3 * (size_t)i];
+            int32_t a0[3], a1[3];
+            for (int k = 0; k < 3; ++k) { a0[k] = cell_of(lo[k], glo[k], inv); a1[k] = cell_of(hi[k], glo[k], inv); }
+            ConjEntry* o = ent + first[i];
+            for (int32_t cz = a0[2]; cz <= a1[2]; ++cz)
+                for (int32_t cy = a0[1]; cy <= a1[1]; ++cy)
+                    for (int32_t cx = a0[0]; cx <= a1[0]; ++cx)
+                        *o++ = ConjEntry{ cell_hash(cx, cy, cz, mask), cx, cy, cz, i };
+        }
+        });
+
+    sort_entries(c, bits);
+
+    // Pairs: every entry scans the rest of its bucket run. A pair is kept only in the cell
+    // holding the min corner of the two boxes' overlap, so each pair is tested once.
+    const uint32_t m = (uint32_t)total;
+    const ConjEntry* se = c->entries.data();
+    const double* r = c->radius.data();
+    const uint32_t nr = (uint32_t)c->radius.size();
+    const uint32_t gridChunks = (m + kPairGrain - 1) / kPairGrain;
+    const uint32_t largeChunks = c->large.empty() ? 0 : (n + kPairGrain - 1) / kPairGrain;
+    const uint32_t chunks = gridChunks + largeChunks;
+    if (c->chunkEvents.size() < chunks) c->chunkEvents.resize(chunks);
+
+    auto overlap = [&](uint32_t a, uint32_t b) {
+        const double* alo = &c->lo[3 * (size_t)a];
+        const double* ahi = &c->hi[3 * (size_t)a];
+        const double* blo = &c->lo[3 * (size_t)b];
+        const double* bhi = &c->hi[3 * (size_t)b];
+        return !(alo[0] > bhi[0] || blo[0] > ahi[0] || alo[1] > bhi[1] || blo[1] > ahi[1] ||
+            alo[2] > bhi[2] || blo[2] > ahi[2]);
+    };
+    auto test_pair = [&](uint32_t a, uint32_t b, std::vector<fw_conj_event>& outEv) {
+        const uint32_t ia = std::min(a, b), ib = std::max(a, b);
+        const double d[3] = { s.x[ib] - s.x[ia], s.y[ib] - s.y[ia], s.z[ib] - s.z[ia] };
+        const double w[3] = { s.vx[ib] - s.vx[ia], s.vy[ib] - s.vy[ia], s.vz[ib] - s.vz[ia] };
+        const double R = (ia < nr ? r[ia] : 0.0) + (ib < nr ? r[ib] : 0.0);
+        fw_conj_event ev{};
+        if (swept_spheres(d, w, R, c->margin, dt, ev)) {
+            ev.a = ia; ev.b = ib;
+            outEv.push_back(ev);
+        }
+    };
+
+    parallel_for(m, kPairGrain, [&](uint32_t b, uint32_t e) {
+        std::vector<fw_conj_event>& outEv = c->chunkEvents[b / kPairGrain];
+        outEv.clear();
+        for (uint32_t i = b; i < e; ++i) {
+            const ConjEntry& p = se[i];
+            const double* plo = &c->lo[3 * (size_t)p.body];
+            for (uint32_t j = i + 1; j < m && se[j].bucket == p.bucket; ++j) {
+                const ConjEntry& q = se[j];
+                if (q.cx != p.cx || q.cy != p.cy || q.cz != p.cz || q.body == p.body) continue;
+                if (!overlap(p.body, q.body)) continue;
+                const double* qlo = &c->lo[3 * (size_t)q.body];
+                if (cell_of(std::max(plo[0], qlo[0]), glo[0], inv) != p.cx ||
+                    cell_of(std::max(plo[1], qlo[1]), glo[1], inv) != p.cy ||
+                    cell_of(std::max(plo[2], qlo[2]), glo[2], inv) != p.cz) continue;
+                test_pair(p.body, q.body, outEv);
+            }
+        }
+        });
+
+    // Oversized bodies against every body; a pair of two of them is tested from the lower index
+    if (largeChunks) {
+        parallel_for(n, kPairGrain, [&](uint32_t b, uint32_t e) {
+            std::vector<fw_conj_event>& outEv = c->chunkEvents[gridChunks + b / kPairGrain];
+            outEv.clear();
+            for (uint32_t j = b; j < e; ++j) {
+                const bool jLarge = c->ext[j] > largeExt;
+                for (uint32_t a : c->large)
+                    if (a != j && (!jLarge || a < j) && overlap(a, j)) test_pair(a, j, outEv);
+            }
+            });
+    }
+
+    size_t count = 0;
+    for (uint32_t k = 0; k < chunks; ++k) count += c->chunkEvents[k].size();
+    c->events.reserve(count);
+    for (uint32_t k = 0; k < chunks; ++k)
+        c->events.insert(c->events.end(), c->chunkEvents[k].begin(), c->chunkEvents[k].end());
+    std::sort(c->events.begin(), c->events.end(), [](const fw_conj_event& u, const fw_conj_event& v) {
+        return u.a != v.a ? u.a < v.a : u.b < v.b;
+        });
+    return (int)std::min(c->events.size(), (size_t)INT32_MAX);
+}
+
+// ===== ABI =====
+int FM_CALL conj_create(fw_handle* out)
+{
+    if (!out) { native_set_error("conj_create: null out"); return FM_E_BADARGS; }
+    jobs_acquire();
+    *out = to_handle(new Conjunctions());
+    return FM_OK;
+}
+
+void FM_CALL conj_destroy(fw_handle det)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    if (!c) return;
+    delete c;
+    jobs_release();
+}
+
+int FM_CALL conj_set_params(fw_handle det, double margin, double cell_size)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    if (!c) { native_set_error("conj: null handle"); return FM_E_BADARGS; }
+    if (!(margin >= 0) || !(cell_size >= 0)) { native_set_error("conj_set_params: negative margin/cell_size"); return FM_E_BADARGS; }
+    c->margin = margin;
+    c->cellSize = cell_size;
+    return FM_OK;
+}
+
+// Bodies past the end of the array have radius 0; count 0 clears all radii.
+int FM_CALL conj_set_radii(fw_handle det, const double* radii, uint32_t count)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    if (!c) { native_set_error("conj: null handle"); return FM_E_BADARGS; }
+    if (count && !radii) { native_set_error("conj_set_radii: null radii"); return FM_E_BADARGS; }
+    c->radius.assign(radii, radii + count);
+    return FM_OK;
+}
+
+int FM_CALL conj_detect(fw_handle det, const double* pos_xyz, const double* vel_xyz,
+    uint32_t count, double dt)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    if (!c) { native_set_error("conj: null handle"); return FM_E_BADARGS; }
+    if (count && !pos_xyz) { native_set_error("conj_detect: null pos"); return FM_E_BADARGS; }
+    if (!(dt >= 0)) { native_set_error("conj_detect: negative dt"); return FM_E_BADARGS; }
+
+    c->x.resize(count); c->y.resize(count); c->z.resize(count);
+    c->vx.resize(count); c->vy.resize(count); c->vz.resize(count);
+    parallel_for(count, 8192, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            c->x[i] = pos_xyz[3 * (size_t)i + 0];
+            c->y[i] = pos_xyz[3 * (size_t)i + 1];
+            c->z[i] = pos_xyz[3 * (size_t)i + 2];
+            c->vx[i] = vel_xyz ? vel_xyz[3 * (size_t)i + 0] : 0.0;
+            c->vy[i] = vel_xyz ? vel_xyz[3 * (size_t)i + 1] : 0.0;
+            c->vz[i] = vel_xyz ? vel_xyz[3 * (size_t)i + 2] : 0.0;
+        }
+        });
+
+    SoA s{ c->x.data(), c->y.data(), c->z.data(), c->vx.data(), c->vy.data(), c->vz.data() };
+    return detect(c, s, count, dt);
+}
+
+// Works on the sim's SoA state in place, extrapolating current velocities over dt.
+int FM_CALL conj_detect_nbody(fw_handle det, fw_handle nbody_sim, double dt)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    auto* b = handle_to<NBody>(nbody_sim);
+    if (!c || !b) { native_set_error("conj_detect_nbody: null handle"); return FM_E_BADARGS; }
+    if (!(dt >= 0)) { native_set_error("conj_detect_nbody: negative dt"); return FM_E_BADARGS; }
+
+    SoA s{ b->x.data(), b->y.data(), b->z.data(), b->vx.data(), b->vy.data(), b->vz.data() };
+    return detect(c, s, b->n, dt);
+}
+
+int FM_CALL conj_get_events(fw_handle det, fw_conj_event* out, uint32_t max_events)
+{
+    auto* c = handle_to<Conjunctions>(det);
+    if (!c) { native_set_error("conj: null handle"); return FM_E_BADARGS; }
+    if (max_events && !out) { native_set_error("conj_get_events: null out"); return FM_E_BADARGS; }
+    const uint32_t k = (uint32_t)std::min<size_t>(c->events.size(), max_events);
+    std::copy(c->events.begin(), c->events.begin() + k, out);
+    return (int)k;
+}
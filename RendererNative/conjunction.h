@@ -0,0 +1,58 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Close-approach / collision detection between moving bodies over one sim tick.
+    - Broad phase: uniform spatial hash over swept, inflated AABBs, rebuilt in parallel each
+      call (counting sort into buckets, so cost is linear in body count).
+    - Cells are sized from the 90th percentile of the swept box extents, so a few fast or
+      large bodies do not coarsen the grid for everyone. Bodies spanning more than 4 cells
+      per axis are kept out of the hash and tested directly against every body (linear per
+      such outlier).
+    - A pair is tested only in the cell holding the min corner of the two boxes' overlap,
+      so bodies spanning several cells never produce duplicate events.
+    - Narrow phase: swept spheres under linear motion over [0, dt].
+*/
+
+struct NBody;
+
+struct ConjEntry
+{
+    uint32_t bucket;
+    int32_t  cx, cy, cz;
+    uint32_t body;
+};
+
+struct Conjunctions
+{
+    double margin = 0.0;     // close-approach distance added to the summed radii
+    double cellSize = 0.0;   // 0 = auto (90th percentile of the swept box extents)
+    std::vector<double> radius;
+
+    // SoA scratch for callers that pass interleaved arrays
+    std::vector<double> x, y, z, vx, vy, vz;
+
+    // broad phase scratch, reused between calls
+    std::vector<double>    lo, hi;          // 3 per body
+    std::vector<double>    ext, extSorted;  // largest swept box edge per body
+    std::vector<uint32_t>  large;           // bodies too big for the grid
+    std::vector<uint32_t>  firstEntry;      // prefix sum of cells per body
+    std::vector<ConjEntry> entries, sorted;
+    std::vector<uint32_t>  hist;            // 256 per chunk, radix passes
+
+    std::vector<std::vector<fw_conj_event>> chunkEvents;
+    std::vector<fw_conj_event> events;
+};
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL conj_create(fw_handle* out);
+void FM_CALL conj_destroy(fw_handle det);
+int  FM_CALL conj_set_params(fw_handle det, double margin, double cell_size);
+int  FM_CALL conj_set_radii(fw_handle det, const double* radii, uint32_t count);
+int  FM_CALL conj_detect(fw_handle det, const double* pos_xyz, const double* vel_xyz,
+    uint32_t count, double dt);
+int  FM_CALL conj_detect_nbody(fw_handle det, fw_handle nbody_sim, double dt);
+int  FM_CALL conj_get_events(fw_handle det, fw_conj_event* out, uint32_t max_events);
@@ -0,0 +1,343 @@
+// data_file.cpp
+// Memory-mapped section container: writer, lazy per-section views, CRC-32C (see data_file.h)
+
+#include "data_file.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// ===== CRC-32C =====
+struct CrcTables
+{
+    uint32_t t[8][256];
+    CrcTables()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+            for (int s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t bytes)
+{
+    static const CrcTables tables;
+    const uint32_t (*t)[256] = tables.t;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (; bytes >= 8; bytes -= 8, p += 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    while (bytes--) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+// ===== platform =====
+#ifdef _WIN32
+static std::wstring widen(const char* utf8)
+{
+    const int n = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, nullptr, 0);
+    std::wstring w(n > 0 ? n : 1, L'\0');
+    if (n > 0) MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &w[0], n);
+    return w;
+}
+#endif
+
+std::FILE* fopen_utf8(const char* path, const char* mode)
+{
+#ifdef _WIN32
+    return _wfopen(widen(path).c_str(), widen(mode).c_str());
+#else
+    return std::fopen(path, mode);
+#endif
+}
+
+static bool open_file(DataFile* f, const char* path)
+{
+#ifdef _WIN32
+    HANDLE h = CreateFileW(widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    f->file = h;
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(h, &sz)) return false;
+    f->size = (uint64_t)sz.QuadPart;
+    if (f->size) {
+        f->mapping = CreateFileMappingW(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!f->mapping) return false;
+    }
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    f->granularity = si.dwAllocationGranularity;
+#else
+    f->fd = ::open(path, O_RDONLY);
+    if (f->fd < 0) return false;
+    struct stat st{};
+    if (fstat(f->fd, &st) != 0) return false;
+    f->size = (uint64_t)st.st_size;
+    f->granularity = (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+    return true;
+}
+
+static bool read_at(DataFile* f, uint64_t offset, void* dst, size_t bytes)
+{
+#ifdef _WIN32
+    OVERLAPPED ov{};
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD got = 0;
+    return ReadFile((HANDLE)f->file, dst, (DWORD)bytes, &got, &ov) && got == bytes;
+#else
+    return pread(f->fd, dst, bytes, (off_t)offset) == (ssize_t)bytes;
+#endif
+}
+
+static void* map_view(DataFile* f, uint64_t offset, size_t bytes)
+{
+#ifdef _WIN32
+    return MapViewOfFile((HANDLE)f->mapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, bytes);
+#else
+    void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, f->fd, (off_t)offset);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+static void unmap_view(void* view, size_t bytes)
+{
+#ifdef _WIN32
+    (void)bytes;
+    UnmapViewOfFile(view);
+#else
+    munmap(view, bytes);
+#endif
+}
+
+static size_t view_bytes(const DataFile* f, const DataTocEntry& e)
+{
+    return (size_t)(e.offset + e.size - (e.offset & ~(f->granularity - 1)));
+}
+
+static void close_file(DataFile* f)
+{
+    for (DataSection& s : f->sections)
+        if (s.view) unmap_view(s.view, view_bytes(f, s.toc));
+#ifdef _WIN32
+    if (f->mapping) CloseHandle((HANDLE)f->mapping);
+    if (f->file && f->file != INVALID_HANDLE_VALUE) CloseHandle((HANDLE)f->file);
+#else
+    if (f->fd >= 0) ::close(f->fd);
+#endif
+}
+
+// ===== header / TOC =====
+static bool validate(const DataFile* f, const DataHeader& h, const char** why)
+{
+    DataHeader copy = h;
+    copy.headerCrc = 0;
+    if (std::memcmp(h.magic, kDataMagic, sizeof(kDataMagic)) != 0) { *why = "data_open: not a container file"; return false; }
+    if ((h.version >> 16) != (kDataVersion >> 16)) { *why = "data_open: unsupported major version"; return false; }
+    if (crc32c(0, &copy, sizeof(copy)) != h.headerCrc) { *why = "data_open: header checksum mismatch"; return false; }
+    if (h.fileSize != f->size) { *why = "data_open: truncated or extended file"; return false; }
+    if (h.tocOffset > f->size || (uint64_t)h.sectionCount * sizeof(DataTocEntry) > f->size - h.tocOffset) {
+        *why = "data_open: table of contents out of range";
+        return false;
+    }
+    return true;
+}
+
+// ===== ABI =====
+// Writes sections back to back on FW_DATA_ALIGN boundaries, then the TOC, then the header.
+int FM_CALL data_write(const char* path, const fw_data_section_desc* sections, uint32_t count)
+{
+    if (!path) { native_set_error("data_write: null path"); return FM_E_BADARGS; }
+    if (count && !sections) { native_set_error("data_write: null sections"); return FM_E_BADARGS; }
+    for (uint32_t i = 0; i < count; ++i) {
+        const fw_data_section_desc& s = sections[i];
+        if (!s.name || std::strlen(s.name) >= sizeof(DataTocEntry::name)) { native_set_error("data_write: missing or long (> 23 bytes) section name"); return FM_E_BADARGS; }
+        if (s.size && !s.data) { native_set_error("data_write: null section data"); return FM_E_BADARGS; }
+        if (s.elem_size && s.count * s.elem_size != s.size) { native_set_error("data_write: size != count * elem_size"); return FM_E_BADARGS; }
+    }
+
+    std::FILE* fp = fopen_utf8(path, "wb");
+    if (!fp) { native_set_error("data_write: cannot create file"); return FM_E_UNSPECIFIED; }
+
+    static const uint8_t kZeros[FW_DATA_ALIGN] = {};
+    bool ok = true;
+    uint64_t pos = 0;
+    auto put = [&](const void* p, size_t n) {
+        ok = ok && std::fwrite(p, 1, n, fp) == n;
+        pos += n;
+    };
+    auto pad_to = [&](uint64_t align) {
+        while (ok && pos % align) put(kZeros, (size_t)std::min<uint64_t>(align - pos % align, sizeof(kZeros)));
+    };
+
+    DataHeader h{};
+    put(&h, sizeof(h));
+
+    std::vector<DataTocEntry> toc(count);
+    for (uint32_t i = 0; i < count && ok; ++i) {
+        const fw_data_section_desc& s = sections[i];
+        pad_to(FW_DATA_ALIGN);
+        DataTocEntry& e = toc[i];
+        std::strncpy(e.name, s.name, sizeof(e.name));
+        e.type = s.type;
+        e.elemSize = s.elem_size;
+        e.offset = pos;
+        e.size = s.size;
+        e.count = s.count;
+        e.crc = crc32c(0, s.data, (size_t)s.size);
+        put(s.data, (size_t)s.size);
+    }
+    pad_to(sizeof(DataTocEntry));
+
+    std::memcpy(h.magic, kDataMagic, sizeof(kDataMagic));
+    h.version = kDataVersion;
+    h.sectionCount = count;
+    h.tocOffset = pos;
+    h.tocCrc = crc32c(0, toc.data(), toc.size() * sizeof(DataTocEntry));
+    put(toc.data(), toc.size() * sizeof(DataTocEntry));
+    h.fileSize = pos;
+    h.headerCrc = crc32c(0, &h, sizeof(h));
+
+    ok = ok && std::fseek(fp, 0, SEEK_SET) == 0 && std::fwrite(&h, 1, sizeof(h), fp) == sizeof(h);
+    ok = (std::fclose(fp) == 0) && ok;
+    if (!ok) { native_set_error("data_write: write failed"); return FM_E_UNSPECIFIED; }
+    return FM_OK;
+}
+
+// Reads and checks the header and TOC only; sections are mapped by data_map_section.
+int FM_CALL data_open(const char* path, fw_handle* out)
+{
+    if (!path || !out) { native_set_error("data_open: null argument"); return FM_E_BADARGS; }
+
+    auto* f = new DataFile();
+    const char* why = nullptr;
+    DataHeader h{};
+    if (!open_file(f, path)) why = "data_open: cannot open file";
+    else if (f->size < sizeof(DataHeader) || !read_at(f, 0, &h, sizeof(h))) why = "data_open: not a container file";
+    else validate(f, h, &why);
+
+    std::vector<DataTocEntry> toc;
+    if (!why) {
+        toc.resize(h.sectionCount);
+        if (!read_at(f, h.tocOffset, toc.data(), toc.size() * sizeof(DataTocEntry)))
+            why = "data_open: cannot read table of contents";
+        else if (crc32c(0, toc.data(), toc.size() * sizeof(DataTocEntry)) != h.tocCrc)
+            why = "data_open: table of contents checksum mismatch";
+    }
+    for (size_t i = 0; !why && i < toc.size(); ++i) {
+        const DataTocEntry& e = toc[i];
+        if (e.offset % FW_DATA_ALIGN || e.offset < sizeof(DataHeader) || e.offset > h.tocOffset ||
+            e.size > h.tocOffset - e.offset || (e.elemSize && e.count * e.elemSize != e.size))
+            why = "data_open: bad section entry";
+    }
+    if (why) {
+        close_file(f);
+        delete f;
+        native_set_error(why);
+        return FM_E_BADARGS;
+    }
+
+    f->sections.resize(toc.size());
+    for (size_t i = 0; i < toc.size(); ++i) {
+        f->sections[i].toc = toc[i];
+        f->sections[i].toc.name[sizeof(toc[i].name) - 1] = '\0';
+    }
+    *out = to_handle(f);
+    return FM_OK;
+}
+
+// Unmaps every section; pointers from data_map_section die with the handle.
+void FM_CALL data_close(fw_handle file)
+{
+    auto* f = handle_to<DataFile>(file);
+    if (!f) return;
+    close_file(f);
+    delete f;
+}
+
+int FM_CALL data_section_count(fw_handle file)
+{
+    auto* f = handle_to<DataFile>(file);
+    if (!f) { native_set_error("data: null handle"); return FM_E_BADARGS; }
+    return (int)std::min<size_t>(f->sections.size(), INT32_MAX);
+}
+
+int FM_CALL data_section_info(fw_handle file, uint32_t index, fw_data_section* out)
+{
+    auto* f = handle_to<DataFile>(file);
+    if (!f || !out) { native_set_error("data_section_info: null argument"); return FM_E_BADARGS; }
+    if (index >= f->sections.size()) { native_set_error("data_section_info: bad index"); return FM_E_BADARGS; }
+    const DataTocEntry& e = f->sections[index].toc;
+    *out = fw_data_section{};
+    std::memcpy(out->name, e.name, sizeof(out->name));
+    out->type = e.type;
+    out->elem_size = e.elemSize;
+    out->offset = e.offset;
+    out->size = e.size;
+    out->count = e.count;
+    return FM_OK;
+}
+
+// Returns 1 with the first section of that name in *out_index, 0 if there is none.
+int FM_CALL data_find_section(fw_handle file, const char* name, uint32_t* out_index)
+{
+    auto* f = handle_to<DataFile>(file);
+    if (!f || !name || !out_index) { native_set_error("data_find_section: null argument"); return FM_E_BADARGS; }
+    for (size_t i = 0; i < f->sections.size(); ++i)
+        if (std::strncmp(f->sections[i].toc.name, name, sizeof(DataTocEntry::name)) == 0) {
+            *out_index = (uint32_t)i;
+            return 1;
+        }
+    return 0;
+}
+
+// Maps the section on first use (read-only, paged in on touch) and returns its payload.
+// verify checks the CRC once per handle; a mismatch fails this and every later verified map.
+int FM_CALL data_map_section(fw_handle file, uint32_t index, uint32_t verify, const void** out_data)
+{
+    auto* f = handle_to<DataFile>(file);
+    if (!f || !out_data) { native_set_error("data_map_section: null argument"); return FM_E_BADARGS; }
+    if (index >= f->sections.size()) { native_set_error("data_map_section: bad index"); return FM_E_BADARGS; }
+
+    std::lock_guard<std::mutex> lk(f->lock);
+    DataSection& s = f->sections[index];
+    if (!s.toc.size) { *out_data = nullptr; return FM_OK; }
+    if (!s.view) {
+        const uint64_t base = s.toc.offset & ~(f->granularity - 1);
+        s.view = map_view(f, base, view_bytes(f, s.toc));
+        if (!s.view) { native_set_error("data_map_section: mapping failed"); return FM_E_NOMEM; }
+        s.data = static_cast<const uint8_t*>(s.view) + (s.toc.offset - base);
+    }
+    if (verify && !s.verified) s.verified = crc32c(0, s.data, (size_t)s.toc.size) == s.toc.crc ? 1 : -1;
+    if (verify && s.verified < 0) { native_set_error("data_map_section: checksum mismatch"); return FM_E_UNSPECIFIED; }
+    *out_data = s.data;
+    return FM_OK;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+/*
+    Versioned binary container for large datasets (star catalogs, ephemerides, trajectories).
+    - Layout: a 64-byte header, the sections, then the table of contents (one 64-byte entry
+      per section). Sections start on FW_DATA_ALIGN boundaries and hold records exactly as
+      they go to the GPU or an evaluator, so they are used in place or copied straight into
+      staging memory.
+    - data_open reads nothing but the header and the TOC, and checks their CRC-32C: opening
+      a multi-gigabyte file costs the same as a small one.
+    - Each section is mapped on first data_map_section as its own read-only view; the OS
+      pages it in as it is touched. Its CRC-32C is checked on request, once.
+    - A reader accepts any file with the same major version; minor versions only add fields
+      in reserved space.
+*/
+
+static const char     kDataMagic[8] = { 'F', 'M', 'D', 'A', 'T', 'A', '\r', '\n' };
+static const uint32_t kDataVersion = 1u << 16;   // major << 16 | minor
+
+#pragma pack(push, 1)
+struct DataHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t tocOffset;
+    uint64_t fileSize;
+    uint32_t tocCrc;          // CRC-32C of the TOC entries
+    uint32_t headerCrc;       // CRC-32C of this header with headerCrc = 0
+    uint8_t  reserved[24];
+};
+
+struct DataTocEntry
+{
+    char     name[24];        // NUL-padded
+    uint32_t type;            // caller-defined tag (fourcc)
+    uint32_t elemSize;        // bytes per record, 0 = opaque
+    uint64_t offset;          // multiple of FW_DATA_ALIGN
+    uint64_t size;            // payload bytes
+    uint64_t count;           // records
+    uint32_t crc;             // CRC-32C of the payload
+    uint32_t reserved;
+};
+#pragma pack(pop)
+static_assert(sizeof(DataHeader) == 64 && sizeof(DataTocEntry) == 64, "container layout is fixed");
+
+struct DataSection
+{
+    DataTocEntry   toc{};
+    void*          view = nullptr;     // mapping base (aligned down to the OS granularity)
+    const uint8_t* data = nullptr;     // payload inside the view
+    int            verified = 0;       // 0 not checked, 1 good, -1 checksum mismatch
+};
+
+struct DataFile
+{
+#ifdef _WIN32
+    void*    file = nullptr;           // HANDLE
+    void*    mapping = nullptr;        // HANDLE
+#else
+    int      fd = -1;
+#endif
+    uint64_t size = 0;
+    uint64_t granularity = 4096;       // view offsets must be multiples of this
+
+    std::mutex               lock;     // lazy mapping / verification
+    std::vector<DataSection> sections;
+};
+
+// CRC-32C (Castagnoli), slicing-by-8; crc is the running value (0 to start).
+uint32_t crc32c(uint32_t crc, const void* data, size_t bytes);
+// fopen with a UTF-8 path on every platform.
+std::FILE* fopen_utf8(const char* path, const char* mode);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL data_write(const char* path, const fw_data_section_desc* sections, uint32_t count);
+int  FM_CALL data_open(const char* path, fw_handle* out);
+void FM_CALL data_close(fw_handle file);
+int  FM_CALL data_section_count(fw_handle file);
+int  FM_CALL data_section_info(fw_handle file, uint32_t index, fw_data_section* out);
+int  FM_CALL data_find_section(fw_handle file, const char* name, uint32_t* out_index);
+int  FM_CALL data_map_section(fw_handle file, uint32_t index, uint32_t verify, const void** out_data);
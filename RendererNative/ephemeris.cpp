@@ -0,0 +1,284 @@
+// ephemeris.cpp
+// Chebyshev segment lookup and Clenshaw evaluation (see ephemeris.h)
+
+#include "ephemeris.h"
+#include "data_file.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#   include <emmintrin.h>
+#   define FM_EPHEM_SSE2 1
+#endif
+
+static const uint32_t kEvalGrain = 256;   // bodies per job; even, so pairs never straddle chunks
+
+// One located segment: coefficients and the mapping of t to s in [-1, 1].
+struct EphemSeg
+{
+    const double* c;      // x coefficients; y and z follow at +n and +2n
+    uint32_t      n;
+    double        s;
+    double        invRadius;
+};
+
+static inline const double* record_of(const Ephemeris* e, const fw_ephem_body& b, uint32_t seg)
+{
+    return e->coeffs + b.coeff_offset + (uint64_t)seg * (2 + 3 * (uint64_t)b.coeffs);
+}
+
+static inline double segment_end(const Ephemeris* e, const fw_ephem_body& b, const double* times, uint32_t seg)
+{
+    if (seg + 1 < b.segments) return times[seg + 1];
+    const double* r = record_of(e, b, seg);
+    return r[0] + r[1];
+}
+
+// Segment holding t: the cached one, its successor, else a binary search. The last segment
+// also takes its end time.
+static bool locate(const Ephemeris* e, uint32_t body, double t, EphemSeg& out)
+{
+    const fw_ephem_body& b = e->bodies[body];
+    const double* times = e->times + b.first_segment;
+    std::atomic<uint32_t>& hint = e->lastHit[body];
+
+    uint32_t seg = hint.load(std::memory_order_relaxed);
+    if (!(times[seg] <= t && t < segment_end(e, b, times, seg))) {
+        if (seg + 1 < b.segments && times[seg + 1] <= t && t < segment_end(e, b, times, seg + 1)) {
+            ++seg;
+        }
+        else {
+            if (!(t >= times[0] && t <= segment_end(e, b, times, b.segments - 1))) return false;
+            seg = (uint32_t)(std::upper_bound(times, times + b.segments, t) - times) - 1;
+        }
+        hint.store(seg, std::memory_order_relaxed);
+    }
+
+    const double* r = record_of(e, b, seg);
+    out.c = r + 2;
+    out.n = b.coeffs;
+    out.invRadius = 1.0 / r[1];
+    out.s = (t - r[0]) * out.invRadius;
+    return true;
+}
+
+// ===== Clenshaw =====
+// b_k = c_k + 2s b_{k+1} - b_{k+2} (k = n-1 .. 1), f = c_0 + s b_1 - b_2, and the same
+// recurrence differentiated in s: d_k = 2 b_{k+1} + 2s d_{k+1} - d_{k+2}, f' = b_1 + s d_1 - d_2.
+static void eval_one(const EphemSeg& g, double* pos, double* vel)
+{
+    const double* cx = g.c;
+    const double* cy = cx + g.n;
+    const double* cz = cy + g.n;
+    const double s2 = 2.0 * g.s;
+    double bx1 = 0, bx2 = 0, by1 = 0, by2 = 0, bz1 = 0, bz2 = 0;
+    double dx1 = 0, dx2 = 0, dy1 = 0, dy2 = 0, dz1 = 0, dz2 = 0;
+    for (uint32_t k = g.n - 1; k >= 1; --k) {
+        const double dx0 = 2.0 * bx1 + s2 * dx1 - dx2, bx0 = cx[k] + s2 * bx1 - bx2;
+        const double dy0 = 2.0 * by1 + s2 * dy1 - dy2, by0 = cy[k] + s2 * by1 - by2;
+        const double dz0 = 2.0 * bz1 + s2 * dz1 - dz2, bz0 = cz[k] + s2 * bz1 - bz2;
+        dx2 = dx1; dx1 = dx0; bx2 = bx1; bx1 = bx0;
+        dy2 = dy1; dy1 = dy0; by2 = by1; by1 = by0;
+        dz2 = dz1; dz1 = dz0; bz2 = bz1; bz1 = bz0;
+    }
+    pos[0] = cx[0] + g.s * bx1 - bx2;
+    pos[1] = cy[0] + g.s * by1 - by2;
+    pos[2] = cz[0] + g.s * bz1 - bz2;
+    if (vel) {
+        vel[0] = (bx1 + g.s * dx1 - dx2) * g.invRadius;
+        vel[1] = (by1 + g.s * dy1 - dy2) * g.invRadius;
+        vel[2] = (bz1 + g.s * dz1 - dz2) * g.invRadius;
+    }
+}
+
+#if FM_EPHEM_SSE2
+// Two bodies, one per lane. The shorter series reads as zero above its degree, which leaves
+// its result unchanged.
+static void eval_two(const EphemSeg& a, const EphemSeg& b, double* pa, double* va, double* pb, double* vb)
+{
+    const uint32_t n = std::max(a.n, b.n);
+    const __m128d s = _mm_set_pd(b.s, a.s);
+    const __m128d s2 = _mm_add_pd(s, s);
+    const __m128d zero = _mm_setzero_pd();
+    __m128d b1[3] = { zero, zero, zero }, b2[3] = { zero, zero, zero };
+    __m128d d1[3] = { zero, zero, zero }, d2[3] = { zero, zero, zero };
+
+    for (uint32_t k = n - 1; k >= 1; --k) {
+        for (int j = 0; j < 3; ++j) {
+            const __m128d c = _mm_set_pd(k < b.n ? b.c[j * b.n + k] : 0.0, k < a.n ? a.c[j * a.n + k] : 0.0);
+            const __m128d d0 = _mm_sub_pd(_mm_add_pd(_mm_add_pd(b1[j], b1[j]), _mm_mul_pd(s2, d1[j])), d2[j]);
+            const __m128d b0 = _mm_sub_pd(_mm_add_pd(c, _mm_mul_pd(s2, b1[j])), b2[j]);
+            d2[j] = d1[j]; d1[j] = d0;
+            b2[j] = b1[j]; b1[j] = b0;
+        }
+    }
+
+    alignas(16) double p[2], v[2];
+    const __m128d invR = _mm_set_pd(b.invRadius, a.invRadius);
+    for (int j = 0; j < 3; ++j) {
+        const __m128d c0 = _mm_set_pd(b.c[j * b.n], a.c[j * a.n]);
+        _mm_store_pd(p, _mm_sub_pd(_mm_add_pd(c0, _mm_mul_pd(s, b1[j])), b2[j]));
+        pa[j] = p[0]; pb[j] = p[1];
+        if (va) {
+            _mm_store_pd(v, _mm_mul_pd(_mm_sub_pd(_mm_add_pd(b1[j], _mm_mul_pd(s, d1[j])), d2[j]), invR));
+            va[j] = v[0]; vb[j] = v[1];
+        }
+    }
+}
+#endif
+
+// Evaluates bodies [b, e) of the request; returns how many had no coverage at t.
+static uint32_t eval_range(const Ephemeris* e, double t, const uint32_t* bodies, uint32_t b, uint32_t end,
+    double* pos, double* vel)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    uint32_t missing = 0;
+    EphemSeg pending{};
+    uint32_t pendingIdx = UINT32_MAX;
+
+    for (uint32_t i = b; i < end; ++i) {
+        double* p = pos + 3 * (size_t)i;
+        double* v = vel ? vel + 3 * (size_t)i : nullptr;
+        EphemSeg g;
+        if (!locate(e, bodies[i], t, g)) {
+            p[0] = p[1] = p[2] = nan;
+            if (v) v[0] = v[1] = v[2] = nan;
+            ++missing;
+            continue;
+        }
+#if FM_EPHEM_SSE2
+        if (pendingIdx == UINT32_MAX) { pending = g; pendingIdx = i; continue; }
+        eval_two(pending, g, pos + 3 * (size_t)pendingIdx, vel ? vel + 3 * (size_t)pendingIdx : nullptr, p, v);
+        pendingIdx = UINT32_MAX;
+#else
+        eval_one(g, p, v);
+#endif
+    }
+    if (pendingIdx != UINT32_MAX)
+        eval_one(pending, pos + 3 * (size_t)pendingIdx, vel ? vel + 3 * (size_t)pendingIdx : nullptr);
+    return missing;
+}
+
+// ===== ABI =====
+// Binds to the ephemeris sections of an open data file, which must outlive the handle.
+int FM_CALL ephem_create(fw_handle data_file, uint32_t verify, fw_handle* out)
+{
+    if (!data_file || !out) { native_set_error("ephem_create: null argument"); return FM_E_BADARGS; }
+
+    const char* names[3] = { kEphemBodies, kEphemTimes, kEphemCoeffs };
+    const uint32_t elemSize[3] = { sizeof(fw_ephem_body), sizeof(double), sizeof(double) };
+    const void* data[3] = {};
+    uint64_t count[3] = {};
+    for (int i = 0; i < 3; ++i) {
+        uint32_t idx = 0;
+        fw_data_section info{};
+        const int found = data_find_section(data_file, names[i], &idx);
+        if (found < 0) return found;
+        if (!found) { native_set_error("ephem_create: missing ephem.* section"); return FM_E_BADARGS; }
+        data_section_info(data_file, idx, &info);
+        if (info.elem_size != elemSize[i]) { native_set_error("ephem_create: bad ephem.* record size"); return FM_E_BADARGS; }
+        const int rc = data_map_section(data_file, idx, verify, &data[i]);
+        if (rc != FM_OK) return rc;
+        count[i] = info.count;
+    }
+    if (count[0] > UINT32_MAX) { native_set_error("ephem_create: too many bodies"); return FM_E_BADARGS; }
+
+    const auto* bodies = static_cast<const fw_ephem_body*>(data[0]);
+    for (uint64_t i = 0; i < count[0]; ++i) {
+        const fw_ephem_body& b = bodies[i];
+        const uint64_t stride = 2 + 3 * (uint64_t)b.coeffs;
+        if (b.coeffs < 1 || b.coeffs > kEphemMaxCoeffs || b.segments < 1 ||
+            b.first_segment > count[1] || b.segments > count[1] - b.first_segment ||
+            b.coeff_offset > count[2] || b.segments * stride > count[2] - b.coeff_offset) {
+            native_set_error("ephem_create: body table out of range");
+            return FM_E_BADARGS;
+        }
+        // locate() bisects the start times and divides by the radius: reject tables that
+        // would make either meaningless (NaN fails both tests).
+        const double* times = static_cast<const double*>(data[1]) + b.first_segment;
+        const double* coeffs = static_cast<const double*>(data[2]) + b.coeff_offset;
+        for (uint64_t s = 0; s < b.segments; ++s) {
+            if (!(coeffs[s * stride + 1] > 0)) {
+                native_set_error("ephem_create: segment radius not positive"); return FM_E_BADARGS;
+            }
+            if (s > 0 && !(times[s] > times[s - 1])) {
+                native_set_error("ephem_create: segment start times not increasing"); return FM_E_BADARGS;
+            }
+        }
+    }
+
+    auto* e = new Ephemeris();
+    e->bodies = bodies;
+    e->bodyCount = (uint32_t)count[0];
+    e->times = static_cast<const double*>(data[1]);
+    e->timeCount = count[1];
+    e->coeffs = static_cast<const double*>(data[2]);
+    e->coeffCount = count[2];
+    e->lastHit.reset(new std::atomic<uint32_t>[e->bodyCount ? e->bodyCount : 1]);
+    for (uint32_t i = 0; i < e->bodyCount; ++i) e->lastHit[i].store(0, std::memory_order_relaxed);
+    jobs_acquire();
+    *out = to_handle(e);
+    return FM_OK;
+}
+
+void FM_CALL ephem_destroy(fw_handle eph)
+{
+    auto* e = handle_to<Ephemeris>(eph);
+    if (!e) return;
+    delete e;
+    jobs_release();
+}
+
+int FM_CALL ephem_body_count(fw_handle eph)
+{
+    auto* e = handle_to<Ephemeris>(eph);
+    if (!e) { native_set_error("ephem: null handle"); return FM_E_BADARGS; }
+    return (int)std::min<uint32_t>(e->bodyCount, INT32_MAX);
+}
+
+// Returns 1 with the first body of that id in *out_index, 0 if there is none.
+int FM_CALL ephem_find_body(fw_handle eph, int32_t id, uint32_t* out_index)
+{
+    auto* e = handle_to<Ephemeris>(eph);
+    if (!e || !out_index) { native_set_error("ephem_find_body: null argument"); return FM_E_BADARGS; }
+    for (uint32_t i = 0; i < e->bodyCount; ++i)
+        if (e->bodies[i].id == id) { *out_index = i; return 1; }
+    return 0;
+}
+
+int FM_CALL ephem_coverage(fw_handle eph, uint32_t body, double* out_begin, double* out_end)
+{
+    auto* e = handle_to<Ephemeris>(eph);
+    if (!e || !out_begin || !out_end) { native_set_error("ephem_coverage: null argument"); return FM_E_BADARGS; }
+    if (body >= e->bodyCount) { native_set_error("ephem_coverage: bad body index"); return FM_E_BADARGS; }
+    const fw_ephem_body& b = e->bodies[body];
+    const double* times = e->times + b.first_segment;
+    *out_begin = times[0];
+    *out_end = segment_end(e, b, times, b.segments - 1);
+    return FM_OK;
+}
+
+// Positions (and velocities, if vel_xyz is set) of bodies[i] at t, relative to each body's
+// centre. Bodies without coverage at t get NaN; returns how many there were.
+int FM_CALL ephem_eval(fw_handle eph, double t, const uint32_t* bodies, uint32_t count,
+    double* pos_xyz, double* vel_xyz)
+{
+    auto* e = handle_to<Ephemeris>(eph);
+    if (!e) { native_set_error("ephem_eval: null handle"); return FM_E_BADARGS; }
+    if (count && (!bodies || !pos_xyz)) { native_set_error("ephem_eval: null arrays"); return FM_E_BADARGS; }
+    for (uint32_t i = 0; i < count; ++i)
+        if (bodies[i] >= e->bodyCount) { native_set_error("ephem_eval: bad body index"); return FM_E_BADARGS; }
+
+    if (count < 2 * kEvalGrain || jobs_worker_count() == 0)
+        return (int)eval_range(e, t, bodies, 0, count, pos_xyz, vel_xyz);
+
+    std::atomic<uint32_t> missing{ 0 };
+    parallel_for(count, kEvalGrain, [&](uint32_t b, uint32_t end) {
+        const uint32_t m = eval_range(e, t, bodies, b, end, pos_xyz, vel_xyz);
+        if (m) missing.fetch_add(m, std::memory_order_relaxed);
+        });
+    return (int)std::min<uint32_t>(missing.load(), INT32_MAX);
+}
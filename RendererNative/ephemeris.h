@@ -0,0 +1,47 @@
+#pragma once
+#include "native_common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+    Chebyshev-segment ephemeris (SPK type 2 style) evaluated in place over a data file.
+    - Three container sections: "ephem.bodies" (fw_ephem_body), "ephem.times" (segment start
+      times, increasing per body) and "ephem.coeffs" (per segment: mid, radius, then the x,
+      y and z coefficients). Nothing is copied; create only reads the body table and checks
+      each body's start times (strictly increasing) and segment radii (positive).
+    - A segment is found from the body's last hit (or the one after it, for forward
+      playback) and otherwise by binary search over its start times.
+    - Position and velocity come from one Clenshaw pass over the three components; with SSE2
+      two bodies share the pass, one per lane.
+    - Per-call work allocates nothing; large batches are split over the job system.
+*/
+
+static const char     kEphemBodies[] = "ephem.bodies";
+static const char     kEphemTimes[]  = "ephem.times";
+static const char     kEphemCoeffs[] = "ephem.coeffs";
+static const uint32_t kEphemMaxCoeffs = 64;
+
+struct Ephemeris
+{
+    const fw_ephem_body* bodies = nullptr;
+    uint32_t             bodyCount = 0;
+    const double*        times = nullptr;
+    uint64_t             timeCount = 0;
+    const double*        coeffs = nullptr;
+    uint64_t             coeffCount = 0;
+
+    // Segment of the previous lookup per body. Relaxed atomics: concurrent evaluations only
+    // race on a hint.
+    std::unique_ptr<std::atomic<uint32_t>[]> lastHit;
+};
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL ephem_create(fw_handle data_file, uint32_t verify, fw_handle* out);
+void FM_CALL ephem_destroy(fw_handle eph);
+int  FM_CALL ephem_body_count(fw_handle eph);
+int  FM_CALL ephem_find_body(fw_handle eph, int32_t id, uint32_t* out_index);
+int  FM_CALL ephem_coverage(fw_handle eph, uint32_t body, double* out_begin, double* out_end);
+int  FM_CALL ephem_eval(fw_handle eph, double t, const uint32_t* bodies, uint32_t count,
+    double* pos_xyz, double* vel_xyz);
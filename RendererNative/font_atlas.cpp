@@ -0,0 +1,831 @@
+// font_atlas.cpp
+// TrueType outlines -> MSDF atlas, shelf packing and the on-disk cache (see font_atlas.h)
+
+#include "font_atlas.h"
+#include "data_file.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t kAtlasRevision = 1;      // bump when the generator output changes
+static const double   kPi = 3.14159265358979323846;
+static const double   kCornerCross = 0.14112000805986721;   // sin(3 rad): msdfgen's default
+static const uint32_t kMaxComponentDepth = 8;
+
+static const char kFontInfo[]   = "font.info";
+static const char kFontGlyphs[] = "font.glyphs";
+static const char kFontAtlas[]  = "font.atlas";
+
+// font.info record of the cache file
+struct FontCacheInfo
+{
+    uint32_t key;
+    uint32_t width, height;
+    uint32_t glyphCount;
+    float    emPx, pxRange;
+    float    ascender, descender, lineHeight;
+    uint32_t reserved[7];
+};
+static_assert(sizeof(FontCacheInfo) == 64, "font.info layout is fixed");
+
+// ===== TrueType tables =====
+struct TrueType
+{
+    const uint8_t* d = nullptr;
+    size_t   n = 0;
+    uint32_t glyf = 0, loca = 0, hmtx = 0, cmap = 0;
+    uint32_t glyfLen = 0;
+    uint16_t upem = 0, numGlyphs = 0, numHMetrics = 0;
+    int16_t  locFormat = 0;
+    int16_t  ascender = 0, descender = 0, lineGap = 0;
+    uint16_t cmapFormat = 0;
+};
+
+static inline bool in_range(const TrueType& f, size_t off, size_t len) { return off <= f.n && len <= f.n - off; }
+static inline uint16_t u16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static inline int16_t  i16(const uint8_t* p) { return (int16_t)u16(p); }
+static inline uint32_t u32(const uint8_t* p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+
+static uint32_t find_table(const TrueType& f, uint32_t dir, const char tag[4], uint32_t* len = nullptr)
+{
+    const uint16_t count = u16(f.d + dir + 4);
+    if (!in_range(f, dir + 12, (size_t)count * 16)) return 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint8_t* r = f.d + dir + 12 + 16 * i;
+        if (std::memcmp(r, tag, 4) != 0) continue;
+        const uint32_t off = u32(r + 8), l = u32(r + 12);
+        if (!in_range(f, off, l)) return 0;
+        if (len) *len = l;
+        return off;
+    }
+    return 0;
+}
+
+static const char* parse_font(TrueType& f)
+{
+    if (f.n < 12) return "font: not a TrueType file";
+    uint32_t dir = 0;
+    if (std::memcmp(f.d, "ttcf", 4) == 0) dir = f.n >= 16 ? u32(f.d + 12) : 0;   // first font of a collection
+    if (!in_range(f, dir, 12)) return "font: not a TrueType file";
+    const uint32_t tag = u32(f.d + dir);
+    if (std::memcmp(f.d + dir, "OTTO", 4) == 0) return "font: CFF outlines are not supported";
+    if (tag != 0x00010000u && std::memcmp(f.d + dir, "true", 4) != 0) return "font: not a TrueType file";
+
+    uint32_t headLen = 0, maxpLen = 0, hheaLen = 0, hmtxLen = 0, locaLen = 0, cmapLen = 0;
+    const uint32_t head = find_table(f, dir, "head", &headLen);
+    const uint32_t maxp = find_table(f, dir, "maxp", &maxpLen);
+    const uint32_t hhea = find_table(f, dir, "hhea", &hheaLen);
+    f.hmtx = find_table(f, dir, "hmtx", &hmtxLen);
+    f.loca = find_table(f, dir, "loca", &locaLen);
+    f.glyf = find_table(f, dir, "glyf", &f.glyfLen);
+    f.cmap = find_table(f, dir, "cmap", &cmapLen);
+    if (!head || headLen < 54 || !maxp || maxpLen < 6 || !hhea || hheaLen < 36 || !f.hmtx || !f.loca || !f.glyf || !f.cmap)
+        return "font: missing TrueType table";
+
+    f.upem = u16(f.d + head + 18);
+    f.locFormat = i16(f.d + head + 50);
+    f.numGlyphs = u16(f.d + maxp + 4);
+    f.ascender = i16(f.d + hhea + 4);
+    f.descender = i16(f.d + hhea + 6);
+    f.lineGap = i16(f.d + hhea + 8);
+    f.numHMetrics = u16(f.d + hhea + 34);
+    if (!f.upem || !f.numHMetrics || (size_t)f.numHMetrics * 4 > hmtxLen ||
+        (size_t)(f.numGlyphs + 1) * (f.locFormat ? 4 : 2) > locaLen)
+        return "font: bad head/hhea/loca tables";
+
+    // Unicode cmap: full repertoire (format 12) first, then the BMP (format 4)
+    const uint16_t subtables = u16(f.d + f.cmap + 2);
+    if (!in_range(f, f.cmap + 4, (size_t)subtables * 8)) return "font: bad cmap";
+    uint32_t best = 0;
+    for (uint16_t i = 0; i < subtables; ++i) {
+        const uint8_t* r = f.d + f.cmap + 4 + 8 * i;
+        const uint16_t platform = u16(r), encoding = u16(r + 2);
+        const uint32_t off = f.cmap + u32(r + 4);
+        if (!in_range(f, off, 8)) continue;
+        const uint16_t format = u16(f.d + off);
+        const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode || (format != 4 && format != 12)) continue;
+        if (!in_range(f, off, format == 12 ? 16 : 14)) continue;   // truncated subtable header
+        if (!best || format == 12) { best = off; f.cmapFormat = format; }
+    }
+    if (!best) return "font: no Unicode cmap";
+    f.cmap = best;
+    return nullptr;
+}
+
+static uint32_t glyph_index(const TrueType& f, uint32_t cp)
+{
+    const uint8_t* t = f.d + f.cmap;
+    if (f.cmapFormat == 12) {
+        if (!in_range(f, f.cmap, 16)) return 0;
+        const uint32_t groups = u32(t + 12);
+        if (!in_range(f, f.cmap + 16, (size_t)groups * 12)) return 0;
+        uint32_t lo = 0, hi = groups;
+        while (lo < hi) {
+            const uint32_t mid = (lo + hi) / 2;
+            const uint8_t* g = t + 16 + 12 * mid;
+            if (cp < u32(g)) hi = mid;
+            else if (cp > u32(g + 4)) lo = mid + 1;
+            else return u32(g + 8) + (cp - u32(g));
+        }
+        return 0;
+    }
+    if (cp > 0xFFFF) return 0;
+    const uint16_t segX2 = u16(t + 6);
+    if (!in_range(f, f.cmap + 16, (size_t)segX2 * 4)) return 0;
+    for (uint16_t s = 0; s < segX2; s += 2) {
+        if (cp > u16(t + 14 + s)) continue;
+        const uint16_t start = u16(t + 16 + segX2 + s);
+        if (cp < start) return 0;
+        const uint16_t delta = u16(t + 16 + 2 * segX2 + s);
+        const uint32_t rangePos = f.cmap + 16 + 3 * segX2 + s;
+        const uint16_t range = u16(f.d + rangePos);
+        if (!range) return (cp + delta) & 0xFFFF;
+        const size_t at = rangePos + range + 2 * (size_t)(cp - start);
+        if (!in_range(f, at, 2)) return 0;
+        const uint16_t g = u16(f.d + at);
+        return g ? (g + delta) & 0xFFFF : 0;
+    }
+    return 0;
+}
+
+static float advance_of(const TrueType& f, uint32_t g)
+{
+    const uint32_t m = std::min<uint32_t>(g, f.numHMetrics - 1u);
+    return (float)u16(f.d + f.hmtx + 4 * m) / f.upem;
+}
+
+// ===== outlines =====
+struct Vec2 { double x, y; };
+static inline Vec2 operator+(Vec2 a, Vec2 b) { return { a.x + b.x, a.y + b.y }; }
+static inline Vec2 operator-(Vec2 a, Vec2 b) { return { a.x - b.x, a.y - b.y }; }
+static inline Vec2 operator*(double s, Vec2 a) { return { s * a.x, s * a.y }; }
+static inline double dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+static inline double cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+static inline double length(Vec2 a) { return std::sqrt(dot(a, a)); }
+static inline Vec2 normalize(Vec2 a) { const double l = length(a); return l > 0 ? (1.0 / l) * a : Vec2{ 0, 1 }; }
+
+enum { kRed = 1, kGreen = 2, kBlue = 4, kYellow = 3, kMagenta = 5, kCyan = 6, kWhite = 7 };
+
+struct Edge
+{
+    Vec2    p[3];          // p[2] unused by lines
+    uint8_t quad = 0;
+    uint8_t color = kWhite;
+};
+
+struct Shape
+{
+    std::vector<Edge>     edges;
+    std::vector<uint32_t> contourEnd;    // one past each contour's last edge
+    double xMin = 0, yMin = 0, xMax = 0, yMax = 0;
+};
+
+struct Affine { double a, b, c, d, e, f; };   // x' = a x + c y + e, y' = b x + d y + f
+
+static inline Vec2 apply(const Affine& m, double x, double y)
+{
+    return { m.a * x + m.c * y + m.e, m.b * x + m.d * y + m.f };
+}
+
+static void add_line(Shape& s, Vec2 a, Vec2 b)
+{
+    if (a.x == b.x && a.y == b.y) return;
+    Edge e; e.p[0] = a; e.p[1] = b; e.quad = 0;
+    s.edges.push_back(e);
+}
+
+static void add_quad(Shape& s, Vec2 a, Vec2 c, Vec2 b)
+{
+    if (cross(c - a, b - c) == 0 && dot(c - a, b - c) >= 0) { add_line(s, a, b); return; }
+    Edge e; e.p[0] = a; e.p[1] = c; e.p[2] = b; e.quad = 1;
+    s.edges.push_back(e);
+}
+
+// One contour of on/off-curve points; two off-curve points in a row imply the on-curve
+// midpoint between them.
+static void add_contour(Shape& s, const std::vector<Vec2>& pts, const std::vector<uint8_t>& on, size_t b, size_t e)
+{
+    const size_t n = e - b;
+    if (n < 2) return;
+    size_t first = b;
+    while (first < e && !on[first]) ++first;
+
+    Vec2 start, cur, ctrl{};
+    bool hasCtrl = false;
+    size_t k0, count;
+    if (first == e) {            // no on-curve point at all
+        start = 0.5 * (pts[e - 1] + pts[b]);
+        k0 = 0; count = n;
+    } else {
+        start = pts[first];
+        k0 = first - b + 1; count = n - 1;
+    }
+    cur = start;
+    const size_t edge0 = s.edges.size();
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = b + (k0 + k) % n;
+        if (on[i]) {
+            if (hasCtrl) add_quad(s, cur, ctrl, pts[i]); else add_line(s, cur, pts[i]);
+            cur = pts[i];
+            hasCtrl = false;
+        } else {
+            if (hasCtrl) {
+                const Vec2 mid = 0.5 * (ctrl + pts[i]);
+                add_quad(s, cur, ctrl, mid);
+                cur = mid;
+            }
+            ctrl = pts[i];
+            hasCtrl = true;
+        }
+    }
+    if (hasCtrl) add_quad(s, cur, ctrl, start); else add_line(s, cur, start);
+    if (s.edges.size() > edge0) s.contourEnd.push_back((uint32_t)s.edges.size());
+}
+
+static bool load_glyph(const TrueType& f, uint32_t g, const Affine& m, Shape& s, uint32_t depth)
+{
+    if (g >= f.numGlyphs || depth > kMaxComponentDepth) return false;
+    const uint32_t o0 = f.locFormat ? u32(f.d + f.loca + 4 * g) : 2u * u16(f.d + f.loca + 2 * g);
+    const uint32_t o1 = f.locFormat ? u32(f.d + f.loca + 4 * g + 4) : 2u * u16(f.d + f.loca + 2 * g + 2);
+    if (o1 <= o0) return true;                                   // empty glyph (space)
+    if (o1 > f.glyfLen || o1 - o0 < 10) return false;
+    const uint8_t* p = f.d + f.glyf + o0;
+    const uint8_t* end = f.d + f.glyf + o1;
+    const int16_t contours = i16(p);
+    p += 10;
+
+    if (contours >= 0) {
+        if (p + 2 * contours + 2 > end) return false;
+        std::vector<uint16_t> ends(contours);
+        for (int16_t c = 0; c < contours; ++c) ends[c] = u16(p + 2 * c);
+        const size_t npts = contours ? (size_t)ends[contours - 1] + 1 : 0;
+        p += 2 * contours;
+        p += 2 + u16(p);                                         // instructions
+        if (p > end) return false;
+
+        std::vector<uint8_t> flags(npts);
+        for (size_t i = 0; i < npts;) {
+            if (p >= end) return false;
+            const uint8_t fl = *p++;
+            flags[i++] = fl;
+            if (fl & 8) {
+                if (p >= end) return false;
+                for (uint8_t r = *p++; r && i < npts; --r) flags[i++] = fl;
+            }
+        }
+        std::vector<Vec2> pts(npts);
+        std::vector<uint8_t> on(npts);
+        for (int axis = 0; axis < 2; ++axis) {
+            const uint8_t shortBit = axis ? 4 : 2, sameBit = axis ? 32 : 16;
+            int32_t v = 0;
+            for (size_t i = 0; i < npts; ++i) {
+                if (flags[i] & shortBit) {
+                    if (p + 1 > end) return false;
+                    v += (flags[i] & sameBit) ? *p : -(int32_t)*p;
+                    p += 1;
+                } else if (!(flags[i] & sameBit)) {
+                    if (p + 2 > end) return false;
+                    v += i16(p);
+                    p += 2;
+                }
+                (axis ? pts[i].y : pts[i].x) = v;
+            }
+        }
+        for (size_t i = 0; i < npts; ++i) {
+            pts[i] = apply(m, pts[i].x, pts[i].y);
+            on[i] = flags[i] & 1;
+        }
+        size_t b = 0;
+        for (int16_t c = 0; c < contours; ++c) {
+            const size_t e = (size_t)ends[c] + 1;
+            if (e <= b || e > npts) return false;
+            add_contour(s, pts, on, b, e);
+            b = e;
+        }
+        return true;
+    }
+
+    // Composite: transformed references to other glyphs
+    for (;;) {
+        if (p + 4 > end) return false;
+        const uint16_t fl = u16(p), child = u16(p + 2);
+        p += 4;
+        double dx = 0, dy = 0;
+        if (fl & 1) { if (p + 4 > end) return false; dx = i16(p); dy = i16(p + 2); p += 4; }
+        else        { if (p + 2 > end) return false; dx = (int8_t)p[0]; dy = (int8_t)p[1]; p += 2; }
+        if (!(fl & 2)) dx = dy = 0;                              // point matching: not supported
+        double a = 1, b = 0, c = 0, d = 1;
+        if (fl & 8)         { if (p + 2 > end) return false; a = d = i16(p) / 16384.0; p += 2; }
+        else if (fl & 0x40) { if (p + 4 > end) return false; a = i16(p) / 16384.0; d = i16(p + 2) / 16384.0; p += 4; }
+        else if (fl & 0x80) {
+            if (p + 8 > end) return false;
+            a = i16(p) / 16384.0; b = i16(p + 2) / 16384.0; c = i16(p + 4) / 16384.0; d = i16(p + 6) / 16384.0;
+            p += 8;
+        }
+        const Affine cm{ m.a * a + m.c * b, m.b * a + m.d * b, m.a * c + m.c * d, m.b * c + m.d * d,
+                         m.a * dx + m.c * dy + m.e, m.b * dx + m.d * dy + m.f };
+        if (!load_glyph(f, child, cm, s, depth + 1)) return false;
+        if (!(fl & 0x20)) return true;
+    }
+}
+
+// ===== edge colouring (msdfgen's simple colouring, seed 0) =====
+static Vec2 direction(const Edge& e, double t)
+{
+    if (!e.quad) return e.p[1] - e.p[0];
+    Vec2 v = t <= 0 ? e.p[1] - e.p[0] : e.p[2] - e.p[1];
+    if (v.x == 0 && v.y == 0) v = e.p[2] - e.p[0];
+    return v;
+}
+
+static inline Vec2 point_at(const Edge& e, double t)
+{
+    if (!e.quad) return e.p[0] + t * (e.p[1] - e.p[0]);
+    const double u = 1 - t;
+    return (u * u) * e.p[0] + (2 * u * t) * e.p[1] + (t * t) * e.p[2];
+}
+
+static inline Vec2 end_point(const Edge& e) { return e.quad ? e.p[2] : e.p[1]; }
+
+static Edge sub_edge(const Edge& e, double t0, double t1)
+{
+    Edge r = e;
+    r.p[0] = point_at(e, t0);
+    if (e.quad) {
+        r.p[1] = r.p[0] + (t1 - t0) * ((1 - t0) * (e.p[1] - e.p[0]) + t0 * (e.p[2] - e.p[1]));
+        r.p[2] = point_at(e, t1);
+    } else {
+        r.p[1] = point_at(e, t1);
+    }
+    return r;
+}
+
+static void switch_color(uint8_t& color, uint32_t& seed, uint8_t banned = 0)
+{
+    const uint8_t combined = color & banned;
+    if (combined == kRed || combined == kGreen || combined == kBlue) { color = combined ^ kWhite; return; }
+    if (color == 0 || color == kWhite) {
+        static const uint8_t start[3] = { kCyan, kMagenta, kYellow };
+        color = start[seed % 3];
+        seed /= 3;
+        return;
+    }
+    const int shifted = color << (1 + (seed & 1));
+    color = (uint8_t)((shifted | shifted >> 3) & kWhite);
+    seed >>= 1;
+}
+
+static inline int symmetrical_trichotomy(int position, int n)
+{
+    return (int)(3 + 2.875 * position / (n - 1) - 1.4375 + 0.5) - 3;
+}
+
+static void color_edges(Shape& s)
+{
+    uint32_t seed = 0;
+    std::vector<Edge> out;
+    std::vector<uint32_t> ends;
+    uint32_t b = 0;
+    for (uint32_t ce : s.contourEnd) {
+        std::vector<Edge> c(s.edges.begin() + b, s.edges.begin() + ce);
+        b = ce;
+        const int m = (int)c.size();
+
+        std::vector<int> corners;
+        Vec2 prev = normalize(direction(c[m - 1], 1));
+        for (int i = 0; i < m; ++i) {
+            const Vec2 cur = normalize(direction(c[i], 0));
+            if (dot(prev, cur) <= 0 || std::fabs(cross(prev, cur)) > kCornerCross) corners.push_back(i);
+            prev = normalize(direction(c[i], 1));
+        }
+
+        if (corners.empty()) {
+            for (Edge& e : c) e.color = kWhite;
+        } else if (corners.size() == 1) {
+            // Teardrop: three colour runs around the single corner, splitting short contours
+            uint8_t colors[3] = { kWhite, kWhite, 0 };
+            switch_color(colors[0], seed);
+            colors[2] = colors[0];
+            switch_color(colors[2], seed);
+            const int corner = corners[0];
+            std::vector<Edge> r;
+            if (m >= 3) {
+                for (int i = 0; i < m; ++i) r.push_back(c[(corner + i) % m]);
+            } else {
+                for (int i = 0; i < m; ++i)
+                    for (int k = 0; k < 3; ++k) r.push_back(sub_edge(c[(corner + i) % m], k / 3.0, (k + 1) / 3.0));
+            }
+            const int rn = (int)r.size();
+            for (int i = 0; i < rn; ++i) r[i].color = colors[1 + symmetrical_trichotomy(i, rn)];
+            c.swap(r);
+        } else {
+            const int cornerCount = (int)corners.size();
+            int spline = 0;
+            const int start = corners[0];
+            uint8_t color = kWhite;
+            switch_color(color, seed);
+            const uint8_t initial = color;
+            for (int i = 0; i < m; ++i) {
+                const int index = (start + i) % m;
+                if (spline + 1 < cornerCount && corners[spline + 1] == index) {
+                    ++spline;
+                    switch_color(color, seed, spline == cornerCount - 1 ? initial : 0);
+                }
+                c[index].color = color;
+            }
+        }
+        out.insert(out.end(), c.begin(), c.end());
+        ends.push_back((uint32_t)out.size());
+    }
+    s.edges.swap(out);
+    s.contourEnd.swap(ends);
+}
+
+// ===== distances =====
+struct SignedDist { double d; double dot; };
+static inline bool closer(const SignedDist& a, const SignedDist& b)
+{
+    return std::fabs(a.d) < std::fabs(b.d) || (std::fabs(a.d) == std::fabs(b.d) && a.dot < b.dot);
+}
+static inline double nonzero_sign(double v) { return v > 0 ? 1.0 : -1.0; }
+
+static int solve_quadratic(double x[2], double a, double b, double c)
+{
+    if (a == 0 || std::fabs(b) > 1e12 * std::fabs(a)) {
+        if (b == 0) return 0;
+        x[0] = -c / b;
+        return 1;
+    }
+    double disc = b * b - 4 * a * c;
+    if (disc > 0) {
+        disc = std::sqrt(disc);
+        x[0] = (-b + disc) / (2 * a);
+        x[1] = (-b - disc) / (2 * a);
+        return 2;
+    }
+    if (disc == 0) { x[0] = -b / (2 * a); return 1; }
+    return 0;
+}
+
+static int solve_cubic(double x[3], double a, double b, double c, double d)
+{
+    if (a != 0) {
+        const double bn = b / a;
+        if (std::fabs(bn) < 1e6) {
+            // Normalised x^3 + a x^2 + b x + c
+            const double A = bn, B = c / a, C = d / a;
+            const double a2 = A * A;
+            double q = (a2 - 3 * B) / 9.0;
+            const double r = (A * (2 * a2 - 9 * B) + 27 * C) / 54.0;
+            const double r2 = r * r, q3 = q * q * q;
+            const double a3 = A / 3.0;
+            if (r2 < q3) {
+                const double t = std::acos(std::min(std::max(r / std::sqrt(q3), -1.0), 1.0));
+                q = -2 * std::sqrt(q);
+                x[0] = q * std::cos(t / 3) - a3;
+                x[1] = q * std::cos((t + 2 * kPi) / 3) - a3;
+                x[2] = q * std::cos((t - 2 * kPi) / 3) - a3;
+                return 3;
+            }
+            const double u = (r < 0 ? 1 : -1) * std::pow(std::fabs(r) + std::sqrt(r2 - q3), 1 / 3.0);
+            const double v = u == 0 ? 0 : q / u;
+            x[0] = (u + v) - a3;
+            if (u == v || std::fabs(u - v) < 1e-12 * std::fabs(u + v)) { x[1] = -0.5 * (u + v) - a3; return 2; }
+            return 1;
+        }
+    }
+    return solve_quadratic(x, b, c, d);
+}
+
+// Signed distance from o to the edge (positive on the right of its direction, i.e. inside
+// for TrueType's clockwise outer contours) and the curve parameter of the closest point.
+static SignedDist edge_distance(const Edge& e, Vec2 o, double& param)
+{
+    if (!e.quad) {
+        const Vec2 aq = o - e.p[0], ab = e.p[1] - e.p[0];
+        param = dot(aq, ab) / dot(ab, ab);
+        const Vec2 eq = (param > 0.5 ? e.p[1] : e.p[0]) - o;
+        const double endDist = length(eq);
+        if (param > 0 && param < 1) {
+            const Vec2 ortho = normalize(Vec2{ ab.y, -ab.x });
+            const double od = dot(ortho, aq);
+            if (std::fabs(od) < endDist) return { od, 0 };
+        }
+        return { nonzero_sign(cross(aq, ab)) * endDist, std::fabs(dot(normalize(ab), normalize(eq))) };
+    }
+
+    const Vec2 qa = e.p[0] - o, ab = e.p[1] - e.p[0], br = e.p[2] - e.p[1] - ab;
+    const double a = dot(br, br), b = 3 * dot(ab, br), c = 2 * dot(ab, ab) + dot(qa, br), d = dot(qa, ab);
+    double t[3];
+    const int roots = solve_cubic(t, a, b, c, d);
+
+    Vec2 ep = direction(e, 0);
+    double minDist = nonzero_sign(cross(ep, qa)) * length(qa);
+    param = -dot(qa, ep) / dot(ep, ep);
+    {
+        ep = direction(e, 1);
+        const double dist = length(e.p[2] - o);
+        if (dist < std::fabs(minDist)) {
+            minDist = nonzero_sign(cross(ep, e.p[2] - o)) * dist;
+            param = dot(o - e.p[1], ep) / dot(ep, ep);
+        }
+    }
+    for (int i = 0; i < roots; ++i) {
+        if (!(t[i] > 0 && t[i] < 1)) continue;
+        const Vec2 qe = qa + (2 * t[i]) * ab + (t[i] * t[i]) * br;
+        const double dist = length(qe);
+        if (dist <= std::fabs(minDist)) {
+            minDist = nonzero_sign(cross(ab + t[i] * br, qe)) * dist;
+            param = t[i];
+        }
+    }
+    if (param >= 0 && param <= 1) return { minDist, 0 };
+    if (param < 0.5) return { minDist, std::fabs(dot(normalize(direction(e, 0)), normalize(qa))) };
+    return { minDist, std::fabs(dot(normalize(direction(e, 1)), normalize(e.p[2] - o))) };
+}
+
+// Past an endpoint, the distance to the tangent line extended from it.
+static double pseudo_distance(const Edge& e, Vec2 o, SignedDist sd, double param)
+{
+    if (param < 0) {
+        const Vec2 dir = normalize(direction(e, 0)), aq = o - e.p[0];
+        if (dot(aq, dir) < 0) {
+            const double pd = cross(aq, dir);
+            if (std::fabs(pd) <= std::fabs(sd.d)) return pd;
+        }
+    } else if (param > 1) {
+        const Vec2 dir = normalize(direction(e, 1)), bq = o - end_point(e);
+        if (dot(bq, dir) > 0) {
+            const double pd = cross(bq, dir);
+            if (std::fabs(pd) <= std::fabs(sd.d)) return pd;
+        }
+    }
+    return sd.d;
+}
+
+// Crossings of the horizontal line through y with the outline: x and winding direction.
+static void row_crossings(const Shape& s, double y, std::vector<std::pair<double, int>>& out)
+{
+    out.clear();
+    for (const Edge& e : s.edges) {
+        if (!e.quad) {
+            const double y0 = e.p[0].y, y1 = e.p[1].y;
+            if ((y0 <= y && y < y1) || (y1 <= y && y < y0)) {
+                const double t = (y - y0) / (y1 - y0);
+                out.push_back({ e.p[0].x + t * (e.p[1].x - e.p[0].x), y1 > y0 ? 1 : -1 });
+            }
+            continue;
+        }
+        const double a = e.p[0].y - 2 * e.p[1].y + e.p[2].y, b = 2 * (e.p[1].y - e.p[0].y), c = e.p[0].y - y;
+        double t[2];
+        const int roots = solve_quadratic(t, a, b, c);
+        for (int i = 0; i < roots; ++i) {
+            if (!(t[i] >= 0 && t[i] < 1)) continue;
+            const double dy = 2 * a * t[i] + b;
+            if (dy == 0) continue;
+            out.push_back({ point_at(e, t[i]).x, dy > 0 ? 1 : -1 });
+        }
+    }
+}
+
+static inline uint8_t encode(double d, double scale)
+{
+    const double v = d * scale + 0.5;
+    return (uint8_t)std::lround(std::min(std::max(v, 0.0), 1.0) * 255.0);
+}
+
+// Fills a w x h cell (stride in texels) whose texel (0, 0) is the top-left; font-unit
+// coordinates of texel centres: ox + (i + 0.5) / scale, oy + (h - j - 0.5) / scale.
+static void render_msdf(const Shape& s, uint32_t* dst, uint32_t stride, uint32_t w, uint32_t h,
+    double ox, double oy, double scale, double pxRange)
+{
+    const double enc = scale / pxRange;      // font units -> encoded distance units
+    std::vector<std::pair<double, int>> xs;
+    for (uint32_t j = 0; j < h; ++j) {
+        const double y = oy + (h - j - 0.5) / scale;
+        row_crossings(s, y, xs);
+        for (uint32_t i = 0; i < w; ++i) {
+            const Vec2 o{ ox + (i + 0.5) / scale, y };
+            SignedDist best[3] = { { -HUGE_VAL, 1 }, { -HUGE_VAL, 1 }, { -HUGE_VAL, 1 } };
+            const Edge* bestEdge[3] = {};
+            double bestParam[3] = {};
+            double trueAbs = HUGE_VAL;
+            for (const Edge& e : s.edges) {
+                double param;
+                const SignedDist sd = edge_distance(e, o, param);
+                trueAbs = std::min(trueAbs, std::fabs(sd.d));
+                for (int ch = 0; ch < 3; ++ch)
+                    if ((e.color & (1 << ch)) && closer(sd, best[ch])) { best[ch] = sd; bestEdge[ch] = &e; bestParam[ch] = param; }
+            }
+            int winding = 0;
+            for (const auto& x : xs) if (x.first > o.x) winding += x.second;
+            const double trueDist = winding ? trueAbs : -trueAbs;
+
+            double ch[3];
+            for (int k = 0; k < 3; ++k)
+                ch[k] = bestEdge[k] ? pseudo_distance(*bestEdge[k], o, best[k], bestParam[k]) : trueDist;
+            const double med = std::max(std::min(ch[0], ch[1]), std::min(std::max(ch[0], ch[1]), ch[2]));
+            if ((med > 0) != (winding != 0)) ch[0] = ch[1] = ch[2] = trueDist;
+
+            dst[(size_t)j * stride + i] = (uint32_t)encode(ch[0], enc) | (uint32_t)encode(ch[1], enc) << 8 |
+                (uint32_t)encode(ch[2], enc) << 16 | (uint32_t)encode(trueDist, enc) << 24;
+        }
+    }
+}
+
+// ===== atlas =====
+static void default_codepoints(std::vector<uint32_t>& cps)
+{
+    for (uint32_t c = 0x20; c <= 0x7E; ++c) cps.push_back(c);
+    for (uint32_t c = 0xA0; c <= 0xFF; ++c) cps.push_back(c);
+    for (uint32_t c = 0x391; c <= 0x3A9; ++c) cps.push_back(c);
+    for (uint32_t c = 0x3B1; c <= 0x3C9; ++c) cps.push_back(c);
+}
+
+static void index_ascii(FontAtlas& a)
+{
+    std::fill(a.ascii, a.ascii + 128, UINT32_MAX);
+    for (size_t i = 0; i < a.glyphs.size() && a.glyphs[i].codepoint < 128; ++i) a.ascii[a.glyphs[i].codepoint] = (uint32_t)i;
+}
+
+const FontGlyph* font_find_glyph(const FontAtlas& a, uint32_t codepoint)
+{
+    if (codepoint < 128) return a.ascii[codepoint] != UINT32_MAX ? &a.glyphs[a.ascii[codepoint]] : nullptr;
+    auto it = std::lower_bound(a.glyphs.begin(), a.glyphs.end(), codepoint,
+        [](const FontGlyph& g, uint32_t c) { return g.codepoint < c; });
+    return it != a.glyphs.end() && it->codepoint == codepoint ? &*it : nullptr;
+}
+
+static bool load_cache(const char* path, uint32_t key, FontAtlas& out)
+{
+    if (!path) return false;
+    if (std::FILE* probe = fopen_utf8(path, "rb")) std::fclose(probe);   // no cache yet is not an error
+    else return false;
+    fw_handle f = 0;
+    if (data_open(path, &f) != FM_OK) return false;
+    bool ok = false;
+    uint32_t idx[3];
+    const void* data[3] = {};
+    fw_data_section info[3]{};
+    const char* names[3] = { kFontInfo, kFontGlyphs, kFontAtlas };
+    int found = 0;
+    for (int i = 0; i < 3; ++i)
+        if (data_find_section(f, names[i], &idx[i]) == 1 && data_section_info(f, idx[i], &info[i]) == FM_OK &&
+            data_map_section(f, idx[i], 1, &data[i]) == FM_OK && data[i]) ++found;
+    if (found == 3 && info[0].size == sizeof(FontCacheInfo)) {
+        const auto* fi = static_cast<const FontCacheInfo*>(data[0]);
+        if (fi->key == key && info[1].size == (uint64_t)fi->glyphCount * sizeof(FontGlyph) &&
+            info[2].size == (uint64_t)fi->width * fi->height * 4) {
+            out.width = fi->width; out.height = fi->height;
+            out.emPx = fi->emPx; out.pxRange = fi->pxRange;
+            out.ascender = fi->ascender; out.descender = fi->descender; out.lineHeight = fi->lineHeight;
+            const auto* g = static_cast<const FontGlyph*>(data[1]);
+            out.glyphs.assign(g, g + fi->glyphCount);
+            const auto* px = static_cast<const uint32_t*>(data[2]);
+            out.pixels.assign(px, px + (size_t)fi->width * fi->height);
+            ok = true;
+        }
+    }
+    data_close(f);
+    return ok;
+}
+
+static void store_cache(const char* path, uint32_t key, const FontAtlas& a)
+{
+    FontCacheInfo fi{};
+    fi.key = key;
+    fi.width = a.width; fi.height = a.height;
+    fi.glyphCount = (uint32_t)a.glyphs.size();
+    fi.emPx = a.emPx; fi.pxRange = a.pxRange;
+    fi.ascender = a.ascender; fi.descender = a.descender; fi.lineHeight = a.lineHeight;
+    const fw_data_section_desc sections[3] = {
+        { kFontInfo, &fi, sizeof(fi), 1, 0, sizeof(fi) },
+        { kFontGlyphs, a.glyphs.data(), a.glyphs.size() * sizeof(FontGlyph), a.glyphs.size(), 0, sizeof(FontGlyph) },
+        { kFontAtlas, a.pixels.data(), a.pixels.size() * 4, a.pixels.size(), 0, 4 },
+    };
+    // A cache that cannot be written only costs the next start-up a rebuild.
+    if (data_write(path, sections, 3) != FM_OK) native_log(1, "font: atlas cache not written");
+}
+
+int font_atlas_build(const char* font_path, const char* cache_path, float em_px, float px_range,
+    const uint32_t* codepoints, uint32_t count, FontAtlas& out)
+{
+    std::vector<uint8_t> bytes;
+    {
+        std::FILE* fp = fopen_utf8(font_path, "rb");
+        if (!fp) { native_set_error("font: cannot open font file"); return FM_E_BADARGS; }
+        std::fseek(fp, 0, SEEK_END);
+        const long len = std::ftell(fp);
+        std::fseek(fp, 0, SEEK_SET);
+        bytes.resize(len > 0 ? (size_t)len : 0);
+        const bool ok = len > 0 && std::fread(bytes.data(), 1, bytes.size(), fp) == bytes.size();
+        std::fclose(fp);
+        if (!ok) { native_set_error("font: cannot read font file"); return FM_E_BADARGS; }
+    }
+
+    std::vector<uint32_t> cps;
+    if (codepoints) cps.assign(codepoints, codepoints + count);
+    else default_codepoints(cps);
+    std::sort(cps.begin(), cps.end());
+    cps.erase(std::unique(cps.begin(), cps.end()), cps.end());
+
+    const float params[2] = { em_px, px_range };
+    uint32_t key = crc32c(0, bytes.data(), bytes.size());
+    key = crc32c(key, params, sizeof(params));
+    key = crc32c(key, &kAtlasRevision, sizeof(kAtlasRevision));
+    key = crc32c(key, cps.data(), cps.size() * sizeof(uint32_t));
+
+    out = FontAtlas();
+    if (load_cache(cache_path, key, out)) { index_ascii(out); return FM_OK; }
+
+    TrueType f;
+    f.d = bytes.data();
+    f.n = bytes.size();
+    if (const char* why = parse_font(f)) { native_set_error(why); return FM_E_UNSUPPORTED; }
+
+    const double scale = em_px / f.upem;                  // atlas pixels per font unit
+    const uint32_t pad = (uint32_t)std::ceil(px_range * 0.5f) + 1;
+
+    // Outlines and cell sizes
+    struct Item { Shape shape; uint32_t w = 0, h = 0, x = 0, y = 0; uint32_t gid = 0; };
+    std::vector<Item> items;
+    items.reserve(cps.size());
+    out.glyphs.reserve(cps.size());
+    for (uint32_t cp : cps) {
+        const uint32_t gid = glyph_index(f, cp);
+        if (!gid && cp != 0x20) continue;
+        Item it;
+        it.gid = gid;
+        if (!load_glyph(f, gid, Affine{ 1, 0, 0, 1, 0, 0 }, it.shape, 0)) continue;
+        if (!it.shape.edges.empty()) {
+            Shape& s = it.shape;
+            s.xMin = s.yMin = HUGE_VAL; s.xMax = s.yMax = -HUGE_VAL;
+            for (const Edge& e : s.edges)
+                for (int k = 0; k < (e.quad ? 3 : 2); ++k) {
+                    s.xMin = std::min(s.xMin, e.p[k].x); s.xMax = std::max(s.xMax, e.p[k].x);
+                    s.yMin = std::min(s.yMin, e.p[k].y); s.yMax = std::max(s.yMax, e.p[k].y);
+                }
+            it.w = (uint32_t)std::ceil((s.xMax - s.xMin) * scale) + 2 * pad;
+            it.h = (uint32_t)std::ceil((s.yMax - s.yMin) * scale) + 2 * pad;
+            color_edges(s);
+        }
+        FontGlyph g{};
+        g.codepoint = cp;
+        g.advance = advance_of(f, gid);
+        out.glyphs.push_back(g);
+        items.push_back(std::move(it));
+    }
+
+    // Shelf packing, tallest first, one texel of gutter
+    std::vector<uint32_t> order(items.size());
+    uint64_t area = 0;
+    for (uint32_t i = 0; i < order.size(); ++i) { order[i] = i; area += (uint64_t)(items[i].w + 1) * (items[i].h + 1); }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return items[a].h > items[b].h; });
+    uint32_t width = 256;
+    while (width < 4096 && (uint64_t)width * width < area * 5 / 4) width *= 2;
+    uint32_t x = 1, y = 1, shelf = 0;
+    for (uint32_t i : order) {
+        Item& it = items[i];
+        if (!it.w) continue;
+        if (x + it.w + 1 > width) { x = 1; y += shelf + 1; shelf = 0; }
+        it.x = x; it.y = y;
+        x += it.w + 1;
+        shelf = std::max(shelf, it.h);
+    }
+    const uint32_t height = (y + shelf + 1 + 3) & ~3u;
+    if (width * (uint64_t)height > 4096ull * 4096ull || !width || !height) { native_set_error("font: atlas too large"); return FM_E_BADARGS; }
+
+    out.width = width;
+    out.height = height;
+    out.emPx = em_px;
+    out.pxRange = px_range;
+    out.ascender = (float)f.ascender / f.upem;
+    out.descender = (float)f.descender / f.upem;
+    out.lineHeight = (float)(f.ascender - f.descender + f.lineGap) / f.upem;
+    out.pixels.assign((size_t)width * height, 0u);
+
+    parallel_for((uint32_t)items.size(), 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            const Item& it = items[i];
+            FontGlyph& g = out.glyphs[i];
+            if (!it.w) continue;
+            const double ox = it.shape.xMin - pad / scale, oy = it.shape.yMin - pad / scale;
+            render_msdf(it.shape, &out.pixels[(size_t)it.y * width + it.x], width, it.w, it.h, ox, oy, scale, px_range);
+            g.plane[0] = (float)(ox / f.upem);
+            g.plane[1] = (float)(oy / f.upem);
+            g.plane[2] = (float)((ox + it.w / scale) / f.upem);
+            g.plane[3] = (float)((oy + it.h / scale) / f.upem);
+            g.uv[0] = (float)it.x / width;
+            g.uv[1] = (float)(it.y + it.h) / height;
+            g.uv[2] = (float)(it.x + it.w) / width;
+            g.uv[3] = (float)it.y / height;
+        }
+        });
+
+    index_ascii(out);
+    if (cache_path) store_cache(cache_path, key, out);
+    return FM_OK;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Multi-channel signed distance field (MSDF) glyph atlas from a TrueType font.
+    - Outlines come straight from the glyf table (simple and composite glyphs, quadratic
+      contours); CFF-flavoured OpenType fonts are not supported.
+    - Edges are coloured so that corners separate channels (msdfgen's simple colouring); each
+      channel holds the pseudo-distance to its nearest edge, and alpha the true distance.
+      Texels whose median disagrees with the nonzero-winding inside test fall back to the
+      true distance, which removes the usual interior artefacts.
+    - Glyphs are shelf-packed and generated in parallel. The result is cached in a data file
+      (font.info / font.glyphs / font.atlas) keyed on the font bytes and the parameters, so
+      later runs only map and copy it.
+*/
+
+struct FontGlyph
+{
+    uint32_t codepoint;
+    float    advance;        // em
+    float    plane[4];       // quad l, b, r, t: em from the pen position on the baseline
+    float    uv[4];          // u, v of the (l, b) and (r, t) corners, v down
+};
+
+struct FontAtlas
+{
+    uint32_t width = 0, height = 0;
+    float    emPx = 0.0f;          // atlas pixels per em
+    float    pxRange = 0.0f;       // distance range, atlas pixels
+    float    ascender = 0.0f;      // em
+    float    descender = 0.0f;     // em, negative
+    float    lineHeight = 0.0f;    // em
+    std::vector<FontGlyph> glyphs;    // sorted by codepoint
+    std::vector<uint32_t>  pixels;    // RGBA8, row-major from the top
+    uint32_t ascii[128];              // glyph index per ASCII codepoint, UINT32_MAX if absent
+};
+
+// Loads cache_path when it matches the font and parameters, otherwise builds the atlas and
+// (if cache_path is set) writes it. codepoints == null picks ASCII, Latin-1 and Greek.
+// Returns FM_OK or an FM_E_* code with the error set.
+int font_atlas_build(const char* font_path, const char* cache_path, float em_px, float px_range,
+    const uint32_t* codepoints, uint32_t count, FontAtlas& out);
+
+// Glyph for a codepoint, or null.
+const FontGlyph* font_find_glyph(const FontAtlas& a, uint32_t codepoint);
@@ -0,0 +1,133 @@
+// grid_pass.cpp
+// Analytic reference grid drawn from a single quad (see grid_pass.h)
+
+#include "grid_pass.h"
+#include "native_common.h"
+
+#include <cmath>
+#include <cstring>
+
+static const uint32_t VS_GRID_SPV[] = {
+#   include "shaders/vs_grid.spv.inc"
+};
+static const uint32_t FS_GRID_SPV[] = {
+#   include "shaders/fs_grid.spv.inc"
+};
+static_assert((sizeof(VS_GRID_SPV) % 4) == 0, "VS_GRID_SPV must be dword aligned");
+static_assert((sizeof(FS_GRID_SPV) % 4) == 0, "FS_GRID_SPV must be dword aligned");
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, GridPass* g)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0; pcr.size = sizeof(GridPush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &g->layout) != VK_SUCCESS) return false;
+
+    // No vertex input: the quad corners come from gl_VertexIndex.
+    GfxPipelineDesc pd{};
+    pd.vs = VS_GRID_SPV; pd.vsBytes = sizeof(VS_GRID_SPV);
+    pd.fs = FS_GRID_SPV; pd.fsBytes = sizeof(FS_GRID_SPV);
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    pd.blend = BLEND_ALPHA;
+    pd.layout = g->layout;
+    return create_graphics_pipeline(d, pd, &g->pipe);
+}
+
+void grid_release(Device* d)
+{
+    GridPass* g = d->grid;
+    if (!g) return;
+    destroy_graphics_pipeline(d, &g->pipe);
+    if (g->layout) vkDestroyPipelineLayout(d->device, g->layout, nullptr);
+    delete g;
+    d->grid = nullptr;
+}
+
+// ===== frame hook =====
+void grid_record_draw(Device* d, VkCommandBuffer cb)
+{
+    GridPass* g = d->grid;
+    if (!g || !g->enabled) return;
+
+    // Centre the quad on the camera origin's projection onto the plane, snapped to the major
+    // spacing so line phase is preserved. Done in double: only the small camera-relative
+    // offset reaches the shader.
+    const double major = g->spacing * g->majorEvery;
+    const double rel[3]{ d->origin[0] - g->origin[0], d->origin[1] - g->origin[1], d->origin[2] - g->origin[2] };
+    const double su = std::floor((rel[0] * g->u[0] + rel[1] * g->u[1] + rel[2] * g->u[2]) / major + 0.5) * major;
+    const double sv = std::floor((rel[0] * g->v[0] + rel[1] * g->v[1] + rel[2] * g->v[2]) / major + 0.5) * major;
+
+    GridPush gp{};
+    std::memcpy(gp.viewProj, d->viewProj, sizeof(gp.viewProj));
+    for (int k = 0; k < 3; ++k) {
+        gp.anchor[k] = (float)(g->origin[k] + su * g->u[k] + sv * g->v[k] - d->origin[k]);
+        gp.axisU[k] = (float)(g->u[k] * g->extent);
+        gp.axisV[k] = (float)(g->v[k] * g->extent);
+    }
+    gp.anchor[3] = (float)g->spacing;
+    gp.axisU[3] = (float)g->majorEvery;
+    gp.axisV[3] = g->lineWidth;
+    std::memcpy(gp.color, g->color, sizeof(gp.color));
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, g->pipe);
+    vkCmdPushConstants(cb, g->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(GridPush), &gp);
+    vkCmdDraw(cb, 4, 1, 0, 0);
+}
+
+// ===== ABI =====
+static bool normalize3(const double* in, double* out)
+{
+    const double l = std::sqrt(in[0] * in[0] + in[1] * in[1] + in[2] * in[2]);
+    if (!(l > 0)) return false;
+    out[0] = in[0] / l; out[1] = in[1] / l; out[2] = in[2] / l;
+    return true;
+}
+
+// desc == NULL hides the grid. Zero axes select the ecliptic (world XY) plane.
+int FM_CALL grid_set(fw_handle dev, const fw_grid_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("grid_set: null device"); return FM_E_BADARGS; }
+    if (!desc) { if (d->grid) d->grid->enabled = false; return FM_OK; }
+    if (!(desc->spacing > 0) || !(desc->extent > 0)) {
+        native_set_error("grid_set: spacing and extent must be > 0"); return FM_E_BADARGS;
+    }
+
+    double u[3]{ 1,0,0 }, v[3]{ 0,1,0 };
+    const bool hasU = desc->axis_u[0] != 0 || desc->axis_u[1] != 0 || desc->axis_u[2] != 0;
+    const bool hasV = desc->axis_v[0] != 0 || desc->axis_v[1] != 0 || desc->axis_v[2] != 0;
+    if (hasU || hasV) {
+        // Gram-Schmidt so a slightly skewed pair still gives square cells
+        if (!normalize3(desc->axis_u, u)) { native_set_error("grid_set: degenerate axis_u"); return FM_E_BADARGS; }
+        const double dp = desc->axis_v[0] * u[0] + desc->axis_v[1] * u[1] + desc->axis_v[2] * u[2];
+        const double w[3]{ desc->axis_v[0] - dp * u[0], desc->axis_v[1] - dp * u[1], desc->axis_v[2] - dp * u[2] };
+        if (!normalize3(w, v)) { native_set_error("grid_set: axis_v parallel to axis_u"); return FM_E_BADARGS; }
+    }
+
+    if (!d->grid) {
+        auto* g = new GridPass();
+        d->grid = g;
+        if (!create_objects(d, g)) {
+            grid_release(d);
+            native_set_error("grid_set: pipeline creation failed");
+            return FM_E_DEVICE;
+        }
+    }
+
+    GridPass* g = d->grid;
+    std::memcpy(g->origin, desc->origin, sizeof(g->origin));
+    std::memcpy(g->u, u, sizeof(u));
+    std::memcpy(g->v, v, sizeof(v));
+    g->spacing = desc->spacing;
+    g->extent = desc->extent;
+    g->majorEvery = desc->major_every ? desc->major_every : 1;
+    g->lineWidth = desc->line_width > 0 ? desc->line_width : 1.0f;
+    std::memcpy(g->color, desc->color, sizeof(g->color));
+    g->enabled = true;
+    return FM_OK;
+}
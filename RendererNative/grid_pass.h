@@ -0,0 +1,45 @@
+#pragma once
+#include "renderer_device.h"
+
+/*
+    Procedural reference grid (e.g. the ecliptic plane).
+    - One quad on the plane, centred under the camera origin; the fragment shader finds the
+      distance to the nearest minor/major line from the interpolated plane coordinates and
+      antialiases it with screen-space derivatives, so there is no per-line vertex data.
+    - Minor lines fade out as their screen spacing drops below a few pixels and everything
+      fades radially towards the quad edge, so the extent reads as infinite.
+*/
+
+struct GridPass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    bool     enabled = false;
+    double   origin[3]{ 0,0,0 };
+    double   u[3]{ 1,0,0 };            // orthonormal in-plane axes
+    double   v[3]{ 0,1,0 };
+    double   spacing = 1.0;
+    double   extent = 1.0;
+    uint32_t majorEvery = 10;
+    float    lineWidth = 1.0f;
+    float    color[4]{ 1,1,1,1 };
+};
+
+// Push block of vs_grid.vert / fs_grid.frag (128 bytes, the guaranteed minimum)
+struct GridPush
+{
+    float viewProj[16];
+    float anchor[4];   // xyz quad centre relative to the camera origin, w minor spacing
+    float axisU[4];    // xyz u * extent, w major_every
+    float axisV[4];    // xyz v * extent, w line width in pixels
+    float color[4];
+};
+static_assert(sizeof(GridPush) <= 128, "GridPush exceeds the guaranteed push constant size");
+
+// Frame hooks (renderer_api.cpp)
+void grid_record_draw(Device* d, VkCommandBuffer cb);
+void grid_release(Device* d);
+
+// ABI entry point (see fw_renderer_api)
+int  FM_CALL grid_set(fw_handle dev, const fw_grid_desc* desc);
@@ -0,0 +1,254 @@
+// job_system.cpp
+// Work-stealing thread pool shared by every native feature (see job_system.h)
+
+#include "job_system.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ===== pool state =====
+struct Job
+{
+    job_fn      fn = nullptr;
+    void*       user = nullptr;
+    uint32_t    begin = 0;
+    uint32_t    end = 0;
+    JobCounter* counter = nullptr;
+};
+
+struct WorkerQueue
+{
+    std::mutex      m;
+    std::deque<Job> q;
+};
+
+struct JobPool
+{
+    uint32_t                       count = 0;
+    std::unique_ptr<WorkerQueue[]> queues;
+    std::vector<std::thread>       threads;
+
+    std::atomic<uint32_t>   queued{ 0 };
+    std::atomic<bool>       quit{ false };
+    std::mutex              sleepM;
+    std::condition_variable sleepCv;
+};
+
+static std::mutex             g_pool_mutex;
+static std::atomic<JobPool*>  g_pool{ nullptr };
+static uint32_t               g_refs = 0;
+static uint32_t               g_cfg_workers = 0;
+static uint64_t               g_cfg_mask = 0;
+
+// Index of the worker owning this thread; UINT32_MAX on external threads.
+static thread_local uint32_t  t_worker = UINT32_MAX;
+
+// ===== queue ops =====
+static void push_job(JobPool* p, uint32_t slot, const Job& j)
+{
+    WorkerQueue& wq = p->queues[slot % p->count];
+    {
+        std::lock_guard<std::mutex> lk(wq.m);
+        wq.q.push_back(j);
+    }
+    p->queued.fetch_add(1, std::memory_order_release);
+}
+
+static void wake_workers(JobPool* p, bool all)
+{
+    // Taking sleepM orders this wake after any worker's predicate check, so none can miss it.
+    { std::lock_guard<std::mutex> lk(p->sleepM); }
+    if (all) p->sleepCv.notify_all(); else p->sleepCv.notify_one();
+}
+
+// Own deque from the back (hot in cache), other deques from the front (oldest, largest work).
+static bool take_job(JobPool* p, uint32_t self, Job& out)
+{
+    if (p->queued.load(std::memory_order_acquire) == 0) return false;
+
+    if (self < p->count) {
+        WorkerQueue& wq = p->queues[self];
+        std::lock_guard<std::mutex> lk(wq.m);
+        if (!wq.q.empty()) {
+            out = wq.q.back(); wq.q.pop_back();
+            p->queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    uint32_t start = (self < p->count) ? self + 1 : 0;
+    for (uint32_t k = 0; k < p->count; ++k) {
+        uint32_t v = (start + k) % p->count;
+        if (v == self) continue;
+        WorkerQueue& wq = p->queues[v];
+        std::unique_lock<std::mutex> lk(wq.m, std::try_to_lock);
+        if (!lk.owns_lock() || wq.q.empty()) continue;
+        out = wq.q.front(); wq.q.pop_front();
+        p->queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+static void run_job(const Job& j)
+{
+    j.fn(j.user, j.begin, j.end);
+    if (j.counter) j.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+static void worker_main(JobPool* p, uint32_t self)
+{
+    t_worker = self;
+    Job j;
+    while (!p->quit.load(std::memory_order_acquire)) {
+        if (take_job(p, self, j)) { run_job(j); continue; }
+
+        std::unique_lock<std::mutex> lk(p->sleepM);
+        p->sleepCv.wait(lk, [p] {
+            return p->quit.load(std::memory_order_acquire) ||
+                p->queued.load(std::memory_order_acquire) != 0;
+            });
+    }
+    t_worker = UINT32_MAX;
+}
+
+static void pin_thread(std::thread& t, uint64_t mask, uint32_t index)
+{
+#ifdef _WIN32
+    if (!mask) return;
+    uint32_t bits = 0;
+    for (uint64_t m = mask; m; m &= m - 1) ++bits;
+    uint32_t want = index % bits;
+    for (uint32_t b = 0; b < 64; ++b) {
+        if (!(mask & (uint64_t{ 1 } << b))) continue;
+        if (want-- == 0) {
+            SetThreadAffinityMask((HANDLE)t.native_handle(), (DWORD_PTR)(uint64_t{ 1 } << b));
+            return;
+        }
+    }
+#else
+    (void)t; (void)mask; (void)index;
+#endif
+}
+
+static JobPool* start_pool(uint32_t workers, uint64_t mask)
+{
+    if (workers == 0) {
+        uint32_t hw = std::thread::hardware_concurrency();
+        workers = hw > 1 ? hw - 1 : 1;
+    }
+
+    auto* p = new JobPool();
+    p->count = workers;
+    p->queues.reset(new WorkerQueue[workers]);
+    p->threads.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i) {
+        p->threads.emplace_back(worker_main, p, i);
+        pin_thread(p->threads.back(), mask, i);
+    }
+    return p;
+}
+
+static void stop_pool(JobPool* p)
+{
+    p->quit.store(true, std::memory_order_release);
+    wake_workers(p, true);
+    for (auto& t : p->threads) if (t.joinable()) t.join();
+    delete p;
+}
+
+// ===== public surface =====
+void jobs_acquire()
+{
+    std::lock_guard<std::mutex> lk(g_pool_mutex);
+    if (g_refs++ == 0)
+        g_pool.store(start_pool(g_cfg_workers, g_cfg_mask), std::memory_order_release);
+}
+
+void jobs_release()
+{
+    std::lock_guard<std::mutex> lk(g_pool_mutex);
+    if (g_refs == 0) return;
+    if (--g_refs == 0) {
+        JobPool* p = g_pool.exchange(nullptr, std::memory_order_acq_rel);
+        if (p) stop_pool(p);
+    }
+}
+
+// A running pool is never swapped: callers hold its raw pointer (parallel_for, wait, the
+// keyframe prefill thread) and queued jobs would be dropped with their counters pending.
+int jobs_configure(uint32_t worker_count, uint64_t affinity_mask)
+{
+    std::lock_guard<std::mutex> lk(g_pool_mutex);
+    if (g_refs) return -1;
+    g_cfg_workers = worker_count;
+    g_cfg_mask = affinity_mask;
+    return 0;
+}
+
+uint32_t jobs_worker_count()
+{
+    JobPool* p = g_pool.load(std::memory_order_acquire);
+    return p ? p->count : 0;
+}
+
+void jobs_submit(job_fn fn, void* user, uint32_t begin, uint32_t end,
+    JobCounter* counter, uint32_t affinity_hint)
+{
+    if (!fn) return;
+    if (counter) counter->pending.fetch_add(1, std::memory_order_acq_rel);
+
+    JobPool* p = g_pool.load(std::memory_order_acquire);
+    Job j{ fn, user, begin, end, counter };
+    if (!p) { run_job(j); return; }
+
+    push_job(p, affinity_hint, j);
+    wake_workers(p, false);
+}
+
+void jobs_wait(JobCounter* counter)
+{
+    if (!counter) return;
+    JobPool* p = g_pool.load(std::memory_order_acquire);
+
+    Job j;
+    while (counter->pending.load(std::memory_order_acquire) != 0) {
+        if (p && take_job(p, t_worker, j)) run_job(j);
+        else std::this_thread::yield();
+    }
+}
+
+void jobs_parallel_for(uint32_t count, uint32_t grain, job_fn fn, void* user)
+{
+    if (!fn || count == 0) return;
+    if (grain == 0) grain = 1;
+
+    JobPool* p = g_pool.load(std::memory_order_acquire);
+    if (!p || count <= grain) { fn(user, 0, count); return; }
+
+    uint32_t chunks = (count + grain - 1) / grain;
+    JobCounter c;
+    c.pending.store(chunks, std::memory_order_relaxed);
+
+    for (uint32_t i = 0; i < chunks; ++i) {
+        uint32_t b = i * grain;
+        uint32_t e = (count - b > grain) ? b + grain : count;
+        push_job(p, i, Job{ fn, user, b, e, &c });
+    }
+    wake_workers(p, true);
+    jobs_wait(&c);
+}
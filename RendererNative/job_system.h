@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/*
+    Shared work-stealing scheduler for RendererNative.
+    - One pool per process, refcounted by the modules that want worker threads.
+    - Each worker owns a deque: it pops its own work LIFO and steals FIFO from others.
+    - Callers that wait on a counter help execute queued jobs instead of blocking.
+    - With no pool running every entry point degrades to inline execution.
+*/
+
+typedef void (*job_fn)(void* user, uint32_t begin, uint32_t end);
+
+struct JobCounter
+{
+    std::atomic<uint32_t> pending{ 0 };
+};
+
+// Pool lifetime. Release only once no jobs are in flight.
+void     jobs_acquire();
+void     jobs_release();
+
+// worker_count == 0 picks hardware_concurrency - 1. affinity_mask == 0 leaves threads unpinned;
+// otherwise worker i is pinned to the i-th set bit (wrapping). Applied when the pool next
+// starts; returns -1 and changes nothing while it is running (any acquire outstanding).
+int      jobs_configure(uint32_t worker_count, uint64_t affinity_mask);
+uint32_t jobs_worker_count();
+
+// affinity_hint selects the worker deque the job is pushed to (modulo worker count).
+void     jobs_submit(job_fn fn, void* user, uint32_t begin, uint32_t end,
+    JobCounter* counter, uint32_t affinity_hint);
+void     jobs_wait(JobCounter* counter);
+
+// Splits [0,count) into chunks of `grain`; chunk i always lands on worker i % N so repeated
+// passes over the same arrays tend to stay on the same cores. Returns when all chunks ran.
+void     jobs_parallel_for(uint32_t count, uint32_t grain, job_fn fn, void* user);
+
+template <class F>
+inline void parallel_for(uint32_t count, uint32_t grain, F&& f)
+{
+    using Fn = typename std::remove_reference<F>::type;
+    struct Thunk {
+        static void run(void* u, uint32_t b, uint32_t e) { (*static_cast<Fn*>(u))(b, e); }
+    };
+    jobs_parallel_for(count, grain, &Thunk::run, (void*)&f);
+}
@@ -0,0 +1,375 @@
+// keyframe_cache.cpp
+// Keyframed N-body timeline: LRU store, seek-and-replay, prefill thread (see keyframe_cache.h)
+
+#include "keyframe_cache.h"
+#include "sim_clock.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint64_t kDefaultBudget = 256ull << 20;
+static const size_t   kMaxSpare = 2;
+
+// ===== state copies =====
+static void capture_state(const NBody* s, std::vector<double>& dst)
+{
+    const size_t n = s->n;
+    const std::vector<double>* src[6] = { &s->x, &s->y, &s->z, &s->vx, &s->vy, &s->vz };
+    dst.resize(n * 6);
+    for (int a = 0; a < 6; ++a) std::memcpy(dst.data() + a * n, src[a]->data(), n * sizeof(double));
+}
+
+static void restore_state(const std::vector<double>& src, NBody* s)
+{
+    const size_t n = s->n;
+    std::vector<double>* dst[6] = { &s->x, &s->y, &s->z, &s->vx, &s->vy, &s->vz };
+    for (int a = 0; a < 6; ++a) std::memcpy(dst[a]->data(), src.data() + a * n, n * sizeof(double));
+    s->accValid = false;
+}
+
+// ===== store (lock held) =====
+static std::vector<double> take_buffer(KeyframeCache* k)
+{
+    if (k->spare.empty()) return {};
+    std::vector<double> v = std::move(k->spare.back());
+    k->spare.pop_back();
+    return v;
+}
+
+static void recycle(KeyframeCache* k, std::vector<double>&& v)
+{
+    if (k->spare.size() < kMaxSpare) k->spare.push_back(std::move(v));
+}
+
+static void touch(KeyframeCache* k, int64_t index)
+{
+    k->lastUse[index] = ++k->tick;
+}
+
+// Least recently used first; keyframe 0 anchors every replay and stays.
+static void evict(KeyframeCache* k)
+{
+    const uint64_t frameBytes = (uint64_t)k->n * 6 * sizeof(double);
+    while (k->frames.size() > 1 && k->frames.size() * frameBytes > k->budget) {
+        int64_t victim = -1;
+        uint64_t oldest = UINT64_MAX;
+        for (const auto& u : k->lastUse)
+            if (u.first != 0 && u.second < oldest) { oldest = u.second; victim = u.first; }
+        auto it = k->frames.find(victim);
+        recycle(k, std::move(it->second));
+        k->frames.erase(it);
+        k->lastUse.erase(victim);
+        ++k->stats.evicted;
+    }
+}
+
+static void insert(KeyframeCache* k, int64_t index, std::vector<double>&& state)
+{
+    auto it = k->frames.find(index);
+    if (it != k->frames.end()) recycle(k, std::move(state));
+    else k->frames.emplace(index, std::move(state));
+    touch(k, index);
+    evict(k);
+}
+
+// The timeline is only valid for the sim it was computed from.
+static bool anchor_matches(const KeyframeCache* k)
+{
+    const SimClock* c = k->clock;
+    const NBody* s = c->body;
+    return !k->frames.empty() && s->n == k->n && s->G == k->G && s->eps2 == k->eps2 &&
+        s->theta == k->theta && s->mode == k->mode && c->fixedDt == k->dt && c->substeps == k->substeps;
+}
+
+// Re-anchors keyframe 0 at the clock's current state. Needs clock and body.
+static void reset_anchor(KeyframeCache* k)
+{
+    SimClock* c = k->clock;
+    const NBody* s = c->body;
+    for (auto& f : k->frames) recycle(k, std::move(f.second));
+    k->frames.clear();
+    k->lastUse.clear();
+
+    k->n = s->n;
+    k->mass.assign(s->m.begin(), s->m.begin() + s->n);
+    k->G = s->G; k->eps2 = s->eps2; k->theta = s->theta; k->mode = s->mode;
+    k->dt = c->fixedDt;
+    k->substeps = c->substeps;
+    k->originStep = c->step;
+    k->originTime = c->simTime;
+    k->originBodyTime = s->time;
+
+    ++k->epoch;
+    k->generation.fetch_add(1);
+    k->cursor = 0;
+    k->want = -1;
+    k->direction = 1;
+
+    std::vector<double> buf = take_buffer(k);
+    capture_state(s, buf);
+    insert(k, 0, std::move(buf));
+    k->pending = true;
+}
+
+// Caches the body state as keyframe `index` unless it is there already.
+static void store_if_missing(KeyframeCache* k, int64_t index, const NBody* s)
+{
+    std::vector<double> buf;
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        if (k->frames.count(index)) { touch(k, index); return; }
+        buf = take_buffer(k);
+    }
+    capture_state(s, buf);
+    std::lock_guard<std::mutex> lk(k->lock);
+    insert(k, index, std::move(buf));
+}
+
+// ===== prefill thread =====
+static void prefill_main(KeyframeCache* k)
+{
+    std::vector<double> buf;
+    NBody& w = k->worker;
+    std::unique_lock<std::mutex> lk(k->lock);
+    for (;;) {
+        k->wake.wait(lk, [k] { return k->stop || k->pending; });
+        if (k->stop) return;
+
+        // The keyframe a capped seek is waiting for comes first. Otherwise: the window of
+        // keyframes in the playback direction, kept within the budget. Backwards it stops
+        // short of the cursor's own keyframe, which the seek itself fills.
+        int64_t target = -1;
+        if (k->want >= 0 && k->frames.count(k->want)) k->want = -1;
+        if (k->want >= 0) target = k->want;
+        else {
+            const uint64_t frameBytes = (uint64_t)k->n * 6 * sizeof(double);
+            const uint64_t fit = frameBytes ? k->budget / frameBytes : 0;
+            const int64_t span = (int64_t)std::min<uint64_t>(k->ahead, fit > 2 ? fit - 2 : 0);
+            const int64_t lo = k->direction >= 0 ? k->cursor + 1 : std::max<int64_t>(1, k->cursor - span);
+            const int64_t hi = k->direction >= 0 ? k->cursor + span : k->cursor - 1;
+            for (int64_t i = lo; i <= hi; ++i) {
+                if (k->frames.count(i)) touch(k, i);
+                else if (target < 0) target = i;
+            }
+        }
+        if (target < 0) { k->pending = false; continue; }
+
+        const uint64_t gen = k->generation.load();
+        const uint64_t epoch = k->epoch;
+        if (k->workerEpoch != epoch) {
+            w.n = k->n;
+            w.m = k->mass;
+            w.G = k->G; w.eps2 = k->eps2; w.theta = k->theta; w.mode = k->mode;
+            for (auto* v : { &w.x, &w.y, &w.z, &w.vx, &w.vy, &w.vz, &w.ax, &w.ay, &w.az }) v->resize(k->n);
+            k->workerEpoch = epoch;
+            k->workerStep = -1;
+        }
+        // Continue from the worker's own state when it lies between the source keyframe and
+        // the target (the usual case when sweeping a window).
+        auto src = std::prev(k->frames.upper_bound(target));
+        const int64_t srcStep = src->first * (int64_t)k->interval;
+        const int64_t targetStep = target * (int64_t)k->interval;
+        if (!(k->workerStep >= srcStep && k->workerStep <= targetStep)) {
+            restore_state(src->second, &w);
+            w.time = k->originBodyTime + srcStep * k->dt;
+            k->workerStep = srcStep;
+        }
+        const double dt = k->dt;
+        const uint32_t substeps = k->substeps;
+        lk.unlock();
+
+        bool cancelled = false;
+        while (k->workerStep < targetStep) {
+            if (k->generation.load() != gen) { cancelled = true; break; }
+            nbody_step(to_handle(&w), dt, substeps);
+            ++k->workerStep;
+        }
+        if (!cancelled) capture_state(&w, buf);
+
+        lk.lock();
+        if (!cancelled && k->epoch == epoch) {
+            insert(k, target, std::move(buf));
+            ++k->stats.prefilled;
+        }
+        buf = take_buffer(k);
+    }
+}
+
+// ===== sim clock hooks =====
+// After every fixed step: keyframe boundaries are cached and move the prefill window forwards.
+void keyframes_on_step(KeyframeCache* k)
+{
+    SimClock* c = k->clock;
+    if (!c->body) return;
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        if (!anchor_matches(k)) reset_anchor(k);
+    }
+    const int64_t rel = c->step - k->originStep;
+    if (rel < 0 || rel % k->interval) return;
+
+    const int64_t index = rel / k->interval;
+    store_if_missing(k, index, c->body);
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        k->cursor = index;
+        k->direction = 1;
+        k->pending = true;
+    }
+    k->wake.notify_one();
+}
+
+void keyframes_detach(KeyframeCache* k)
+{
+    std::lock_guard<std::mutex> lk(k->lock);
+    k->clock = nullptr;
+}
+
+// ===== ABI =====
+// budget_bytes 0 picks 256 MB. Keyframe 0 is the clock's current state.
+int FM_CALL keyframes_create(fw_handle clock, uint32_t interval_steps, uint64_t budget_bytes,
+    uint32_t ahead, fw_handle* out)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (!c || !out) { native_set_error("keyframes_create: null argument"); return FM_E_BADARGS; }
+    *out = 0;
+    if (!c->body) { native_set_error("keyframes_create: clock has no sim attached"); return FM_E_BADARGS; }
+    if (c->keyframes) { native_set_error("keyframes_create: clock already has a keyframe cache"); return FM_E_BADARGS; }
+    if (!interval_steps) { native_set_error("keyframes_create: interval_steps must be > 0"); return FM_E_BADARGS; }
+
+    jobs_acquire();
+    auto* k = new KeyframeCache();
+    k->clock = c;
+    k->interval = interval_steps;
+    k->budget = budget_bytes ? budget_bytes : kDefaultBudget;
+    k->ahead = ahead;
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        reset_anchor(k);
+    }
+    c->keyframes = k;
+    k->thread = std::thread(prefill_main, k);
+    *out = to_handle(k);
+    return FM_OK;
+}
+
+void FM_CALL keyframes_destroy(fw_handle cache)
+{
+    auto* k = handle_to<KeyframeCache>(cache);
+    if (!k) return;
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        k->stop = true;
+        k->generation.fetch_add(1);
+        if (k->clock) k->clock->keyframes = nullptr;
+    }
+    k->wake.notify_one();
+    k->thread.join();
+    delete k;
+    jobs_release();
+}
+
+int FM_CALL keyframes_set_budget(fw_handle cache, uint64_t budget_bytes, uint32_t ahead)
+{
+    auto* k = handle_to<KeyframeCache>(cache);
+    if (!k) { native_set_error("keyframes: null handle"); return FM_E_BADARGS; }
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        k->budget = budget_bytes ? budget_bytes : kDefaultBudget;
+        k->ahead = ahead;
+        evict(k);
+        k->pending = true;
+    }
+    k->wake.notify_one();
+    return FM_OK;
+}
+
+// Drops every keyframe and re-anchors at the clock's current state. Needed after
+// nbody_set_bodies with an unchanged count; count, parameter and attach changes reset on
+// their own.
+int FM_CALL keyframes_reset(fw_handle cache)
+{
+    auto* k = handle_to<KeyframeCache>(cache);
+    if (!k) { native_set_error("keyframes: null handle"); return FM_E_BADARGS; }
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        if (!k->clock || !k->clock->body) { native_set_error("keyframes_reset: clock detached or without a sim"); return FM_E_NOTREADY; }
+        reset_anchor(k);
+    }
+    k->wake.notify_one();
+    return FM_OK;
+}
+
+// Moves the clock and its sim to the last fixed step at or before sim_time (clamped to the
+// anchor) and returns that step's time. Replays fewer than interval steps: when the target's
+// keyframe is not cached yet the clock stops that far past the nearest one, the prefill
+// thread is pointed at the keyframe and the call returns 1.
+// A cancelled prefill keeps its worker state, so repeated seeks to the same far target do
+// not restart its replay.
+int FM_CALL keyframes_seek(fw_handle cache, double sim_time, double* out_time)
+{
+    auto* k = handle_to<KeyframeCache>(cache);
+    if (!k) { native_set_error("keyframes: null handle"); return FM_E_BADARGS; }
+    SimClock* c = k->clock;
+    if (!c || !c->body) { native_set_error("keyframes_seek: clock detached or without a sim"); return FM_E_NOTREADY; }
+    NBody* s = c->body;
+
+    int64_t from, target, land;
+    {
+        std::lock_guard<std::mutex> lk(k->lock);
+        if (!anchor_matches(k)) reset_anchor(k);
+        k->generation.fetch_add(1);
+
+        const double rel = std::floor((sim_time - k->originTime) / k->dt + 1e-6);
+        target = rel > 0 ? (int64_t)std::min(rel, 9.0e15) : 0;
+        const int64_t live = c->step - k->originStep;
+        const int64_t index = target / k->interval;
+
+        // Nearest keyframe at or before the target; the live state wins when it is closer.
+        auto src = std::prev(k->frames.upper_bound(index));
+        const int64_t srcStep = src->first * (int64_t)k->interval;
+        if (live >= srcStep && live <= target) {
+            from = live;
+        }
+        else {
+            restore_state(src->second, s);
+            s->time = k->originBodyTime + srcStep * k->dt;
+            from = srcStep;
+        }
+        touch(k, src->first);
+
+        // Only reachable when the target's keyframe is missing; its replay goes to the
+        // prefill thread instead of this call.
+        land = std::min<int64_t>(target, from + (int64_t)k->interval - 1);
+        k->want = land < target ? index : -1;
+        k->direction = target < live ? -1 : 1;
+        k->cursor = index;
+        k->pending = true;
+        ++k->stats.seeks;
+        k->stats.replayed_steps += (uint64_t)(land - from);
+        k->stats.last_seek_steps = (uint32_t)(land - from);
+    }
+    k->wake.notify_one();
+
+    for (int64_t step = from; step < land;) {
+        nbody_step(to_handle(s), k->dt, k->substeps);
+        if (++step % k->interval == 0) store_if_missing(k, step / k->interval, s);
+    }
+
+    sim_clock_jump(c, k->originStep + land, k->originTime + land * k->dt);
+    if (out_time) *out_time = c->simTime;
+    return land < target ? 1 : FM_OK;
+}
+
+int FM_CALL keyframes_get_stats(fw_handle cache, fw_keyframe_stats* out)
+{
+    auto* k = handle_to<KeyframeCache>(cache);
+    if (!k || !out) { native_set_error("keyframes_get_stats: null argument"); return FM_E_BADARGS; }
+    std::lock_guard<std::mutex> lk(k->lock);
+    *out = k->stats;
+    out->keyframes = (uint32_t)k->frames.size();
+    out->bytes = (uint64_t)k->frames.size() * k->n * 6 * sizeof(double);
+    return FM_OK;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "native_common.h"
+#include "nbody.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Keyframe cache for scrubbing a sim clock's N-body timeline.
+    - Keyframe k is the full body state (positions and velocities, 48 bytes per body) after
+      k * interval fixed steps from the anchor (the clock's state at create / reset).
+      Keyframe 0 is pinned; the rest are evicted least recently used past the byte budget.
+    - A seek restores the nearest keyframe at or before the target (or keeps the live state
+      if that is closer) and replays at most interval - 1 steps, caching keyframes it crosses.
+      Replay uses the clock's dt and substeps, so results match uninterrupted playback.
+    - When the target's keyframe is not cached the seek still replays no more than that: it
+      stops short (returning 1) and hands the keyframe to the prefill thread, which computes
+      it before anything else. Seeking again lands on the target once it is there.
+    - A prefill thread keeps `ahead` keyframes computed in the playback direction (forwards
+      while advancing, backwards after a backward seek) on its own copy of the sim; a seek
+      cancels its current plan.
+*/
+
+struct SimClock;
+
+struct KeyframeCache
+{
+    SimClock* clock = nullptr;
+    uint32_t  interval = 64;                 // steps between keyframes
+    uint64_t  budget = 0;                    // bytes of keyframe state
+    uint32_t  ahead = 8;                     // keyframes to prefill
+
+    // Anchor: keyframe 0 and the sim parameters the timeline was computed with
+    int64_t   originStep = 0;
+    double    originTime = 0.0;
+    double    originBodyTime = 0.0;
+    uint32_t  n = 0;
+    std::vector<double> mass;
+    double    G = 0, eps2 = 0, theta = 0;
+    uint32_t  mode = 0;
+    double    dt = 0.0;
+    uint32_t  substeps = 1;
+
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::map<int64_t, std::vector<double>> frames;   // keyframe index -> SoA x, y, z, vx, vy, vz
+    std::map<int64_t, uint64_t>            lastUse;
+    std::vector<std::vector<double>>       spare;    // evicted buffers, reused
+    uint64_t  tick = 0;
+    uint64_t  epoch = 0;                     // bumped by reset; stale prefill results are dropped
+    std::atomic<uint64_t> generation{ 0 };   // bumped by seeks; cancels the prefill plan
+    int64_t   cursor = 0;                    // keyframe at or before the playback position
+    int64_t   want = -1;                     // keyframe a capped seek waits for, prefilled first
+    int       direction = 1;
+    bool      pending = false;
+    bool      stop = false;
+
+    // Prefill thread and its private sim (valid for workerEpoch, at workerStep)
+    std::thread thread;
+    NBody       worker;
+    uint64_t    workerEpoch = UINT64_MAX;
+    int64_t     workerStep = -1;
+
+    fw_keyframe_stats stats{};
+};
+
+// Sim clock hooks (sim_clock.cpp)
+void keyframes_on_step(KeyframeCache* k);
+void keyframes_detach(KeyframeCache* k);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL keyframes_create(fw_handle clock, uint32_t interval_steps, uint64_t budget_bytes,
+    uint32_t ahead, fw_handle* out);
+void FM_CALL keyframes_destroy(fw_handle cache);
+int  FM_CALL keyframes_set_budget(fw_handle cache, uint64_t budget_bytes, uint32_t ahead);
+int  FM_CALL keyframes_reset(fw_handle cache);
+int  FM_CALL keyframes_seek(fw_handle cache, double sim_time, double* out_time);
+int  FM_CALL keyframes_get_stats(fw_handle cache, fw_keyframe_stats* out);
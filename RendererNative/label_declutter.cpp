@@ -0,0 +1,182 @@
+// label_declutter.cpp
+// Priority-ordered greedy label placement over a screen grid (see label_declutter.h)
+
+#include "label_declutter.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t kDeclutterGrain = 4096;
+static const float    kMinCell = 8.0f;
+static const float    kMaxCell = 512.0f;
+static const uint32_t kMaxCells = 1u << 16;
+
+// Unsigned key that sorts ascending as the priority descends; NaN goes last.
+static inline uint32_t priority_key(float p)
+{
+    if (p != p) p = -HUGE_VALF;
+    uint32_t u;
+    std::memcpy(&u, &p, sizeof(u));
+    u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+    return ~u;
+}
+
+// ===== projection =====
+// Screen box of label i (pixels, y down, padded by half the padding each side); false when
+// it is empty, behind the camera or entirely off screen.
+static bool project_label(const fw_label& l, const float* ext, const DeclutterParams& p, float* box)
+{
+    if (!(ext[0] < ext[2])) return false;
+    const float* m = p.viewProj;
+    const float x = (float)(l.pos[0] - p.origin[0]);
+    const float y = (float)(l.pos[1] - p.origin[1]);
+    const float z = (float)(l.pos[2] - p.origin[2]);
+    const float cx = m[0] * x + m[4] * y + m[8] * z + m[12];
+    const float cy = m[1] * x + m[5] * y + m[9] * z + m[13];
+    const float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+    if (!(cw > 0)) return false;
+
+    // Same pixel snap as vs_glyph.vert
+    const float px = std::floor((cx / cw * 0.5f + 0.5f) * p.width + 0.5f);
+    const float py = std::floor((cy / cw * 0.5f + 0.5f) * p.height + 0.5f);
+    const float h = 0.5f * p.padding;
+    box[0] = px + ext[0] - h;
+    box[1] = py - ext[3] - h;
+    box[2] = px + ext[2] + h;
+    box[3] = py - ext[1] + h;
+    return box[2] > 0 && box[0] < p.width && box[3] > 0 && box[1] < p.height;
+}
+
+// ===== priority sort =====
+// Stable LSD radix sort of (key, order) by key, 8 bits a pass; passes where every key shares
+// the digit (e.g. all priorities equal) are skipped.
+static void sort_by_priority(DeclutterScratch& s, uint32_t n)
+{
+    const uint32_t chunks = (n + kDeclutterGrain - 1) / kDeclutterGrain;
+    s.keyTmp.resize(n);
+    s.orderTmp.resize(n);
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        s.hist.assign((size_t)chunks * 256, 0);
+        parallel_for(n, kDeclutterGrain, [&](uint32_t b, uint32_t e) {
+            uint32_t* h = &s.hist[(size_t)(b / kDeclutterGrain) * 256];
+            for (uint32_t i = b; i < e; ++i) h[(s.key[i] >> shift) & 255]++;
+            });
+
+        uint32_t sum = 0;
+        bool trivial = false;
+        for (uint32_t k = 0; k < 256 && !trivial; ++k) {
+            uint32_t bucket = 0;
+            for (uint32_t c = 0; c < chunks; ++c) bucket += s.hist[(size_t)c * 256 + k];
+            trivial = bucket == n;
+        }
+        if (trivial) continue;
+        for (uint32_t k = 0; k < 256; ++k)
+            for (uint32_t c = 0; c < chunks; ++c) {
+                uint32_t& h = s.hist[(size_t)c * 256 + k];
+                const uint32_t cnt = h;
+                h = sum;
+                sum += cnt;
+            }
+
+        parallel_for(n, kDeclutterGrain, [&](uint32_t b, uint32_t e) {
+            uint32_t* h = &s.hist[(size_t)(b / kDeclutterGrain) * 256];
+            for (uint32_t i = b; i < e; ++i) {
+                const uint32_t at = h[(s.key[i] >> shift) & 255]++;
+                s.keyTmp[at] = s.key[i];
+                s.orderTmp[at] = s.order[i];
+            }
+            });
+        s.key.swap(s.keyTmp);
+        s.order.swap(s.orderTmp);
+    }
+}
+
+// ===== declutter =====
+uint32_t declutter_labels(const fw_label* labels, const float* extents, uint32_t count,
+    const DeclutterParams& p, DeclutterScratch& s, uint8_t* keep, uint32_t* culled)
+{
+    *culled = count;
+    if (!count) return 0;
+    if (!(p.width > 0) || !(p.height > 0)) { std::memset(keep, 0, count); return 0; }
+
+    // Project, and count the candidates per chunk
+    const uint32_t chunks = (count + kDeclutterGrain - 1) / kDeclutterGrain;
+    s.box.resize((size_t)count * 4);
+    s.chunkCount.assign(chunks, 0);
+    s.chunkSize.assign(chunks, 0.0);
+    parallel_for(count, kDeclutterGrain, [&](uint32_t b, uint32_t e) {
+        uint32_t n = 0;
+        double size = 0;
+        for (uint32_t i = b; i < e; ++i) {
+            float* box = &s.box[(size_t)i * 4];
+            keep[i] = 0;
+            if (!project_label(labels[i], extents + (size_t)i * 4, p, box)) { box[0] = box[2] = 0; continue; }
+            ++n;
+            size += std::sqrt((double)(box[2] - box[0]) * (box[3] - box[1]));
+        }
+        s.chunkCount[b / kDeclutterGrain] = n;
+        s.chunkSize[b / kDeclutterGrain] = size;
+        });
+    uint32_t n = 0;
+    double size = 0;
+    for (uint32_t c = 0; c < chunks; ++c) {
+        const uint32_t k = s.chunkCount[c];
+        s.chunkCount[c] = n;
+        n += k;
+        size += s.chunkSize[c];
+    }
+    *culled = count - n;
+    if (!n) return 0;
+
+    s.key.resize(n);
+    s.order.resize(n);
+    parallel_for(count, kDeclutterGrain, [&](uint32_t b, uint32_t e) {
+        uint32_t at = s.chunkCount[b / kDeclutterGrain];
+        for (uint32_t i = b; i < e; ++i) {
+            const float* box = &s.box[(size_t)i * 4];
+            if (!(box[0] < box[2])) continue;
+            s.key[at] = priority_key(labels[i].priority);
+            s.order[at] = i;
+            ++at;
+        }
+        });
+    sort_by_priority(s, n);
+
+    // Grid: cells of the mean label's geometric size, so a box touches a few of them
+    float cell = p.cell > 0 ? p.cell : (float)(size / n);
+    cell = std::min(std::max(cell, kMinCell), kMaxCell);
+    while ((uint64_t)std::ceil(p.width / cell) * (uint64_t)std::ceil(p.height / cell) > kMaxCells) cell *= 2.0f;
+    const int gx = (int)std::ceil(p.width / cell), gy = (int)std::ceil(p.height / cell);
+    const float inv = 1.0f / cell;
+    s.cellHead.assign((size_t)gx * gy, -1);
+    s.nodes.clear();
+
+    uint32_t kept = 0;
+    for (uint32_t k = 0; k < n; ++k) {
+        const uint32_t i = s.order[k];
+        const float* b = &s.box[(size_t)i * 4];
+        const int x0 = std::max(0, (int)(b[0] * inv)), x1 = std::min(gx - 1, (int)(b[2] * inv));
+        const int y0 = std::max(0, (int)(b[1] * inv)), y1 = std::min(gy - 1, (int)(b[3] * inv));
+
+        bool hit = false;
+        for (int y = y0; y <= y1 && !hit; ++y)
+            for (int x = x0; x <= x1 && !hit; ++x)
+                for (int32_t nd = s.cellHead[(size_t)y * gx + x]; nd >= 0; nd = s.nodes[nd].next) {
+                    const float* o = s.nodes[nd].box;
+                    if (b[0] < o[2] && o[0] < b[2] && b[1] < o[3] && o[1] < b[3]) { hit = true; break; }
+                }
+        if (hit) continue;
+
+        keep[i] = 1;
+        ++kept;
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x) {
+                int32_t& head = s.cellHead[(size_t)y * gx + x];
+                s.nodes.push_back({ { b[0], b[1], b[2], b[3] }, head });
+                head = (int32_t)s.nodes.size() - 1;
+            }
+    }
+    return kept;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "renderer_api.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Screen-space label declutter (see labels_set_declutter).
+    - Each label's text block is placed around its anchor projected through the camera at
+      upload time (pixel-snapped like vs_glyph.vert); labels behind the camera or entirely off
+      screen are culled.
+    - Survivors are ordered by priority, highest first, by a stable LSD radix sort (ties keep
+      input order), then inserted greedily into a uniform screen grid: a label is kept when its
+      padded box overlaps no kept box in the cells it covers, and is then linked into them.
+      Kept boxes do not overlap, so each cell holds only a few and a rejection usually stops
+      at the first test.
+    - Cells are about the mean label's geometric size (sqrt of its area), and each cell's
+      list carries copies of its boxes, so a test never chases the label arrays.
+    - Projection and the sort's histogram and scatter passes run in parallel; the insertion
+      is one O(n) sweep, since every decision depends on all higher-priority ones.
+*/
+
+struct DeclutterParams
+{
+    double origin[3]{ 0,0,0 };
+    float  viewProj[16]{};     // column-major, relative to origin
+    float  width = 0, height = 0;
+    float  padding = 0;        // pixels kept clear between labels
+    float  cell = 0;           // grid cell edge in pixels, 0 = from the mean label size
+};
+
+struct DeclutterScratch
+{
+    std::vector<float>    box;          // x0, y0, x1, y1 per label, pixels y down
+    std::vector<uint32_t> chunkCount;   // candidates per chunk, then their first slot
+    std::vector<double>   chunkSize;    // summed sqrt(box area) per chunk (automatic cell size)
+    std::vector<uint32_t> key, keyTmp;  // sort keys, priority descending
+    std::vector<uint32_t> order, orderTmp;   // candidate label indices
+    std::vector<uint32_t> hist;         // per chunk x 256
+    std::vector<int32_t>  cellHead;     // grid: first node per cell, -1 = empty
+    struct Node { float box[4]; int32_t next; };   // a kept box linked into one cell
+    std::vector<Node>     nodes;
+};
+
+// extents: per label x0, y0, x1, y1 of its text block in pixels from the anchor, y up
+// (x0 >= x1 for labels with nothing to draw). Sets keep[i] to 1 for the labels to draw and
+// returns how many; *culled counts those behind the camera, off screen or empty.
+uint32_t declutter_labels(const fw_label* labels, const float* extents, uint32_t count,
+    const DeclutterParams& p, DeclutterScratch& s, uint8_t* keep, uint32_t* culled);
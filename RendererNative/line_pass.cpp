@@ -0,0 +1,333 @@
+// line_pass.cpp
+// Arc-length parameterised polylines with shader-side patterns (see line_pass.h)
+
+#include "line_pass.h"
+#include "native_common.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t VS_LINE_SPV[] = {
+#   include "shaders/vs_line_styled.spv.inc"
+};
+static const uint32_t FS_LINE_SPV[] = {
+#   include "shaders/fs_line_pattern.spv.inc"
+};
+static_assert((sizeof(VS_LINE_SPV) % 4) == 0, "VS_LINE_SPV must be dword aligned");
+static_assert((sizeof(FS_LINE_SPV) % 4) == 0, "FS_LINE_SPV must be dword aligned");
+
+static const uint32_t kFloatsPerVertex = 6;   // xyz camera-relative, arc length, pattern base, segment length
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, LinePass* l)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0; pcr.size = sizeof(LinePush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &l->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription binds[2]{};
+    binds[0].binding = 0; binds[0].stride = sizeof(float) * kFloatsPerVertex; binds[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binds[1].binding = 1; binds[1].stride = sizeof(uint32_t); binds[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attrs[3]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[0].offset = 0;
+    attrs[1].location = 1; attrs[1].binding = 1; attrs[1].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[1].offset = 0;
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32_SFLOAT; attrs[2].offset = sizeof(float) * 4;
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_LINE_SPV; pd.vsBytes = sizeof(VS_LINE_SPV);
+    pd.fs = FS_LINE_SPV; pd.fsBytes = sizeof(FS_LINE_SPV);
+    pd.bindings = binds; pd.bindingCount = 2;
+    pd.attrs = attrs; pd.attrCount = 3;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+    pd.layout = l->layout;
+    for (int b = BLEND_OPAQUE; b <= BLEND_ADDITIVE; ++b) {
+        pd.blend = (PipelineBlend)b;
+        if (!create_graphics_pipeline(d, pd, &l->pipes[b])) return false;
+    }
+    return true;
+}
+
+void line_release(Device* d)
+{
+    LinePass* l = d->lines;
+    if (!l) return;
+    host_buffer_release(d, l->verts);
+    host_buffer_release(d, l->rgba);
+    for (VkPipeline& p : l->pipes) destroy_graphics_pipeline(d, &p);
+    if (l->layout) vkDestroyPipelineLayout(d->device, l->layout, nullptr);
+    delete l;
+    d->lines = nullptr;
+}
+
+// ===== frame hooks =====
+void line_record_draw(Device* d, VkCommandBuffer cb)
+{
+    LinePass* l = d->lines;
+    if (!l || l->draws.empty()) return;
+
+    VkBuffer bufs[2]{ l->verts.buf, l->rgba.buf };
+    VkDeviceSize offs[2]{ 0, 0 };
+    vkCmdBindVertexBuffers(cb, 0, 2, bufs, offs);
+
+    LinePush lp{};
+    std::memcpy(lp.viewProj, d->viewProj, sizeof(lp.viewProj));
+    uint32_t bound = UINT32_MAX;
+    for (size_t i = 0; i < l->draws.size(); ++i) {
+        const LinePass::Draw& dr = l->draws[i];
+        if (dr.blend != bound) {
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, l->pipes[dr.blend]);
+            bound = dr.blend;
+        }
+        const fw_line_style& s = dr.style;
+        std::memcpy(lp.color0, s.color0, sizeof(lp.color0));
+        std::memcpy(lp.color1, s.color1, sizeof(lp.color1));
+        lp.gradient[0] = s.gradient[0] * dr.totalLength;
+        lp.gradient[1] = s.gradient[1] * dr.totalLength;
+        lp.gradient[2] = s.dash;
+        lp.gradient[3] = s.gap;
+        lp.phase = s.phase;
+        lp.pickId = pick_id(FW_PICK_POLYLINE, (uint32_t)i);
+        vkCmdPushConstants(cb, l->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0, sizeof(LinePush), &lp);
+        vkCmdDraw(cb, dr.count, 1, dr.first, 0);
+    }
+}
+
+void line_end_frame(Device* d)
+{
+    LinePass* l = d->lines;
+    if (!l) return;
+    l->cpu.clear();
+    l->cpuRgba.clear();
+    l->draws.clear();
+
+    fw_simplify_stats& st = l->lastStats;
+    st.points_in = l->pointsIn;
+    st.points_out = l->pointsOut;
+    st.polylines = l->polylines;
+    st.ratio = l->pointsIn ? (float)((double)l->pointsOut / (double)l->pointsIn) : 1.0f;
+    l->pointsIn = l->pointsOut = 0;
+    l->polylines = 0;
+}
+
+// ===== ABI =====
+static LinePass* ensure_pass(Device* d)
+{
+    if (!d->lines) {
+        auto* l = new LinePass();
+        d->lines = l;
+        if (!create_objects(d, l)) {
+            line_release(d);
+            native_set_error("polyline_upload: pipeline creation failed");
+            return nullptr;
+        }
+    }
+    return d->lines;
+}
+
+static SimplifyParams simplify_params(const Device* d)
+{
+    SimplifyParams p;
+    p.method = d->lineSimplify.method;
+    p.screen = d->lineSimplify.space == FW_SIMPLIFY_SCREEN;
+    p.tolerance = (float)d->lineSimplify.tolerance;
+    for (int k = 0; k < 3; ++k) p.origin[k] = d->origin[k];
+    std::memcpy(p.viewProj, d->viewProj, sizeof(p.viewProj));
+    p.width = (float)d->extent.width;
+    p.height = (float)d->extent.height;
+    return p;
+}
+
+// Appends the points listed in keep (ascending; all of them when keep is NULL) as one draw.
+static int append_polyline(Device* d, LinePass* l, const double* xyz, const uint32_t* rgba, uint32_t count,
+    const fw_line_style* style, const uint32_t* keep, uint32_t keepCount)
+{
+    const uint32_t outCount = keep ? keepCount : count;
+    const size_t first = l->cpuRgba.size();
+    if (first + outCount > UINT32_MAX) { native_set_error("polyline_upload: batch too large"); return FM_E_BADARGS; }
+    l->cpu.resize((first + outCount) * kFloatsPerVertex);
+    l->cpuRgba.resize(first + outCount);
+
+    // Arc length accumulates in double along the full world-space path, dropped points
+    // included, so dashes and gradients stay put whatever the simplification keeps. A float
+    // arc is fine for the gradient but far too coarse for dashes on long paths: the pattern
+    // gets the arc reduced modulo its period (in double) and the length of the segment the
+    // vertex starts, from which the shader rebuilds it within each segment.
+    const double period = style && style->dash > 0 && style->gap > 0 ? (double)style->dash + style->gap : 0.0;
+    float* v = l->cpu.data() + first * kFloatsPerVertex;
+    uint32_t* c = l->cpuRgba.data() + first;
+    double arc = 0, prevArc = 0;
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < count && j < outCount; ++i) {
+        const double* p = xyz + 3 * (size_t)i;
+        if (i) {
+            const double dx = p[0] - p[-3], dy = p[1] - p[-2], dz = p[2] - p[-1];
+            arc += std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        if (keep && keep[j] != i) continue;
+        float* o = v + (size_t)j * kFloatsPerVertex;
+        o[0] = (float)(p[0] - d->origin[0]);
+        o[1] = (float)(p[1] - d->origin[1]);
+        o[2] = (float)(p[2] - d->origin[2]);
+        o[3] = (float)arc;
+        o[4] = period > 0 ? (float)std::fmod(arc, period) : 0.0f;
+        o[5] = 0.0f;
+        if (j) o[5 - (int)kFloatsPerVertex] = (float)(arc - prevArc);   // previous vertex's segment
+        prevArc = arc;
+        c[j] = rgba ? rgba[i] : 0xFFFFFFFFu;
+        ++j;
+    }
+
+    const size_t oldCap[2]{ l->verts.cap, l->rgba.cap };
+    if (!host_buffer_reserve(d, l->verts, l->cpu.size() * sizeof(float), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) ||
+        !host_buffer_reserve(d, l->rgba, l->cpuRgba.size() * sizeof(uint32_t), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
+        l->cpu.resize(first * kFloatsPerVertex);
+        l->cpuRgba.resize(first);
+        return FM_E_NOMEM;
+    }
+    // A grown buffer lost the earlier draws of this frame: copy the whole batch again.
+    const size_t from = (l->verts.cap != oldCap[0] || l->rgba.cap != oldCap[1]) ? 0 : first;
+    std::memcpy(static_cast<float*>(l->verts.mapped) + from * kFloatsPerVertex, l->cpu.data() + from * kFloatsPerVertex,
+        (first + outCount - from) * kFloatsPerVertex * sizeof(float));
+    std::memcpy(static_cast<uint32_t*>(l->rgba.mapped) + from, l->cpuRgba.data() + from,
+        (first + outCount - from) * sizeof(uint32_t));
+
+    LinePass::Draw dr{};
+    dr.first = (uint32_t)first;
+    dr.count = outCount;
+    dr.totalLength = (float)arc;
+    dr.blend = d->polylineBlend;
+    if (style) dr.style = *style;
+    else {
+        for (int k = 0; k < 4; ++k) dr.style.color0[k] = dr.style.color1[k] = 1.0f;
+    }
+    l->draws.push_back(dr);
+
+    l->pointsIn += count;
+    l->pointsOut += outCount;
+    l->polylines++;
+    return FM_OK;
+}
+
+static int upload_one(Device* d, const double* xyz, const uint32_t* rgba, uint32_t count,
+    const fw_line_style* style)
+{
+    LinePass* l = ensure_pass(d);
+    if (!l) return FM_E_DEVICE;
+    if (d->lineSimplify.method == FW_SIMPLIFY_OFF) return append_polyline(d, l, xyz, rgba, count, style, nullptr, 0);
+
+    if (l->scratch.empty()) l->scratch.resize(1);
+    if (l->kept.empty()) l->kept.resize(1);
+    const uint32_t kept = simplify_polyline(xyz, count, simplify_params(d), l->scratch[0], l->kept[0]);
+    return append_polyline(d, l, xyz, rgba, count, style, l->kept[0].data(), kept);
+}
+
+// Appends one polyline (xyz world triplets) to this frame's batch. style NULL draws a solid
+// white line. Gradient positions are fractions of the polyline's total length; dash, gap
+// and phase are in world units of arc length (dash 0 = solid).
+int FM_CALL polyline_upload(fw_handle dev, const double* xyz, uint32_t count, const fw_line_style* style)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("polyline_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("polyline_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !xyz) { native_set_error("polyline_upload: null xyz"); return FM_E_BADARGS; }
+    if (count < 2) return FM_OK;
+    return upload_one(d, xyz, nullptr, count, style);
+}
+
+// As polyline_upload, with one packed RGBA8 colour per vertex (R in the lowest byte)
+// multiplying the style colour, e.g. a heatmap along a trajectory.
+int FM_CALL polyline_upload_rgba(fw_handle dev, const double* xyz, const uint32_t* rgba, uint32_t count,
+    const fw_line_style* style)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("polyline_upload_rgba: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("polyline_upload_rgba: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && (!xyz || !rgba)) { native_set_error("polyline_upload_rgba: null xyz/rgba"); return FM_E_BADARGS; }
+    if (count < 2) return FM_OK;
+    return upload_one(d, xyz, rgba, count, style);
+}
+
+// Many polylines in one call: with simplification on they are thinned in parallel (one
+// scratch per job chunk), then appended in order as one draw each, exactly as the same
+// sequence of polyline_upload(_rgba) calls would be. All or nothing: on failure the batch
+// is left as it was before the call.
+int FM_CALL polylines_upload(fw_handle dev, const fw_polyline* lines, uint32_t count)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("polylines_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("polylines_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !lines) { native_set_error("polylines_upload: null lines"); return FM_E_BADARGS; }
+    for (uint32_t i = 0; i < count; ++i)
+        if (lines[i].count && !lines[i].xyz) { native_set_error("polylines_upload: null xyz"); return FM_E_BADARGS; }
+    if (!count) return FM_OK;
+
+    LinePass* l = ensure_pass(d);
+    if (!l) return FM_E_DEVICE;
+
+    const bool simplify = d->lineSimplify.method != FW_SIMPLIFY_OFF;
+    if (simplify) {
+        const SimplifyParams params = simplify_params(d);
+        const uint32_t grain = std::max(1u, count / (4 * (jobs_worker_count() + 1)));
+        const uint32_t chunks = (count + grain - 1) / grain;
+        if (l->scratch.size() < chunks) l->scratch.resize(chunks);
+        if (l->kept.size() < count) l->kept.resize(count);
+        parallel_for(count, grain, [&](uint32_t b, uint32_t e) {
+            SimplifyScratch& s = l->scratch[b / grain];
+            for (uint32_t i = b; i < e; ++i)
+                if (lines[i].count >= 2) simplify_polyline(lines[i].xyz, lines[i].count, params, s, l->kept[i]);
+            });
+    }
+
+    const size_t cpuSize = l->cpu.size(), rgbaSize = l->cpuRgba.size(), drawCount = l->draws.size();
+    const uint64_t pointsIn = l->pointsIn, pointsOut = l->pointsOut;
+    const uint32_t polylines = l->polylines;
+    for (uint32_t i = 0; i < count; ++i) {
+        const fw_polyline& pl = lines[i];
+        if (pl.count < 2) continue;
+        const int rc = simplify
+            ? append_polyline(d, l, pl.xyz, pl.rgba, pl.count, pl.style, l->kept[i].data(), (uint32_t)l->kept[i].size())
+            : append_polyline(d, l, pl.xyz, pl.rgba, pl.count, pl.style, nullptr, 0);
+        if (rc != FM_OK) {
+            // Drop the polylines this call already appended; the mapped buffers keep the
+            // earlier draws intact, so only the CPU side and the counters need rewinding.
+            l->cpu.resize(cpuSize);
+            l->cpuRgba.resize(rgbaSize);
+            l->draws.resize(drawCount);
+            l->pointsIn = pointsIn; l->pointsOut = pointsOut; l->polylines = polylines;
+            return rc;
+        }
+    }
+    return FM_OK;
+}
+
+// Simplification for later polyline uploads; desc NULL (or method OFF) uploads every point.
+// Screen-space tolerances use the camera and swapchain size at upload time.
+int FM_CALL lines_set_simplify(fw_handle dev, const fw_simplify_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("lines_set_simplify: null device"); return FM_E_BADARGS; }
+    if (!desc) { d->lineSimplify = fw_simplify_desc{}; return FM_OK; }
+    if (desc->method > FW_SIMPLIFY_VISVALINGAM || desc->space > FW_SIMPLIFY_SCREEN) {
+        native_set_error("lines_set_simplify: unknown method/space");
+        return FM_E_BADARGS;
+    }
+    if (!(desc->tolerance >= 0)) { native_set_error("lines_set_simplify: negative tolerance"); return FM_E_BADARGS; }
+    d->lineSimplify = *desc;
+    return FM_OK;
+}
+
+// Point counts of the last frame's polyline batch (before and after simplification).
+int FM_CALL lines_get_simplify_stats(fw_handle dev, fw_simplify_stats* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("lines_get_simplify_stats: null argument"); return FM_E_BADARGS; }
+    *out = d->lines ? d->lines->lastStats : fw_simplify_stats{ 0, 0, 0, 1.0f };
+    return FM_OK;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "renderer_device.h"
+#include "polyline_simplify.h"
+
+#include <vector>
+
+/*
+    Styled world-space polylines (trajectories, predicted paths, uncertainty tracks).
+    - Each vertex carries its cumulative arc length (computed in double on upload); dash,
+      gap, phase and a two-colour gradient are per-draw push constants evaluated in the
+      fragment shader, so patterns cost no extra vertices.
+    - The gradient reads the float arc. Dashes would lose it on long (AU-scale) paths, so
+      each vertex also carries its arc modulo the pattern period, reduced in double, and
+      the length of the segment it starts; flat-interpolated from the segment's first
+      vertex, they give an exact pattern coordinate anywhere along the segment.
+    - Every polyline_upload() call is one draw in this frame's batch; the vertices of the
+      whole batch share one mapped buffer. An RGBA8 stream (white unless given) multiplies
+      the style colour, and each draw keeps the blend mode current at upload.
+    - With lines_set_simplify on, polylines are thinned before they are appended (arc
+      length still comes from the full path, so patterns don't shift). polylines_upload
+      simplifies its polylines in parallel on the job system, then appends them in order.
+*/
+
+struct LinePass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipes[3]{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };   // by PipelineBlend
+
+    HostBuffer            verts, rgba;
+    std::vector<float>    cpu;       // this frame's vertices, re-copied if a buffer has to grow
+    std::vector<uint32_t> cpuRgba;
+
+    struct Draw { uint32_t first, count; fw_line_style style; float totalLength; uint32_t blend; };
+    std::vector<Draw>  draws;
+
+    // Simplification scratch (one per job chunk) and kept point indices per polyline of the
+    // current upload call
+    std::vector<SimplifyScratch>       scratch;
+    std::vector<std::vector<uint32_t>> kept;
+
+    // Points in / out of this frame's batch; snapshot into lastStats by line_end_frame
+    uint64_t           pointsIn = 0, pointsOut = 0;
+    uint32_t           polylines = 0;
+    fw_simplify_stats  lastStats{ 0, 0, 0, 1.0f };
+};
+
+// Push block of vs_line_styled.vert / fs_line_pattern.frag
+struct LinePush
+{
+    float    viewProj[16];
+    float    color0[4];
+    float    color1[4];
+    float    gradient[4];  // x arc where color0 ends, y arc where color1 is reached, z dash, w gap
+    float    phase;
+    uint32_t pickId;       // pick_id of the polyline (its index in the frame's batch)
+};
+
+// Frame hooks (renderer_api.cpp)
+void line_record_draw(Device* d, VkCommandBuffer cb);
+void line_end_frame(Device* d);
+void line_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL polyline_upload(fw_handle dev, const double* xyz, uint32_t count, const fw_line_style* style);
+int  FM_CALL polyline_upload_rgba(fw_handle dev, const double* xyz, const uint32_t* rgba, uint32_t count,
+    const fw_line_style* style);
+int  FM_CALL polylines_upload(fw_handle dev, const fw_polyline* lines, uint32_t count);
+int  FM_CALL lines_set_simplify(fw_handle dev, const fw_simplify_desc* desc);
+int  FM_CALL lines_get_simplify_stats(fw_handle dev, fw_simplify_stats* out);
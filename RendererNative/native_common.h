@@ -0,0 +1,15 @@
+#pragma once
+#include "renderer_api.h"
+
+#include <cstdint>
+
+// Shared plumbing for native modules that live outside renderer_api.cpp.
+// Implemented in renderer_api.cpp next to the thread-local error string and logger.
+void native_set_error(const char* msg);
+void native_log(int level, const char* msg);
+
+// fw_handle (uint64) <-> object pointer, same convention as devices
+template <class T>
+static inline T* handle_to(fw_handle h) { return reinterpret_cast<T*>(static_cast<uintptr_t>(h)); }
+template <class T>
+static inline fw_handle to_handle(T* p) { return static_cast<fw_handle>(reinterpret_cast<uintptr_t>(p)); }
@@ -0,0 +1,421 @@
+// nbody.cpp
+// Barnes-Hut / direct N-body integrator over SoA state (see nbody.h)
+
+#include "nbody.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const uint32_t kLeafSize = 8;        // bodies per leaf before splitting
+static const int      kMaxLevel = 21;       // 21 bits per axis in a 63-bit Morton code
+static const int      kParallelDepth = 2;   // subtrees below this depth build as jobs (<= 64)
+
+// ===== Morton codes =====
+static inline uint64_t spread_bits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8) & 0x100f00f00f00f00full;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2) & 0x1249249249249249ull;
+    return v;
+}
+
+static inline uint32_t octant_at(uint64_t code, int level)
+{
+    return (uint32_t)(code >> (3 * (kMaxLevel - 1 - level))) & 7u;
+}
+
+struct Bounds { double lo[3]; double hi[3]; };
+
+static Bounds compute_bounds(const NBody* s)
+{
+    const uint32_t grain = 4096;
+    uint32_t chunks = (s->n + grain - 1) / grain;
+    std::vector<Bounds> part(chunks);
+
+    parallel_for(s->n, grain, [&](uint32_t b, uint32_t e) {
+        Bounds r{ { s->x[b], s->y[b], s->z[b] }, { s->x[b], s->y[b], s->z[b] } };
+        for (uint32_t i = b + 1; i < e; ++i) {
+            r.lo[0] = std::min(r.lo[0], s->x[i]); r.hi[0] = std::max(r.hi[0], s->x[i]);
+            r.lo[1] = std::min(r.lo[1], s->y[i]); r.hi[1] = std::max(r.hi[1], s->y[i]);
+            r.lo[2] = std::min(r.lo[2], s->z[i]); r.hi[2] = std::max(r.hi[2], s->z[i]);
+        }
+        part[b / grain] = r;
+        });
+
+    Bounds out = part[0];
+    for (uint32_t c = 1; c < chunks; ++c)
+        for (int k = 0; k < 3; ++k) {
+            out.lo[k] = std::min(out.lo[k], part[c].lo[k]);
+            out.hi[k] = std::max(out.hi[k], part[c].hi[k]);
+        }
+    return out;
+}
+
+// LSD radix sort of (code, body) pairs, 8 bits per pass; only passes covering used bits.
+static void sort_by_code(NBody* s)
+{
+    const uint32_t n = s->n;
+    s->sortTmp.resize(n);
+    s->orderTmp.resize(n);
+
+    uint64_t* kin = s->codes.data();   uint64_t* kout = s->sortTmp.data();
+    uint32_t* vin = s->order.data();   uint32_t* vout = s->orderTmp.data();
+
+    for (int shift = 0; shift < 3 * kMaxLevel; shift += 8) {
+        uint32_t hist[256] = {};
+        for (uint32_t i = 0; i < n; ++i) ++hist[(kin[i] >> shift) & 0xff];
+        if (hist[(kin[0] >> shift) & 0xff] == n) continue;   // digit constant: pass is a no-op
+
+        uint32_t sum = 0;
+        for (uint32_t d = 0; d < 256; ++d) { uint32_t c = hist[d]; hist[d] = sum; sum += c; }
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t dst = hist[(kin[i] >> shift) & 0xff]++;
+            kout[dst] = kin[i]; vout[dst] = vin[i];
+        }
+        std::swap(kin, kout); std::swap(vin, vout);
+    }
+
+    if (kin != s->codes.data()) {
+        std::memcpy(s->codes.data(), kin, n * sizeof(uint64_t));
+        std::memcpy(s->order.data(), vin, n * sizeof(uint32_t));
+    }
+}
+
+// ===== octree build =====
+static void make_leaf(const NBody* s, NBodyNode& nd, uint32_t b, uint32_t e)
+{
+    nd.leaf = 1; nd.first = b; nd.count = e - b;
+    double m = 0, cx = 0, cy = 0, cz = 0;
+    for (uint32_t k = b; k < e; ++k) {
+        uint32_t i = s->order[k];
+        m += s->m[i]; cx += s->m[i] * s->x[i]; cy += s->m[i] * s->y[i]; cz += s->m[i] * s->z[i];
+    }
+    nd.mass = m;
+    if (m > 0) { nd.cx = cx / m; nd.cy = cy / m; nd.cz = cz / m; }
+    else { nd.cx = s->x[s->order[b]]; nd.cy = s->y[s->order[b]]; nd.cz = s->z[s->order[b]]; }
+}
+
+static void aggregate_children(std::vector<NBodyNode>& nodes, uint32_t idx)
+{
+    double m = 0, cx = 0, cy = 0, cz = 0;
+    const uint32_t first = nodes[idx].first, count = nodes[idx].count;
+    for (uint32_t c = first; c < first + count; ++c) {
+        const NBodyNode& ch = nodes[c];
+        m += ch.mass; cx += ch.mass * ch.cx; cy += ch.mass * ch.cy; cz += ch.mass * ch.cz;
+    }
+    NBodyNode& nd = nodes[idx];
+    nd.mass = m;
+    if (m > 0) { nd.cx = cx / m; nd.cy = cy / m; nd.cz = cz / m; }
+    else if (count) { nd.cx = nodes[first].cx; nd.cy = nodes[first].cy; nd.cz = nodes[first].cz; }
+}
+
+// Splits sorted range [b,e) into up to 8 child ranges by the octant digit at `level`.
+static uint32_t child_ranges(const uint64_t* codes, uint32_t b, uint32_t e, int level, uint32_t cut[9])
+{
+    uint32_t nonEmpty = 0;
+    cut[0] = b;
+    for (uint32_t o = 1; o < 8; ++o) {
+        const uint64_t* p = std::lower_bound(codes + cut[o - 1], codes + e, o,
+            [level](uint64_t c, uint32_t oct) { return octant_at(c, level) < oct; });
+        cut[o] = (uint32_t)(p - codes);
+    }
+    cut[8] = e;
+    for (uint32_t o = 0; o < 8; ++o) if (cut[o + 1] > cut[o]) ++nonEmpty;
+    return nonEmpty;
+}
+
+struct SubtreeTask { uint32_t node; uint32_t b, e; int level; double size; };
+
+// Builds node `idx` (already allocated in `nodes`). Siblings are allocated contiguously so
+// traversal can walk [first, first+count). When `tasks` is set, recursion stops at
+// kParallelDepth and the remaining work is queued instead.
+static void build_node(const NBody* s, std::vector<NBodyNode>& nodes, uint32_t idx,
+    uint32_t b, uint32_t e, int level, double size, std::vector<SubtreeTask>* tasks)
+{
+    nodes[idx].size = size;
+    if (e - b <= kLeafSize || level >= kMaxLevel) { make_leaf(s, nodes[idx], b, e); return; }
+    if (tasks && level >= kParallelDepth) { tasks->push_back({ idx, b, e, level, size }); return; }
+
+    uint32_t cut[9];
+    uint32_t k = child_ranges(s->codes.data(), b, e, level, cut);
+    uint32_t first = (uint32_t)nodes.size();
+    nodes.resize(first + k);
+    nodes[idx].leaf = 0; nodes[idx].first = first; nodes[idx].count = k;
+
+    uint32_t c = first;
+    for (uint32_t o = 0; o < 8; ++o) {
+        if (cut[o + 1] == cut[o]) continue;
+        build_node(s, nodes, c++, cut[o], cut[o + 1], level + 1, size * 0.5, tasks);
+    }
+    if (!tasks) aggregate_children(nodes, idx);
+}
+
+// Bottom-up pass over the serially built top levels once all subtrees are merged.
+static void finish_top(std::vector<NBodyNode>& nodes, uint32_t idx, int level)
+{
+    if (nodes[idx].leaf || level >= kParallelDepth) return;
+    for (uint32_t c = nodes[idx].first; c < nodes[idx].first + nodes[idx].count; ++c)
+        finish_top(nodes, c, level + 1);
+    aggregate_children(nodes, idx);
+}
+
+static void build_tree(NBody* s)
+{
+    const uint32_t n = s->n;
+    Bounds bb = compute_bounds(s);
+    double size = std::max({ bb.hi[0] - bb.lo[0], bb.hi[1] - bb.lo[1], bb.hi[2] - bb.lo[2] });
+    if (!(size > 0)) size = 1.0;
+    size *= 1.0000001;   // keep the max coordinate strictly inside the last cell
+
+    s->codes.resize(n);
+    s->order.resize(n);
+    const double q = double(1u << kMaxLevel) / size;
+    parallel_for(n, 4096, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            uint64_t ix = (uint64_t)std::min((s->x[i] - bb.lo[0]) * q, double((1u << kMaxLevel) - 1));
+            uint64_t iy = (uint64_t)std::min((s->y[i] - bb.lo[1]) * q, double((1u << kMaxLevel) - 1));
+            uint64_t iz = (uint64_t)std::min((s->z[i] - bb.lo[2]) * q, double((1u << kMaxLevel) - 1));
+            s->codes[i] = spread_bits(ix) << 2 | spread_bits(iy) << 1 | spread_bits(iz);
+            s->order[i] = i;
+        }
+        });
+    sort_by_code(s);
+
+    // Top levels serially, subtrees in parallel into private arrays, then splice.
+    std::vector<SubtreeTask> tasks;
+    s->nodes.clear();
+    s->nodes.resize(1);
+    build_node(s, s->nodes, 0, 0, n, 0, size, &tasks);
+
+    std::vector<std::vector<NBodyNode>> sub(tasks.size());
+    parallel_for((uint32_t)tasks.size(), 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t t = b; t < e; ++t) {
+            const SubtreeTask& tk = tasks[t];
+            sub[t].reserve(2 * (tk.e - tk.b) / kLeafSize + 8);
+            sub[t].resize(1);
+            build_node(s, sub[t], 0, tk.b, tk.e, tk.level, tk.size, nullptr);
+        }
+        });
+
+    for (size_t t = 0; t < tasks.size(); ++t) {
+        const uint32_t base = (uint32_t)s->nodes.size();
+        std::vector<NBodyNode>& local = sub[t];
+        for (size_t i = 0; i < local.size(); ++i)
+            if (!local[i].leaf) local[i].first = base + local[i].first - 1;
+        s->nodes[tasks[t].node] = local[0];
+        s->nodes.insert(s->nodes.end(), local.begin() + 1, local.end());
+    }
+    finish_top(s->nodes, 0, 0);
+}
+
+// ===== force evaluation =====
+static void accel_barnes_hut(NBody* s)
+{
+    build_tree(s);
+
+    const NBodyNode* nodes = s->nodes.data();
+    const double theta2 = s->theta * s->theta;
+    const double eps2 = s->eps2, G = s->G;
+
+    // Walk bodies in Morton order so neighbouring jobs traverse similar paths.
+    parallel_for(s->n, 64, [&](uint32_t b, uint32_t e) {
+        uint32_t stack[256];
+        for (uint32_t k = b; k < e; ++k) {
+            const uint32_t i = s->order[k];
+            const double px = s->x[i], py = s->y[i], pz = s->z[i];
+            double ax = 0, ay = 0, az = 0;
+
+            uint32_t sp = 0;
+            stack[sp++] = 0;
+            while (sp) {
+                const NBodyNode& nd = nodes[stack[--sp]];
+                if (nd.mass == 0) continue;
+
+                if (nd.leaf) {
+                    for (uint32_t q = nd.first; q < nd.first + nd.count; ++q) {
+                        uint32_t j = s->order[q];
+                        if (j == i) continue;
+                        double dx = s->x[j] - px, dy = s->y[j] - py, dz = s->z[j] - pz;
+                        double r2 = dx * dx + dy * dy + dz * dz + eps2;
+                        if (r2 == 0) continue;
+                        double inv = 1.0 / std::sqrt(r2);
+                        double f = G * s->m[j] * inv * inv * inv;
+                        ax += f * dx; ay += f * dy; az += f * dz;
+                    }
+                    continue;
+                }
+
+                double dx = nd.cx - px, dy = nd.cy - py, dz = nd.cz - pz;
+                double d2 = dx * dx + dy * dy + dz * dz;
+                if (nd.size * nd.size < theta2 * d2) {
+                    double r2 = d2 + eps2;
+                    double inv = 1.0 / std::sqrt(r2);
+                    double f = G * nd.mass * inv * inv * inv;
+                    ax += f * dx; ay += f * dy; az += f * dz;
+                }
+                else {
+                    for (uint32_t c = nd.first; c < nd.first + nd.count && sp < 256; ++c)
+                        stack[sp++] = c;
+                }
+            }
+            s->ax[i] = ax; s->ay[i] = ay; s->az[i] = az;
+        }
+        });
+}
+
+static void accel_direct(NBody* s)
+{
+    const double eps2 = s->eps2, G = s->G;
+    const uint32_t n = s->n;
+    parallel_for(n, 32, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            const double px = s->x[i], py = s->y[i], pz = s->z[i];
+            double ax = 0, ay = 0, az = 0;
+            for (uint32_t j = 0; j < n; ++j) {
+                if (j == i) continue;
+                double dx = s->x[j] - px, dy = s->y[j] - py, dz = s->z[j] - pz;
+                double r2 = dx * dx + dy * dy + dz * dz + eps2;
+                if (r2 == 0) continue;
+                double inv = 1.0 / std::sqrt(r2);
+                double f = G * s->m[j] * inv * inv * inv;
+                ax += f * dx; ay += f * dy; az += f * dz;
+            }
+            s->ax[i] = ax; s->ay[i] = ay; s->az[i] = az;
+        }
+        });
+}
+
+void nbody_compute_accel(NBody* s)
+{
+    if (s->n < 2) {
+        std::fill(s->ax.begin(), s->ax.end(), 0.0);
+        std::fill(s->ay.begin(), s->ay.end(), 0.0);
+        std::fill(s->az.begin(), s->az.end(), 0.0);
+    }
+    else if (s->mode == FW_NBODY_DIRECT) accel_direct(s);
+    else accel_barnes_hut(s);
+    s->accValid = true;
+}
+
+void nbody_write_positions_f32(const NBody* s, float* dst, uint32_t stride_floats,
+    double ox, double oy, double oz)
+{
+    parallel_for(s->n, 8192, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            float* p = dst + (size_t)i * stride_floats;
+            p[0] = (float)(s->x[i] - ox);
+            p[1] = (float)(s->y[i] - oy);
+            p[2] = (float)(s->z[i] - oz);
+        }
+        });
+}
+
+// ===== ABI =====
+int FM_CALL nbody_create(uint32_t capacity, fw_handle* out)
+{
+    if (!out) { native_set_error("nbody_create: null out"); return FM_E_BADARGS; }
+    *out = 0;
+
+    auto* s = new NBody();
+    s->x.reserve(capacity); s->y.reserve(capacity); s->z.reserve(capacity);
+    s->vx.reserve(capacity); s->vy.reserve(capacity); s->vz.reserve(capacity);
+    s->ax.reserve(capacity); s->ay.reserve(capacity); s->az.reserve(capacity);
+    s->m.reserve(capacity);
+
+    jobs_acquire();
+    *out = to_handle(s);
+    return FM_OK;
+}
+
+void FM_CALL nbody_destroy(fw_handle sim)
+{
+    auto* s = handle_to<NBody>(sim); if (!s) return;
+    delete s;
+    jobs_release();
+}
+
+int FM_CALL nbody_set_params(fw_handle sim, double G, double softening, double theta, uint32_t mode)
+{
+    auto* s = handle_to<NBody>(sim);
+    if (!s) { native_set_error("nbody: null handle"); return FM_E_BADARGS; }
+    if (mode > FW_NBODY_DIRECT || theta < 0 || softening < 0) {
+        native_set_error("nbody_set_params: bad mode/theta/softening"); return FM_E_BADARGS;
+    }
+    s->G = G; s->eps2 = softening * softening; s->theta = theta; s->mode = mode;
+    s->accValid = false;
+    return FM_OK;
+}
+
+int FM_CALL nbody_set_bodies(fw_handle sim, const double* pos_xyz, const double* vel_xyz,
+    const double* mass, uint32_t count)
+{
+    auto* s = handle_to<NBody>(sim);
+    if (!s) { native_set_error("nbody: null handle"); return FM_E_BADARGS; }
+    if (count && (!pos_xyz || !mass)) { native_set_error("nbody_set_bodies: null pos/mass"); return FM_E_BADARGS; }
+
+    s->n = count;
+    s->x.resize(count); s->y.resize(count); s->z.resize(count);
+    s->vx.resize(count); s->vy.resize(count); s->vz.resize(count);
+    s->ax.resize(count); s->ay.resize(count); s->az.resize(count);
+    s->m.resize(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        s->x[i] = pos_xyz[3 * i + 0]; s->y[i] = pos_xyz[3 * i + 1]; s->z[i] = pos_xyz[3 * i + 2];
+        s->vx[i] = vel_xyz ? vel_xyz[3 * i + 0] : 0.0;
+        s->vy[i] = vel_xyz ? vel_xyz[3 * i + 1] : 0.0;
+        s->vz[i] = vel_xyz ? vel_xyz[3 * i + 2] : 0.0;
+        s->m[i] = mass[i];
+    }
+    s->accValid = false;
+    return FM_OK;
+}
+
+int FM_CALL nbody_get_bodies(fw_handle sim, double* pos_xyz, double* vel_xyz, uint32_t count)
+{
+    auto* s = handle_to<NBody>(sim);
+    if (!s) { native_set_error("nbody: null handle"); return FM_E_BADARGS; }
+    if (count > s->n) count = s->n;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (pos_xyz) { pos_xyz[3 * i + 0] = s->x[i]; pos_xyz[3 * i + 1] = s->y[i]; pos_xyz[3 * i + 2] = s->z[i]; }
+        if (vel_xyz) { vel_xyz[3 * i + 0] = s->vx[i]; vel_xyz[3 * i + 1] = s->vy[i]; vel_xyz[3 * i + 2] = s->vz[i]; }
+    }
+    return (int)count;
+}
+
+// Kick-drift-kick leapfrog. Accelerations from the previous step's final kick are reused.
+int FM_CALL nbody_step(fw_handle sim, double dt, uint32_t substeps)
+{
+    auto* s = handle_to<NBody>(sim);
+    if (!s) { native_set_error("nbody: null handle"); return FM_E_BADARGS; }
+    if (substeps == 0) substeps = 1;
+    if (s->n == 0) { s->time += dt; return FM_OK; }
+
+    const double h = dt / substeps;
+    auto kick = [s](double k) {
+        parallel_for(s->n, 8192, [&](uint32_t b, uint32_t e) {
+            for (uint32_t i = b; i < e; ++i) {
+                s->vx[i] += s->ax[i] * k; s->vy[i] += s->ay[i] * k; s->vz[i] += s->az[i] * k;
+            }
+            });
+    };
+
+    for (uint32_t step = 0; step < substeps; ++step) {
+        if (!s->accValid) nbody_compute_accel(s);
+        kick(0.5 * h);
+        parallel_for(s->n, 8192, [&](uint32_t b, uint32_t e) {
+            for (uint32_t i = b; i < e; ++i) {
+                s->x[i] += s->vx[i] * h; s->y[i] += s->vy[i] * h; s->z[i] += s->vz[i] * h;
+            }
+            });
+        nbody_compute_accel(s);
+        kick(0.5 * h);
+    }
+    s->time += dt;
+    return FM_OK;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    N-body integrator for bodies that do not follow pure Kepler orbits.
+    - State is SoA doubles; positions/velocities in caller units consistent with G.
+    - Forces via a Barnes-Hut octree rebuilt every step (Morton sort + parallel subtree
+      build) or, for validation, direct O(N^2) summation.
+    - Kick-drift-kick leapfrog, so energy error stays bounded over long runs.
+*/
+
+enum {
+    FW_NBODY_BARNES_HUT = 0,
+    FW_NBODY_DIRECT = 1
+};
+
+struct NBodyNode
+{
+    double   cx = 0, cy = 0, cz = 0;  // center of mass
+    double   mass = 0;
+    double   size = 0;                // cell edge length
+    uint32_t first = 0;               // first child node, or first body (leaf)
+    uint32_t count = 0;               // child count, or body count (leaf)
+    uint32_t leaf = 0;
+};
+
+struct NBody
+{
+    uint32_t n = 0;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<double> ax, ay, az;
+    std::vector<double> m;
+
+    double   G = 6.67430e-11;
+    double   eps2 = 0.0;      // softening length squared
+    double   theta = 0.5;     // opening angle
+    uint32_t mode = FW_NBODY_BARNES_HUT;
+    bool     accValid = false;
+    double   time = 0.0;
+
+    // tree scratch, reused between steps
+    std::vector<uint64_t>  codes;
+    std::vector<uint32_t>  order;
+    std::vector<uint64_t>  sortTmp;
+    std::vector<uint32_t>  orderTmp;
+    std::vector<NBodyNode> nodes;
+};
+
+// Internal helpers (also used by the renderer bridge)
+void nbody_compute_accel(NBody* s);
+void nbody_write_positions_f32(const NBody* s, float* dst, uint32_t stride_floats,
+    double ox, double oy, double oz);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL nbody_create(uint32_t capacity, fw_handle* out);
+void FM_CALL nbody_destroy(fw_handle sim);
+int  FM_CALL nbody_set_params(fw_handle sim, double G, double softening, double theta, uint32_t mode);
+int  FM_CALL nbody_set_bodies(fw_handle sim, const double* pos_xyz, const double* vel_xyz,
+    const double* mass, uint32_t count);
+int  FM_CALL nbody_get_bodies(fw_handle sim, double* pos_xyz, double* vel_xyz, uint32_t count);
+int  FM_CALL nbody_step(fw_handle sim, double dt, uint32_t substeps);
@@ -0,0 +1,353 @@
+// nbody_gpu.cpp
+// Compute-shader direct N-body backend (see nbody_gpu.h)
+
+#include "nbody_gpu.h"
+#include "native_common.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t CS_NBODY_SPV[] = {
+#   include "shaders/cs_nbody_direct.spv.inc"
+};
+static_assert((sizeof(CS_NBODY_SPV) % 4) == 0, "CS_NBODY_SPV must be dword aligned");
+
+static const uint32_t kGroupSize = 128;   // local_size_x in cs_nbody_direct.comp
+
+// Push block of cs_nbody_direct.comp
+struct NBodyPush
+{
+    uint32_t count;
+    float    dt;
+    float    G;
+    float    eps2;
+    uint32_t phase;      // 0 = kick + drift, 1 = forces + kick
+};
+
+// ===== creation / teardown =====
+static void destroy_objects(Device* d, GpuNBody* g)
+{
+    if (g->pipe)   vkDestroyPipeline(d->device, g->pipe, nullptr);
+    if (g->layout) vkDestroyPipelineLayout(d->device, g->layout, nullptr);
+    if (g->pool)   vkDestroyDescriptorPool(d->device, g->pool, nullptr);
+    if (g->dsl)    vkDestroyDescriptorSetLayout(d->device, g->dsl, nullptr);
+    for (int k = 0; k < 2; ++k) {
+        if (g->pos[k])    vkDestroyBuffer(d->device, g->pos[k], nullptr);
+        if (g->posMem[k]) vkFreeMemory(d->device, g->posMem[k], nullptr);
+    }
+    if (g->vel)    vkDestroyBuffer(d->device, g->vel, nullptr);
+    if (g->velMem) vkFreeMemory(d->device, g->velMem, nullptr);
+    if (g->acc)    vkDestroyBuffer(d->device, g->acc, nullptr);
+    if (g->accMem) vkFreeMemory(d->device, g->accMem, nullptr);
+}
+
+static bool create_objects(Device* d, GpuNBody* g)
+{
+    const VkDeviceSize bytes = (VkDeviceSize)g->cap * sizeof(float) * 4;
+    const VkBufferUsageFlags posUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    const VkBufferUsageFlags velUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    for (int k = 0; k < 2; ++k)
+        if (!create_buffer(d, bytes, posUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g->pos[k], &g->posMem[k]))
+            return false;
+    if (!create_buffer(d, bytes, velUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g->vel, &g->velMem) ||
+        !create_buffer(d, bytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g->acc, &g->accMem))
+        return false;
+
+    VkDescriptorSetLayoutBinding b[4]{};
+    for (uint32_t i = 0; i < 4; ++i) {
+        b[i].binding = i;
+        b[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        b[i].descriptorCount = 1;
+        b[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo dlci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    dlci.bindingCount = 4; dlci.pBindings = b;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &g->dsl) != VK_SUCCESS) return false;
+
+    VkDescriptorPoolSize ps{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8 };
+    VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dpci.maxSets = 2; dpci.poolSizeCount = 1; dpci.pPoolSizes = &ps;
+    if (vkCreateDescriptorPool(d->device, &dpci, nullptr, &g->pool) != VK_SUCCESS) return false;
+
+    VkDescriptorSetLayout layouts[2]{ g->dsl, g->dsl };
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = g->pool; dsai.descriptorSetCount = 2; dsai.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(d->device, &dsai, g->sets) != VK_SUCCESS) return false;
+
+    for (int k = 0; k < 2; ++k) {
+        VkDescriptorBufferInfo bi[4]{
+            { g->pos[k], 0, VK_WHOLE_SIZE },
+            { g->pos[k ^ 1], 0, VK_WHOLE_SIZE },
+            { g->vel, 0, VK_WHOLE_SIZE },
+            { g->acc, 0, VK_WHOLE_SIZE } };
+        VkWriteDescriptorSet w[4]{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            w[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w[i].dstSet = g->sets[k]; w[i].dstBinding = i;
+            w[i].descriptorCount = 1; w[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w[i].pBufferInfo = &bi[i];
+        }
+        vkUpdateDescriptorSets(d->device, 4, w, 0, nullptr);
+    }
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcr.offset = 0; pcr.size = sizeof(NBodyPush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.setLayoutCount = 1; plci.pSetLayouts = &g->dsl;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &g->layout) != VK_SUCCESS) return false;
+
+    VkShaderModule cs = create_shader(d, CS_NBODY_SPV, sizeof(CS_NBODY_SPV));
+    if (!cs) return false;
+
+    VkComputePipelineCreateInfo cpci{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    cpci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    cpci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    cpci.stage.module = cs;
+    cpci.stage.pName = "main";
+    cpci.layout = g->layout;
+    VkResult pr = vkCreateComputePipelines(d->device, VK_NULL_HANDLE, 1, &cpci, nullptr, &g->pipe);
+    vkDestroyShaderModule(d->device, cs, nullptr);
+    return pr == VK_SUCCESS;
+}
+
+void gpu_nbody_release(Device* d, GpuNBody* g)
+{
+    vkDeviceWaitIdle(d->device);
+    destroy_objects(d, g);
+    d->gpuSims.erase(std::remove(d->gpuSims.begin(), d->gpuSims.end(), g), d->gpuSims.end());
+    delete g;
+}
+
+// ===== frame hooks =====
+void gpu_nbody_record_compute(Device* d, GpuNBody* g, VkCommandBuffer cb)
+{
+    (void)d;
+    if (g->pending.empty()) return;
+    if (g->n == 0) { g->pending.clear(); return; }
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, g->pipe);
+    const uint32_t groups = (g->n + kGroupSize - 1) / kGroupSize;
+
+    VkMemoryBarrier mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    // One dispatch over the bodies; phase 0 writes the other position buffer
+    auto dispatch = [&](float h, uint32_t phase) {
+        NBodyPush push{ g->n, h, g->G, g->eps2, phase };
+        vkCmdPushConstants(cb, g->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, g->layout, 0, 1, &g->sets[g->cur], 0, nullptr);
+        vkCmdDispatch(cb, groups, 1, 1);
+        vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &mb, 0, nullptr, 0, nullptr);
+        if (phase == 0) g->cur ^= 1;
+    };
+
+    // Accelerations at the current positions for the first half-kick
+    if (!g->accValid) {
+        dispatch(0.0f, 1);
+        g->accValid = true;
+    }
+    for (const auto& p : g->pending)
+        for (uint32_t s = 0; s < p.steps; ++s) {
+            dispatch(p.h, 0);
+            dispatch(p.h, 1);
+        }
+    g->pending.clear();
+
+    // Latest positions feed the points pipeline as instance data.
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 1, &mb, 0, nullptr, 0, nullptr);
+}
+
+void gpu_nbody_record_draw(Device* d, GpuNBody* g, VkCommandBuffer cb)
+{
+    if (!g->drawThisFrame || g->n == 0 || !d->pointPipe) return;
+    g->drawThisFrame = false;
+
+    // Positions are relative to the origin at upload time; fold the difference to the
+    // current camera origin into the matrix (VP * T(delta)) in double precision.
+    const double delta[3]{ g->origin[0] - d->origin[0], g->origin[1] - d->origin[1], g->origin[2] - d->origin[2] };
+    PointPush pp{};
+    std::memcpy(pp.viewProj, d->viewProj, sizeof(pp.viewProj));
+    for (int r = 0; r < 4; ++r)
+        pp.viewProj[12 + r] = (float)(d->viewProj[12 + r] + d->viewProj[0 + r] * delta[0] +
+            d->viewProj[4 + r] * delta[1] + d->viewProj[8 + r] * delta[2]);
+    std::memcpy(pp.color, g->color, sizeof(pp.color));
+    pp.size = std::min(g->pointSize, d->pointSizeMax);
+    // Bodies of all sims share one ID range, each sim starting after the capacity of the
+    // ones before it (pick_pass.cpp resolves it back).
+    uint32_t first = 0;
+    for (GpuNBody* s : d->gpuSims) { if (s == g) break; first += s->cap; }
+    pp.pickBase = pick_id(FW_PICK_BODY, first);
+
+    VkDeviceSize off = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, d->pointPipe);
+    vkCmdBindVertexBuffers(cb, 0, 1, &g->pos[g->cur], &off);
+    vkCmdPushConstants(cb, d->pointLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PointPush), &pp);
+    vkCmdDraw(cb, 1, g->n, 0, 0);
+}
+
+// ===== ABI =====
+int FM_CALL gpu_nbody_create(fw_handle dev, uint32_t capacity, fw_handle* out)
+{
+    if (!out) { native_set_error("gpu_nbody_create: null out"); return FM_E_BADARGS; }
+    *out = 0;
+    auto* d = H2D(dev);
+    if (!d || capacity == 0) { native_set_error("gpu_nbody_create: null device or zero capacity"); return FM_E_BADARGS; }
+
+    auto* g = new GpuNBody();
+    g->dev = d;
+    g->cap = capacity;
+    if (!create_objects(d, g)) {
+        destroy_objects(d, g);
+        delete g;
+        native_set_error("gpu_nbody_create: buffer/pipeline creation failed");
+        return FM_E_DEVICE;
+    }
+
+    d->gpuSims.push_back(g);
+    *out = to_handle(g);
+    return FM_OK;
+}
+
+void FM_CALL gpu_nbody_destroy(fw_handle sim)
+{
+    auto* g = handle_to<GpuNBody>(sim); if (!g) return;
+    gpu_nbody_release(g->dev, g);
+}
+
+int FM_CALL gpu_nbody_set_params(fw_handle sim, double G, double softening)
+{
+    auto* g = handle_to<GpuNBody>(sim);
+    if (!g) { native_set_error("gpu_nbody: null handle"); return FM_E_BADARGS; }
+    g->G = (float)G;
+    g->eps2 = (float)(softening * softening);
+    g->accValid = false;
+    return FM_OK;
+}
+
+int FM_CALL gpu_nbody_set_bodies(fw_handle sim, const double* pos_xyz, const double* vel_xyz,
+    const double* mass, uint32_t count)
+{
+    auto* g = handle_to<GpuNBody>(sim);
+    if (!g) { native_set_error("gpu_nbody: null handle"); return FM_E_BADARGS; }
+    if (count > g->cap) { native_set_error("gpu_nbody_set_bodies: count exceeds capacity"); return FM_E_BADARGS; }
+    if (count && (!pos_xyz || !mass)) { native_set_error("gpu_nbody_set_bodies: null pos/mass"); return FM_E_BADARGS; }
+
+    Device* d = g->dev;
+    g->n = count; g->cur = 0; g->pending.clear();
+    g->accValid = false;
+    if (!count) return FM_OK;
+
+    g->origin[0] = d->origin[0]; g->origin[1] = d->origin[1]; g->origin[2] = d->origin[2];
+
+    const VkDeviceSize bytes = (VkDeviceSize)count * sizeof(float) * 4;
+    VkBuffer stage = VK_NULL_HANDLE; VkDeviceMemory stageMem = VK_NULL_HANDLE;
+    if (!create_buffer(d, bytes * 2, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage, &stageMem)) {
+        native_set_error("gpu_nbody_set_bodies: staging allocation failed"); return FM_E_NOMEM;
+    }
+
+    void* mapped = nullptr;
+    vkMapMemory(d->device, stageMem, 0, bytes * 2, 0, &mapped);
+    float* p = static_cast<float*>(mapped);
+    float* v = p + (size_t)count * 4;
+    for (uint32_t i = 0; i < count; ++i) {
+        p[4 * i + 0] = (float)(pos_xyz[3 * i + 0] - g->origin[0]);
+        p[4 * i + 1] = (float)(pos_xyz[3 * i + 1] - g->origin[1]);
+        p[4 * i + 2] = (float)(pos_xyz[3 * i + 2] - g->origin[2]);
+        p[4 * i + 3] = (float)mass[i];
+        v[4 * i + 0] = vel_xyz ? (float)vel_xyz[3 * i + 0] : 0.f;
+        v[4 * i + 1] = vel_xyz ? (float)vel_xyz[3 * i + 1] : 0.f;
+        v[4 * i + 2] = vel_xyz ? (float)vel_xyz[3 * i + 2] : 0.f;
+        v[4 * i + 3] = 0.f;
+    }
+    vkUnmapMemory(d->device, stageMem);
+
+    bool ok = false;
+    VkCommandBuffer cb = begin_one_shot(d);
+    if (cb) {
+        VkBufferCopy cp{ 0, 0, bytes };
+        vkCmdCopyBuffer(cb, stage, g->pos[0], 1, &cp);
+        cp.srcOffset = bytes;
+        vkCmdCopyBuffer(cb, stage, g->vel, 1, &cp);
+        ok = end_one_shot(d, cb);
+    }
+    vkDestroyBuffer(d->device, stage, nullptr);
+    vkFreeMemory(d->device, stageMem, nullptr);
+
+    if (!ok) { native_set_error("gpu_nbody_set_bodies: upload failed"); return FM_E_DEVICE; }
+    return FM_OK;
+}
+
+int FM_CALL gpu_nbody_get_bodies(fw_handle sim, double* pos_xyz, double* vel_xyz, uint32_t count)
+{
+    auto* g = handle_to<GpuNBody>(sim);
+    if (!g) { native_set_error("gpu_nbody: null handle"); return FM_E_BADARGS; }
+    if (count > g->n) count = g->n;
+    if (!count) return 0;
+
+    Device* d = g->dev;
+    const VkDeviceSize bytes = (VkDeviceSize)count * sizeof(float) * 4;
+    VkBuffer stage = VK_NULL_HANDLE; VkDeviceMemory stageMem = VK_NULL_HANDLE;
+    if (!create_buffer(d, bytes * 2, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage, &stageMem)) {
+        native_set_error("gpu_nbody_get_bodies: staging allocation failed"); return FM_E_NOMEM;
+    }
+
+    bool ok = false;
+    VkCommandBuffer cb = begin_one_shot(d);
+    if (cb) {
+        VkBufferCopy cp{ 0, 0, bytes };
+        vkCmdCopyBuffer(cb, g->pos[g->cur], stage, 1, &cp);
+        cp.dstOffset = bytes;
+        vkCmdCopyBuffer(cb, g->vel, stage, 1, &cp);
+        ok = end_one_shot(d, cb);
+    }
+
+    if (ok) {
+        void* mapped = nullptr;
+        vkMapMemory(d->device, stageMem, 0, bytes * 2, 0, &mapped);
+        const float* p = static_cast<const float*>(mapped);
+        const float* v = p + (size_t)count * 4;
+        for (uint32_t i = 0; i < count; ++i)
+            for (int k = 0; k < 3; ++k) {
+                if (pos_xyz) pos_xyz[3 * i + k] = (double)p[4 * i + k] + g->origin[k];
+                if (vel_xyz) vel_xyz[3 * i + k] = (double)v[4 * i + k];
+            }
+        vkUnmapMemory(d->device, stageMem);
+    }
+    vkDestroyBuffer(d->device, stage, nullptr);
+    vkFreeMemory(d->device, stageMem, nullptr);
+
+    if (!ok) { native_set_error("gpu_nbody_get_bodies: readback failed"); return FM_E_DEVICE; }
+    return (int)count;
+}
+
+int FM_CALL gpu_nbody_step(fw_handle sim, double dt, uint32_t substeps)
+{
+    auto* g = handle_to<GpuNBody>(sim);
+    if (!g) { native_set_error("gpu_nbody: null handle"); return FM_E_BADARGS; }
+    if (substeps == 0) substeps = 1;
+    g->pending.push_back({ (float)(dt / substeps), substeps });
+    return FM_OK;
+}
+
+int FM_CALL gpu_nbody_draw(fw_handle sim, float r, float g_, float b, float a, float point_size)
+{
+    auto* g = handle_to<GpuNBody>(sim);
+    if (!g) { native_set_error("gpu_nbody: null handle"); return FM_E_BADARGS; }
+    g->drawThisFrame = true;
+    g->color[0] = r; g->color[1] = g_; g->color[2] = b; g->color[3] = a;
+    g->pointSize = point_size > 0 ? point_size : 1.0f;
+    return FM_OK;
+}
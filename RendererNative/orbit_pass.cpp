@@ -0,0 +1,135 @@
+// orbit_pass.cpp
+// Unit-circle strip drawn once per orbit instance (see orbit_pass.h)
+
+#include "orbit_pass.h"
+#include "native_common.h"
+#include "job_system.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const uint32_t VS_ORBIT_SPV[] = {
+#   include "shaders/vs_orbit_instanced.spv.inc"
+};
+static_assert((sizeof(VS_ORBIT_SPV) % 4) == 0, "VS_ORBIT_SPV must be dword aligned");
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, OrbitPass* o)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pcr.offset = 0; pcr.size = sizeof(OrbitPush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &o->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription binds[2]{};
+    binds[0].binding = 0; binds[0].stride = sizeof(float) * 2; binds[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binds[1].binding = 1; binds[1].stride = sizeof(OrbitInstance); binds[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[5]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32_SFLOAT; attrs[0].offset = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        attrs[1 + i].location = 1 + i; attrs[1 + i].binding = 1;
+        attrs[1 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[1 + i].offset = i * sizeof(float) * 4;
+    }
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_ORBIT_SPV; pd.vsBytes = sizeof(VS_ORBIT_SPV);
+    pd.fs = FS_VCOLOR_SPV; pd.fsBytes = FS_VCOLOR_SPV_BYTES;
+    pd.bindings = binds; pd.bindingCount = 2;
+    pd.attrs = attrs; pd.attrCount = 5;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+    pd.blend = BLEND_ALPHA;
+    pd.layout = o->layout;
+    if (!create_graphics_pipeline(d, pd, &o->pipe)) return false;
+
+    // Closed strip: the last point repeats the first.
+    std::vector<float> pts((kOrbitCircleSegments + 1) * 2);
+    for (uint32_t i = 0; i <= kOrbitCircleSegments; ++i) {
+        const double t = 2.0 * 3.14159265358979323846 * (i % kOrbitCircleSegments) / kOrbitCircleSegments;
+        pts[2 * i + 0] = (float)std::cos(t);
+        pts[2 * i + 1] = (float)std::sin(t);
+    }
+    const VkDeviceSize bytes = pts.size() * sizeof(float);
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &o->circle, &o->circleMem)) return false;
+    return upload_buffer(d, o->circle, pts.data(), bytes);
+}
+
+void orbit_release(Device* d)
+{
+    OrbitPass* o = d->orbits;
+    if (!o) return;
+    host_buffer_release(d, o->inst);
+    if (o->circle)    vkDestroyBuffer(d->device, o->circle, nullptr);
+    if (o->circleMem) vkFreeMemory(d->device, o->circleMem, nullptr);
+    destroy_graphics_pipeline(d, &o->pipe);
+    if (o->layout)    vkDestroyPipelineLayout(d->device, o->layout, nullptr);
+    delete o;
+    d->orbits = nullptr;
+}
+
+// ===== frame hook =====
+void orbit_record_draw(Device* d, VkCommandBuffer cb)
+{
+    OrbitPass* o = d->orbits;
+    if (!o || !o->count) return;
+
+    VkBuffer bufs[2]{ o->circle, o->inst.buf };
+    VkDeviceSize offs[2]{ 0, 0 };
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, o->pipe);
+    vkCmdBindVertexBuffers(cb, 0, 2, bufs, offs);
+    OrbitPush op{};
+    std::memcpy(op.viewProj, d->viewProj, sizeof(op.viewProj));
+    op.pickBase = pick_id(FW_PICK_ORBIT, 0);
+    vkCmdPushConstants(cb, o->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(OrbitPush), &op);
+    vkCmdDraw(cb, kOrbitCircleSegments + 1, o->count, 0, 0);
+}
+
+// ===== ABI =====
+// Replaces this frame's orbits. Translations are world positions; they are made relative to
+// the camera origin in double before the float conversion.
+int FM_CALL orbits_upload(fw_handle dev, const fw_orbit_xform* orbits, uint32_t count)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("orbits_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("orbits_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !orbits) { native_set_error("orbits_upload: null orbits"); return FM_E_BADARGS; }
+
+    if (!d->orbits) {
+        auto* o = new OrbitPass();
+        d->orbits = o;
+        if (!create_objects(d, o)) {
+            orbit_release(d);
+            native_set_error("orbits_upload: pipeline/buffer creation failed");
+            return FM_E_DEVICE;
+        }
+    }
+
+    OrbitPass* o = d->orbits;
+    o->count = 0;
+    if (!count) return FM_OK;
+    if (!host_buffer_reserve(d, o->inst, (size_t)count * sizeof(OrbitInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        return FM_E_NOMEM;
+
+    auto* dst = static_cast<OrbitInstance*>(o->inst.mapped);
+    const double* origin = d->origin;
+    parallel_for(count, 4096, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            const fw_orbit_xform& src = orbits[i];
+            OrbitInstance& oi = dst[i];
+            for (int r = 0; r < 3; ++r) {
+                oi.rows[r][0] = (float)src.m[4 * r + 0];
+                oi.rows[r][1] = (float)src.m[4 * r + 1];
+                oi.rows[r][2] = (float)src.m[4 * r + 2];
+                oi.rows[r][3] = (float)(src.m[4 * r + 3] - origin[r]);
+            }
+            std::memcpy(oi.color, src.color, sizeof(oi.color));
+        }
+        });
+
+    o->count = count;
+    return FM_OK;
+}
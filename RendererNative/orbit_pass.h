@@ -0,0 +1,45 @@
+#pragma once
+#include "renderer_device.h"
+
+/*
+    Instanced orbits: every ellipse is an affine image of the unit circle.
+    - One static line strip around the unit circle lives in device-local memory; each orbit
+      contributes a 3x4 matrix (rows, camera-relative translation) and a colour, 64 bytes.
+    - All orbits go out in a single instanced draw. For an ellipse with centre C, semi-axes
+      a, b along unit U, V the matrix columns are (a*U, b*V, 0, C).
+*/
+
+static const uint32_t kOrbitCircleSegments = 256;
+
+struct OrbitPass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    VkBuffer         circle = VK_NULL_HANDLE;       // kOrbitCircleSegments + 1 vec2 points
+    VkDeviceMemory   circleMem = VK_NULL_HANDLE;
+
+    HostBuffer       inst;
+    uint32_t         count = 0;                     // instances uploaded for this frame
+};
+
+// Per-instance data of vs_orbit_instanced.vert (4 x vec4)
+struct OrbitInstance
+{
+    float rows[3][4];   // row-major 3x4, translation relative to the camera origin
+    float color[4];
+};
+
+// Push block of vs_orbit_instanced.vert
+struct OrbitPush
+{
+    float    viewProj[16];
+    uint32_t pickBase;   // pick_id of orbit 0
+};
+
+// Frame hooks (renderer_api.cpp)
+void orbit_record_draw(Device* d, VkCommandBuffer cb);
+void orbit_release(Device* d);
+
+// ABI entry point (see fw_renderer_api)
+int  FM_CALL orbits_upload(fw_handle dev, const fw_orbit_xform* orbits, uint32_t count);
@@ -0,0 +1,286 @@
+// pick_pass.cpp
+// Object-ID attachment and asynchronous pick readback (see pick_pass.h)
+
+#include "pick_pass.h"
+#include "native_common.h"
+#include "nbody_gpu.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const VkFormat kIdFormat = VK_FORMAT_R32_UINT;
+static const uint32_t kPickWindow = 2 * kPickMaxRadius + 1;
+
+// ===== creation / teardown =====
+// Attachment 0 matches swapRp; attachment 1 holds the IDs and ends ready for the copy.
+static bool create_render_pass(Device* d, PickPass* p)
+{
+    VkAttachmentDescription att[2]{};
+    att[0].format = d->swapFmt;
+    att[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    att[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    att[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    att[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    att[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    att[1] = att[0];
+    att[1].format = kIdFormat;
+    att[1].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference cref[2]{
+        { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+        { 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL } };
+    VkSubpassDescription sub{}; sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 2; sub.pColorAttachments = cref;
+
+    // As swapRp: wait for the acquire; the last frame's ID copy finished with its fence.
+    VkSubpassDependency dep{};
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL; dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    rpci.attachmentCount = 2; rpci.pAttachments = att;
+    rpci.subpassCount = 1;    rpci.pSubpasses = &sub;
+    rpci.dependencyCount = 1; rpci.pDependencies = &dep;
+    return vkCreateRenderPass(d->device, &rpci, nullptr, &p->rp) == VK_SUCCESS;
+}
+
+static void destroy_targets(Device* d, PickPass* p)
+{
+    for (auto fb : p->fbs) if (fb) vkDestroyFramebuffer(d->device, fb, nullptr);
+    p->fbs.clear();
+    destroy_image(d, p->ids);
+}
+
+static bool create_targets(Device* d, PickPass* p)
+{
+    if (!create_image(d, d->extent.width, d->extent.height, kIdFormat,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, &p->ids))
+        return false;
+
+    p->fbs.assign(d->views.size(), VK_NULL_HANDLE);
+    for (size_t i = 0; i < d->views.size(); ++i) {
+        VkImageView att[2]{ d->views[i], p->ids.view };
+        VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        fbci.renderPass = p->rp;
+        fbci.attachmentCount = 2; fbci.pAttachments = att;
+        fbci.width = d->extent.width; fbci.height = d->extent.height; fbci.layers = 1;
+        if (vkCreateFramebuffer(d->device, &fbci, nullptr, &p->fbs[i]) != VK_SUCCESS) return false;
+    }
+    return true;
+}
+
+static bool create_objects(Device* d, PickPass* p)
+{
+    if (!create_render_pass(d, p) || !create_targets(d, p)) return false;
+
+    const VkDeviceSize bytes = (VkDeviceSize)kPickWindow * kPickWindow * sizeof(uint32_t);
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &p->buf, &p->mem) &&
+        !create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host, &p->buf, &p->mem))
+        return false;
+    return vkMapMemory(d->device, p->mem, 0, VK_WHOLE_SIZE, 0, &p->mapped) == VK_SUCCESS;
+}
+
+void pick_release(Device* d)
+{
+    PickPass* p = d->pick;
+    if (!p) return;
+    destroy_targets(d, p);
+    if (p->mapped) vkUnmapMemory(d->device, p->mem);
+    if (p->buf)    vkDestroyBuffer(d->device, p->buf, nullptr);
+    if (p->mem)    vkFreeMemory(d->device, p->mem, nullptr);
+    if (p->rp)     vkDestroyRenderPass(d->device, p->rp, nullptr);
+    delete p;
+    d->pick = nullptr;
+    d->rp = d->swapRp;   // the caller rebuilds the scene pipelines if the device lives on
+}
+
+// Swapchain was recreated (device idle): new images need new framebuffers. On failure
+// picking is switched off rather than leaving the scene pass without a target.
+bool pick_resize(Device* d)
+{
+    PickPass* p = d->pick;
+    if (!p) return true;
+    p->inFlight = false;
+    destroy_targets(d, p);
+    if (create_targets(d, p)) return true;
+
+    pick_release(d);
+    rebuild_graphics_pipelines(d);
+    native_log(2, "Vulkan: pick targets could not be resized; picking disabled.");
+    return false;
+}
+
+// ===== frame hooks =====
+// GPU bodies carry one ID range over all sims, in d->gpuSims order (see gpu_nbody_record_draw).
+static void resolve(Device* d, uint32_t id, fw_pick_result* r)
+{
+    r->kind = id >> 28;
+    r->index = id & 0x0FFFFFFFu;
+    r->object = 0;
+    if (r->kind != FW_PICK_BODY) return;
+    uint32_t first = 0;
+    for (GpuNBody* g : d->gpuSims) {
+        if (r->index < first + g->cap) { r->object = to_handle(g); r->index -= first; return; }
+        first += g->cap;
+    }
+    r->kind = FW_PICK_NONE; r->index = 0;   // the sim is gone
+}
+
+// The fence covering the copy has just been waited on.
+void pick_retire(Device* d)
+{
+    PickPass* p = d->pick;
+    if (!p || !p->inFlight) return;
+    p->inFlight = false;
+
+    const uint32_t* ids = static_cast<const uint32_t*>(p->mapped);
+    const int64_t r2 = (int64_t)p->radius * p->radius;
+    int64_t best = r2 + 1;
+    uint32_t bestId = 0;
+    for (uint32_t j = 0; j < p->size.height; ++j) {
+        const int64_t dy = (int64_t)p->origin.y + j - p->y;
+        for (uint32_t i = 0; i < p->size.width; ++i) {
+            const uint32_t id = ids[j * p->size.width + i];
+            if (!id) continue;
+            const int64_t dx = (int64_t)p->origin.x + i - p->x;
+            const int64_t e = dx * dx + dy * dy;
+            if (e < best) { best = e; bestId = id; }
+        }
+    }
+
+    fw_pick_result& r = p->result;
+    r = fw_pick_result{};
+    r.x = p->x; r.y = p->y;
+    if (bestId) {
+        resolve(d, bestId, &r);
+        r.distance = std::sqrt((float)best);
+    }
+    p->hasResult = true;
+}
+
+static void record_copy(Device*, VkCommandBuffer cb, void* user)
+{
+    auto* p = static_cast<PickPass*>(user);
+
+    VkBufferImageCopy r{};
+    r.bufferRowLength = p->size.width;
+    r.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    r.imageOffset = { p->origin.x, p->origin.y, 0 };
+    r.imageExtent = { p->size.width, p->size.height, 1 };
+    vkCmdCopyImageToBuffer(cb, p->ids.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, p->buf, 1, &r);
+
+    // Host reads after the fence; make the writes visible to it.
+    VkBufferMemoryBarrier bb{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    bb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bb.srcQueueFamilyIndex = bb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bb.buffer = p->buf; bb.offset = 0; bb.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bb, 0, nullptr);
+}
+
+RgRes pick_import_ids(Device* d, RenderGraph* g)
+{
+    const GpuImage& ids = d->pick->ids;
+    return rg_import_image(g, ids.img, ids.view, ids.fmt, ids.extent,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, false);
+}
+
+void pick_add_pass(Device* d, RenderGraph* g, RgRes ids)
+{
+    PickPass* p = d->pick;
+    if (!p || !p->requested) return;
+    p->requested = false;
+
+    // Window around the pixel, clipped to the image; nothing to copy = no hit.
+    const int64_t r = p->reqRadius;
+    const int64_t x0 = std::max<int64_t>(0, (int64_t)p->reqX - r), y0 = std::max<int64_t>(0, (int64_t)p->reqY - r);
+    const int64_t x1 = std::min<int64_t>(d->extent.width, (int64_t)p->reqX + r + 1);
+    const int64_t y1 = std::min<int64_t>(d->extent.height, (int64_t)p->reqY + r + 1);
+    if (x0 >= x1 || y0 >= y1) {
+        p->result = fw_pick_result{};
+        p->result.x = p->reqX; p->result.y = p->reqY;
+        p->hasResult = true;
+        return;
+    }
+    p->x = p->reqX; p->y = p->reqY; p->radius = p->reqRadius;
+    p->origin = { (int32_t)x0, (int32_t)y0 };
+    p->size = { (uint32_t)(x1 - x0), (uint32_t)(y1 - y0) };
+    p->inFlight = true;
+
+    const RgRes dst = rg_import_buffer(g, p->buf, (VkDeviceSize)kPickWindow * kPickWindow * sizeof(uint32_t), true);
+    rg_add_pass(g, "pick", &record_copy, p);
+    rg_use(g, ids, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    rg_use(g, dst, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+}
+
+// ===== ABI =====
+// enable 0 drops the ID attachment and renders straight to the swapchain pass again.
+int FM_CALL pick_enable(fw_handle dev, uint32_t enable)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("pick_enable: null device"); return FM_E_BADARGS; }
+    if (d->inFrame && (enable != 0) != (d->pick != nullptr)) {   // switching waits for the device
+        native_set_error("pick_enable: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (!enable) {
+        if (!d->pick) return FM_OK;
+        vkDeviceWaitIdle(d->device);
+        pick_release(d);
+        if (!rebuild_graphics_pipelines(d)) {
+            native_set_error("pick_enable: pipeline rebuild failed"); return FM_E_DEVICE;
+        }
+        return FM_OK;
+    }
+    if (d->pick) return FM_OK;
+    if (!d->swapRp || d->fbs.empty()) { native_set_error("pick_enable: no swapchain"); return FM_E_UNSUPPORTED; }
+    if (d->bloom || !d->windows.empty()) {
+        native_set_error("pick_enable: not available with bloom or extra windows"); return FM_E_UNSUPPORTED;
+    }
+
+    vkDeviceWaitIdle(d->device);
+    auto* p = new PickPass();
+    d->pick = p;
+    if (!create_objects(d, p)) {
+        pick_release(d);
+        native_set_error("pick_enable: ID target/readback creation failed");
+        return FM_E_DEVICE;
+    }
+    d->rp = p->rp;
+    if (!rebuild_graphics_pipelines(d)) {
+        pick_release(d);
+        rebuild_graphics_pipelines(d);
+        native_set_error("pick_enable: scene pipelines could not be rebuilt with the ID attachment");
+        return FM_E_DEVICE;
+    }
+    return FM_OK;
+}
+
+// (x, y) in swapchain pixels; radius is clamped to kPickMaxRadius.
+int FM_CALL pick(fw_handle dev, int32_t x, int32_t y, uint32_t radius)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("pick: null device"); return FM_E_BADARGS; }
+    PickPass* p = d->pick;
+    if (!p) { native_set_error("pick: picking not enabled"); return FM_E_NOTREADY; }
+    p->requested = true;
+    p->reqX = x; p->reqY = y;
+    p->reqRadius = std::min(radius, kPickMaxRadius);
+    return FM_OK;
+}
+
+// Returns 1 and fills *out when a pick has completed since the last poll, FM_E_NOTREADY if
+// none has (or picking is off).
+int FM_CALL pick_poll(fw_handle dev, fw_pick_result* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("pick_poll: null argument"); return FM_E_BADARGS; }
+    PickPass* p = d->pick;
+    if (!p) { native_set_error("pick_poll: picking not enabled"); return FM_E_NOTREADY; }
+    if (!p->hasResult) { native_set_error("pick_poll: no result ready"); return FM_E_NOTREADY; }
+    *out = p->result;
+    p->hasResult = false;
+    return 1;
+}
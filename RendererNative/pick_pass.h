@@ -0,0 +1,57 @@
+#pragma once
+#include "renderer_device.h"
+#include "render_graph.h"
+
+/*
+    GPU object picking.
+    - While enabled the scene pass gets a second, R32_UINT attachment. Every scene fragment
+      shader writes its object ID there (pick_id: kind + instance/body/polyline index, 0 for
+      the background, grid and NDC overlay); translucent objects drawn later win, as on screen.
+    - pick() asks for the ID nearest to a pixel within a radius. The next frame copies that
+      (2r+1)^2 window of IDs into a small host buffer after its scene pass; the frame after
+      reads it once its fence has been waited on anyway. Nothing ever stalls.
+    - The ID attachment is built into the swapchain scene pass, so picking excludes the
+      bloom post chain and extra windows (which need the plain swapchain pass).
+*/
+
+static const uint32_t kPickMaxRadius = 32;
+
+struct PickPass
+{
+    VkRenderPass               rp = VK_NULL_HANDLE;    // swapchain colour + IDs
+    GpuImage                   ids;                    // swapchain extent
+    std::vector<VkFramebuffer> fbs;                    // per swapchain image
+
+    VkBuffer       buf = VK_NULL_HANDLE;               // (2 * kPickMaxRadius + 1)^2 IDs
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    void*          mapped = nullptr;
+
+    // Request for the next frame (the latest pick() wins)
+    bool           requested = false;
+    int32_t        reqX = 0, reqY = 0;
+    uint32_t       reqRadius = 0;
+
+    // Window copied by the frame in flight
+    bool           inFlight = false;
+    int32_t        x = 0, y = 0;
+    uint32_t       radius = 0;
+    VkOffset2D     origin{ 0,0 };
+    VkExtent2D     size{ 0,0 };
+
+    bool           hasResult = false;
+    fw_pick_result result{};
+};
+
+// Frame hooks (renderer_api.cpp). retire runs right after the frame fence wait; the scene
+// pass uses pick_import_ids (colour write, TRANSFER_SRC after the pass) and add_pass then
+// appends the copy when a pick is pending.
+void  pick_retire(Device* d);
+RgRes pick_import_ids(Device* d, RenderGraph* g);
+void  pick_add_pass(Device* d, RenderGraph* g, RgRes ids);
+bool  pick_resize(Device* d);
+void  pick_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL pick_enable(fw_handle dev, uint32_t enable);
+int  FM_CALL pick(fw_handle dev, int32_t x, int32_t y, uint32_t radius);
+int  FM_CALL pick_poll(fw_handle dev, fw_pick_result* out);
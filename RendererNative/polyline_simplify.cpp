@@ -0,0 +1,197 @@
+// polyline_simplify.cpp
+// Douglas-Peucker / Visvalingam-Whyatt simplification on upload (see polyline_simplify.h)
+
+#include "polyline_simplify.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#   include <emmintrin.h>
+#   define FM_SIMPLIFY_SSE2 1
+#endif
+
+// ===== positions =====
+// Fills s.x/y/z and clears s.keep, except for points behind the camera (screen space only),
+// which are marked kept.
+static void load_points(const double* xyz, uint32_t count, const SimplifyParams& p, SimplifyScratch& s)
+{
+    s.x.resize(count); s.y.resize(count); s.z.resize(count);
+    s.keep.assign(count, 0);
+    const float* m = p.viewProj;
+    for (uint32_t i = 0; i < count; ++i) {
+        const float x = (float)(xyz[3 * (size_t)i + 0] - p.origin[0]);
+        const float y = (float)(xyz[3 * (size_t)i + 1] - p.origin[1]);
+        const float z = (float)(xyz[3 * (size_t)i + 2] - p.origin[2]);
+        if (!p.screen) { s.x[i] = x; s.y[i] = y; s.z[i] = z; continue; }
+
+        const float cx = m[0] * x + m[4] * y + m[8] * z + m[12];
+        const float cy = m[1] * x + m[5] * y + m[9] * z + m[13];
+        const float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+        if (!(cw > 1e-6f)) { s.x[i] = s.y[i] = s.z[i] = 0.0f; s.keep[i] = 1; continue; }
+        s.x[i] = (cx / cw * 0.5f + 0.5f) * p.width;
+        s.y[i] = (cy / cw * 0.5f + 0.5f) * p.height;
+        s.z[i] = 0.0f;
+    }
+}
+
+// ===== Douglas-Peucker =====
+static inline float seg_dist2(float dx, float dy, float dz, float ex, float ey, float ez, float inv)
+{
+    const float t = std::min(std::max((dx * ex + dy * ey + dz * ez) * inv, 0.0f), 1.0f);
+    const float rx = dx - t * ex, ry = dy - t * ey, rz = dz - t * ez;
+    return rx * rx + ry * ry + rz * rz;
+}
+
+// Point in (a, b) farthest from the segment a-b (distance to the segment, not the line, so
+// closed loops with a == b still split). Ties go to the lower index.
+static uint32_t farthest(const SimplifyScratch& s, uint32_t a, uint32_t b, float& outDist2)
+{
+    const float ax = s.x[a], ay = s.y[a], az = s.z[a];
+    const float ex = s.x[b] - ax, ey = s.y[b] - ay, ez = s.z[b] - az;
+    const float ee = ex * ex + ey * ey + ez * ez;
+    const float inv = ee > 0 ? 1.0f / ee : 0.0f;
+
+    float best = -1.0f;
+    uint32_t bestIdx = a + 1;
+    uint32_t i = a + 1;
+#if FM_SIMPLIFY_SSE2
+    if (b - i >= 4) {
+        const __m128 vax = _mm_set1_ps(ax), vay = _mm_set1_ps(ay), vaz = _mm_set1_ps(az);
+        const __m128 vex = _mm_set1_ps(ex), vey = _mm_set1_ps(ey), vez = _mm_set1_ps(ez);
+        const __m128 vinv = _mm_set1_ps(inv), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        __m128  vbest = _mm_set1_ps(-1.0f);
+        __m128i vidx = _mm_set1_epi32((int)i);
+        __m128i cur = _mm_setr_epi32((int)i, (int)i + 1, (int)i + 2, (int)i + 3);
+        const __m128i four = _mm_set1_epi32(4);
+        for (; i + 4 <= b; i += 4) {
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&s.x[i]), vax);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&s.y[i]), vay);
+            const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&s.z[i]), vaz);
+            __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, vex), _mm_mul_ps(dy, vey)), _mm_mul_ps(dz, vez)), vinv);
+            t = _mm_min_ps(_mm_max_ps(t, zero), one);
+            const __m128 rx = _mm_sub_ps(dx, _mm_mul_ps(t, vex));
+            const __m128 ry = _mm_sub_ps(dy, _mm_mul_ps(t, vey));
+            const __m128 rz = _mm_sub_ps(dz, _mm_mul_ps(t, vez));
+            const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+            const __m128 gt = _mm_cmpgt_ps(d2, vbest);
+            vbest = _mm_or_ps(_mm_and_ps(gt, d2), _mm_andnot_ps(gt, vbest));
+            const __m128i gti = _mm_castps_si128(gt);
+            vidx = _mm_or_si128(_mm_and_si128(gti, cur), _mm_andnot_si128(gti, vidx));
+            cur = _mm_add_epi32(cur, four);
+        }
+        alignas(16) float lb[4];
+        alignas(16) int32_t li[4];
+        _mm_store_ps(lb, vbest);
+        _mm_store_si128(reinterpret_cast<__m128i*>(li), vidx);
+        for (int k = 0; k < 4; ++k)
+            if (lb[k] > best || (lb[k] == best && (uint32_t)li[k] < bestIdx)) { best = lb[k]; bestIdx = (uint32_t)li[k]; }
+    }
+#endif
+    for (; i < b; ++i) {
+        const float d2 = seg_dist2(s.x[i] - ax, s.y[i] - ay, s.z[i] - az, ex, ey, ez, inv);
+        if (d2 > best) { best = d2; bestIdx = i; }
+    }
+    outDist2 = best;
+    return bestIdx;
+}
+
+static void douglas_peucker(SimplifyScratch& s, uint32_t a, uint32_t b, float tol2)
+{
+    s.keep[a] = s.keep[b] = 1;
+    s.stack.clear();
+    s.stack.push_back(a); s.stack.push_back(b);
+    while (!s.stack.empty()) {
+        const uint32_t e = s.stack.back(); s.stack.pop_back();
+        const uint32_t f = s.stack.back(); s.stack.pop_back();
+        if (e - f < 2) continue;
+        float d2;
+        const uint32_t m = farthest(s, f, e, d2);
+        if (!(d2 > tol2)) continue;
+        s.keep[m] = 1;
+        s.stack.push_back(f); s.stack.push_back(m);
+        s.stack.push_back(m); s.stack.push_back(e);
+    }
+}
+
+// ===== Visvalingam-Whyatt =====
+static inline float tri_area(const SimplifyScratch& s, uint32_t a, uint32_t b, uint32_t c)
+{
+    const float ux = s.x[b] - s.x[a], uy = s.y[b] - s.y[a], uz = s.z[b] - s.z[a];
+    const float vx = s.x[c] - s.x[a], vy = s.y[c] - s.y[a], vz = s.z[c] - s.z[a];
+    const float cx = uy * vz - uz * vy, cy = uz * vx - ux * vz, cz = ux * vy - uy * vx;
+    return 0.5f * std::sqrt(cx * cx + cy * cy + cz * cz);
+}
+
+static void visvalingam(SimplifyScratch& s, uint32_t a, uint32_t b, float minArea)
+{
+    using Entry = SimplifyScratch::Entry;
+    auto later = [](const Entry& u, const Entry& v) { return u.area > v.area; };   // min-heap
+
+    for (uint32_t i = a; i <= b; ++i) {
+        s.keep[i] = 1;
+        s.prev[i] = i - 1;
+        s.next[i] = i + 1;
+        s.stamp[i] = 0;
+    }
+    s.heap.clear();
+    for (uint32_t i = a + 1; i < b; ++i) s.heap.push_back({ tri_area(s, i - 1, i, i + 1), i, 0 });
+    std::make_heap(s.heap.begin(), s.heap.end(), later);
+
+    // Stale entries (stamp changed since push) are skipped. A neighbour's new area never
+    // drops below the one just removed, so removal order stays monotonic.
+    while (!s.heap.empty()) {
+        std::pop_heap(s.heap.begin(), s.heap.end(), later);
+        const Entry en = s.heap.back();
+        s.heap.pop_back();
+        if (en.stamp != s.stamp[en.point]) continue;
+        if (!(en.area < minArea)) break;
+
+        const uint32_t i = en.point, p = s.prev[i], n = s.next[i];
+        s.keep[i] = 0;
+        s.next[p] = n;
+        s.prev[n] = p;
+        if (p > a) {
+            s.heap.push_back({ std::max(en.area, tri_area(s, s.prev[p], p, n)), p, ++s.stamp[p] });
+            std::push_heap(s.heap.begin(), s.heap.end(), later);
+        }
+        if (n < b) {
+            s.heap.push_back({ std::max(en.area, tri_area(s, p, n, s.next[n])), n, ++s.stamp[n] });
+            std::push_heap(s.heap.begin(), s.heap.end(), later);
+        }
+    }
+}
+
+// ===== entry point =====
+uint32_t simplify_polyline(const double* xyz, uint32_t count, const SimplifyParams& p,
+    SimplifyScratch& s, std::vector<uint32_t>& out)
+{
+    out.clear();
+    if (p.method == FW_SIMPLIFY_OFF || !(p.tolerance > 0) || count < 3) {
+        out.resize(count);
+        for (uint32_t i = 0; i < count; ++i) out[i] = i;
+        return count;
+    }
+
+    load_points(xyz, count, p, s);
+    if (p.method == FW_SIMPLIFY_VISVALINGAM) {
+        s.prev.resize(count); s.next.resize(count); s.stamp.resize(count);
+    }
+    const float tol2 = p.tolerance * p.tolerance;
+
+    // Runs of visible points between points behind the camera (kept already); in world
+    // space the whole polyline is one run.
+    uint32_t i = 0;
+    while (i < count) {
+        if (s.keep[i]) { ++i; continue; }
+        uint32_t e = i;
+        while (e + 1 < count && !s.keep[e + 1]) ++e;
+        if (p.method == FW_SIMPLIFY_VISVALINGAM) visvalingam(s, i, e, 0.5f * tol2);
+        else douglas_peucker(s, i, e, tol2);
+        i = e + 1;
+    }
+
+    for (uint32_t k = 0; k < count; ++k)
+        if (s.keep[k]) out.push_back(k);
+    return (uint32_t)out.size();
+}
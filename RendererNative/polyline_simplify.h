@@ -0,0 +1,45 @@
+#pragma once
+#include "renderer_api.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Polyline simplification for upload (see lines_set_simplify).
+    - Works on float positions relative to the camera origin, i.e. at the precision the
+      vertices are drawn with; in screen space on pixel positions through the camera.
+    - Douglas-Peucker keeps the farthest point from the current chord while it is beyond the
+      tolerance; the scan over a range runs 4 points at a time (SSE2) on SoA arrays.
+    - Visvalingam-Whyatt drops the point with the smallest triangle (with its neighbours)
+      while that area is below tolerance^2 / 2, the triangle a point tolerance away from a
+      chord of length tolerance would span.
+    - Screen-space points behind the camera are always kept and split the polyline, so each
+      visible run is simplified on its own.
+    - The first and last points are always kept. Scratch is reused between calls; one
+      SimplifyScratch per thread.
+*/
+
+struct SimplifyParams
+{
+    uint32_t method = FW_SIMPLIFY_OFF;
+    bool     screen = false;
+    float    tolerance = 0.0f;        // world units or pixels
+    double   origin[3]{ 0,0,0 };
+    float    viewProj[16]{};          // column-major, relative to origin (screen only)
+    float    width = 0, height = 0;   // viewport in pixels (screen only)
+};
+
+struct SimplifyScratch
+{
+    std::vector<float>    x, y, z;    // SoA positions (z = 0 in screen space)
+    std::vector<uint8_t>  keep;
+    std::vector<uint32_t> stack;      // Douglas-Peucker ranges
+    std::vector<uint32_t> prev, next; // Visvalingam linked list
+    struct Entry { float area; uint32_t point, stamp; };
+    std::vector<Entry>    heap;
+    std::vector<uint32_t> stamp;
+};
+
+// Indices of the points to keep, ascending, into `out` (cleared first). Returns out.size().
+uint32_t simplify_polyline(const double* xyz, uint32_t count, const SimplifyParams& p,
+    SimplifyScratch& s, std::vector<uint32_t>& out);
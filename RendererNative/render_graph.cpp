@@ -0,0 +1,544 @@
+// render_graph.cpp
+// Pass culling, barrier insertion and transient aliasing (see render_graph.h)
+
+#include "render_graph.h"
+#include "native_common.h"
+
+#include <algorithm>
+
+static const VkAccessFlags2 kWriteAccess =
+    VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+// ===== building =====
+void rg_reset(RenderGraph* g)
+{
+    g->res.clear();
+    g->passes.clear();
+    g->uses.clear();
+    g->order.clear();
+}
+
+RgRes rg_import_image(RenderGraph* g, VkImage img, VkImageView view, VkFormat fmt, VkExtent2D extent,
+    VkImageLayout initial, VkImageLayout final_layout, bool output)
+{
+    RgResource r;
+    r.image = img; r.view = view; r.fmt = fmt; r.extent = extent;
+    r.initialLayout = initial; r.finalLayout = final_layout; r.output = output;
+    g->res.push_back(r);
+    return (RgRes)g->res.size() - 1;
+}
+
+RgRes rg_import_buffer(RenderGraph* g, VkBuffer buf, VkDeviceSize size, bool output)
+{
+    RgResource r;
+    r.isImage = false; r.buffer = buf; r.size = size; r.output = output;
+    g->res.push_back(r);
+    return (RgRes)g->res.size() - 1;
+}
+
+RgRes rg_create_image(RenderGraph* g, uint32_t w, uint32_t h, VkFormat fmt, VkImageUsageFlags usage)
+{
+    RgResource r;
+    r.transient = true; r.fmt = fmt; r.extent = { w, h }; r.imageUsage = usage;
+    g->res.push_back(r);
+    return (RgRes)g->res.size() - 1;
+}
+
+RgRes rg_create_buffer(RenderGraph* g, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    RgResource r;
+    r.isImage = false; r.transient = true; r.size = size; r.bufferUsage = usage;
+    g->res.push_back(r);
+    return (RgRes)g->res.size() - 1;
+}
+
+void rg_add_pass(RenderGraph* g, const char* name, rg_record_fn fn, void* user, uint32_t flags)
+{
+    RgPass p;
+    p.name = name; p.fn = fn; p.user = user; p.flags = flags;
+    p.firstUse = (uint32_t)g->uses.size();
+    g->passes.push_back(p);
+}
+
+// A second use of the same resource by the same pass is folded into the first.
+void rg_use(RenderGraph* g, RgRes res, VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+    VkImageLayout layout, VkImageLayout layout_out)
+{
+    if (g->passes.empty() || res >= g->res.size()) return;
+    RgPass& p = g->passes.back();
+    for (uint32_t i = p.firstUse; i < p.firstUse + p.useCount; ++i) {
+        RgUse& u = g->uses[i];
+        if (u.res != res) continue;
+        u.stages |= stages; u.access |= access;
+        if (layout_out != VK_IMAGE_LAYOUT_UNDEFINED) u.layoutOut = layout_out;
+        return;
+    }
+    RgUse u;
+    u.res = res; u.stages = stages; u.access = access; u.layout = layout; u.layoutOut = layout_out;
+    g->uses.push_back(u);
+    ++p.useCount;
+}
+
+VkImage     rg_image(const RenderGraph* g, RgRes r)  { return r < g->res.size() ? g->res[r].image : VK_NULL_HANDLE; }
+VkImageView rg_view(const RenderGraph* g, RgRes r)   { return r < g->res.size() ? g->res[r].view : VK_NULL_HANDLE; }
+VkBuffer    rg_buffer(const RenderGraph* g, RgRes r) { return r < g->res.size() ? g->res[r].buffer : VK_NULL_HANDLE; }
+
+// ===== compile =====
+static bool use_reads(const RgUse& u)
+{
+    return (u.access & ~kWriteAccess) != 0;
+}
+
+static bool use_writes(const RgUse& u)
+{
+    return (u.access & kWriteAccess) != 0 || u.layoutOut != VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+// Walks passes backwards from the outputs; a pass lives if something live (or the host)
+// consumes one of its writes. A discarding write ends the demand for earlier writers.
+static void cull(RenderGraph* g)
+{
+    std::vector<uint8_t> needed(g->res.size(), 0);
+    for (size_t i = 0; i < g->res.size(); ++i) needed[i] = g->res[i].output ? 1 : 0;
+
+    for (size_t pi = g->passes.size(); pi-- > 0;) {
+        RgPass& p = g->passes[pi];
+        bool live = (p.flags & RG_PASS_SIDE_EFFECT) != 0;
+        for (uint32_t i = p.firstUse; i < p.firstUse + p.useCount && !live; ++i)
+            live = use_writes(g->uses[i]) && needed[g->uses[i].res];
+        p.live = live;
+        if (!live) continue;
+
+        for (uint32_t i = p.firstUse; i < p.firstUse + p.useCount; ++i) {
+            const RgUse& u = g->uses[i];
+            if (use_reads(u)) needed[u.res] = 1;
+            else if (use_writes(u) && !g->res[u.res].output) needed[u.res] = 0;
+        }
+    }
+
+    g->culled = 0;
+    for (uint32_t pi = 0; pi < (uint32_t)g->passes.size(); ++pi) {
+        if (g->passes[pi].live) g->order.push_back(pi);
+        else ++g->culled;
+    }
+}
+
+static void compute_lifetimes(RenderGraph* g)
+{
+    for (uint32_t k = 0; k < (uint32_t)g->order.size(); ++k) {
+        const RgPass& p = g->passes[g->order[k]];
+        for (uint32_t i = p.firstUse; i < p.firstUse + p.useCount; ++i) {
+            const RgUse& u = g->uses[i];
+            RgResource& r = g->res[u.res];
+            if (r.first == kRgNone) r.first = k;
+            r.last = k;
+            r.lastStages = u.stages;
+            r.lastAccess = u.access;
+        }
+    }
+}
+
+// ===== transient placement =====
+static uint64_t hash_mix(uint64_t h, uint64_t v)
+{
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static void destroy_pool(Device* d, RenderGraph* g)
+{
+    for (RgTransient& t : g->pool) {
+        if (t.view)   vkDestroyImageView(d->device, t.view, nullptr);
+        if (t.image)  vkDestroyImage(d->device, t.image, nullptr);
+        if (t.buffer) vkDestroyBuffer(d->device, t.buffer, nullptr);
+    }
+    for (VkDeviceMemory m : g->heaps) vkFreeMemory(d->device, m, nullptr);
+    g->pool.clear();
+    g->heaps.clear();
+    g->poolKey = 0;
+    g->heapBytes = 0;
+}
+
+struct Placement
+{
+    uint32_t     res;
+    uint32_t     memType;
+    VkDeviceSize size, align;
+};
+
+static bool lifetimes_overlap(const RgResource& a, const RgResource& b)
+{
+    return a.first <= b.last && b.first <= a.last;
+}
+
+// Creates the physical objects for every live transient in creation order, then places
+// them largest first: each one goes at the lowest offset that does not collide with an
+// already placed resource whose lifetime overlaps its own.
+static bool build_pool(Device* d, RenderGraph* g, const std::vector<uint32_t>& live)
+{
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(d->phys, &props);
+    const VkDeviceSize granularity = std::max<VkDeviceSize>(props.limits.bufferImageGranularity, 1);
+
+    g->pool.resize(live.size());
+    std::vector<Placement> items(live.size());
+    for (uint32_t s = 0; s < (uint32_t)live.size(); ++s) {
+        RgResource& r = g->res[live[s]];
+        RgTransient& t = g->pool[s];
+        VkMemoryRequirements mr{};
+        if (r.isImage) {
+            VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            ici.imageType = VK_IMAGE_TYPE_2D;
+            ici.format = r.fmt;
+            ici.extent = { r.extent.width, r.extent.height, 1 };
+            ici.mipLevels = 1; ici.arrayLayers = 1;
+            ici.samples = VK_SAMPLE_COUNT_1_BIT;
+            ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+            ici.usage = r.imageUsage;
+            ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if (vkCreateImage(d->device, &ici, nullptr, &t.image) != VK_SUCCESS) return false;
+            vkGetImageMemoryRequirements(d->device, t.image, &mr);
+        }
+        else {
+            VkBufferCreateInfo bci{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+            bci.size = r.size; bci.usage = r.bufferUsage;
+            bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkCreateBuffer(d->device, &bci, nullptr, &t.buffer) != VK_SUCCESS) return false;
+            vkGetBufferMemoryRequirements(d->device, t.buffer, &mr);
+        }
+        const uint32_t mt = find_memtype(d->phys, mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (mt == UINT32_MAX) return false;
+        // Every start on a granularity boundary, so linear and optimal neighbours never
+        // share a page whatever the placement.
+        items[s] = { s, mt, mr.size, std::max(mr.alignment, granularity) };
+        t.size = mr.size;
+    }
+
+    std::vector<uint32_t> bySize(items.size());
+    for (uint32_t i = 0; i < (uint32_t)bySize.size(); ++i) bySize[i] = i;
+    std::stable_sort(bySize.begin(), bySize.end(),
+        [&](uint32_t a, uint32_t b) { return items[a].size > items[b].size; });
+
+    std::vector<uint32_t> heapType;      // memory type per heap
+    std::vector<VkDeviceSize> heapSize;
+    std::vector<uint32_t> placed;
+    for (uint32_t s : bySize) {
+        const Placement& it = items[s];
+        const RgResource& r = g->res[live[s]];
+        RgTransient& t = g->pool[s];
+
+        uint32_t heap = 0;
+        while (heap < heapType.size() && heapType[heap] != it.memType) ++heap;
+        if (heap == heapType.size()) { heapType.push_back(it.memType); heapSize.push_back(0); }
+        t.heap = heap;
+
+        // Candidates: 0 and the end of every conflicting neighbour. Few transients per
+        // frame, so the quadratic scan is cheaper than anything cleverer.
+        VkDeviceSize best = VK_WHOLE_SIZE;
+        auto fits = [&](VkDeviceSize off) {
+            for (uint32_t o : placed) {
+                const RgTransient& ot = g->pool[o];
+                if (ot.heap != heap || !lifetimes_overlap(r, g->res[live[o]])) continue;
+                if (off < ot.offset + ot.size && ot.offset < off + it.size) return false;
+            }
+            return true;
+        };
+        if (fits(0)) best = 0;
+        for (uint32_t o : placed) {
+            const RgTransient& ot = g->pool[o];
+            if (ot.heap != heap || !lifetimes_overlap(r, g->res[live[o]])) continue;
+            const VkDeviceSize off = (ot.offset + ot.size + it.align - 1) / it.align * it.align;
+            if (off < best && fits(off)) best = off;
+        }
+        t.offset = best;
+        heapSize[heap] = std::max(heapSize[heap], best + it.size);
+        placed.push_back(s);
+    }
+
+    // Aliasing hazards: a transient whose range was used earlier in the frame by another
+    // one waits on that resource's last use.
+    for (uint32_t a = 0; a < (uint32_t)live.size(); ++a) {
+        RgTransient& ta = g->pool[a];
+        const RgResource& ra = g->res[live[a]];
+        for (uint32_t b = 0; b < (uint32_t)live.size(); ++b) {
+            const RgTransient& tb = g->pool[b];
+            const RgResource& rb = g->res[live[b]];
+            if (a == b || ta.heap != tb.heap || rb.last >= ra.first) continue;
+            if (ta.offset < tb.offset + tb.size && tb.offset < ta.offset + ta.size) {
+                ta.aliasStages |= rb.lastStages;
+                ta.aliasAccess |= rb.lastAccess & kWriteAccess;
+            }
+        }
+    }
+
+    g->heaps.assign(heapType.size(), VK_NULL_HANDLE);
+    for (size_t h = 0; h < heapType.size(); ++h) {
+        VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        mai.allocationSize = heapSize[h]; mai.memoryTypeIndex = heapType[h];
+        if (vkAllocateMemory(d->device, &mai, nullptr, &g->heaps[h]) != VK_SUCCESS) return false;
+        g->heapBytes += heapSize[h];
+    }
+
+    for (uint32_t s = 0; s < (uint32_t)live.size(); ++s) {
+        RgTransient& t = g->pool[s];
+        const RgResource& r = g->res[live[s]];
+        if (t.image) {
+            if (vkBindImageMemory(d->device, t.image, g->heaps[t.heap], t.offset) != VK_SUCCESS) return false;
+            VkImageViewCreateInfo vci{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+            vci.image = t.image; vci.viewType = VK_IMAGE_VIEW_TYPE_2D; vci.format = r.fmt;
+            vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+            if (vkCreateImageView(d->device, &vci, nullptr, &t.view) != VK_SUCCESS) return false;
+        }
+        else if (vkBindBufferMemory(d->device, t.buffer, g->heaps[t.heap], t.offset) != VK_SUCCESS) return false;
+    }
+    return true;
+}
+
+static bool place_transients(Device* d, RenderGraph* g)
+{
+    std::vector<uint32_t> live;
+    uint64_t key = 0x51ED270B2C3A4F1Dull;
+    g->transientBytes = 0;
+    for (uint32_t i = 0; i < (uint32_t)g->res.size(); ++i) {
+        const RgResource& r = g->res[i];
+        if (!r.transient || r.first == kRgNone) continue;
+        live.push_back(i);
+        key = hash_mix(key, r.isImage ? 1 : 2);
+        key = hash_mix(key, r.isImage ? ((uint64_t)r.extent.width << 32 | r.extent.height) : r.size);
+        key = hash_mix(key, r.isImage ? ((uint64_t)r.fmt << 32 | r.imageUsage) : r.bufferUsage);
+        key = hash_mix(key, (uint64_t)r.first << 32 | r.last);
+    }
+    if (live.empty()) { if (!g->pool.empty()) destroy_pool(d, g); return true; }
+
+    if (key != g->poolKey || g->pool.size() != live.size()) {
+        destroy_pool(d, g);
+        if (!build_pool(d, g, live)) {
+            destroy_pool(d, g);
+            native_set_error("render graph: transient allocation failed");
+            return false;
+        }
+        g->poolKey = key;
+        ++g->poolGeneration;
+    }
+
+    for (uint32_t s = 0; s < (uint32_t)live.size(); ++s) {
+        RgResource& r = g->res[live[s]];
+        const RgTransient& t = g->pool[s];
+        r.slot = s;
+        r.image = t.image; r.view = t.view; r.buffer = t.buffer;
+        g->transientBytes += t.size;
+    }
+    return true;
+}
+
+// ===== barriers =====
+// What the frame has done to a resource so far.
+struct RgState
+{
+    VkPipelineStageFlags2 writeStages = 0;   // last write
+    VkAccessFlags2        writeAccess = 0;
+    VkPipelineStageFlags2 readStages = 0;    // reads since, for write-after-read
+    VkPipelineStageFlags2 visStages = 0;     // stages/accesses the last write is visible to
+    VkAccessFlags2        visAccess = 0;
+    VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+static VkPipelineStageFlags legacy_stages(VkPipelineStageFlags2 s, VkPipelineStageFlags none)
+{
+    if (!s) return none;
+    VkPipelineStageFlags out = (VkPipelineStageFlags)(s & 0xFFFFFFFFull);
+    if (s >> 32) out |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;   // copy/blit/resolve etc.
+    return out;
+}
+
+static VkAccessFlags legacy_access(VkAccessFlags2 a)
+{
+    VkAccessFlags out = (VkAccessFlags)(a & 0xFFFFFFFFull);
+    if (a & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) out |= VK_ACCESS_SHADER_READ_BIT;
+    if (a & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) out |= VK_ACCESS_SHADER_WRITE_BIT;
+    return out;
+}
+
+static void flush_barriers(Device* d, RenderGraph* g, VkCommandBuffer cb)
+{
+    if (g->imageBarriers.empty() && g->bufferBarriers.empty() && g->memoryBarriers.empty()) return;
+    ++g->barrierBatches;
+
+    if (d->cmdBarrier2) {
+        VkDependencyInfo di{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        di.memoryBarrierCount = (uint32_t)g->memoryBarriers.size();
+        di.pMemoryBarriers = g->memoryBarriers.data();
+        di.imageMemoryBarrierCount = (uint32_t)g->imageBarriers.size();
+        di.pImageMemoryBarriers = g->imageBarriers.data();
+        di.bufferMemoryBarrierCount = (uint32_t)g->bufferBarriers.size();
+        di.pBufferMemoryBarriers = g->bufferBarriers.data();
+        d->cmdBarrier2(cb, &di);
+    }
+    else {
+        VkPipelineStageFlags2 src = 0, dst = 0;
+        std::vector<VkImageMemoryBarrier> ib(g->imageBarriers.size(), { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER });
+        std::vector<VkBufferMemoryBarrier> bb(g->bufferBarriers.size(), { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER });
+        std::vector<VkMemoryBarrier> mb(g->memoryBarriers.size(), { VK_STRUCTURE_TYPE_MEMORY_BARRIER });
+        for (size_t i = 0; i < ib.size(); ++i) {
+            const VkImageMemoryBarrier2& b = g->imageBarriers[i];
+            src |= b.srcStageMask; dst |= b.dstStageMask;
+            ib[i].srcAccessMask = legacy_access(b.srcAccessMask);
+            ib[i].dstAccessMask = legacy_access(b.dstAccessMask);
+            ib[i].oldLayout = b.oldLayout; ib[i].newLayout = b.newLayout;
+            ib[i].srcQueueFamilyIndex = ib[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            ib[i].image = b.image; ib[i].subresourceRange = b.subresourceRange;
+        }
+        for (size_t i = 0; i < bb.size(); ++i) {
+            const VkBufferMemoryBarrier2& b = g->bufferBarriers[i];
+            src |= b.srcStageMask; dst |= b.dstStageMask;
+            bb[i].srcAccessMask = legacy_access(b.srcAccessMask);
+            bb[i].dstAccessMask = legacy_access(b.dstAccessMask);
+            bb[i].srcQueueFamilyIndex = bb[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bb[i].buffer = b.buffer; bb[i].offset = b.offset; bb[i].size = b.size;
+        }
+        for (size_t i = 0; i < mb.size(); ++i) {
+            const VkMemoryBarrier2& b = g->memoryBarriers[i];
+            src |= b.srcStageMask; dst |= b.dstStageMask;
+            mb[i].srcAccessMask = legacy_access(b.srcAccessMask);
+            mb[i].dstAccessMask = legacy_access(b.dstAccessMask);
+        }
+        vkCmdPipelineBarrier(cb, legacy_stages(src, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+            legacy_stages(dst, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT), 0, (uint32_t)mb.size(), mb.data(),
+            (uint32_t)bb.size(), bb.data(), (uint32_t)ib.size(), ib.data());
+    }
+    g->imageBarriers.clear();
+    g->bufferBarriers.clear();
+    g->memoryBarriers.clear();
+}
+
+// An image with no layout to go to (still UNDEFINED, its pass transitions it itself) only
+// needs the dependency: that goes out as a global memory barrier, never as an image
+// barrier with newLayout UNDEFINED.
+static void push_barrier(RenderGraph* g, const RgResource& r, VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+    VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess, VkImageLayout from, VkImageLayout to)
+{
+    if (r.isImage && to == VK_IMAGE_LAYOUT_UNDEFINED) {
+        VkMemoryBarrier2 b{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        b.srcStageMask = srcStages; b.srcAccessMask = srcAccess;
+        b.dstStageMask = dstStages; b.dstAccessMask = dstAccess;
+        g->memoryBarriers.push_back(b);
+    }
+    else if (r.isImage) {
+        VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        b.srcStageMask = srcStages; b.srcAccessMask = srcAccess;
+        b.dstStageMask = dstStages; b.dstAccessMask = dstAccess;
+        b.oldLayout = from; b.newLayout = to;
+        b.srcQueueFamilyIndex = b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = r.image;
+        b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        g->imageBarriers.push_back(b);
+    }
+    else {
+        VkBufferMemoryBarrier2 b{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+        b.srcStageMask = srcStages; b.srcAccessMask = srcAccess;
+        b.dstStageMask = dstStages; b.dstAccessMask = dstAccess;
+        b.srcQueueFamilyIndex = b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.buffer = r.buffer; b.offset = 0; b.size = VK_WHOLE_SIZE;
+        g->bufferBarriers.push_back(b);
+    }
+}
+
+// Adds whatever `u` needs against the state left by earlier passes, then advances it.
+static void sync_use(RenderGraph* g, const RgUse& u, RgState& st)
+{
+    const RgResource& r = g->res[u.res];
+    const bool reads = use_reads(u);
+    const bool writes = (u.access & kWriteAccess) != 0;
+    const bool transition = r.isImage && u.layout != VK_IMAGE_LAYOUT_UNDEFINED && u.layout != st.layout;
+    const VkPipelineStageFlags2 prior = st.writeStages | st.readStages;
+
+    if (transition || (writes && prior)) {
+        // Discarding uses drop the old contents, which also lets the transition skip them;
+        // a transient's first use so goes UNDEFINED -> its layout.
+        const VkImageLayout from = reads ? st.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        const VkImageLayout to = transition ? u.layout : st.layout;
+        push_barrier(g, r, prior, st.writeAccess, u.stages, u.access, from, to);
+        st.visStages = u.stages; st.visAccess = u.access;
+    }
+    else if (reads && st.writeStages && ((u.stages & ~st.visStages) || (u.access & ~st.visAccess))) {
+        push_barrier(g, r, st.writeStages, st.writeAccess, u.stages, u.access & ~kWriteAccess, st.layout, st.layout);
+        st.visStages |= u.stages; st.visAccess |= u.access;
+    }
+
+    if (u.layout != VK_IMAGE_LAYOUT_UNDEFINED) st.layout = u.layout;
+    if (u.layoutOut != VK_IMAGE_LAYOUT_UNDEFINED) st.layout = u.layoutOut;
+    if (writes || u.layoutOut != VK_IMAGE_LAYOUT_UNDEFINED) {
+        st.writeStages = u.stages;
+        st.writeAccess = u.access & kWriteAccess;
+        st.readStages = 0;
+        st.visStages = 0; st.visAccess = 0;
+    }
+    else st.readStages |= u.stages;
+}
+
+// ===== execute =====
+bool rg_execute(Device* d, RenderGraph* g, VkCommandBuffer cb)
+{
+    g->order.clear();
+    g->barrierBatches = 0;
+    cull(g);
+    compute_lifetimes(g);
+    if (!place_transients(d, g)) return false;
+
+    std::vector<RgState> state(g->res.size());
+    for (uint32_t i = 0; i < (uint32_t)g->res.size(); ++i) {
+        const RgResource& r = g->res[i];
+        state[i].layout = r.initialLayout;
+        if (r.slot != kRgNone) {
+            state[i].writeStages = g->pool[r.slot].aliasStages;
+            state[i].writeAccess = g->pool[r.slot].aliasAccess;
+        }
+    }
+
+    for (uint32_t pi : g->order) {
+        const RgPass& p = g->passes[pi];
+        for (uint32_t i = p.firstUse; i < p.firstUse + p.useCount; ++i)
+            sync_use(g, g->uses[i], state[g->uses[i].res]);
+        flush_barriers(d, g, cb);
+        p.fn(d, cb, p.user);
+    }
+
+    // Imported images handed back in the layout their owner expects.
+    for (uint32_t i = 0; i < (uint32_t)g->res.size(); ++i) {
+        const RgResource& r = g->res[i];
+        RgState& st = state[i];
+        if (!r.isImage || r.transient || r.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || r.finalLayout == st.layout) continue;
+        if (r.first == kRgNone) continue;   // untouched this frame
+        push_barrier(g, r, st.writeStages | st.readStages, st.writeAccess,
+            VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, 0, st.layout, r.finalLayout);
+    }
+    flush_barriers(d, g, cb);
+    return true;
+}
+
+void rg_release(Device* d)
+{
+    RenderGraph* g = d->graph;
+    if (!g) return;
+    destroy_pool(d, g);
+    delete g;
+    d->graph = nullptr;
+}
+
+// ===== ABI =====
+int FM_CALL render_graph_get_stats(fw_handle dev, fw_render_graph_stats* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("render_graph_get_stats: null argument"); return FM_E_BADARGS; }
+    *out = fw_render_graph_stats{};
+    if (const RenderGraph* g = d->graph) {
+        out->passes = (uint32_t)g->order.size();
+        out->culled = g->culled;
+        out->barrier_batches = g->barrierBatches;
+        out->transient_bytes = g->transientBytes;
+        out->heap_bytes = g->heapBytes;
+    }
+    return FM_OK;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "renderer_device.h"
+
+#include <vector>
+
+/*
+    Per-frame render graph: passes declare the images and buffers they touch, the graph
+    culls passes whose results nobody consumes, inserts the barriers between the rest and
+    places transient resources in shared memory.
+    - Declaration order is submission order, like recording a command buffer; hazards
+      between passes are derived from it and culled passes simply drop out.
+    - Barriers are batched per pass (one vkCmdPipelineBarrier2 with every image/buffer
+      barrier the pass needs). Read-after-read in the same layout needs none; without
+      synchronization2 the same barriers go out through vkCmdPipelineBarrier.
+    - Transients live only between their first and last live use. Resources whose
+      lifetimes do not overlap share memory; the first use of an aliased range waits on
+      the last use of whatever held it before. Placement is cached and redone only when
+      the set of transients or their lifetimes change.
+    - Imported resources (swapchain image, pass-owned targets) start the frame in their
+      given layout; cross-frame hazards stay with the frame fence and render pass deps.
+*/
+
+typedef uint32_t RgRes;
+static const RgRes kRgNone = 0xFFFFFFFFu;
+
+typedef void (*rg_record_fn)(Device* d, VkCommandBuffer cb, void* user);
+
+enum RgPassFlags
+{
+    RG_PASS_SIDE_EFFECT = 1,   // never culled (host-visible results, internal state)
+};
+
+// One resource as seen by one pass. For images `layout` is what the pass expects at its
+// start; UNDEFINED means the pass transitions it itself (render pass initialLayout) and
+// `layoutOut` is where it leaves it (finalLayout). A use without read access discards.
+struct RgUse
+{
+    RgRes                 res = kRgNone;
+    VkPipelineStageFlags2 stages = 0;
+    VkAccessFlags2        access = 0;
+    VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout         layoutOut = VK_IMAGE_LAYOUT_UNDEFINED;   // UNDEFINED = unchanged
+};
+
+struct RgResource
+{
+    bool                  isImage = true;
+    bool                  transient = false;
+    bool                  output = false;       // consumed after the frame: a culling root
+    VkImage               image = VK_NULL_HANDLE;
+    VkImageView           view = VK_NULL_HANDLE;
+    VkFormat              fmt = VK_FORMAT_UNDEFINED;
+    VkExtent2D            extent{ 0,0 };
+    VkImageUsageFlags     imageUsage = 0;
+    VkBuffer              buffer = VK_NULL_HANDLE;
+    VkDeviceSize          size = 0;
+    VkBufferUsageFlags    bufferUsage = 0;
+    VkImageLayout         initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout         finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;  // UNDEFINED = leave as is
+
+    // compile results
+    uint32_t              first = kRgNone, last = 0;   // live pass positions
+    VkPipelineStageFlags2 lastStages = 0;
+    VkAccessFlags2        lastAccess = 0;
+    uint32_t              slot = kRgNone;              // transient pool entry
+};
+
+struct RgPass
+{
+    const char*  name = nullptr;
+    rg_record_fn fn = nullptr;
+    void*        user = nullptr;
+    uint32_t     flags = 0;
+    uint32_t     firstUse = 0, useCount = 0;
+    bool         live = false;
+};
+
+// Physical object behind a transient, kept across frames while the layout is unchanged.
+struct RgTransient
+{
+    VkImage        image = VK_NULL_HANDLE;
+    VkImageView    view = VK_NULL_HANDLE;
+    VkBuffer       buffer = VK_NULL_HANDLE;
+    uint32_t       heap = 0;
+    VkDeviceSize   offset = 0, size = 0;
+    // waited on by the first use: last use of everything placed earlier in this range
+    VkPipelineStageFlags2 aliasStages = 0;
+    VkAccessFlags2        aliasAccess = 0;
+};
+
+struct RenderGraph
+{
+    std::vector<RgResource> res;
+    std::vector<RgPass>     passes;
+    std::vector<RgUse>      uses;
+    std::vector<uint32_t>   order;        // live passes, execution order
+
+    std::vector<RgTransient>    pool;
+    std::vector<VkDeviceMemory> heaps;
+    uint64_t                    poolKey = 0;
+    uint32_t                    poolGeneration = 0;   // bumped whenever transients get new objects
+
+    std::vector<VkImageMemoryBarrier2>  imageBarriers;   // scratch, one pass at a time
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    std::vector<VkMemoryBarrier2>       memoryBarriers;  // images whose pass does its own transition
+
+    // last execute
+    uint32_t     culled = 0;
+    uint32_t     barrierBatches = 0;
+    VkDeviceSize transientBytes = 0;    // sum of transient sizes
+    VkDeviceSize heapBytes = 0;         // memory actually bound after aliasing
+};
+
+// Frame building. Uses attach to the most recently added pass.
+void        rg_reset(RenderGraph* g);
+RgRes       rg_import_image(RenderGraph* g, VkImage img, VkImageView view, VkFormat fmt, VkExtent2D extent,
+                VkImageLayout initial, VkImageLayout final_layout, bool output);
+RgRes       rg_import_buffer(RenderGraph* g, VkBuffer buf, VkDeviceSize size, bool output);
+RgRes       rg_create_image(RenderGraph* g, uint32_t w, uint32_t h, VkFormat fmt, VkImageUsageFlags usage);
+RgRes       rg_create_buffer(RenderGraph* g, VkDeviceSize size, VkBufferUsageFlags usage);
+void        rg_add_pass(RenderGraph* g, const char* name, rg_record_fn fn, void* user, uint32_t flags = 0);
+void        rg_use(RenderGraph* g, RgRes res, VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+                VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout layout_out = VK_IMAGE_LAYOUT_UNDEFINED);
+
+// Culls, places transients and records every live pass into cb. Call after the frame
+// fence wait: transients from the previous layout are destroyed when it changes.
+bool        rg_execute(Device* d, RenderGraph* g, VkCommandBuffer cb);
+
+// Physical handles, valid inside pass callbacks.
+VkImage     rg_image(const RenderGraph* g, RgRes r);
+VkImageView rg_view(const RenderGraph* g, RgRes r);
+VkBuffer    rg_buffer(const RenderGraph* g, RgRes r);
+
+void        rg_release(Device* d);
+
+// ABI entry point (see fw_renderer_api)
+int  FM_CALL render_graph_get_stats(fw_handle dev, fw_render_graph_stats* out);
@@ -1,14 +1,31 @@
 #include "renderer_api.h"
-
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-#ifndef VK_USE_PLATFORM_WIN32_KHR
-#define VK_USE_PLATFORM_WIN32_KHR
-#endif
-#include <windows.h>
-#include <vulkan/vulkan.h>
-
+#include "renderer_device.h"
+#include "job_system.h"
+#include "native_common.h"
+#include "nbody.h"
+#include "nbody_gpu.h"
+#include "sim_clock.h"
+#include "conjunction.h"
+#include "grid_pass.h"
+#include "conic_pass.h"
+#include "orbit_pass.h"
+#include "line_pass.h"
+#include "bloom_pass.h"
+#include "render_graph.h"
+#include "capture_pass.h"
+#include "tiled_render.h"
+#include "window_target.h"
+#include "pick_pass.h"
+#include "segment_bvh.h"
+#include "star_pass.h"
+#include "data_file.h"
+#include "ephemeris.h"
+#include "keyframe_cache.h"
+#include "text_pass.h"
+#include "texture_table.h"
+#include "sprite_pass.h"
+
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -21,8 +38,22 @@ static const uint32_t VS_SPV[] = {
 static const uint32_t FS_SPV[] = {
 #   include "shaders/fs_solid_color.spv.inc"
 };
+static const uint32_t VS_POINTS_SPV[] = {
+#   include "shaders/vs_points_world.spv.inc"
+};
+// Shared with orbit_pass.cpp (renderer_device.h)
+extern const uint32_t FS_VCOLOR_SPV[] = {
+#   include "shaders/fs_vertex_color.spv.inc"
+};
+extern const size_t FS_VCOLOR_SPV_BYTES = sizeof(FS_VCOLOR_SPV);
+static const uint32_t VS_VCOLOR_SPV[] = {
+#   include "shaders/vs_ndc_vcolor.spv.inc"
+};
 static_assert((sizeof(VS_SPV) % 4) == 0, "VS_SPV must be dword aligned");
 static_assert((sizeof(FS_SPV) % 4) == 0, "FS_SPV must be dword aligned");
+static_assert((sizeof(VS_POINTS_SPV) % 4) == 0, "VS_POINTS_SPV must be dword aligned");
+static_assert((sizeof(FS_VCOLOR_SPV) % 4) == 0, "FS_VCOLOR_SPV must be dword aligned");
+static_assert((sizeof(VS_VCOLOR_SPV) % 4) == 0, "VS_VCOLOR_SPV must be dword aligned");
 
 // ===== API + logging =====
 static thread_local std::string g_last_error;
@@ -36,8 +67,12 @@ static void log_msg(int level, const char* msg)
         reinterpret_cast<fw_log_fn>(g_api.hdr.log_cb)(level, msg, g_api.hdr.log_user);
 }
 
+// entry points for modules in other translation units (native_common.h)
+void native_set_error(const char* msg) { g_last_error = msg ? msg : ""; }
+void native_log(int level, const char* msg) { log_msg(level, msg); }
+
 // ===== helpers =====
-static uint32_t find_memtype(VkPhysicalDevice phys, uint32_t type_bits, VkMemoryPropertyFlags want)
+uint32_t find_memtype(VkPhysicalDevice phys, uint32_t type_bits, VkMemoryPropertyFlags want)
 {
     VkPhysicalDeviceMemoryProperties mp{};
     vkGetPhysicalDeviceMemoryProperties(phys, &mp);
@@ -57,7 +92,7 @@ static bool pick_graphics_queue_family(VkPhysicalDevice pd, uint32_t& family)
         if (props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) { family = i; return true; }
     return false;
 }
-static bool supports_present(VkPhysicalDevice pd, uint32_t family, VkSurfaceKHR surface)
+bool supports_present(VkPhysicalDevice pd, uint32_t family, VkSurfaceKHR surface)
 {
     VkBool32 sup = VK_FALSE;
     vkGetPhysicalDeviceSurfaceSupportKHR(pd, family, surface, &sup);
@@ -72,13 +107,13 @@ static VkSurfaceFormatKHR choose_surface_format(const std::vector<VkSurfaceForma
     }
     return formats[0];
 }
-static VkPresentModeKHR choose_present_mode(const std::vector<VkPresentModeKHR>& modes)
+VkPresentModeKHR choose_present_mode(const std::vector<VkPresentModeKHR>& modes)
 {
     for (auto m : modes) if (m == VK_PRESENT_MODE_MAILBOX_KHR)   return m;
     for (auto m : modes) if (m == VK_PRESENT_MODE_IMMEDIATE_KHR) return m;
     return VK_PRESENT_MODE_FIFO_KHR;
 }
-static VkExtent2D choose_extent(const VkSurfaceCapabilitiesKHR& caps, HWND hwnd)
+VkExtent2D choose_extent(const VkSurfaceCapabilitiesKHR& caps, HWND hwnd)
 {
     if (caps.currentExtent.width != UINT32_MAX) return caps.currentExtent;
     RECT rc{}; GetClientRect(hwnd, &rc);
@@ -89,78 +124,92 @@ static VkExtent2D choose_extent(const VkSurfaceCapabilitiesKHR& caps, HWND hwnd)
     if (e.height > caps.maxImageExtent.height) e.height = caps.maxImageExtent.height;
     return e;
 }
-static inline VkExtent2D client_extent(HWND hwnd)
-{
-    RECT rc{}; GetClientRect(hwnd, &rc);
-    return VkExtent2D{ (uint32_t)(rc.right - rc.left), (uint32_t)(rc.bottom - rc.top) };
-}
 
-// ===== device state =====
-struct Device
+// ===== pipeline + buffer creation =====
+static bool create_lines_pipeline(Device* d)
 {
-    HWND            hwnd = nullptr;
-
-    VkInstance       instance = VK_NULL_HANDLE;
-    VkPhysicalDevice phys = VK_NULL_HANDLE;
-    VkDevice         device = VK_NULL_HANDLE;
-    uint32_t         gfxFam = 0xFFFFFFFF;
-    VkQueue          gfxQ = VK_NULL_HANDLE;
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0; pcr.size = sizeof(float) * 4;
 
-    VkSurfaceKHR     surface = VK_NULL_HANDLE;
-    VkSwapchainKHR   swap = VK_NULL_HANDLE;
-    VkFormat         swapFmt = VK_FORMAT_B8G8R8A8_UNORM;
-    VkExtent2D       extent{ 0,0 };
-    std::vector<VkImage>     images;
-    std::vector<VkImageView> views;
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &d->layout) != VK_SUCCESS) return false;
 
-    VkRenderPass                 rp = VK_NULL_HANDLE;
-    std::vector<VkFramebuffer>   fbs;
+    VkVertexInputBindingDescription bind{}; bind.binding = 0; bind.stride = sizeof(float) * 2; bind.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attr{}; attr.location = 0; attr.binding = 0; attr.format = VK_FORMAT_R32G32_SFLOAT; attr.offset = 0;
 
-    VkCommandPool                cmdPool = VK_NULL_HANDLE;
-    std::vector<VkCommandBuffer> cbs;
-    VkSemaphore semAcquire = VK_NULL_HANDLE;
-    VkSemaphore semRender = VK_NULL_HANDLE;
-    VkFence     fence = VK_NULL_HANDLE;
-    uint32_t    curImg = 0;
+    GfxPipelineDesc pd{};
+    pd.vs = VS_SPV; pd.vsBytes = sizeof(VS_SPV);
+    pd.fs = FS_SPV; pd.fsBytes = sizeof(FS_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = &attr; pd.attrCount = 1;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    pd.layout = d->layout;
+    return create_graphics_pipeline(d, pd, &d->pipe);
+}
 
-    VkPipelineLayout layout = VK_NULL_HANDLE;
-    VkPipeline       pipe = VK_NULL_HANDLE;
+static bool create_vertex_buffer(Device* d, size_t min_bytes)
+{
+    if (min_bytes < 65536) min_bytes = 65536;
 
-    VkBuffer         vbuf = VK_NULL_HANDLE;
-    VkDeviceMemory   vmem = VK_NULL_HANDLE;
-    size_t           vcap = 0;
-    size_t           vused = 0;
-    void* mapped = nullptr;
+    VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bi.size = min_bytes;
+    bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(d->device, &bi, nullptr, &d->vbuf) != VK_SUCCESS) return false;
 
-    float            color[4]{ 1,1,1,1 };
+    VkMemoryRequirements mr{};
+    vkGetBufferMemoryRequirements(d->device, d->vbuf, &mr);
+    uint32_t type = find_memtype(d->phys, mr.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (type == UINT32_MAX) return false;
 
-    bool             needs_recreate = false;
-};
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = type;
+    if (vkAllocateMemory(d->device, &mai, nullptr, &d->vmem) != VK_SUCCESS) return false;
+    if (vkBindBufferMemory(d->device, d->vbuf, d->vmem, 0) != VK_SUCCESS) return false;
+    if (vkMapMemory(d->device, d->vmem, 0, mr.size, 0, &d->mapped) != VK_SUCCESS) return false;
 
-// fw_handle (uint64) <-> pointer helpers
-static inline Device* H2D(fw_handle h) { return reinterpret_cast<Device*>(static_cast<uintptr_t>(h)); }
-static inline fw_handle D2H(Device* p) { return static_cast<fw_handle>(reinterpret_cast<uintptr_t>(p)); }
+    d->vcap = mr.size;
+    d->vused = 0;
+    return true;
+}
 
-// ===== pipeline + buffer creation =====
-static bool create_lines_pipeline(Device* d)
+static bool create_points_pipeline(Device* d)
 {
     VkPushConstantRange pcr{};
-    pcr.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    pcr.offset = 0; pcr.size = sizeof(float) * 4;
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pcr.offset = 0; pcr.size = sizeof(PointPush);
 
     VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
     plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
-    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &d->layout) != VK_SUCCESS) return false;
-
-    VkShaderModuleCreateInfo smci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-    smci.codeSize = sizeof(VS_SPV); smci.pCode = VS_SPV;
-    VkShaderModule vs = VK_NULL_HANDLE;
-    if (vkCreateShaderModule(d->device, &smci, nullptr, &vs) != VK_SUCCESS) return false;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &d->pointLayout) != VK_SUCCESS) return false;
+
+    // One vertex per instance: position advances per instance, not per vertex.
+    // vec4 stride so compute-written SSBOs (xyz + w) bind directly as instance data.
+    VkVertexInputBindingDescription bind{}; bind.binding = 0; bind.stride = sizeof(float) * 4; bind.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attr{}; attr.location = 0; attr.binding = 0; attr.format = VK_FORMAT_R32G32B32_SFLOAT; attr.offset = 0;
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_POINTS_SPV; pd.vsBytes = sizeof(VS_POINTS_SPV);
+    pd.fs = FS_VCOLOR_SPV; pd.fsBytes = sizeof(FS_VCOLOR_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = &attr; pd.attrCount = 1;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    pd.layout = d->pointLayout;
+    return create_graphics_pipeline(d, pd, &d->pointPipe);
+}
 
-    smci.codeSize = sizeof(FS_SPV); smci.pCode = FS_SPV;
-    VkShaderModule fs = VK_NULL_HANDLE;
-    if (vkCreateShaderModule(d->device, &smci, nullptr, &fs) != VK_SUCCESS) {
-        vkDestroyShaderModule(d->device, vs, nullptr); return false;
+static VkPipeline build_graphics_pipeline(Device* d, const GfxPipelineDesc& desc)
+{
+    VkShaderModule vs = create_shader(d, desc.vs, desc.vsBytes);
+    VkShaderModule fs = create_shader(d, desc.fs, desc.fsBytes);
+    if (!vs || !fs) {
+        if (vs) vkDestroyShaderModule(d->device, vs, nullptr);
+        if (fs) vkDestroyShaderModule(d->device, fs, nullptr);
+        return VK_NULL_HANDLE;
     }
 
     VkPipelineShaderStageCreateInfo stages[2]{};
@@ -173,15 +222,12 @@ static bool create_lines_pipeline(Device* d)
     stages[1].module = fs;
     stages[1].pName = "main";
 
-    VkVertexInputBindingDescription bind{}; bind.binding = 0; bind.stride = sizeof(float) * 2; bind.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    VkVertexInputAttributeDescription attr{}; attr.location = 0; attr.binding = 0; attr.format = VK_FORMAT_R32G32_SFLOAT; attr.offset = 0;
-
     VkPipelineVertexInputStateCreateInfo vi{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
-    vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &bind;
-    vi.vertexAttributeDescriptionCount = 1; vi.pVertexAttributeDescriptions = &attr;
+    vi.vertexBindingDescriptionCount = desc.bindingCount; vi.pVertexBindingDescriptions = desc.bindings;
+    vi.vertexAttributeDescriptionCount = desc.attrCount; vi.pVertexAttributeDescriptions = desc.attrs;
 
     VkPipelineInputAssemblyStateCreateInfo ia{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
-    ia.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    ia.topology = desc.topology;
 
     VkPipelineViewportStateCreateInfo vpci{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
     vpci.viewportCount = 1; vpci.scissorCount = 1;
@@ -200,9 +246,21 @@ static bool create_lines_pipeline(Device* d)
     VkPipelineColorBlendAttachmentState cba{};
     cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
         VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    if (desc.blend != BLEND_OPAQUE) {
+        cba.blendEnable = VK_TRUE;
+        cba.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        cba.dstColorBlendFactor = desc.blend == BLEND_ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        cba.colorBlendOp = VK_BLEND_OP_ADD;
+        cba.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        cba.dstAlphaBlendFactor = desc.blend == BLEND_ADDITIVE ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        cba.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
 
+    // The scene pass carries the object-ID attachment while picking: written, never blended.
+    VkPipelineColorBlendAttachmentState cbas[2]{ cba, {} };
+    cbas[1].colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
     VkPipelineColorBlendStateCreateInfo cb{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
-    cb.attachmentCount = 1; cb.pAttachments = &cba;
+    cb.attachmentCount = (!desc.renderPass && d->pick) ? 2u : 1u; cb.pAttachments = cbas;
 
     VkGraphicsPipelineCreateInfo gp{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
     gp.stageCount = 2; gp.pStages = stages;
@@ -213,21 +271,108 @@ static bool create_lines_pipeline(Device* d)
     gp.pMultisampleState = &ms;
     gp.pColorBlendState = &cb;
     gp.pDynamicState = &dyn;
-    gp.layout = d->layout;
-    gp.renderPass = d->rp;
+    gp.layout = desc.layout;
+    gp.renderPass = desc.renderPass ? desc.renderPass : d->rp;
     gp.subpass = 0;
 
     VkPipeline pipe = VK_NULL_HANDLE;
     VkResult pr = vkCreateGraphicsPipelines(d->device, VK_NULL_HANDLE, 1, &gp, nullptr, &pipe);
     vkDestroyShaderModule(d->device, vs, nullptr);
     vkDestroyShaderModule(d->device, fs, nullptr);
-    if (pr != VK_SUCCESS) return false;
+    return pr == VK_SUCCESS ? pipe : VK_NULL_HANDLE;
+}
 
-    d->pipe = pipe;
+bool create_graphics_pipeline(Device* d, const GfxPipelineDesc& desc, VkPipeline* out)
+{
+    *out = build_graphics_pipeline(d, desc);
+    if (!*out) return false;
+
+    GfxPipelineSlot slot;
+    slot.desc = desc;
+    slot.bindings.assign(desc.bindings, desc.bindings + desc.bindingCount);
+    slot.attrs.assign(desc.attrs, desc.attrs + desc.attrCount);
+    slot.out = out;
+    d->gfxPipes.push_back(std::move(slot));
     return true;
 }
 
-static bool create_vertex_buffer(Device* d, size_t min_bytes)
+void destroy_graphics_pipeline(Device* d, VkPipeline* out)
+{
+    for (size_t i = 0; i < d->gfxPipes.size(); ++i) {
+        if (d->gfxPipes[i].out != out) continue;
+        d->gfxPipes[i] = std::move(d->gfxPipes.back());
+        d->gfxPipes.pop_back();
+        break;
+    }
+    if (*out) vkDestroyPipeline(d->device, *out, nullptr);
+    *out = VK_NULL_HANDLE;
+}
+
+bool rebuild_graphics_pipelines(Device* d)
+{
+    bool ok = true;
+    for (GfxPipelineSlot& s : d->gfxPipes) {
+        if (s.desc.renderPass) continue;   // bound to a fixed pass, not the scene pass
+        s.desc.bindings = s.bindings.data();
+        s.desc.attrs = s.attrs.data();
+        VkPipeline p = build_graphics_pipeline(d, s.desc);
+        if (!p) { ok = false; continue; }   // keep the old one; the caller reverts d->rp
+        vkDestroyPipeline(d->device, *s.out, nullptr);
+        *s.out = p;
+    }
+    return ok;
+}
+
+// Blend variants of the lines pipeline plus the per-vertex colour pipelines (same layout;
+// the colour twin reads RGBA8 from a second vertex stream and ignores the push colour).
+static bool create_line_variants(Device* d)
+{
+    VkVertexInputBindingDescription binds[2]{};
+    binds[0].binding = 0; binds[0].stride = sizeof(float) * 2; binds[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binds[1].binding = 1; binds[1].stride = sizeof(uint32_t); binds[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attrs[2]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32_SFLOAT; attrs[0].offset = 0;
+    attrs[1].location = 1; attrs[1].binding = 1; attrs[1].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[1].offset = 0;
+
+    GfxPipelineDesc pd{};
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    pd.layout = d->layout;
+    pd.bindings = binds; pd.attrs = attrs;
+    for (int b = BLEND_OPAQUE; b <= BLEND_ADDITIVE; ++b) {
+        pd.blend = (PipelineBlend)b;
+        if (b != BLEND_OPAQUE) {
+            pd.vs = VS_SPV; pd.vsBytes = sizeof(VS_SPV);
+            pd.fs = FS_SPV; pd.fsBytes = sizeof(FS_SPV);
+            pd.bindingCount = 1; pd.attrCount = 1;
+            if (!create_graphics_pipeline(d, pd, &d->lineBlendPipes[b])) return false;
+        }
+        pd.vs = VS_VCOLOR_SPV; pd.vsBytes = sizeof(VS_VCOLOR_SPV);
+        pd.fs = FS_VCOLOR_SPV; pd.fsBytes = sizeof(FS_VCOLOR_SPV);
+        pd.bindingCount = 2; pd.attrCount = 2;
+        if (!create_graphics_pipeline(d, pd, &d->lineColorPipes[b])) return false;
+    }
+    return true;
+}
+
+static void destroy_line_variants(Device* d)
+{
+    for (int b = 0; b < 3; ++b) {
+        destroy_graphics_pipeline(d, &d->lineBlendPipes[b]);
+        destroy_graphics_pipeline(d, &d->lineColorPipes[b]);
+    }
+    host_buffer_release(d, d->lineRgba);
+}
+
+static void destroy_instance_buffer(Device* d)
+{
+    if (d->instMem)  vkUnmapMemory(d->device, d->instMem);
+    if (d->instBuf)  vkDestroyBuffer(d->device, d->instBuf, nullptr);
+    if (d->instMem)  vkFreeMemory(d->device, d->instMem, nullptr);
+    d->instBuf = VK_NULL_HANDLE; d->instMem = VK_NULL_HANDLE;
+    d->instMapped = nullptr; d->instCap = 0; d->instCount = 0;
+}
+
+static bool create_instance_buffer(Device* d, size_t min_bytes)
 {
     if (min_bytes < 65536) min_bytes = 65536;
 
@@ -235,10 +380,10 @@ static bool create_vertex_buffer(Device* d, size_t min_bytes)
     bi.size = min_bytes;
     bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
     bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    if (vkCreateBuffer(d->device, &bi, nullptr, &d->vbuf) != VK_SUCCESS) return false;
+    if (vkCreateBuffer(d->device, &bi, nullptr, &d->instBuf) != VK_SUCCESS) return false;
 
     VkMemoryRequirements mr{};
-    vkGetBufferMemoryRequirements(d->device, d->vbuf, &mr);
+    vkGetBufferMemoryRequirements(d->device, d->instBuf, &mr);
     uint32_t type = find_memtype(d->phys, mr.memoryTypeBits,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     if (type == UINT32_MAX) return false;
@@ -246,15 +391,285 @@ static bool create_vertex_buffer(Device* d, size_t min_bytes)
     VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
     mai.allocationSize = mr.size;
     mai.memoryTypeIndex = type;
-    if (vkAllocateMemory(d->device, &mai, nullptr, &d->vmem) != VK_SUCCESS) return false;
-    if (vkBindBufferMemory(d->device, d->vbuf, d->vmem, 0) != VK_SUCCESS) return false;
-    if (vkMapMemory(d->device, d->vmem, 0, mr.size, 0, &d->mapped) != VK_SUCCESS) return false;
+    if (vkAllocateMemory(d->device, &mai, nullptr, &d->instMem) != VK_SUCCESS) return false;
+    if (vkBindBufferMemory(d->device, d->instBuf, d->instMem, 0) != VK_SUCCESS) return false;
+    if (vkMapMemory(d->device, d->instMem, 0, mr.size, 0, &d->instMapped) != VK_SUCCESS) return false;
 
-    d->vcap = mr.size;
-    d->vused = 0;
+    d->instCap = mr.size;
+    d->instCount = 0;
+    return true;
+}
+
+bool create_buffer(Device* d, VkDeviceSize size, VkBufferUsageFlags usage,
+    VkMemoryPropertyFlags props, VkBuffer* out_buf, VkDeviceMemory* out_mem)
+{
+    *out_buf = VK_NULL_HANDLE; *out_mem = VK_NULL_HANDLE;
+
+    VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bi.size = size;
+    bi.usage = usage;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(d->device, &bi, nullptr, out_buf) != VK_SUCCESS) return false;
+
+    VkMemoryRequirements mr{};
+    vkGetBufferMemoryRequirements(d->device, *out_buf, &mr);
+    uint32_t type = find_memtype(d->phys, mr.memoryTypeBits, props);
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = type;
+    if (type == UINT32_MAX ||
+        vkAllocateMemory(d->device, &mai, nullptr, out_mem) != VK_SUCCESS ||
+        vkBindBufferMemory(d->device, *out_buf, *out_mem, 0) != VK_SUCCESS)
+    {
+        if (*out_mem) vkFreeMemory(d->device, *out_mem, nullptr);
+        vkDestroyBuffer(d->device, *out_buf, nullptr);
+        *out_buf = VK_NULL_HANDLE; *out_mem = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+VkShaderModule create_shader(Device* d, const uint32_t* code, size_t bytes)
+{
+    VkShaderModuleCreateInfo smci{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    smci.codeSize = bytes; smci.pCode = code;
+    VkShaderModule m = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(d->device, &smci, nullptr, &m) != VK_SUCCESS) return VK_NULL_HANDLE;
+    return m;
+}
+
+VkPipeline create_compute_pipeline(Device* d, VkPipelineLayout layout, const uint32_t* code, size_t bytes)
+{
+    VkShaderModule cs = create_shader(d, code, bytes);
+    if (!cs) return VK_NULL_HANDLE;
+
+    VkComputePipelineCreateInfo cpci{ VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    cpci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    cpci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    cpci.stage.module = cs;
+    cpci.stage.pName = "main";
+    cpci.layout = layout;
+    VkPipeline pipe = VK_NULL_HANDLE;
+    VkResult pr = vkCreateComputePipelines(d->device, VK_NULL_HANDLE, 1, &cpci, nullptr, &pipe);
+    vkDestroyShaderModule(d->device, cs, nullptr);
+    return pr == VK_SUCCESS ? pipe : VK_NULL_HANDLE;
+}
+
+bool create_image(Device* d, uint32_t w, uint32_t h, VkFormat fmt, VkImageUsageFlags usage, GpuImage* out)
+{
+    *out = GpuImage{};
+    VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = fmt;
+    ici.extent = { w, h, 1 };
+    ici.mipLevels = 1; ici.arrayLayers = 1;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = usage;
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(d->device, &ici, nullptr, &out->img) != VK_SUCCESS) return false;
+
+    VkMemoryRequirements mr{};
+    vkGetImageMemoryRequirements(d->device, out->img, &mr);
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = find_memtype(d->phys, mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(d->device, &mai, nullptr, &out->mem) != VK_SUCCESS ||
+        vkBindImageMemory(d->device, out->img, out->mem, 0) != VK_SUCCESS)
+    {
+        destroy_image(d, *out);
+        return false;
+    }
+
+    VkImageViewCreateInfo iv{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    iv.image = out->img;
+    iv.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    iv.format = fmt;
+    iv.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    iv.subresourceRange.levelCount = 1;
+    iv.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(d->device, &iv, nullptr, &out->view) != VK_SUCCESS) {
+        destroy_image(d, *out);
+        return false;
+    }
+    out->fmt = fmt;
+    out->extent = { w, h };
+    return true;
+}
+
+void destroy_image(Device* d, GpuImage& img)
+{
+    if (img.view) vkDestroyImageView(d->device, img.view, nullptr);
+    if (img.img)  vkDestroyImage(d->device, img.img, nullptr);
+    if (img.mem)  vkFreeMemory(d->device, img.mem, nullptr);
+    img = GpuImage{};
+}
+
+void cmd_image_barrier(VkCommandBuffer cb, VkImage img, VkImageLayout from, VkImageLayout to,
+    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    b.srcAccessMask = srcAccess; b.dstAccessMask = dstAccess;
+    b.oldLayout = from; b.newLayout = to;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = img;
+    b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    b.subresourceRange.levelCount = 1;
+    b.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cb, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+}
+
+VkCommandBuffer begin_one_shot(Device* d)
+{
+    VkCommandBufferAllocateInfo cbai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    cbai.commandPool = d->cmdPool;
+    cbai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cbai.commandBufferCount = 1;
+    VkCommandBuffer cb = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(d->device, &cbai, &cb) != VK_SUCCESS) return VK_NULL_HANDLE;
+
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cb, &bi);
+    return cb;
+}
+
+bool end_one_shot(Device* d, VkCommandBuffer cb)
+{
+    vkEndCommandBuffer(cb);
+    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    si.commandBufferCount = 1; si.pCommandBuffers = &cb;
+    bool ok = vkQueueSubmit(d->gfxQ, 1, &si, VK_NULL_HANDLE) == VK_SUCCESS &&
+        vkQueueWaitIdle(d->gfxQ) == VK_SUCCESS;
+    vkFreeCommandBuffers(d->device, d->cmdPool, 1, &cb);
+    return ok;
+}
+
+bool upload_buffer(Device* d, VkBuffer dst, const void* data, VkDeviceSize bytes)
+{
+    VkBuffer stage = VK_NULL_HANDLE; VkDeviceMemory stageMem = VK_NULL_HANDLE;
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage, &stageMem)) {
+        g_last_error = "staging allocation failed"; return false;
+    }
+
+    void* mapped = nullptr;
+    bool ok = vkMapMemory(d->device, stageMem, 0, bytes, 0, &mapped) == VK_SUCCESS;
+    if (ok) {
+        std::memcpy(mapped, data, (size_t)bytes);
+        vkUnmapMemory(d->device, stageMem);
+
+        VkCommandBuffer cb = begin_one_shot(d);
+        ok = cb != VK_NULL_HANDLE;
+        if (ok) {
+            VkBufferCopy cp{ 0, 0, bytes };
+            vkCmdCopyBuffer(cb, stage, dst, 1, &cp);
+            ok = end_one_shot(d, cb);
+        }
+    }
+    vkDestroyBuffer(d->device, stage, nullptr);
+    vkFreeMemory(d->device, stageMem, nullptr);
+    if (!ok) g_last_error = "buffer upload failed";
+    return ok;
+}
+
+bool upload_image(Device* d, const GpuImage& img, const void* data, VkDeviceSize bytes)
+{
+    VkBuffer stage = VK_NULL_HANDLE; VkDeviceMemory stageMem = VK_NULL_HANDLE;
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage, &stageMem)) {
+        g_last_error = "staging allocation failed"; return false;
+    }
+
+    void* mapped = nullptr;
+    bool ok = vkMapMemory(d->device, stageMem, 0, bytes, 0, &mapped) == VK_SUCCESS;
+    if (ok) {
+        std::memcpy(mapped, data, (size_t)bytes);
+        vkUnmapMemory(d->device, stageMem);
+
+        VkCommandBuffer cb = begin_one_shot(d);
+        ok = cb != VK_NULL_HANDLE;
+        if (ok) {
+            cmd_image_barrier(cb, img.img, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            VkBufferImageCopy cp{};
+            cp.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            cp.imageSubresource.layerCount = 1;
+            cp.imageExtent = { img.extent.width, img.extent.height, 1 };
+            vkCmdCopyBufferToImage(cb, stage, img.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cp);
+            cmd_image_barrier(cb, img.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            ok = end_one_shot(d, cb);
+        }
+    }
+    vkDestroyBuffer(d->device, stage, nullptr);
+    vkFreeMemory(d->device, stageMem, nullptr);
+    if (!ok) g_last_error = "image upload failed";
+    return ok;
+}
+
+// Outside a frame only: inside one the fence has nothing submitted behind it yet and the
+// recorded command buffer may reference the buffer. The uploaders check first.
+bool host_buffer_reserve(Device* d, HostBuffer& hb, size_t bytes, VkBufferUsageFlags usage)
+{
+    if (d->inFrame) { g_last_error = "host buffer written inside a frame"; return false; }
+    vkWaitForFences(d->device, 1, &d->fence, VK_TRUE, UINT64_MAX);
+    if (bytes <= hb.cap && hb.mapped) return true;
+
+    size_t cap = hb.cap ? hb.cap : 65536;
+    while (cap < bytes) cap *= 2;
+    vkDeviceWaitIdle(d->device);
+    host_buffer_release(d, hb);
+    if (!create_buffer(d, cap, usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &hb.buf, &hb.mem) ||
+        vkMapMemory(d->device, hb.mem, 0, VK_WHOLE_SIZE, 0, &hb.mapped) != VK_SUCCESS)
+    {
+        host_buffer_release(d, hb);
+        g_last_error = "host buffer allocation failed";
+        return false;
+    }
+    hb.cap = cap;
     return true;
 }
 
+void host_buffer_release(Device* d, HostBuffer& hb)
+{
+    if (hb.mapped) vkUnmapMemory(d->device, hb.mem);
+    if (hb.buf)    vkDestroyBuffer(d->device, hb.buf, nullptr);
+    if (hb.mem)    vkFreeMemory(d->device, hb.mem, nullptr);
+    hb = HostBuffer{};
+}
+
+float* points_begin_upload(Device* d, uint32_t count, float r, float g, float b, float a, float point_size)
+{
+    if (!d->pointPipe) { g_last_error = "points pipeline unavailable"; return nullptr; }
+    if (d->inFrame) { g_last_error = "points written inside a frame"; return nullptr; }
+
+    // The previous submit may still be reading the instance buffer.
+    vkWaitForFences(d->device, 1, &d->fence, VK_TRUE, UINT64_MAX);
+
+    size_t need = (size_t)count * sizeof(float) * 4;
+    if (need > d->instCap || !d->instMapped) {
+        size_t cap = d->instCap ? d->instCap : 65536;
+        while (cap < need) cap *= 2;
+        vkDeviceWaitIdle(d->device);
+        destroy_instance_buffer(d);
+        if (!create_instance_buffer(d, cap)) {
+            destroy_instance_buffer(d);
+            g_last_error = "instance buffer allocation failed"; return nullptr;
+        }
+    }
+
+    d->instCount = count;
+    d->pointColor[0] = r; d->pointColor[1] = g; d->pointColor[2] = b; d->pointColor[3] = a;
+    d->pointSize = point_size > 0 ? point_size : 1.0f;
+    return static_cast<float*>(d->instMapped);
+}
+
 // ===== swapchain (re)creation =====
 static void destroy_swapchain_objects(Device* d)
 {
@@ -304,7 +719,9 @@ static bool create_swapchain_objects(Device* d)
     sci.imageColorSpace = sf.colorSpace;
     sci.imageExtent = ex;
     sci.imageArrayLayers = 1;
-    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Copy-out and sampling (frame capture) where the surface allows them.
+    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        (caps.supportedUsageFlags & (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
     sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     sci.preTransform = caps.currentTransform;
     sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
@@ -318,6 +735,7 @@ static bool create_swapchain_objects(Device* d)
     }
 
     d->swap = swap;
+    d->swapUsage = sci.imageUsage;
     d->swapFmt = sf.format;
     d->extent = ex;
 
@@ -356,7 +774,7 @@ static bool create_swapchain_objects(Device* d)
     for (uint32_t i = 0; i < ic; ++i) {
         VkImageView att[]{ d->views[i] };
         VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
-        fbci.renderPass = d->rp;
+        fbci.renderPass = d->swapRp;
         fbci.attachmentCount = 1; fbci.pAttachments = att;
         fbci.width = ex.width; fbci.height = ex.height; fbci.layers = 1;
         if (vkCreateFramebuffer(d->device, &fbci, nullptr, &d->fbs[i]) != VK_SUCCESS) {
@@ -376,6 +794,8 @@ static bool recreate_swapchain(Device* d)
     vkDeviceWaitIdle(d->device);
     destroy_swapchain_objects(d);
     if (!create_swapchain_objects(d)) return false;
+    bloom_resize(d);
+    pick_resize(d);
 
     log_msg(1, "Vulkan: Swapchain recreated.");
     d->needs_recreate = false;
@@ -402,9 +822,93 @@ static int FM_CALL lines_upload_dev(fw_handle hdev, const float* xy, uint32_t co
     std::memcpy(d->mapped, xy, need);
     d->vused = need;
     d->color[0] = r; d->color[1] = g; d->color[2] = b; d->color[3] = a;
+    d->lineHasColor = false;
+    return 0;
+}
+
+// Same as lines_upload with one packed RGBA8 colour per vertex (R in the lowest byte).
+static int FM_CALL lines_upload_rgba(fw_handle hdev, const float* xy, const uint32_t* rgba, uint32_t count)
+{
+    auto* d = H2D(hdev);
+    if (!d) { g_last_error = "null device"; return FM_E_BADARGS; }
+    if (!xy || !rgba || count == 0) return 0;
+    if (!d->lineColorPipes[BLEND_OPAQUE]) { g_last_error = "colored lines pipeline unavailable"; return FM_E_UNSUPPORTED; }
+    if (d->inFrame) { g_last_error = "lines_upload_rgba: called inside a frame, call it before begin_frame"; return FM_E_NOTREADY; }
+
+    size_t need = (size_t)count * sizeof(float) * 2;
+    if (need > d->vcap) { g_last_error = "lines buffer overflow"; return FM_E_BADARGS; }
+    if (!host_buffer_reserve(d, d->lineRgba, (size_t)count * sizeof(uint32_t), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        return FM_E_NOMEM;
+
+    std::memcpy(d->mapped, xy, need);
+    std::memcpy(d->lineRgba.mapped, rgba, (size_t)count * sizeof(uint32_t));
+    d->vused = need;
+    d->lineHasColor = true;
     return 0;
 }
 
+static_assert(BLEND_ALPHA == FW_BLEND_ALPHA && BLEND_ADDITIVE == FW_BLEND_ADDITIVE, "blend ids are shared with the ABI");
+
+static int FM_CALL lines_set_blend(fw_handle hdev, uint32_t mode)
+{
+    auto* d = H2D(hdev);
+    if (!d) { g_last_error = "null device"; return FM_E_BADARGS; }
+    if (mode > BLEND_ADDITIVE) { g_last_error = "lines_set_blend: unknown mode"; return FM_E_BADARGS; }
+    d->lineBlend = mode;
+    d->polylineBlend = mode;
+    return FM_OK;
+}
+
+static int FM_CALL set_camera(fw_handle hdev, const float* view_proj, const double* origin)
+{
+    auto* d = H2D(hdev);
+    if (!d) { g_last_error = "null device"; return FM_E_BADARGS; }
+    if (view_proj) std::memcpy(d->viewProj, view_proj, sizeof(d->viewProj));
+    if (origin) { d->origin[0] = origin[0]; d->origin[1] = origin[1]; d->origin[2] = origin[2]; }
+    return FM_OK;
+}
+
+// Writes the simulation's positions (camera-relative, float) straight into the instance buffer.
+static int FM_CALL nbody_upload_points(fw_handle hdev, fw_handle hsim,
+    float r, float g, float b, float a, float point_size)
+{
+    auto* d = H2D(hdev);
+    auto* s = handle_to<NBody>(hsim);
+    if (!d || !s) { g_last_error = "null device/sim"; return FM_E_BADARGS; }
+    if (d->inFrame) { g_last_error = "nbody_upload_points: called inside a frame, call it before begin_frame"; return FM_E_NOTREADY; }
+
+    float* dst = points_begin_upload(d, s->n, r, g, b, a, point_size);
+    if (!dst) return d->pointPipe ? FM_E_NOMEM : FM_E_UNSUPPORTED;
+
+    nbody_write_positions_f32(s, dst, 4, d->origin[0], d->origin[1], d->origin[2]);
+    return FM_OK;
+}
+
+// Blends the clock's last two snapshots by its alpha straight into the instance buffer.
+static int FM_CALL sim_upload_points(fw_handle hdev, fw_handle hclock,
+    float r, float g, float b, float a, float point_size)
+{
+    auto* d = H2D(hdev);
+    auto* c = handle_to<SimClock>(hclock);
+    if (!d || !c) { g_last_error = "null device/clock"; return FM_E_BADARGS; }
+    if (d->inFrame) { g_last_error = "sim_upload_points: called inside a frame, call it before begin_frame"; return FM_E_NOTREADY; }
+
+    float* dst = points_begin_upload(d, c->snapN, r, g, b, a, point_size);
+    if (!dst) return d->pointPipe ? FM_E_NOMEM : FM_E_UNSUPPORTED;
+
+    sim_clock_write_interpolated(c, dst, 4, d->origin[0], d->origin[1], d->origin[2]);
+    return FM_OK;
+}
+
+static int FM_CALL jobs_configure_impl(uint32_t worker_count, uint64_t affinity_mask)
+{
+    if (jobs_configure(worker_count, affinity_mask) != 0) {
+        g_last_error = "jobs_configure: job pool in use, configure before creating devices or sims";
+        return FM_E_NOTREADY;
+    }
+    return FM_OK;
+}
+
 static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
 {
     *out = 0;
@@ -464,15 +968,70 @@ static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
         return -4;
     }
 
-    // Logical device
+    // synchronization2 is optional: the render graph falls back to legacy barriers.
+    // Descriptor indexing is optional too: without it there is no bindless texture table.
+    bool sync2 = false, indexing = false;
+    {
+        uint32_t en = 0; vkEnumerateDeviceExtensionProperties(phys, nullptr, &en, nullptr);
+        std::vector<VkExtensionProperties> exts(en);
+        vkEnumerateDeviceExtensionProperties(phys, nullptr, &en, exts.data());
+        for (const auto& e : exts) {
+            if (std::strcmp(e.extensionName, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == 0) sync2 = true;
+            if (std::strcmp(e.extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0) indexing = true;
+        }
+    }
+    VkPhysicalDeviceSynchronization2FeaturesKHR s2f{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR };
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT dif{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+    if (sync2 || indexing) {
+        VkPhysicalDeviceFeatures2 f2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        s2f.pNext = indexing ? &dif : nullptr;
+        f2.pNext = sync2 ? (void*)&s2f : (void*)&dif;
+        vkGetPhysicalDeviceFeatures2(phys, &f2);
+        sync2 = sync2 && s2f.synchronization2 == VK_TRUE;
+        indexing = indexing && dif.runtimeDescriptorArray && dif.descriptorBindingPartiallyBound &&
+            dif.descriptorBindingSampledImageUpdateAfterBind && dif.shaderSampledImageArrayNonUniformIndexing;
+    }
+    uint32_t bindlessMax = 0;
+    if (indexing) {
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT dip{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT };
+        VkPhysicalDeviceProperties2 p2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+        p2.pNext = &dip;
+        vkGetPhysicalDeviceProperties2(phys, &p2);
+        bindlessMax = std::min(dip.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            std::min(dip.maxDescriptorSetUpdateAfterBindSampledImages, dip.maxPerStageDescriptorUpdateAfterBindSamplers));
+    }
+
+    // Point sprites above 1 px need largePoints; without it every point is drawn at 1 px.
+    VkPhysicalDeviceFeatures feats{};
+    vkGetPhysicalDeviceFeatures(phys, &feats);
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(phys, &props);
+    const bool largePoints = feats.largePoints == VK_TRUE;
+
+    // Logical device: only the features the renderer uses
+    VkPhysicalDeviceFeatures featsOn{};
+    featsOn.largePoints = largePoints ? VK_TRUE : VK_FALSE;
     float prio = 1.f;
     VkDeviceQueueCreateInfo qci{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
     qci.queueFamilyIndex = fam; qci.queueCount = 1; qci.pQueuePriorities = &prio;
 
-    const char* devExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT difOn{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+    difOn.runtimeDescriptorArray = VK_TRUE;
+    difOn.descriptorBindingPartiallyBound = VK_TRUE;
+    difOn.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    difOn.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    s2f.pNext = nullptr;
+
+    const char* devExts[3] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    uint32_t devExtCount = 1;
+    const void* chain = nullptr;
+    if (indexing) { devExts[devExtCount++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME; difOn.pNext = (void*)chain; chain = &difOn; }
+    if (sync2)    { devExts[devExtCount++] = VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME; s2f.pNext = (void*)chain; chain = &s2f; }
     VkDeviceCreateInfo dci{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    dci.pNext = chain;
     dci.queueCreateInfoCount = 1; dci.pQueueCreateInfos = &qci;
-    dci.enabledExtensionCount = (uint32_t)(sizeof(devExts) / sizeof(devExts[0]));
+    dci.pEnabledFeatures = &featsOn;
+    dci.enabledExtensionCount = devExtCount;
     dci.ppEnabledExtensionNames = devExts;
 
     VkDevice device = VK_NULL_HANDLE;
@@ -488,6 +1047,10 @@ static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
     d->hwnd = hwnd;
     d->instance = instance; d->phys = phys; d->device = device; d->gfxFam = fam; d->gfxQ = q;
     d->surface = surface;
+    if (sync2)
+        d->cmdBarrier2 = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+    d->bindlessMax = indexing ? bindlessMax : 0;
+    d->pointSizeMax = largePoints ? std::max(1.0f, props.limits.pointSizeRange[1]) : 1.0f;
 
     // Command pool & sync
     VkCommandPoolCreateInfo cpci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO }; cpci.queueFamilyIndex = fam;
@@ -535,7 +1098,7 @@ static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
     rpci.attachmentCount = 1; rpci.pAttachments = &color;
     rpci.subpassCount = 1;    rpci.pSubpasses = &sub;
     rpci.dependencyCount = 1; rpci.pDependencies = &dep;
-    if (vkCreateRenderPass(device, &rpci, nullptr, &d->rp) != VK_SUCCESS) {
+    if (vkCreateRenderPass(device, &rpci, nullptr, &d->swapRp) != VK_SUCCESS) {
         g_last_error = "vkCreateRenderPass failed";
         destroy_swapchain_objects(d);
         vkDestroySemaphore(device, d->semRender, nullptr);
@@ -549,13 +1112,15 @@ static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
         return -7;
     }
 
+    d->rp = d->swapRp;
+
     // Rebuild FBs now that rp exists
     for (auto fb : d->fbs) if (fb) vkDestroyFramebuffer(device, fb, nullptr);
     d->fbs.resize(d->views.size());
     for (uint32_t i = 0; i < d->views.size(); ++i) {
         VkImageView att[]{ d->views[i] };
         VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
-        fbci.renderPass = d->rp;
+        fbci.renderPass = d->swapRp;
         fbci.attachmentCount = 1; fbci.pAttachments = att;
         fbci.width = d->extent.width; fbci.height = d->extent.height; fbci.layers = 1;
         if (vkCreateFramebuffer(device, &fbci, nullptr, &d->fbs[i]) != VK_SUCCESS) {
@@ -565,6 +1130,17 @@ static int FM_CALL create_device(const fw_renderer_desc* desc, fw_handle* out)
 
     if (!create_lines_pipeline(d) || !create_vertex_buffer(d, size_t{ 1 } << 20))
         g_last_error = "pipeline/buffer creation failed";
+    if (!create_points_pipeline(d) || !create_instance_buffer(d, size_t{ 1 } << 20))
+        g_last_error = "points pipeline/buffer creation failed";
+    if (d->pipe && !create_line_variants(d)) {
+        destroy_line_variants(d);
+        g_last_error = "line blend/colour pipelines creation failed";
+    }
+
+    d->graph = new RenderGraph();
+
+    // Each live device keeps the shared worker pool running.
+    jobs_acquire();
 
     *out = D2H(d);
     log_msg(1, "Vulkan: swapchain + lines pipeline ready.");
@@ -576,18 +1152,37 @@ static void FM_CALL destroy_device(fw_handle h)
     auto* d = H2D(h); if (!d) return;
     vkDeviceWaitIdle(d->device);
 
+    while (!d->gpuSims.empty()) gpu_nbody_release(d, d->gpuSims.back());
+    windows_release(d);
+    bloom_release(d);
+    pick_release(d);
+    capture_release(d);
+    rg_release(d);
+    star_release(d);
+    grid_release(d);
+    conic_release(d);
+    orbit_release(d);
+    line_release(d);
+    sprite_release(d);
+    texture_table_release(d);
+    text_release(d);
+
     if (d->vmem)   vkUnmapMemory(d->device, d->vmem);
     if (d->vbuf)   vkDestroyBuffer(d->device, d->vbuf, nullptr);
     if (d->vmem)   vkFreeMemory(d->device, d->vmem, nullptr);
-    if (d->pipe)   vkDestroyPipeline(d->device, d->pipe, nullptr);
+    destroy_line_variants(d);
+    destroy_graphics_pipeline(d, &d->pipe);
     if (d->layout) vkDestroyPipelineLayout(d->device, d->layout, nullptr);
+    destroy_instance_buffer(d);
+    destroy_graphics_pipeline(d, &d->pointPipe);
+    if (d->pointLayout) vkDestroyPipelineLayout(d->device, d->pointLayout, nullptr);
 
     if (d->fence)      vkDestroyFence(d->device, d->fence, nullptr);
     if (d->semRender)  vkDestroySemaphore(d->device, d->semRender, nullptr);
     if (d->semAcquire) vkDestroySemaphore(d->device, d->semAcquire, nullptr);
 
     destroy_swapchain_objects(d);
-    if (d->rp) vkDestroyRenderPass(d->device, d->rp, nullptr);
+    if (d->swapRp) vkDestroyRenderPass(d->device, d->swapRp, nullptr);
 
     if (d->cmdPool) vkDestroyCommandPool(d->device, d->cmdPool, nullptr);
     if (d->surface) vkDestroySurfaceKHR(d->instance, d->surface, nullptr);
@@ -595,9 +1190,85 @@ static void FM_CALL destroy_device(fw_handle h)
     if (d->instance)vkDestroyInstance(d->instance, nullptr);
 
     delete d;
+    jobs_release();
     log_msg(1, "Vulkan: Device destroyed.");
 }
 
+// ===== frame passes =====
+// Compute work must be recorded outside the render pass; each sim carries its own barriers.
+static void record_sims(Device* d, VkCommandBuffer cb, void*)
+{
+    for (GpuNBody* g : d->gpuSims) gpu_nbody_record_compute(d, g, cb);
+}
+
+void record_scene_draws(Device* d, VkCommandBuffer cb, bool ndc_overlay)
+{
+    // Stars, then the grid: both are backdrops and blend under everything else.
+    star_record_draw(d, cb);
+    grid_record_draw(d, cb);
+
+    if (ndc_overlay && d->vused >= sizeof(float) * 2) {
+        const bool colored = d->lineHasColor && d->lineColorPipes[d->lineBlend];
+        VkPipeline lp = colored ? d->lineColorPipes[d->lineBlend] : d->lineBlendPipes[d->lineBlend];
+        if (!lp) lp = d->pipe;
+        VkBuffer bufs[2]{ d->vbuf, d->lineRgba.buf };
+        VkDeviceSize offs[2]{ 0, 0 };
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, lp);
+        vkCmdBindVertexBuffers(cb, 0, colored ? 2 : 1, bufs, offs);
+        vkCmdPushConstants(cb, d->layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float) * 4, d->color);
+        uint32_t vtx = (uint32_t)(d->vused / (sizeof(float) * 2));
+        vkCmdDraw(cb, vtx, 1, 0, 0);
+    }
+
+    if (d->pointPipe && d->instCount) {
+        PointPush pp{};
+        std::memcpy(pp.viewProj, d->viewProj, sizeof(pp.viewProj));
+        std::memcpy(pp.color, d->pointColor, sizeof(pp.color));
+        pp.size = std::min(d->pointSize, d->pointSizeMax);
+        pp.pickBase = pick_id(FW_PICK_POINT, 0);
+
+        VkDeviceSize off = 0;
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, d->pointPipe);
+        vkCmdBindVertexBuffers(cb, 0, 1, &d->instBuf, &off);
+        vkCmdPushConstants(cb, d->pointLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PointPush), &pp);
+        vkCmdDraw(cb, 1, d->instCount, 0, 0);
+    }
+
+    for (GpuNBody* g : d->gpuSims) gpu_nbody_record_draw(d, g, cb);
+
+    orbit_record_draw(d, cb);
+    line_record_draw(d, cb);
+    conic_record_draw(d, cb);
+    sprite_record_draw(d, cb);
+    // Labels over everything they annotate
+    text_record_draw(d, cb);
+}
+
+static void record_scene(Device* d, VkCommandBuffer cb, void*)
+{
+    VkClearValue clear[2]{};
+    clear[0].color = { { kClearColor[0], kClearColor[1], kClearColor[2], kClearColor[3] } };
+    clear[1].color.uint32[0] = 0;   // object IDs: background
+
+    // With bloom on, the scene goes to its HDR target and the post chain writes the swapchain.
+    VkRenderPassBeginInfo rbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    rbi.renderPass = d->rp;
+    rbi.framebuffer = d->bloom ? d->bloom->sceneFb : d->pick ? d->pick->fbs[d->curImg] : d->fbs[d->curImg];
+    rbi.renderArea = { {0,0}, d->extent };
+    rbi.clearValueCount = d->pick ? 2 : 1; rbi.pClearValues = clear;
+
+    vkCmdBeginRenderPass(cb, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport vp{ 0.f, 0.f, (float)d->extent.width, (float)d->extent.height, 0.f, 1.f };
+    VkRect2D   sc{ {0,0}, d->extent };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    record_scene_draws(d, cb, true);
+
+    vkCmdEndRenderPass(cb);
+}
+
 static void FM_CALL begin_frame(fw_handle h)
 {
     auto* d = H2D(h); if (!d) return;
@@ -614,41 +1285,47 @@ static void FM_CALL begin_frame(fw_handle h)
 
     vkWaitForFences(d->device, 1, &d->fence, VK_TRUE, UINT64_MAX);
     vkResetFences(d->device, 1, &d->fence);
+    d->inFrame = true;
+    capture_retire(d);
+    pick_retire(d);
 
     uint32_t idx = 0;
     VkResult aq = vkAcquireNextImageKHR(d->device, d->swap, UINT64_MAX, d->semAcquire, VK_NULL_HANDLE, &idx);
     if (aq == VK_ERROR_OUT_OF_DATE_KHR || aq == VK_SUBOPTIMAL_KHR) { d->needs_recreate = true; d->vused = 0; return; }
     else if (aq != VK_SUCCESS) { d->vused = 0; return; }
     d->curImg = idx;
+    windows_acquire(d);
 
     VkCommandBuffer cb = d->cbs[idx];
     VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
     vkBeginCommandBuffer(cb, &bi);
 
-    VkClearValue clear{}; clear.color = { { 0.02f, 0.03f, 0.05f, 1.0f } };
-
-    VkRenderPassBeginInfo rbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-    rbi.renderPass = d->rp; rbi.framebuffer = d->fbs[idx];
-    rbi.renderArea = { {0,0}, d->extent };
-    rbi.clearValueCount = 1; rbi.pClearValues = &clear;
-
-    vkCmdBeginRenderPass(cb, &rbi, VK_SUBPASS_CONTENTS_INLINE);
-
-    VkViewport vp{ 0.f, 0.f, (float)d->extent.width, (float)d->extent.height, 0.f, 1.f };
-    VkRect2D   sc{ {0,0}, d->extent };
-    vkCmdSetViewport(cb, 0, 1, &vp);
-    vkCmdSetScissor(cb, 0, 1, &sc);
-
-    if (d->vused >= sizeof(float) * 2) {
-        VkDeviceSize off = 0;
-        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, d->pipe);
-        vkCmdBindVertexBuffers(cb, 0, 1, &d->vbuf, &off);
-        vkCmdPushConstants(cb, d->layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float) * 4, d->color);
-        uint32_t vtx = (uint32_t)(d->vused / (sizeof(float) * 2));
-        vkCmdDraw(cb, vtx, 1, 0, 0);
+    // The swapchain image is the frame's output; render passes that write it clear from
+    // UNDEFINED and leave it ready to present.
+    RenderGraph* g = d->graph;
+    rg_reset(g);
+    const RgRes swapImg = rg_import_image(g, d->images[idx], d->views[idx], d->swapFmt, d->extent,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, true);
+
+    if (!d->gpuSims.empty()) rg_add_pass(g, "sims", &record_sims, nullptr, RG_PASS_SIDE_EFFECT);
+
+    const RgRes scene = d->bloom ? bloom_import_scene(d, g) : swapImg;
+    rg_add_pass(g, "scene", &record_scene, nullptr);
+    rg_use(g, scene, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        d->bloom ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    if (d->pick) {
+        const RgRes ids = pick_import_ids(d, g);
+        rg_use(g, ids, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        pick_add_pass(d, g, ids);
     }
 
-    vkCmdEndRenderPass(cb);
+    if (d->bloom) bloom_add_pass(d, g, scene, swapImg);
+    capture_add_pass(d, g, swapImg);
+    windows_add_passes(d, g);
+
+    if (!rg_execute(d, g, cb)) log_msg(2, g_last_error.c_str());
     vkEndCommandBuffer(cb);
 }
 
@@ -657,23 +1334,48 @@ static void FM_CALL end_frame(fw_handle h)
     auto* d = H2D(h); if (!d) return;
     if (d->cbs.empty()) return;
 
+    // One submit waits on every acquired image; one present shows them all.
     VkCommandBuffer cb = d->cbs[d->curImg];
-    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    std::vector<VkSemaphore>&    waits = d->presentWaits;
+    std::vector<VkSwapchainKHR>& swaps = d->presentSwaps;
+    std::vector<uint32_t>&       idxs = d->presentImages;
+    std::vector<VkResult>&       results = d->presentResults;
+    waits.assign(1, d->semAcquire); swaps.assign(1, d->swap); idxs.assign(1, d->curImg);
+    for (WindowTarget* w : d->windows) {
+        if (!w->acquired) continue;
+        waits.push_back(w->semAcquire); swaps.push_back(w->swap); idxs.push_back(w->curImg);
+    }
+    d->presentStages.assign(waits.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    results.assign(swaps.size(), VK_SUCCESS);
 
     VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-    si.waitSemaphoreCount = 1; si.pWaitSemaphores = &d->semAcquire; si.pWaitDstStageMask = &waitStage;
+    si.waitSemaphoreCount = (uint32_t)waits.size(); si.pWaitSemaphores = waits.data();
+    si.pWaitDstStageMask = d->presentStages.data();
     si.commandBufferCount = 1; si.pCommandBuffers = &cb;
     si.signalSemaphoreCount = 1; si.pSignalSemaphores = &d->semRender;
     vkQueueSubmit(d->gfxQ, 1, &si, d->fence);
+    d->inFrame = false;
 
     VkPresentInfoKHR pi{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
-    VkSwapchainKHR sw = d->swap; uint32_t idx = d->curImg;
     pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = &d->semRender;
-    pi.swapchainCount = 1; pi.pSwapchains = &sw; pi.pImageIndices = &idx;
-    VkResult pr = vkQueuePresentKHR(d->gfxQ, &pi);
-    if (pr == VK_ERROR_OUT_OF_DATE_KHR || pr == VK_SUBOPTIMAL_KHR) d->needs_recreate = true;
+    pi.swapchainCount = (uint32_t)swaps.size(); pi.pSwapchains = swaps.data(); pi.pImageIndices = idxs.data();
+    pi.pResults = results.data();
+    vkQueuePresentKHR(d->gfxQ, &pi);
+    if (results[0] == VK_ERROR_OUT_OF_DATE_KHR || results[0] == VK_SUBOPTIMAL_KHR) d->needs_recreate = true;
+    for (size_t i = 1, k = 0; i < results.size(); ++k) {
+        WindowTarget* w = d->windows[k];
+        if (!w->acquired) continue;
+        if (results[i] == VK_ERROR_OUT_OF_DATE_KHR || results[i] == VK_SUBOPTIMAL_KHR) w->needsRecreate = true;
+        w->acquired = false;
+        ++i;
+    }
 
     d->vused = 0;
+    d->lineHasColor = false;
+    d->instCount = 0;
+    if (d->conics) d->conics->count = 0;
+    if (d->orbits) d->orbits->count = 0;
+    line_end_frame(d);
 }
 
 // =====================  EXPORTS  =====================
@@ -697,6 +1399,116 @@ extern "C" {
         g_api.destroy_device = &destroy_device;
         g_api.begin_frame = &begin_frame;
         g_api.end_frame = &end_frame;
+        g_api.jobs_configure = &jobs_configure_impl;
+
+        g_api.set_camera = &set_camera;
+        g_api.nbody_create = &nbody_create;
+        g_api.nbody_destroy = &nbody_destroy;
+        g_api.nbody_set_params = &nbody_set_params;
+        g_api.nbody_set_bodies = &nbody_set_bodies;
+        g_api.nbody_get_bodies = &nbody_get_bodies;
+        g_api.nbody_step = &nbody_step;
+        g_api.nbody_upload_points = &nbody_upload_points;
+
+        g_api.gpu_nbody_create = &gpu_nbody_create;
+        g_api.gpu_nbody_destroy = &gpu_nbody_destroy;
+        g_api.gpu_nbody_set_params = &gpu_nbody_set_params;
+        g_api.gpu_nbody_set_bodies = &gpu_nbody_set_bodies;
+        g_api.gpu_nbody_get_bodies = &gpu_nbody_get_bodies;
+        g_api.gpu_nbody_step = &gpu_nbody_step;
+        g_api.gpu_nbody_draw = &gpu_nbody_draw;
+
+        g_api.sim_clock_create = &sim_clock_create;
+        g_api.sim_clock_destroy = &sim_clock_destroy;
+        g_api.sim_clock_set_rate = &sim_clock_set_rate;
+        g_api.sim_clock_attach_nbody = &sim_clock_attach_nbody;
+        g_api.sim_clock_advance = &sim_clock_advance;
+        g_api.sim_clock_get_time = &sim_clock_get_time;
+        g_api.sim_upload_points = &sim_upload_points;
+
+        g_api.conj_create = &conj_create;
+        g_api.conj_destroy = &conj_destroy;
+        g_api.conj_set_params = &conj_set_params;
+        g_api.conj_set_radii = &conj_set_radii;
+        g_api.conj_detect = &conj_detect;
+        g_api.conj_detect_nbody = &conj_detect_nbody;
+        g_api.conj_get_events = &conj_get_events;
+
+        g_api.grid_set = &grid_set;
+        g_api.conics_upload = &conics_upload;
+        g_api.orbits_upload = &orbits_upload;
+        g_api.polyline_upload = &polyline_upload;
+
+        g_api.lines_upload_rgba = &lines_upload_rgba;
+        g_api.lines_set_blend = &lines_set_blend;
+        g_api.polyline_upload_rgba = &polyline_upload_rgba;
+
+        g_api.bloom_set = &bloom_set;
+        g_api.bloom_get_stats = &bloom_get_stats;
+
+        g_api.render_graph_get_stats = &render_graph_get_stats;
+
+        g_api.capture_start = &capture_start;
+        g_api.capture_poll = &capture_poll;
+
+        g_api.render_tiled = &render_tiled;
+
+        g_api.window_create = &window_create;
+        g_api.window_destroy = &window_destroy;
+        g_api.window_set_camera = &window_set_camera;
+
+        g_api.pick_enable = &pick_enable;
+        g_api.pick = &pick;
+        g_api.pick_poll = &pick_poll;
+
+        g_api.bvh_create = &bvh_create;
+        g_api.bvh_destroy = &bvh_destroy;
+        g_api.bvh_clear = &bvh_clear;
+        g_api.bvh_add_polyline = &bvh_add_polyline;
+        g_api.bvh_set_transform = &bvh_set_transform;
+        g_api.bvh_update = &bvh_update;
+        g_api.bvh_ray = &bvh_ray;
+        g_api.bvh_nearest = &bvh_nearest;
+        g_api.bvh_frustum = &bvh_frustum;
+
+        g_api.lines_set_simplify = &lines_set_simplify;
+        g_api.polylines_upload = &polylines_upload;
+        g_api.lines_get_simplify_stats = &lines_get_simplify_stats;
+
+        g_api.stars_load = &stars_load;
+        g_api.stars_set_params = &stars_set_params;
+
+        g_api.data_write = &data_write;
+        g_api.data_open = &data_open;
+        g_api.data_close = &data_close;
+        g_api.data_section_count = &data_section_count;
+        g_api.data_section_info = &data_section_info;
+        g_api.data_find_section = &data_find_section;
+        g_api.data_map_section = &data_map_section;
+
+        g_api.ephem_create = &ephem_create;
+        g_api.ephem_destroy = &ephem_destroy;
+        g_api.ephem_body_count = &ephem_body_count;
+        g_api.ephem_find_body = &ephem_find_body;
+        g_api.ephem_coverage = &ephem_coverage;
+        g_api.ephem_eval = &ephem_eval;
+
+        g_api.keyframes_create = &keyframes_create;
+        g_api.keyframes_destroy = &keyframes_destroy;
+        g_api.keyframes_set_budget = &keyframes_set_budget;
+        g_api.keyframes_reset = &keyframes_reset;
+        g_api.keyframes_seek = &keyframes_seek;
+        g_api.keyframes_get_stats = &keyframes_get_stats;
+
+        g_api.text_load_font = &text_load_font;
+        g_api.labels_upload = &labels_upload;
+        g_api.labels_set_outline = &labels_set_outline;
+        g_api.labels_set_declutter = &labels_set_declutter;
+        g_api.labels_get_stats = &labels_get_stats;
+
+        g_api.texture_create = &texture_create;
+        g_api.texture_destroy = &texture_destroy;
+        g_api.sprites_upload = &sprites_upload;
 
         return &g_api;
     }
@@ -10,6 +10,320 @@ extern "C" {
         void* hwnd; // HWND on Windows
     } fw_renderer_desc;
 
+    // Close-approach record from conj_detect; times are relative to the start of the tick.
+    enum { FW_CONJ_CLOSE_APPROACH = 1, FW_CONJ_COLLISION = 2 };
+    typedef struct fw_conj_event {
+        uint32_t a, b;          // body indices, a < b
+        uint32_t flags;         // FW_CONJ_*
+        uint32_t reserved;
+        double   t_closest;     // time of minimum separation within [0, dt]
+        double   min_dist;      // centre distance at t_closest
+        double   t_contact;     // first time the spheres touch, -1 if they don't
+    } fw_conj_event;
+
+    // Procedural reference grid on a plane (zero axes = ecliptic / world XY).
+    typedef struct fw_grid_desc {
+        double   origin[3];     // a point on the plane, world units
+        double   axis_u[3];     // in-plane axes (normalised / orthogonalised on set)
+        double   axis_v[3];
+        double   spacing;       // minor line spacing, world units
+        double   extent;        // half-size of the drawn quad; lines fade out towards it
+        uint32_t major_every;   // every Nth line is a major line
+        float    line_width;    // pixels
+        float    color[4];
+    } fw_grid_desc;
+
+    // Keplerian conic for analytic orbit rendering. Parabolic (e ~ 1) orbits are not
+    // representable and are skipped; use the polyline path for those.
+    typedef struct fw_conic {
+        double focus[3];        // world position of the attracting body
+        double periapsis[3];    // direction focus -> periapsis (projected into the plane)
+        double normal[3];       // orbit normal
+        double semi_major;      // |a|; the sign is ignored
+        double eccentricity;    // [0,1) ellipse, > 1 hyperbola
+        double max_radius;      // hyperbola only: arc drawn out to this focal distance
+        float  color[4];
+    } fw_conic;
+
+    // One instanced orbit: row-major 3x4 world transform of the unit circle (x, y, 0, 1).
+    // For an ellipse with centre C and semi-axes a, b along unit U, V: columns a*U, b*V, 0, C.
+    typedef struct fw_orbit_xform {
+        double m[12];
+        float  color[4];
+    } fw_orbit_xform;
+
+    // Blend modes for lines_set_blend
+    enum { FW_BLEND_OPAQUE = 0, FW_BLEND_ALPHA = 1, FW_BLEND_ADDITIVE = 2 };
+
+    // Per-draw line pattern, evaluated in the fragment shader from arc length.
+    // Stipple is a dash much shorter than the gap.
+    typedef struct fw_line_style {
+        float color0[4];        // colour at gradient[0]
+        float color1[4];        // colour at gradient[1]
+        float gradient[2];      // fractions of the polyline length; equal = solid color0
+        float dash;             // dash length in world units of arc length, 0 = solid
+        float gap;              // gap length, same units
+        float phase;            // pattern offset along the arc (animate for marching dashes)
+    } fw_line_style;
+
+    // Polyline simplification on upload (lines_set_simplify). SCREEN tolerances are pixels
+    // through the camera at upload time, WORLD ones world units.
+    enum { FW_SIMPLIFY_OFF = 0, FW_SIMPLIFY_DOUGLAS_PEUCKER = 1, FW_SIMPLIFY_VISVALINGAM = 2 };
+    enum { FW_SIMPLIFY_WORLD = 0, FW_SIMPLIFY_SCREEN = 1 };
+    typedef struct fw_simplify_desc {
+        uint32_t method;        // FW_SIMPLIFY_OFF / DOUGLAS_PEUCKER / VISVALINGAM
+        uint32_t space;         // FW_SIMPLIFY_WORLD / SCREEN
+        double   tolerance;     // max deviation kept out; 0 = upload every point
+    } fw_simplify_desc;
+
+    typedef struct fw_simplify_stats {
+        uint64_t points_in;     // polyline points passed in during the last frame
+        uint64_t points_out;    // points uploaded after simplification
+        uint32_t polylines;
+        float    ratio;         // points_out / points_in, 1 when nothing was uploaded
+    } fw_simplify_stats;
+
+    // One polyline of a polylines_upload batch; rgba and style may be NULL.
+    typedef struct fw_polyline {
+        const double*        xyz;
+        const uint32_t*      rgba;
+        const fw_line_style* style;
+        uint32_t             count;
+        uint32_t             reserved;
+    } fw_polyline;
+
+    // Catalog star (stars_load): also the record layout a binary catalog can be mapped as.
+    typedef struct fw_star {
+        float dir[3];           // direction on the celestial sphere, world axes
+        float magnitude;        // apparent visual magnitude
+        float color_index;      // B-V
+    } fw_star;
+
+    typedef struct fw_star_params {
+        float limiting_magnitude;   // faintest magnitude drawn (default 6.5)
+        float point_size;           // sprite diameter in pixels of a star at the limit (1.5)
+        float max_point_size;       // brighter stars grow with sqrt(flux) up to this (8)
+        float intensity;            // alpha of a star at the limit (1)
+    } fw_star_params;
+
+    // Section of a binary container (data_write / data_open). Payloads start on
+    // FW_DATA_ALIGN file offsets; elem_size 0 marks opaque data.
+    enum { FW_DATA_ALIGN = 4096 };
+    typedef struct fw_data_section_desc {
+        const char* name;       // up to 23 bytes
+        const void* data;
+        uint64_t    size;       // bytes
+        uint64_t    count;      // records
+        uint32_t    type;       // caller-defined tag, e.g. a fourcc
+        uint32_t    elem_size;  // bytes per record; count * elem_size must equal size
+    } fw_data_section_desc;
+
+    typedef struct fw_data_section {
+        char     name[24];
+        uint32_t type;
+        uint32_t elem_size;
+        uint64_t offset;        // in the file
+        uint64_t size;
+        uint64_t count;
+    } fw_data_section;
+
+    // One body of a Chebyshev ephemeris ("ephem.bodies" section). Its segments are
+    // times[first_segment + i] (start times, increasing) and, in "ephem.coeffs" from
+    // coeff_offset, records of 2 + 3 * coeffs doubles: mid, radius, x[coeffs], y[...], z[...].
+    typedef struct fw_ephem_body {
+        int32_t  id;            // target code
+        int32_t  center;        // code of the body positions are relative to
+        uint32_t coeffs;        // per component (degree + 1), at most 64
+        uint32_t segments;
+        uint64_t first_segment;
+        uint64_t coeff_offset;  // in doubles
+    } fw_ephem_body;
+
+    // Keyframe cache counters (keyframes_get_stats); the seek and step figures are cumulative.
+    typedef struct fw_keyframe_stats {
+        uint32_t keyframes;         // held now
+        uint32_t last_seek_steps;   // steps replayed by the last seek
+        uint64_t bytes;             // held now
+        uint64_t seeks;
+        uint64_t replayed_steps;
+        uint64_t prefilled;         // keyframes computed by the prefill thread
+        uint64_t evicted;
+    } fw_keyframe_stats;
+
+    // MSDF font for label text (text_load_font). Paths are UTF-8; cache_path may be NULL.
+    typedef struct fw_font_desc {
+        const char*     font_path;        // TrueType (glyf) font
+        const char*     cache_path;       // generated atlas, rebuilt when font or parameters change
+        float           em_px;            // atlas pixels per em (0 = 40)
+        float           px_range;         // distance range in atlas pixels (0 = 4)
+        const uint32_t* codepoints;       // NULL = ASCII, Latin-1 and Greek
+        uint32_t        codepoint_count;
+        uint32_t        reserved;
+    } fw_font_desc;
+
+    // Label anchor alignment: one horizontal value | one vertical value.
+    enum { FW_LABEL_LEFT = 0, FW_LABEL_CENTER = 1, FW_LABEL_RIGHT = 2 };
+    enum { FW_LABEL_BASELINE = 0, FW_LABEL_MIDDLE = 4, FW_LABEL_TOP = 8, FW_LABEL_BOTTOM = 12 };
+
+    // One label of a labels_upload batch
+    typedef struct fw_label {
+        double      pos[3];         // world anchor
+        const char* text;           // UTF-8, '\n' starts a new line
+        uint32_t    rgba;           // RGBA8, R in the lowest byte
+        float       size_px;        // em size on screen
+        float       offset_px[2];   // text block offset from the projected anchor, y up
+        uint32_t    align;          // FW_LABEL_* horizontal | vertical
+        float       priority;       // declutter order, higher first; ties keep input order
+    } fw_label;
+
+    // Label declutter (labels_set_declutter): each labels_upload keeps, in priority order,
+    // the labels whose screen boxes clear every label already kept.
+    typedef struct fw_declutter_desc {
+        uint32_t enabled;
+        float    padding_px;        // minimum gap between kept labels
+        float    cell_px;           // screen grid cell, 0 = from the mean label size
+        uint32_t reserved;
+    } fw_declutter_desc;
+
+    typedef struct fw_label_stats {
+        uint32_t labels;            // passed to the last labels_upload
+        uint32_t drawn;
+        uint32_t hidden;            // declutter: overlapped a higher-priority label
+        uint32_t culled;            // declutter: behind the camera, off screen or empty
+        uint32_t glyphs;
+        float    cpu_ms;            // layout and declutter time of the last labels_upload
+    } fw_label_stats;
+
+    // Bindless texture (texture_create): RGBA8 pixels, R in the lowest byte.
+    enum { FW_TEXTURE_SRGB = 1, FW_TEXTURE_MIPMAPS = 2, FW_TEXTURE_NEAREST = 4 };
+
+    typedef struct fw_texture_desc {
+        const void* pixels;
+        uint32_t    width, height;
+        uint32_t    row_pitch;        // bytes between rows, 0 = width * 4
+        uint32_t    flags;            // FW_TEXTURE_*
+    } fw_texture_desc;
+
+    // One sprite of a sprites_upload batch: a screen-aligned quad around the projected anchor.
+    typedef struct fw_sprite {
+        double   pos[3];            // world anchor (quad centre)
+        float    size_px[2];        // on screen
+        float    uv[4];             // u0, v0, u1, v1 of the texture, all 0 = the whole texture
+        uint32_t texture;           // texture_create ID, 0 = plain colour
+        uint32_t rgba;              // RGBA8 tint, R in the lowest byte
+    } fw_sprite;
+
+    // HDR bloom post chain (bloom_set). Threshold and knee are in scene colour units, where
+    // 1 is display white before tonemapping.
+    typedef struct fw_bloom_desc {
+        float threshold;        // brightness where glow starts
+        float knee;             // soft transition width around the threshold, 0 = hard cut
+        float intensity;        // bloom weight added to the scene
+        float exposure;         // scene scale before the filmic tonemap
+        float budget_ms;        // GPU time allowed for the chain, 0 = no limit
+    } fw_bloom_desc;
+
+    typedef struct fw_bloom_stats {
+        float    gpu_ms;        // smoothed GPU time of the chain, -1 if not measured (yet)
+        uint32_t levels;        // blur levels currently run: 2 full, 1 half only, 0 tonemap only
+    } fw_bloom_stats;
+
+    typedef struct fw_render_graph_stats {
+        uint32_t passes;            // passes recorded last frame
+        uint32_t culled;            // declared passes whose output nobody consumed
+        uint32_t barrier_batches;   // pipeline barrier calls inserted between passes
+        uint32_t pad;
+        uint64_t transient_bytes;   // sum of transient resource sizes
+        uint64_t heap_bytes;        // memory bound to them after aliasing
+    } fw_render_graph_stats;
+
+    // Frame capture (capture_start). I420 is the Y plane (row_pitch = width) followed by the
+    // U and V planes at half resolution, tightly packed; width/height are then cropped to
+    // multiples of 8 and 2. BGRA8/RGBA8 follow the swapchain format, row_pitch = width * 4.
+    enum { FW_CAPTURE_BGRA8 = 0, FW_CAPTURE_RGBA8 = 1, FW_CAPTURE_I420 = 2 };
+    typedef struct fw_capture_frame {
+        uint64_t       frame;       // frame number since capture_start
+        uint64_t       dropped;     // frames skipped so far because every slot was busy
+        const uint8_t* data;        // valid during the callback / until the next poll
+        uint64_t       bytes;
+        uint32_t       width, height;
+        uint32_t       row_pitch;
+        uint32_t       format;      // FW_CAPTURE_*
+    } fw_capture_frame;
+
+    typedef void (FM_CALL* fw_capture_fn)(const fw_capture_frame* frame, void* user);
+
+    typedef struct fw_capture_desc {
+        uint32_t      ring_size;    // host readback buffers, 2..8 (0 = 3)
+        uint32_t      yuv420;       // 1 = convert to I420 on the GPU before the copy
+        uint32_t      interval;     // capture every Nth frame (0 = every frame)
+        uint32_t      reserved;
+        fw_capture_fn callback;     // called from begin_frame; NULL = use capture_poll
+        void*         user;
+    } fw_capture_desc;
+
+    // Tiled offscreen rendering (render_tiled). One band of full-width rows, top to bottom,
+    // in the capture pixel format (FW_CAPTURE_BGRA8 or RGBA8); data is valid during the call.
+    typedef struct fw_row_block {
+        const uint8_t* data;
+        uint32_t       first_row;
+        uint32_t       row_count;
+        uint32_t       width;
+        uint32_t       row_pitch;   // bytes
+        uint32_t       format;      // FW_CAPTURE_*
+        uint32_t       reserved;
+    } fw_row_block;
+
+    // Return nonzero to abort the render.
+    typedef int (FM_CALL* fw_rows_fn)(const fw_row_block* rows, void* user);
+
+    typedef struct fw_tiled_desc {
+        uint32_t   width;           // output size, any size
+        uint32_t   height;
+        uint32_t   tile_size;       // max tile edge (0 = 2048, clamped to the device limit)
+        uint32_t   reserved;
+        uint64_t   memory_budget;   // bytes for the band strip and both tiles (0 = 64 MiB)
+        fw_rows_fn sink;
+        void*      user;
+    } fw_tiled_desc;
+
+    // Extra window on an existing device (window_create)
+    typedef struct fw_window_desc {
+        void* hwnd; // HWND on Windows
+    } fw_window_desc;
+
+    // Object picking (pick_enable / pick / pick_poll). index is the point instance of the
+    // frame's point buffer, the body of a GPU sim (object = its handle), the orbit or conic
+    // in upload order (skipped conics included), the polyline in polyline_upload order of that frame, or the label or sprite
+    // in labels_upload / sprites_upload order.
+    enum { FW_PICK_NONE = 0, FW_PICK_POINT = 1, FW_PICK_BODY = 2, FW_PICK_ORBIT = 3, FW_PICK_CONIC = 4,
+           FW_PICK_POLYLINE = 5, FW_PICK_LABEL = 6, FW_PICK_SPRITE = 7 };
+
+    typedef struct fw_pick_result {
+        uint32_t  kind;       // FW_PICK_*, NONE when nothing lies within the radius
+        uint32_t  index;
+        fw_handle object;     // FW_PICK_BODY: the GPU sim, else 0
+        int32_t   x, y;       // requested pixel
+        float     distance;   // pixels from (x, y) to the nearest covered pixel of the hit
+        uint32_t  reserved;
+    } fw_pick_result;
+
+    // Segment BVH query results. segment k joins points k and k + 1 of the polyline
+    // (index returned by bvh_add_polyline).
+    typedef struct fw_bvh_hit {
+        uint32_t polyline;
+        uint32_t segment;
+        double   distance;    // from the ray / query point to the segment
+        double   t;           // bvh_ray: ray parameter of the closest approach; bvh_nearest: 0
+        double   u;           // position of the closest point along the segment, [0, 1]
+        double   point[3];    // closest point on the segment, world
+    } fw_bvh_hit;
+
+    typedef struct fw_bvh_segment {
+        uint32_t polyline;
+        uint32_t segment;
+    } fw_bvh_segment;
+
     // Full function table returned by fmGetRendererAPI
     typedef struct fw_renderer_api {
         fw_header hdr;
@@ -21,13 +335,243 @@ extern "C" {
         int  (FM_CALL* create_device)(const fw_renderer_desc* desc, fw_handle* out_dev);
         void (FM_CALL* destroy_device)(fw_handle dev);
 
-        // Per-frame
+        // Per-frame. begin_frame records the frame from what has been uploaded so far and
+        // end_frame submits it. Uploads through host buffers (lines_upload_rgba, conics,
+        // orbits, polylines, labels, sprites, points, the first stars_set_params) belong
+        // before begin_frame: in between they return FM_E_NOTREADY.
         void (FM_CALL* begin_frame)(fw_handle dev);
         void (FM_CALL* end_frame)  (fw_handle dev);
 
         // Demo draw path: upload an array of NDC line vertices [x0,y0, x1,y1, ...]
         int  (FM_CALL* lines_upload)(fw_handle dev, const float* xy, uint32_t count,
             float r, float g, float b, float a);
+
+        // ---- Extensions below are appended only; the prefix above keeps its v3 layout ----
+
+        // Shared job system: worker_count 0 = cores-1, affinity_mask 0 = unpinned.
+        // Takes effect when the pool starts (first device, sim or other pool user); returns
+        // FM_E_NOTREADY and changes nothing while the pool is running.
+        int  (FM_CALL* jobs_configure)(uint32_t worker_count, uint64_t affinity_mask);
+
+        // Camera for world-space passes: column-major view*proj (16 floats, may be NULL to keep)
+        // and a double-precision origin subtracted from positions before float conversion.
+        int  (FM_CALL* set_camera)(fw_handle dev, const float* view_proj, const double* origin);
+
+        // N-body integrator (Barnes-Hut or direct). Arrays are xyz triplets; vel may be NULL.
+        // mode: 0 = Barnes-Hut, 1 = direct O(N^2). softening is a length, theta the opening angle.
+        int  (FM_CALL* nbody_create)(uint32_t capacity, fw_handle* out_sim);
+        void (FM_CALL* nbody_destroy)(fw_handle sim);
+        int  (FM_CALL* nbody_set_params)(fw_handle sim, double G, double softening, double theta, uint32_t mode);
+        int  (FM_CALL* nbody_set_bodies)(fw_handle sim, const double* pos_xyz, const double* vel_xyz,
+            const double* mass, uint32_t count);
+        int  (FM_CALL* nbody_get_bodies)(fw_handle sim, double* pos_xyz, double* vel_xyz, uint32_t count);
+        int  (FM_CALL* nbody_step)(fw_handle sim, double dt, uint32_t substeps);
+        // Copies current positions into the device's point instance buffer for this frame.
+        // point_size here and in the other point draws is clamped to the device's point size
+        // range (1 px on devices without the largePoints feature).
+        int  (FM_CALL* nbody_upload_points)(fw_handle dev, fw_handle sim,
+            float r, float g, float b, float a, float point_size);
+
+        // GPU direct N-body on the device's queue (float precision, positions relative to the
+        // camera origin at upload time). Steps and draws are recorded into the next frame;
+        // get_bodies is a blocking readback meant for validation.
+        int  (FM_CALL* gpu_nbody_create)(fw_handle dev, uint32_t capacity, fw_handle* out_sim);
+        void (FM_CALL* gpu_nbody_destroy)(fw_handle sim);
+        int  (FM_CALL* gpu_nbody_set_params)(fw_handle sim, double G, double softening);
+        int  (FM_CALL* gpu_nbody_set_bodies)(fw_handle sim, const double* pos_xyz, const double* vel_xyz,
+            const double* mass, uint32_t count);
+        int  (FM_CALL* gpu_nbody_get_bodies)(fw_handle sim, double* pos_xyz, double* vel_xyz, uint32_t count);
+        int  (FM_CALL* gpu_nbody_step)(fw_handle sim, double dt, uint32_t substeps);
+        int  (FM_CALL* gpu_nbody_draw)(fw_handle sim, float r, float g, float b, float a, float point_size);
+
+        // Fixed-timestep clock. advance() accumulates real seconds * time_scale and runs whole
+        // fixed steps of the attached N-body sim (at most max_steps per call; any backlog beyond
+        // that is dropped). alpha = leftover / fixed_dt is the interpolation factor between the
+        // last two step snapshots, which sim_upload_points blends on upload.
+        int  (FM_CALL* sim_clock_create)(double fixed_dt, fw_handle* out_clock);
+        void (FM_CALL* sim_clock_destroy)(fw_handle clock);
+        int  (FM_CALL* sim_clock_set_rate)(fw_handle clock, double time_scale, uint32_t max_steps);
+        int  (FM_CALL* sim_clock_attach_nbody)(fw_handle clock, fw_handle nbody_sim, uint32_t substeps);
+        int  (FM_CALL* sim_clock_advance)(fw_handle clock, double real_seconds,
+            uint32_t* out_steps, double* out_alpha);
+        int  (FM_CALL* sim_clock_get_time)(fw_handle clock, double* out_sim_time, double* out_alpha);
+        int  (FM_CALL* sim_upload_points)(fw_handle dev, fw_handle clock,
+            float r, float g, float b, float a, float point_size);
+
+        // Close-approach / collision detection over one tick of linear motion. Bodies whose
+        // spheres (radius from set_radii, 0 if unset) come within margin of each other during
+        // [0, dt] are reported, sorted by (a, b). cell_size 0 picks the hash cell size from the
+        // swept boxes. detect returns the event count (or FM_E_*); get_events copies them out.
+        int  (FM_CALL* conj_create)(fw_handle* out_det);
+        void (FM_CALL* conj_destroy)(fw_handle det);
+        int  (FM_CALL* conj_set_params)(fw_handle det, double margin, double cell_size);
+        int  (FM_CALL* conj_set_radii)(fw_handle det, const double* radii, uint32_t count);
+        int  (FM_CALL* conj_detect)(fw_handle det, const double* pos_xyz, const double* vel_xyz,
+            uint32_t count, double dt);
+        int  (FM_CALL* conj_detect_nbody)(fw_handle det, fw_handle nbody_sim, double dt);
+        int  (FM_CALL* conj_get_events)(fw_handle det, fw_conj_event* out, uint32_t max_events);
+
+        // Reference grid drawn analytically from one quad under the camera, before other
+        // world passes. Persistent until changed; desc NULL hides it.
+        int  (FM_CALL* grid_set)(fw_handle dev, const fw_grid_desc* desc);
+
+        // Analytic orbits: each conic is one quad shaded by per-pixel distance to the curve.
+        // Per frame like lines_upload; returns the number of drawable conics.
+        int  (FM_CALL* conics_upload)(fw_handle dev, const fw_conic* conics, uint32_t count, float line_width);
+
+        // All orbits in one instanced draw of a shared unit-circle strip. Per frame.
+        int  (FM_CALL* orbits_upload)(fw_handle dev, const fw_orbit_xform* orbits, uint32_t count);
+
+        // Styled world-space polyline (xyz triplets), appended to this frame's batch as one
+        // line-strip draw; style may be NULL for solid white.
+        int  (FM_CALL* polyline_upload)(fw_handle dev, const double* xyz, uint32_t count,
+            const fw_line_style* style);
+
+        // Per-vertex colour (packed RGBA8, R in the lowest byte) for the NDC lines and styled
+        // polylines, and the blend mode (FW_BLEND_*) used by lines and by polylines uploaded
+        // after the call (until it is called, lines are opaque and polylines alpha blended).
+        // Mixed colours and additive trails then go out in a single draw.
+        int  (FM_CALL* lines_upload_rgba)(fw_handle dev, const float* xy, const uint32_t* rgba, uint32_t count);
+        int  (FM_CALL* lines_set_blend)(fw_handle dev, uint32_t mode);
+        int  (FM_CALL* polyline_upload_rgba)(fw_handle dev, const double* xyz, const uint32_t* rgba,
+            uint32_t count, const fw_line_style* style);
+
+        // Optional post chain: the scene renders into an HDR target, bright parts are blurred
+        // at half and quarter resolution in compute and the tonemap writes the swapchain.
+        // With a budget, blur levels are dropped while the measured GPU time exceeds it.
+        // desc NULL disables. Enabling/disabling waits for the device and rebuilds pipelines,
+        // so it belongs before begin_frame (FM_E_NOTREADY in between); parameters change anytime.
+        int  (FM_CALL* bloom_set)(fw_handle dev, const fw_bloom_desc* desc);
+        int  (FM_CALL* bloom_get_stats)(fw_handle dev, fw_bloom_stats* out);
+
+        // Frame recording goes through a render graph (pass culling, automatic barriers,
+        // aliased transients); this reports what the last frame did.
+        int  (FM_CALL* render_graph_get_stats)(fw_handle dev, fw_render_graph_stats* out);
+
+        // Asynchronous readback of the presented image into a ring of host buffers, delivered
+        // one frame later without stalling (to the callback, or through capture_poll). desc
+        // NULL stops; start/stop belong before begin_frame (FM_E_NOTREADY in between).
+        // capture_poll returns 1 when it filled *out and FM_E_NOTREADY when no frame is
+        // waiting yet or capture is not running; never FM_OK.
+        int  (FM_CALL* capture_start)(fw_handle dev, const fw_capture_desc* desc);
+        int  (FM_CALL* capture_poll)(fw_handle dev, fw_capture_frame* out);
+
+        // Renders the current scene at desc->width x desc->height (beyond the swapchain and
+        // image limits) in tiles between frames, streaming bands of rows to desc->sink.
+        // Blocking; bloom must be off. Call it after the scene's uploads and before
+        // begin_frame; between begin_frame and end_frame it returns FM_E_NOTREADY.
+        int  (FM_CALL* render_tiled)(fw_handle dev, const fw_tiled_desc* desc);
+
+        // More windows on one device: shared pipelines and geometry, one scene pass per window
+        // each frame and a single batched present. The surface must offer the main window's
+        // format; not available with bloom on. Create/destroy between frames: inside one,
+        // create returns FM_E_NOTREADY and destroy leaves the window alive (error set).
+        // view_proj is relative to the device origin; NULL follows the device camera.
+        int  (FM_CALL* window_create)(fw_handle dev, const fw_window_desc* desc, fw_handle* out_win);
+        void (FM_CALL* window_destroy)(fw_handle win);
+        int  (FM_CALL* window_set_camera)(fw_handle win, const float* view_proj);
+
+        // Object IDs: enable adds an R32_UINT ID attachment to the scene pass (not with bloom or
+        // extra windows); switching it belongs before begin_frame (FM_E_NOTREADY in between).
+        // pick() queues a lookup of the nearest object within radius pixels (max 32); the next
+        // frame copies that window out and pick_poll returns 1 with the result a frame later,
+        // FM_E_NOTREADY until then (and while picking is off); never FM_OK. Never waits on the GPU.
+        int  (FM_CALL* pick_enable)(fw_handle dev, uint32_t enable);
+        int  (FM_CALL* pick)(fw_handle dev, int32_t x, int32_t y, uint32_t radius);
+        int  (FM_CALL* pick_poll)(fw_handle dev, fw_pick_result* out);
+
+        // CPU BVH over polylines (no device needed). xform is a row-major 3x4 world transform,
+        // NULL for identity. Changes apply on bvh_update: set_transform refits, add/clear (or
+        // rebuild != 0) rebuild; queries return FM_E_NOTREADY until then and may run from
+        // several threads. ray / nearest return 1 with *out filled, 0 on a miss; frustum
+        // (six planes a, b, c, d, inside where >= 0) returns the total and copies up to max.
+        int  (FM_CALL* bvh_create)(fw_handle* out_bvh);
+        void (FM_CALL* bvh_destroy)(fw_handle bvh);
+        int  (FM_CALL* bvh_clear)(fw_handle bvh);
+        int  (FM_CALL* bvh_add_polyline)(fw_handle bvh, const double* xyz, uint32_t count, const double* xform);
+        int  (FM_CALL* bvh_set_transform)(fw_handle bvh, uint32_t polyline, const double* xform);
+        int  (FM_CALL* bvh_update)(fw_handle bvh, uint32_t rebuild);
+        int  (FM_CALL* bvh_ray)(fw_handle bvh, const double* origin, const double* dir, double max_t,
+            double radius, fw_bvh_hit* out);
+        int  (FM_CALL* bvh_nearest)(fw_handle bvh, const double* point, double max_dist, fw_bvh_hit* out);
+        int  (FM_CALL* bvh_frustum)(fw_handle bvh, const double* planes, fw_bvh_segment* out, uint32_t max_segments);
+
+        // Optional simplification (Douglas-Peucker or Visvalingam, world or pixel tolerance)
+        // of later polyline uploads; arc length for patterns still follows the full path.
+        // polylines_upload appends a batch (all of it or, on failure, none), simplifying the
+        // polylines in parallel; the stats report the last frame's points in and out. desc
+        // NULL turns simplification off.
+        int  (FM_CALL* lines_set_simplify)(fw_handle dev, const fw_simplify_desc* desc);
+        int  (FM_CALL* polylines_upload)(fw_handle dev, const fw_polyline* lines, uint32_t count);
+        int  (FM_CALL* lines_get_simplify_stats)(fw_handle dev, fw_simplify_stats* out);
+
+        // Background star field: the catalog is bucketed by magnitude and uploaded once
+        // (blocking; returns the star count, 0 clears; FM_E_NOTREADY inside a frame), then
+        // drawn every frame behind the scene as one indirect draw of the buckets brighter
+        // than the limiting magnitude.
+        int  (FM_CALL* stars_load)(fw_handle dev, const fw_star* stars, uint32_t count);
+        int  (FM_CALL* stars_set_params)(fw_handle dev, const fw_star_params* params);
+
+        // Versioned, checksummed binary container (paths are UTF-8). open reads only the header
+        // and table of contents; map_section maps one section read-only on first use (verify
+        // checks its CRC-32C once) and returns a pointer valid until close, which can go
+        // straight to stars_load, an upload or a staging copy. find returns 1 when found.
+        int  (FM_CALL* data_write)(const char* path, const fw_data_section_desc* sections, uint32_t count);
+        int  (FM_CALL* data_open)(const char* path, fw_handle* out_file);
+        void (FM_CALL* data_close)(fw_handle file);
+        int  (FM_CALL* data_section_count)(fw_handle file);
+        int  (FM_CALL* data_section_info)(fw_handle file, uint32_t index, fw_data_section* out);
+        int  (FM_CALL* data_find_section)(fw_handle file, const char* name, uint32_t* out_index);
+        int  (FM_CALL* data_map_section)(fw_handle file, uint32_t index, uint32_t verify, const void** out_data);
+
+        // Chebyshev ephemeris evaluated in place over an open data file (which must outlive it).
+        // eval writes xyz per body relative to its centre, in file units per time unit for
+        // velocities (vel_xyz may be null), and returns how many bodies had no coverage at t
+        // (their outputs are NaN). Safe to call from several threads on one handle.
+        int  (FM_CALL* ephem_create)(fw_handle data_file, uint32_t verify, fw_handle* out_eph);
+        void (FM_CALL* ephem_destroy)(fw_handle eph);
+        int  (FM_CALL* ephem_body_count)(fw_handle eph);
+        int  (FM_CALL* ephem_find_body)(fw_handle eph, int32_t id, uint32_t* out_index);
+        int  (FM_CALL* ephem_coverage)(fw_handle eph, uint32_t body, double* out_begin, double* out_end);
+        int  (FM_CALL* ephem_eval)(fw_handle eph, double t, const uint32_t* bodies, uint32_t count,
+            double* pos_xyz, double* vel_xyz);
+
+        // Keyframed timeline of a sim clock's N-body sim for scrubbing: keyframes every
+        // interval_steps fixed steps, evicted least recently used past budget_bytes (0 = 256 MB),
+        // with `ahead` of them prefilled in the playback direction by a background thread.
+        // seek restores the nearest keyframe and replays fewer than interval_steps steps. When
+        // the target's keyframe is not cached yet it stops that short of it, returns 1 and has
+        // the prefill thread compute the keyframe; repeat the seek until it returns FM_OK.
+        int  (FM_CALL* keyframes_create)(fw_handle clock, uint32_t interval_steps, uint64_t budget_bytes,
+            uint32_t ahead, fw_handle* out_cache);
+        void (FM_CALL* keyframes_destroy)(fw_handle cache);
+        int  (FM_CALL* keyframes_set_budget)(fw_handle cache, uint64_t budget_bytes, uint32_t ahead);
+        int  (FM_CALL* keyframes_reset)(fw_handle cache);
+        int  (FM_CALL* keyframes_seek)(fw_handle cache, double sim_time, double* out_time);
+        int  (FM_CALL* keyframes_get_stats)(fw_handle cache, fw_keyframe_stats* out);
+
+        // Text labels from an MSDF glyph atlas (generated once, cached on disk). load_font is
+        // blocking, belongs before begin_frame (FM_E_NOTREADY in between) and returns the glyph
+        // count; labels_upload replaces this frame's labels, lays them out in parallel and
+        // returns the glyph quads drawn, all in one instanced draw.
+        // Outline width (pixels, 0 = none) is limited by the font's distance range.
+        int  (FM_CALL* text_load_font)(fw_handle dev, const fw_font_desc* desc);
+        int  (FM_CALL* labels_upload)(fw_handle dev, const fw_label* labels, uint32_t count);
+        int  (FM_CALL* labels_set_outline)(fw_handle dev, float width_px, uint32_t rgba);
+
+        // Screen-space declutter of later labels_upload batches through the camera at upload
+        // time (desc NULL turns it off); the stats describe the last batch.
+        int  (FM_CALL* labels_set_declutter)(fw_handle dev, const fw_declutter_desc* desc);
+        int  (FM_CALL* labels_get_stats)(fw_handle dev, fw_label_stats* out);
+
+        // Bindless textures: one descriptor array shared by every draw, indexed per instance.
+        // texture_create uploads (blocking) and returns an ID > 0; IDs are recycled after
+        // texture_destroy, which returns FM_E_NOTREADY between begin_frame and end_frame.
+        // Both return FM_E_UNSUPPORTED without VK_EXT_descriptor_indexing.
+        // sprites_upload replaces this frame's sprites, any mix of textures in one draw.
+        int  (FM_CALL* texture_create)(fw_handle dev, const fw_texture_desc* desc, uint32_t* out_id);
+        int  (FM_CALL* texture_destroy)(fw_handle dev, uint32_t id);
+        int  (FM_CALL* sprites_upload)(fw_handle dev, const fw_sprite* sprites, uint32_t count);
     } fw_renderer_api;
 
     // Single exported function that returns &fw_renderer_api
@@ -0,0 +1,282 @@
+#pragma once
+// renderer_device.h
+// Internal Device state shared by the renderer translation units (not part of the C ABI).
+
+#include "renderer_api.h"
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef VK_USE_PLATFORM_WIN32_KHR
+#define VK_USE_PLATFORM_WIN32_KHR
+#endif
+#include <windows.h>
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstdint>
+
+struct GpuNBody;
+struct GridPass;
+struct ConicPass;
+struct OrbitPass;
+struct LinePass;
+struct BloomPass;
+struct RenderGraph;
+struct CapturePass;
+struct WindowTarget;
+struct PickPass;
+struct StarPass;
+struct TextPass;
+struct TextureTable;
+struct SpritePass;
+
+// Host-visible, persistently mapped buffer for per-frame uploads; grows on demand.
+struct HostBuffer
+{
+    VkBuffer       buf = VK_NULL_HANDLE;
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    void*          mapped = nullptr;
+    size_t         cap = 0;
+};
+
+// Device-local 2D image with a full-view, one mip, one layer.
+struct GpuImage
+{
+    VkImage        img = VK_NULL_HANDLE;
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    VkImageView    view = VK_NULL_HANDLE;
+    VkFormat       fmt = VK_FORMAT_UNDEFINED;
+    VkExtent2D     extent{ 0,0 };
+};
+
+// Fixed-function blend presets for create_graphics_pipeline
+enum PipelineBlend
+{
+    BLEND_OPAQUE = 0,
+    BLEND_ALPHA = 1,      // straight alpha: src*a + dst*(1-a)
+    BLEND_ADDITIVE = 2,   // src*a + dst
+};
+
+// Everything that differs between the renderer's graphics pipelines; the rest (dynamic
+// viewport/scissor, no culling, 1 sample, subpass 0) is shared.
+struct GfxPipelineDesc
+{
+    const uint32_t* vs = nullptr;  size_t vsBytes = 0;
+    const uint32_t* fs = nullptr;  size_t fsBytes = 0;
+    const VkVertexInputBindingDescription*   bindings = nullptr;   uint32_t bindingCount = 0;
+    const VkVertexInputAttributeDescription* attrs = nullptr;      uint32_t attrCount = 0;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    PipelineBlend       blend = BLEND_OPAQUE;
+    VkPipelineLayout    layout = VK_NULL_HANDLE;
+    VkRenderPass        renderPass = VK_NULL_HANDLE;   // null = the scene pass d->rp
+};
+
+// Registered pipeline: the desc with its vertex layout copied out of the caller's frame,
+// and the caller-owned handle the rebuilt pipeline is written back to.
+struct GfxPipelineSlot
+{
+    GfxPipelineDesc desc;
+    std::vector<VkVertexInputBindingDescription>   bindings;
+    std::vector<VkVertexInputAttributeDescription> attrs;
+    VkPipeline*     out = nullptr;
+};
+
+// ===== device state =====
+struct Device
+{
+    HWND            hwnd = nullptr;
+
+    VkInstance       instance = VK_NULL_HANDLE;
+    VkPhysicalDevice phys = VK_NULL_HANDLE;
+    VkDevice         device = VK_NULL_HANDLE;
+    uint32_t         gfxFam = 0xFFFFFFFF;
+    VkQueue          gfxQ = VK_NULL_HANDLE;
+    // VK_KHR_synchronization2 when the device has it; null = legacy vkCmdPipelineBarrier
+    PFN_vkCmdPipelineBarrier2KHR cmdBarrier2 = nullptr;
+    // Update-after-bind sampled images per stage with VK_EXT_descriptor_indexing; 0 = no
+    // bindless texture table on this device
+    uint32_t         bindlessMax = 0;
+    // Largest gl_PointSize the device rasterizes (pointSizeRange, 1 without largePoints);
+    // point passes clamp their push constants to it
+    float            pointSizeMax = 1.0f;
+
+    VkSurfaceKHR     surface = VK_NULL_HANDLE;
+    VkSwapchainKHR   swap = VK_NULL_HANDLE;
+    VkFormat         swapFmt = VK_FORMAT_B8G8R8A8_UNORM;
+    VkImageUsageFlags swapUsage = 0;
+    VkExtent2D       extent{ 0,0 };
+    std::vector<VkImage>     images;
+    std::vector<VkImageView> views;
+
+    // Scene pass that every registered graphics pipeline is built against. It is swapRp
+    // (straight into the swapchain) unless a post chain renders the scene offscreen first.
+    VkRenderPass                 rp = VK_NULL_HANDLE;
+    VkRenderPass                 swapRp = VK_NULL_HANDLE;
+    std::vector<VkFramebuffer>   fbs;       // per swapchain image, for swapRp
+
+    VkCommandPool                cmdPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> cbs;
+    VkSemaphore semAcquire = VK_NULL_HANDLE;
+    VkSemaphore semRender = VK_NULL_HANDLE;
+    VkFence     fence = VK_NULL_HANDLE;
+    uint32_t    curImg = 0;
+    // end_frame scratch for the batched submit/present (main swapchain first, then windows)
+    std::vector<VkSemaphore>          presentWaits;
+    std::vector<VkPipelineStageFlags> presentStages;
+    std::vector<VkSwapchainKHR>       presentSwaps;
+    std::vector<uint32_t>             presentImages;
+    std::vector<VkResult>             presentResults;
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    VkBuffer         vbuf = VK_NULL_HANDLE;
+    VkDeviceMemory   vmem = VK_NULL_HANDLE;
+    size_t           vcap = 0;
+    size_t           vused = 0;
+    void* mapped = nullptr;
+
+    float            color[4]{ 1,1,1,1 };
+
+    // Lines pass variants, indexed by PipelineBlend: solid colour (the opaque one is `pipe`)
+    // and per-vertex RGBA8 colour read from lineRgba alongside vbuf.
+    VkPipeline       lineBlendPipes[3]{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
+    VkPipeline       lineColorPipes[3]{ VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
+    HostBuffer       lineRgba;
+    bool             lineHasColor = false;
+    uint32_t         lineBlend = 0;      // PipelineBlend for the NDC lines
+    uint32_t         polylineBlend = BLEND_ALPHA;   // for later polyline uploads; set with lineBlend
+    fw_simplify_desc lineSimplify{};     // applied to later polyline uploads
+
+    // World-space point instances (N-body output etc.), drawn as one instanced point list
+    VkPipelineLayout pointLayout = VK_NULL_HANDLE;
+    VkPipeline       pointPipe = VK_NULL_HANDLE;
+    VkBuffer         instBuf = VK_NULL_HANDLE;
+    VkDeviceMemory   instMem = VK_NULL_HANDLE;
+    size_t           instCap = 0; // bytes
+    uint32_t         instCount = 0;
+    void*            instMapped = nullptr;
+    float            pointColor[4]{ 1,1,1,1 };
+    float            pointSize = 1.0f;
+
+    // Camera: column-major view*projection, applied to positions made relative to `origin`
+    // in double precision before the float conversion.
+    float            viewProj[16]{ 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+    double           origin[3]{ 0,0,0 };
+
+    // Compute-driven simulations recorded ahead of the render pass each frame
+    std::vector<GpuNBody*> gpuSims;
+
+    // Catalog star field behind everything (created on first use)
+    StarPass*        stars = nullptr;
+    // Procedural reference grid (created on first use)
+    GridPass*        grid = nullptr;
+    // Analytic orbit conics (created on first use)
+    ConicPass*       conics = nullptr;
+    // Instanced unit-circle orbits (created on first use)
+    OrbitPass*       orbits = nullptr;
+    // Styled world-space polylines (created on first use)
+    LinePass*        lines = nullptr;
+    // Bindless texture table (created by texture_create)
+    TextureTable*    textures = nullptr;
+    // Textured screen-space sprites (created on first use)
+    SpritePass*      sprites = nullptr;
+    // MSDF text labels (created by text_load_font)
+    TextPass*        text = nullptr;
+    // HDR offscreen scene + bloom/tonemap post chain (created when enabled)
+    BloomPass*       bloom = nullptr;
+
+    // Frame passes and their barriers/transients, rebuilt each begin_frame
+    RenderGraph*     graph = nullptr;
+    // Frame readback ring (created by capture_start)
+    CapturePass*     capture = nullptr;
+    // Object-ID attachment in the scene pass + pick readback (created by pick_enable)
+    PickPass*        pick = nullptr;
+    // Extra windows presented with this one (created by window_create)
+    std::vector<WindowTarget*> windows;
+
+    // Scene pipelines, rebuilt in place when rp changes (see create_graphics_pipeline)
+    std::vector<GfxPipelineSlot> gfxPipes;
+
+    bool             needs_recreate = false;
+    // Between begin_frame's fence reset and end_frame's submit: d->fence will not signal,
+    // so nothing may wait on it (uploads, render_tiled, texture_destroy: FM_E_NOTREADY), nor
+    // free what the recorded frame uses (bloom/pick switches, capture_start, windows,
+    // stars_load, text_load_font: FM_E_NOTREADY).
+    bool             inFrame = false;
+};
+
+// Scene background, shared by every pass that clears the scene target
+static const float kClearColor[4]{ 0.02f, 0.03f, 0.05f, 1.0f };
+
+// Object ID written by the scene fragment shaders to the pick attachment: FW_PICK_* kind in
+// the top 4 bits, the index within that kind below. 0 is the background.
+static inline uint32_t pick_id(uint32_t kind, uint32_t index) { return (kind << 28) | (index & 0x0FFFFFFFu); }
+
+// Push block of vs_points_world.vert
+struct PointPush
+{
+    float    viewProj[16];
+    float    color[4];
+    float    size;
+    uint32_t pickBase;   // pick_id of instance 0
+};
+
+// fw_handle (uint64) <-> pointer helpers
+static inline Device* H2D(fw_handle h) { return reinterpret_cast<Device*>(static_cast<uintptr_t>(h)); }
+static inline fw_handle D2H(Device* p) { return static_cast<fw_handle>(reinterpret_cast<uintptr_t>(p)); }
+
+// ===== shared helpers (renderer_api.cpp) =====
+// fs_vertex_color.frag, embedded once for every pipeline that uses it
+extern const uint32_t FS_VCOLOR_SPV[];
+extern const size_t   FS_VCOLOR_SPV_BYTES;
+uint32_t        find_memtype(VkPhysicalDevice phys, uint32_t type_bits, VkMemoryPropertyFlags want);
+bool            supports_present(VkPhysicalDevice pd, uint32_t family, VkSurfaceKHR surface);
+VkPresentModeKHR choose_present_mode(const std::vector<VkPresentModeKHR>& modes);
+VkExtent2D      choose_extent(const VkSurfaceCapabilitiesKHR& caps, HWND hwnd);
+static inline VkExtent2D client_extent(HWND hwnd)
+{
+    RECT rc{}; GetClientRect(hwnd, &rc);
+    return VkExtent2D{ (uint32_t)(rc.right - rc.left), (uint32_t)(rc.bottom - rc.top) };
+}
+bool            create_buffer(Device* d, VkDeviceSize size, VkBufferUsageFlags usage,
+                    VkMemoryPropertyFlags props, VkBuffer* out_buf, VkDeviceMemory* out_mem);
+VkShaderModule  create_shader(Device* d, const uint32_t* code, size_t bytes);
+VkPipeline      create_compute_pipeline(Device* d, VkPipelineLayout layout, const uint32_t* code, size_t bytes);
+bool            create_image(Device* d, uint32_t w, uint32_t h, VkFormat fmt, VkImageUsageFlags usage, GpuImage* out);
+void            destroy_image(Device* d, GpuImage& img);
+// Full-image layout transition, colour aspect.
+void            cmd_image_barrier(VkCommandBuffer cb, VkImage img, VkImageLayout from, VkImageLayout to,
+                    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+// Builds a pipeline into *out and registers it, so scene pipelines follow d->rp when a
+// post chain swaps it; destroy_graphics_pipeline unregisters and nulls *out.
+bool            create_graphics_pipeline(Device* d, const GfxPipelineDesc& desc, VkPipeline* out);
+void            destroy_graphics_pipeline(Device* d, VkPipeline* out);
+// Recreates every registered scene pipeline against the current d->rp (device idle).
+bool            rebuild_graphics_pipelines(Device* d);
+
+// Waits for the in-flight frame (the GPU may still read hb) and grows hb to at least
+// `bytes`, contents not preserved. Returns false with the error set on failure.
+bool            host_buffer_reserve(Device* d, HostBuffer& hb, size_t bytes, VkBufferUsageFlags usage);
+void            host_buffer_release(Device* d, HostBuffer& hb);
+
+// Reserves `count` vec4 slots in the point instance buffer for this frame (growing it if
+// needed) and sets the draw color; returns the mapped slots or nullptr with the error set.
+float*          points_begin_upload(Device* d, uint32_t count, float r, float g, float b, float a, float point_size);
+
+// Every scene draw, for a render pass compatible with d->rp that is already begun with
+// viewport and scissor set. ndc_overlay = the screen-space lines_upload batch.
+void            record_scene_draws(Device* d, VkCommandBuffer cb, bool ndc_overlay);
+
+// Blocking one-shot command buffer on the graphics queue (uploads, readbacks, setup).
+VkCommandBuffer begin_one_shot(Device* d);
+bool            end_one_shot(Device* d, VkCommandBuffer cb);
+// Blocking copy of `bytes` from host memory into a (device-local) buffer via staging.
+bool            upload_buffer(Device* d, VkBuffer dst, const void* data, VkDeviceSize bytes);
+// Same for a whole image (tightly packed rows), left in SHADER_READ_ONLY_OPTIMAL.
+bool            upload_image(Device* d, const GpuImage& img, const void* data, VkDeviceSize bytes);
@@ -0,0 +1,711 @@
+// segment_bvh.cpp
+// Binned-SAH BVH over polyline segments with refit and ray / nearest / frustum queries (see segment_bvh.h)
+
+#include "segment_bvh.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const int      kBins = 16;
+static const uint32_t kMinLeaf = 2;
+static const uint32_t kMaxLeaf = 8;
+static const int      kParallelDepth = 6;       // subtrees below this depth build as jobs (<= 64)
+static const int      kMedianDepth = 48;        // past this, split at the median to bound depth
+static const int      kStackSize = 128;         // > kMedianDepth + log2(max segments)
+static const uint32_t kParallelRange = 1u << 16;   // top-level ranges this large bin in parallel
+static const uint32_t kRangeGrain = 16384;
+static const uint32_t kPointGrain = 8192;
+
+// ===== float boxes =====
+struct Box
+{
+    float lo[3]{ HUGE_VALF, HUGE_VALF, HUGE_VALF };
+    float hi[3]{ -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+
+    void grow(const float* l, const float* h)
+    {
+        for (int k = 0; k < 3; ++k) { lo[k] = std::min(lo[k], l[k]); hi[k] = std::max(hi[k], h[k]); }
+    }
+    void grow(const Box& b) { grow(b.lo, b.hi); }
+    float area() const
+    {
+        const float dx = hi[0] - lo[0], dy = hi[1] - lo[1], dz = hi[2] - lo[2];
+        return (dx < 0 || dy < 0 || dz < 0) ? 0.0f : dx * dy + dy * dz + dz * dx;
+    }
+};
+
+// Float offsets from the build centre that never shrink the double box they stand for.
+static inline float round_down(double v)
+{
+    float f = (float)v;
+    return (double)f > v ? std::nextafter(f, -HUGE_VALF) : f;
+}
+
+static inline float round_up(double v)
+{
+    float f = (float)v;
+    return (double)f < v ? std::nextafter(f, HUGE_VALF) : f;
+}
+
+static void segment_box(const SegmentBvh* t, const BvhSegment& s, float* lo, float* hi)
+{
+    const double* a = &t->world[3 * (size_t)s.point];
+    for (int k = 0; k < 3; ++k) {
+        lo[k] = round_down(std::min(a[k], a[k + 3]) - t->centre[k]);
+        hi[k] = round_up(std::max(a[k], a[k + 3]) - t->centre[k]);
+    }
+}
+
+static inline void transform_point(const double* m, const double* p, double* out)
+{
+    for (int r = 0; r < 3; ++r)
+        out[r] = m[4 * r + 0] * p[0] + m[4 * r + 1] * p[1] + m[4 * r + 2] * p[2] + m[4 * r + 3];
+}
+
+static void transform_polyline(SegmentBvh* t, const BvhPolyline& pl)
+{
+    const size_t first = 3 * (size_t)pl.firstPoint;
+    for (uint32_t i = 0; i < pl.pointCount; ++i)
+        transform_point(pl.m, &t->local[first + 3 * (size_t)i], &t->world[first + 3 * (size_t)i]);
+}
+
+// ===== build =====
+struct RangeStats
+{
+    Box bounds;     // of the segments
+    Box cbounds;    // of their centroids (stored as lo + hi, the factor 2 cancels in binning)
+};
+
+struct Bin
+{
+    Box      box;
+    uint32_t n = 0;
+};
+
+struct BinSet
+{
+    Bin bins[3][kBins];
+};
+
+static inline float centroid2(const SegmentBvh* t, uint32_t p, int k)
+{
+    return t->primLo[3 * (size_t)p + k] + t->primHi[3 * (size_t)p + k];
+}
+
+static void stats_serial(const SegmentBvh* t, uint32_t b, uint32_t e, RangeStats& st)
+{
+    for (uint32_t i = b; i < e; ++i) {
+        const uint32_t p = t->prims[i];
+        st.bounds.grow(&t->primLo[3 * (size_t)p], &t->primHi[3 * (size_t)p]);
+        const float c[3] = { centroid2(t, p, 0), centroid2(t, p, 1), centroid2(t, p, 2) };
+        st.cbounds.grow(c, c);
+    }
+}
+
+static void bin_serial(const SegmentBvh* t, uint32_t b, uint32_t e, const Box& cb,
+    const float* scale, BinSet& bs)
+{
+    for (uint32_t i = b; i < e; ++i) {
+        const uint32_t p = t->prims[i];
+        const float* lo = &t->primLo[3 * (size_t)p];
+        const float* hi = &t->primHi[3 * (size_t)p];
+        for (int k = 0; k < 3; ++k) {
+            const int j = std::min(kBins - 1, (int)((lo[k] + hi[k] - cb.lo[k]) * scale[k]));
+            bs.bins[k][j].box.grow(lo, hi);
+            bs.bins[k][j].n++;
+        }
+    }
+}
+
+static void range_stats(const SegmentBvh* t, uint32_t b, uint32_t e, bool par, RangeStats& st)
+{
+    if (!par || e - b < kParallelRange) { stats_serial(t, b, e, st); return; }
+    const uint32_t chunks = (e - b + kRangeGrain - 1) / kRangeGrain;
+    std::vector<RangeStats> part(chunks);
+    parallel_for(e - b, kRangeGrain, [&](uint32_t cb, uint32_t ce) {
+        stats_serial(t, b + cb, b + ce, part[cb / kRangeGrain]);
+        });
+    for (const RangeStats& p : part) { st.bounds.grow(p.bounds); st.cbounds.grow(p.cbounds); }
+}
+
+static void range_bins(const SegmentBvh* t, uint32_t b, uint32_t e, bool par, const Box& cb,
+    const float* scale, BinSet& bs)
+{
+    if (!par || e - b < kParallelRange) { bin_serial(t, b, e, cb, scale, bs); return; }
+    const uint32_t chunks = (e - b + kRangeGrain - 1) / kRangeGrain;
+    std::vector<BinSet> part(chunks);
+    parallel_for(e - b, kRangeGrain, [&](uint32_t c0, uint32_t c1) {
+        bin_serial(t, b + c0, b + c1, cb, scale, part[c0 / kRangeGrain]);
+        });
+    for (const BinSet& p : part)
+        for (int k = 0; k < 3; ++k)
+            for (int j = 0; j < kBins; ++j) {
+                bs.bins[k][j].box.grow(p.bins[k][j].box);
+                bs.bins[k][j].n += p.bins[k][j].n;
+            }
+}
+
+struct SubtreeTask { uint32_t node; uint32_t b, e; int depth; };
+
+static void make_leaf(BvhNode& n, uint32_t b, uint32_t e) { n.first = b; n.count = e - b; }
+
+// Builds node `idx` (already allocated in `nodes`) over prims[b, e). Children are allocated
+// as a pair. When `tasks` is set, recursion stops at kParallelDepth and the rest is queued.
+static void build_node(SegmentBvh* t, std::vector<BvhNode>& nodes, uint32_t idx,
+    uint32_t b, uint32_t e, int depth, std::vector<SubtreeTask>* tasks)
+{
+    const bool par = tasks != nullptr;
+    RangeStats st;
+    range_stats(t, b, e, par, st);
+    for (int k = 0; k < 3; ++k) { nodes[idx].lo[k] = st.bounds.lo[k]; nodes[idx].hi[k] = st.bounds.hi[k]; }
+
+    const uint32_t n = e - b;
+    if (n <= kMinLeaf) { make_leaf(nodes[idx], b, e); return; }
+    if (tasks && depth >= kParallelDepth) { tasks->push_back({ idx, b, e, depth }); return; }
+
+    int axis = 0;
+    float ext = -1.0f;
+    for (int k = 0; k < 3; ++k)
+        if (st.cbounds.hi[k] - st.cbounds.lo[k] > ext) { ext = st.cbounds.hi[k] - st.cbounds.lo[k]; axis = k; }
+
+    uint32_t mid = b;
+    if (ext > 0 && depth < kMedianDepth) {
+        float scale[3];
+        for (int k = 0; k < 3; ++k) {
+            const float d = st.cbounds.hi[k] - st.cbounds.lo[k];
+            scale[k] = d > 0 ? kBins * (1.0f - 1e-6f) / d : 0.0f;
+        }
+        BinSet bs;
+        range_bins(t, b, e, par, st.cbounds, scale, bs);
+
+        // cost = traversal + (A_l N_l + A_r N_r) / A, against n for a leaf
+        const float invArea = 1.0f / std::max(st.bounds.area(), 1e-30f);
+        float bestCost = HUGE_VALF;
+        int bestAxis = -1, bestBin = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (scale[k] == 0) continue;
+            float rightArea[kBins];
+            uint32_t rightCount[kBins];
+            Box acc; uint32_t cnt = 0;
+            for (int j = kBins - 1; j > 0; --j) {
+                acc.grow(bs.bins[k][j].box); cnt += bs.bins[k][j].n;
+                rightArea[j] = acc.area(); rightCount[j] = cnt;
+            }
+            acc = Box(); cnt = 0;
+            for (int j = 0; j < kBins - 1; ++j) {
+                acc.grow(bs.bins[k][j].box); cnt += bs.bins[k][j].n;
+                if (!cnt || !rightCount[j + 1]) continue;
+                const float cost = 1.0f + (acc.area() * cnt + rightArea[j + 1] * rightCount[j + 1]) * invArea;
+                if (cost < bestCost) { bestCost = cost; bestAxis = k; bestBin = j; }
+            }
+        }
+
+        if (bestAxis >= 0 && bestCost >= (float)n && n <= kMaxLeaf) { make_leaf(nodes[idx], b, e); return; }
+        if (bestAxis >= 0) {
+            const float lo = st.cbounds.lo[bestAxis], sc = scale[bestAxis];
+            uint32_t* first = t->prims.data() + b;
+            mid = (uint32_t)(std::partition(first, first + n, [&](uint32_t p) {
+                return std::min(kBins - 1, (int)((centroid2(t, p, bestAxis) - lo) * sc)) <= bestBin;
+                }) - t->prims.data());
+        }
+    }
+    if (mid == b || mid == e) {
+        // Coincident centroids, no useful SAH split, or too deep: halve along the widest axis.
+        if (n <= kMaxLeaf) { make_leaf(nodes[idx], b, e); return; }
+        mid = b + n / 2;
+        uint32_t* first = t->prims.data();
+        std::nth_element(first + b, first + mid, first + e, [&](uint32_t u, uint32_t v) {
+            return centroid2(t, u, axis) < centroid2(t, v, axis);
+            });
+    }
+
+    const uint32_t child = (uint32_t)nodes.size();
+    nodes.resize(child + 2);
+    nodes[idx].first = child;
+    nodes[idx].count = 0;
+    build_node(t, nodes, child, b, mid, depth + 1, tasks);
+    build_node(t, nodes, child + 1, mid, e, depth + 1, tasks);
+}
+
+static void build_tree(SegmentBvh* t)
+{
+    // world points for everything
+    const uint32_t points = (uint32_t)(t->local.size() / 3);
+    t->world.resize(t->local.size());
+    parallel_for(points, kPointGrain, [&](uint32_t b, uint32_t e) {
+        auto it = std::upper_bound(t->polylines.begin(), t->polylines.end(), b,
+            [](uint32_t v, const BvhPolyline& pl) { return v < pl.firstPoint; });
+        size_t pi = (size_t)(it - t->polylines.begin()) - 1;
+        for (uint32_t i = b; i < e; ++i) {
+            while (i >= t->polylines[pi].firstPoint + t->polylines[pi].pointCount) ++pi;
+            transform_point(t->polylines[pi].m, &t->local[3 * (size_t)i], &t->world[3 * (size_t)i]);
+        }
+        });
+
+    // Float node bounds are offsets from the centre of all points.
+    struct Extent { double lo[3]{ HUGE_VAL, HUGE_VAL, HUGE_VAL }, hi[3]{ -HUGE_VAL, -HUGE_VAL, -HUGE_VAL }; };
+    std::vector<Extent> part((points + kPointGrain - 1) / kPointGrain);
+    parallel_for(points, kPointGrain, [&](uint32_t b, uint32_t e) {
+        Extent& x = part[b / kPointGrain];
+        for (uint32_t i = b; i < e; ++i)
+            for (int k = 0; k < 3; ++k) {
+                x.lo[k] = std::min(x.lo[k], t->world[3 * (size_t)i + k]);
+                x.hi[k] = std::max(x.hi[k], t->world[3 * (size_t)i + k]);
+            }
+        });
+    Extent all;
+    for (const Extent& x : part)
+        for (int k = 0; k < 3; ++k) { all.lo[k] = std::min(all.lo[k], x.lo[k]); all.hi[k] = std::max(all.hi[k], x.hi[k]); }
+    for (int k = 0; k < 3; ++k) t->centre[k] = all.lo[k] <= all.hi[k] ? 0.5 * (all.lo[k] + all.hi[k]) : 0.0;
+
+    t->refs.clear();
+    for (uint32_t p = 0; p < (uint32_t)t->polylines.size(); ++p) {
+        const BvhPolyline& pl = t->polylines[p];
+        for (uint32_t i = 0; i + 1 < pl.pointCount; ++i) t->refs.push_back({ pl.firstPoint + i, p });
+    }
+
+    const uint32_t n = (uint32_t)t->refs.size();
+    t->nodes.clear();
+    t->segs.clear();
+    t->subtrees.clear();
+    t->topCount = 0;
+    if (!n) return;
+
+    t->primLo.resize((size_t)n * 3);
+    t->primHi.resize((size_t)n * 3);
+    t->prims.resize(n);
+    parallel_for(n, kRangeGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            segment_box(t, t->refs[i], &t->primLo[3 * (size_t)i], &t->primHi[3 * (size_t)i]);
+            t->prims[i] = i;
+        }
+        });
+
+    // Top levels serially (binning in parallel), subtrees as jobs into private arrays, then splice.
+    std::vector<SubtreeTask> tasks;
+    t->nodes.reserve(2 * (size_t)n / kMinLeaf);
+    t->nodes.resize(1);
+    build_node(t, t->nodes, 0, 0, n, 0, &tasks);
+    t->topCount = (uint32_t)t->nodes.size();
+
+    std::vector<std::vector<BvhNode>> sub(tasks.size());
+    parallel_for((uint32_t)tasks.size(), 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t k = b; k < e; ++k) {
+            const SubtreeTask& tk = tasks[k];
+            sub[k].reserve(2 * (size_t)(tk.e - tk.b) / kMinLeaf + 1);
+            sub[k].resize(1);
+            build_node(t, sub[k], 0, tk.b, tk.e, tk.depth, nullptr);
+        }
+        });
+
+    for (size_t k = 0; k < tasks.size(); ++k) {
+        const uint32_t base = (uint32_t)t->nodes.size();
+        std::vector<BvhNode>& local = sub[k];
+        for (size_t i = 0; i < local.size(); ++i)
+            if (!local[i].count) local[i].first = base + local[i].first - 1;
+        t->nodes[tasks[k].node] = local[0];
+        t->nodes.insert(t->nodes.end(), local.begin() + 1, local.end());
+        t->subtrees.push_back(tasks[k].node);
+        t->subtrees.push_back(base);
+        t->subtrees.push_back((uint32_t)t->nodes.size());
+    }
+
+    t->segs.resize(n);
+    parallel_for(n, kRangeGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) t->segs[i] = t->refs[t->prims[i]];
+        });
+}
+
+// ===== refit =====
+static inline void merge_children(std::vector<BvhNode>& nodes, uint32_t i)
+{
+    BvhNode& n = nodes[i];
+    const BvhNode& l = nodes[n.first];
+    const BvhNode& r = nodes[n.first + 1];
+    for (int k = 0; k < 3; ++k) { n.lo[k] = std::min(l.lo[k], r.lo[k]); n.hi[k] = std::max(l.hi[k], r.hi[k]); }
+}
+
+// Children always sit after their parent: the serial top first, each spliced subtree after
+// it. Leaves go in parallel, then subtrees bottom-up in parallel, then the top.
+static void refit_tree(SegmentBvh* t)
+{
+    parallel_for((uint32_t)t->dirty.size(), 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) transform_polyline(t, t->polylines[t->dirty[i]]);
+        });
+
+    std::vector<BvhNode>& nodes = t->nodes;
+    parallel_for((uint32_t)nodes.size(), kRangeGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            BvhNode& n = nodes[i];
+            if (!n.count) continue;
+            Box box;
+            for (uint32_t s = n.first; s < n.first + n.count; ++s) {
+                float lo[3], hi[3];
+                segment_box(t, t->segs[s], lo, hi);
+                box.grow(lo, hi);
+            }
+            for (int k = 0; k < 3; ++k) { n.lo[k] = box.lo[k]; n.hi[k] = box.hi[k]; }
+        }
+        });
+
+    parallel_for((uint32_t)(t->subtrees.size() / 3), 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t k = b; k < e; ++k) {
+            const uint32_t root = t->subtrees[3 * k], first = t->subtrees[3 * k + 1], end = t->subtrees[3 * k + 2];
+            for (uint32_t i = end; i-- > first;)
+                if (!nodes[i].count) merge_children(nodes, i);
+            if (!nodes[root].count) merge_children(nodes, root);
+        }
+        });
+
+    for (uint32_t i = t->topCount; i-- > 0;)
+        if (!nodes[i].count) merge_children(nodes, i);
+}
+
+// ===== queries =====
+struct Hit
+{
+    double dist2 = HUGE_VAL;
+    double t = 0.0, u = 0.0;
+    double point[3]{ 0,0,0 };
+    uint32_t seg = UINT32_MAX;
+};
+
+static inline double dot3(const double* a, const double* b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+static inline void node_box(const SegmentBvh* t, const BvhNode& n, double pad, double* lo, double* hi)
+{
+    for (int k = 0; k < 3; ++k) {
+        lo[k] = t->centre[k] + (double)n.lo[k] - pad;
+        hi[k] = t->centre[k] + (double)n.hi[k] + pad;
+    }
+}
+
+// Entry parameter of the ray [0, tmax] into the box, or HUGE_VAL when it misses.
+static double ray_box(const double* o, const double* d, const double* inv, double tmax,
+    const double* lo, const double* hi)
+{
+    double t0 = 0.0, t1 = tmax;
+    for (int k = 0; k < 3; ++k) {
+        if (d[k] == 0.0) {
+            if (o[k] < lo[k] || o[k] > hi[k]) return HUGE_VAL;
+            continue;
+        }
+        double a = (lo[k] - o[k]) * inv[k], b = (hi[k] - o[k]) * inv[k];
+        if (a > b) std::swap(a, b);
+        t0 = std::max(t0, a);
+        t1 = std::min(t1, b);
+        if (t0 > t1) return HUGE_VAL;
+    }
+    return t0;
+}
+
+static double box_dist2(const double* p, const double* lo, const double* hi)
+{
+    double s = 0.0;
+    for (int k = 0; k < 3; ++k) {
+        const double d = p[k] < lo[k] ? lo[k] - p[k] : p[k] > hi[k] ? p[k] - hi[k] : 0.0;
+        s += d * d;
+    }
+    return s;
+}
+
+// Closest points between the ray o + t d (|d| = 1, t in [0, tmax]) and segment a + u (b - a).
+static void ray_segment(const double* o, const double* d, double tmax, const double* a,
+    const double* b, double& t, double& u)
+{
+    const double e[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const double r[3] = { o[0] - a[0], o[1] - a[1], o[2] - a[2] };
+    const double ee = dot3(e, e), f = dot3(e, r), c = dot3(d, r), de = dot3(d, e);
+    if (ee <= 0.0) { u = 0.0; t = std::min(std::max(-c, 0.0), tmax); return; }
+    const double denom = ee - de * de;
+    t = denom > 1e-12 * ee ? std::min(std::max((de * f - c * ee) / denom, 0.0), tmax) : 0.0;
+    u = (de * t + f) / ee;
+    if (u < 0.0) { u = 0.0; t = std::min(std::max(-c, 0.0), tmax); }
+    else if (u > 1.0) { u = 1.0; t = std::min(std::max(de - c, 0.0), tmax); }
+}
+
+static void fill_hit(const SegmentBvh* t, const Hit& h, fw_bvh_hit* out)
+{
+    const BvhSegment& s = t->segs[h.seg];
+    out->polyline = s.polyline;
+    out->segment = s.point - t->polylines[s.polyline].firstPoint;
+    out->distance = std::sqrt(h.dist2);
+    out->t = h.t;
+    out->u = h.u;
+    for (int k = 0; k < 3; ++k) out->point[k] = h.point[k];
+}
+
+static int query_check(const SegmentBvh* t)
+{
+    if (!t) { native_set_error("bvh: null handle"); return FM_E_BADARGS; }
+    if (t->rebuild || !t->dirty.empty()) { native_set_error("bvh: pending changes, call bvh_update"); return FM_E_NOTREADY; }
+    return FM_OK;
+}
+
+// ===== ABI =====
+int FM_CALL bvh_create(fw_handle* out)
+{
+    if (!out) { native_set_error("bvh_create: null out"); return FM_E_BADARGS; }
+    jobs_acquire();
+    *out = to_handle(new SegmentBvh());
+    return FM_OK;
+}
+
+void FM_CALL bvh_destroy(fw_handle bvh)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (!t) return;
+    delete t;
+    jobs_release();
+}
+
+int FM_CALL bvh_clear(fw_handle bvh)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (!t) { native_set_error("bvh: null handle"); return FM_E_BADARGS; }
+    t->polylines.clear();
+    t->local.clear();
+    t->dirty.clear();
+    t->rebuild = true;
+    return FM_OK;
+}
+
+// Returns the polyline index used by set_transform and reported in hits.
+int FM_CALL bvh_add_polyline(fw_handle bvh, const double* xyz, uint32_t count, const double* xform)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (!t) { native_set_error("bvh: null handle"); return FM_E_BADARGS; }
+    if (count && !xyz) { native_set_error("bvh_add_polyline: null xyz"); return FM_E_BADARGS; }
+    if (t->polylines.size() >= (size_t)INT32_MAX || t->local.size() / 3 + count >= (size_t)UINT32_MAX) {
+        native_set_error("bvh_add_polyline: too many points");
+        return FM_E_BADARGS;
+    }
+
+    BvhPolyline pl;
+    pl.firstPoint = (uint32_t)(t->local.size() / 3);
+    pl.pointCount = count;
+    if (xform) std::copy(xform, xform + 12, pl.m);
+    t->local.insert(t->local.end(), xyz, xyz + 3 * (size_t)count);
+    t->polylines.push_back(pl);
+    t->rebuild = true;
+    return (int)(t->polylines.size() - 1);
+}
+
+// xform NULL restores the identity. Takes effect (as a refit) on the next bvh_update.
+int FM_CALL bvh_set_transform(fw_handle bvh, uint32_t polyline, const double* xform)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (!t) { native_set_error("bvh: null handle"); return FM_E_BADARGS; }
+    if (polyline >= t->polylines.size()) { native_set_error("bvh_set_transform: bad polyline index"); return FM_E_BADARGS; }
+
+    static const double kIdentity[12] = { 1,0,0,0, 0,1,0,0, 0,0,1,0 };
+    BvhPolyline& pl = t->polylines[polyline];
+    std::copy(xform ? xform : kIdentity, (xform ? xform : kIdentity) + 12, pl.m);
+    if (!pl.dirty && !t->rebuild) { pl.dirty = true; t->dirty.push_back(polyline); }
+    return FM_OK;
+}
+
+int FM_CALL bvh_update(fw_handle bvh, uint32_t rebuild)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (!t) { native_set_error("bvh: null handle"); return FM_E_BADARGS; }
+    if (rebuild || t->rebuild) build_tree(t);
+    else if (!t->dirty.empty()) refit_tree(t);
+    for (uint32_t p : t->dirty) t->polylines[p].dirty = false;
+    t->dirty.clear();
+    t->rebuild = false;
+    return FM_OK;
+}
+
+// Segment closest to the ray [0, max_t] (<= 0: unbounded) within radius; ties go to the
+// smaller t. Returns 1 and fills *out on a hit, 0 otherwise.
+int FM_CALL bvh_ray(fw_handle bvh, const double* origin, const double* dir, double max_t,
+    double radius, fw_bvh_hit* out)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (int rc = query_check(t)) return rc;
+    if (!origin || !dir || !out) { native_set_error("bvh_ray: null argument"); return FM_E_BADARGS; }
+    const double len = std::sqrt(dot3(dir, dir));
+    if (!(len > 0) || !(radius >= 0)) { native_set_error("bvh_ray: zero direction or negative radius"); return FM_E_BADARGS; }
+    if (t->nodes.empty()) return 0;
+
+    const double d[3] = { dir[0] / len, dir[1] / len, dir[2] / len };
+    const double inv[3] = { 1.0 / d[0], 1.0 / d[1], 1.0 / d[2] };
+    const double tmax = max_t > 0 ? max_t : HUGE_VAL;
+
+    // The ray passes within r of a segment only through the segment's box grown by r, so the
+    // pad shrinks to the best distance found so far.
+    Hit best;
+    best.dist2 = radius * radius;
+    best.t = HUGE_VAL;
+    double pad = radius;
+    uint32_t stack[kStackSize];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        const BvhNode& n = t->nodes[stack[--sp]];
+        double lo[3], hi[3];
+        node_box(t, n, pad, lo, hi);
+        if (ray_box(origin, d, inv, tmax, lo, hi) == HUGE_VAL) continue;
+
+        if (n.count) {
+            for (uint32_t s = n.first; s < n.first + n.count; ++s) {
+                const double* a = &t->world[3 * (size_t)t->segs[s].point];
+                double rt, u;
+                ray_segment(origin, d, tmax, a, a + 3, rt, u);
+                double q[3], diff[3];
+                for (int k = 0; k < 3; ++k) {
+                    q[k] = a[k] + u * (a[k + 3] - a[k]);
+                    diff[k] = origin[k] + rt * d[k] - q[k];
+                }
+                const double dist2 = dot3(diff, diff);
+                if (dist2 < best.dist2 || (dist2 == best.dist2 && rt < best.t)) {
+                    best.dist2 = dist2; best.t = rt; best.u = u; best.seg = s;
+                    for (int k = 0; k < 3; ++k) best.point[k] = q[k];
+                    pad = std::sqrt(dist2);
+                }
+            }
+            continue;
+        }
+
+        // Nearer child (by entry t) is popped first.
+        double ll[3], lh[3], rl[3], rh[3];
+        node_box(t, t->nodes[n.first], pad, ll, lh);
+        node_box(t, t->nodes[n.first + 1], pad, rl, rh);
+        const double tl = ray_box(origin, d, inv, tmax, ll, lh);
+        const double tr = ray_box(origin, d, inv, tmax, rl, rh);
+        if (tl != HUGE_VAL && tr != HUGE_VAL) {
+            stack[sp++] = tl <= tr ? n.first + 1 : n.first;
+            stack[sp++] = tl <= tr ? n.first : n.first + 1;
+        }
+        else if (tl != HUGE_VAL) stack[sp++] = n.first;
+        else if (tr != HUGE_VAL) stack[sp++] = n.first + 1;
+    }
+
+    if (best.seg == UINT32_MAX) return 0;
+    fill_hit(t, best, out);
+    return 1;
+}
+
+// Segment nearest to point within max_dist (<= 0: unbounded). Returns 1 and fills *out
+// (t = 0) when one is found, 0 otherwise.
+int FM_CALL bvh_nearest(fw_handle bvh, const double* point, double max_dist, fw_bvh_hit* out)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (int rc = query_check(t)) return rc;
+    if (!point || !out) { native_set_error("bvh_nearest: null argument"); return FM_E_BADARGS; }
+    if (t->nodes.empty()) return 0;
+
+    Hit best;
+    best.dist2 = max_dist > 0 ? max_dist * max_dist : HUGE_VAL;
+    struct Entry { uint32_t node; double dist2; };
+    Entry stack[kStackSize];
+    int sp = 0;
+    stack[sp++] = { 0, 0.0 };
+    while (sp) {
+        const Entry en = stack[--sp];
+        if (en.dist2 > best.dist2) continue;
+        const BvhNode& n = t->nodes[en.node];
+
+        if (n.count) {
+            for (uint32_t s = n.first; s < n.first + n.count; ++s) {
+                const double* a = &t->world[3 * (size_t)t->segs[s].point];
+                const double e[3] = { a[3] - a[0], a[4] - a[1], a[5] - a[2] };
+                const double r[3] = { point[0] - a[0], point[1] - a[1], point[2] - a[2] };
+                const double ee = dot3(e, e);
+                const double u = ee > 0 ? std::min(std::max(dot3(r, e) / ee, 0.0), 1.0) : 0.0;
+                double q[3], diff[3];
+                for (int k = 0; k < 3; ++k) { q[k] = a[k] + u * e[k]; diff[k] = point[k] - q[k]; }
+                const double dist2 = dot3(diff, diff);
+                if (dist2 <= best.dist2 && (dist2 < best.dist2 || best.seg == UINT32_MAX)) {
+                    best.dist2 = dist2; best.u = u; best.seg = s;
+                    for (int k = 0; k < 3; ++k) best.point[k] = q[k];
+                }
+            }
+            continue;
+        }
+
+        double ll[3], lh[3], rl[3], rh[3];
+        node_box(t, t->nodes[n.first], 0.0, ll, lh);
+        node_box(t, t->nodes[n.first + 1], 0.0, rl, rh);
+        const double dl = box_dist2(point, ll, lh);
+        const double dr = box_dist2(point, rl, rh);
+        const Entry first = dl <= dr ? Entry{ n.first, dl } : Entry{ n.first + 1, dr };
+        const Entry second = dl <= dr ? Entry{ n.first + 1, dr } : Entry{ n.first, dl };
+        if (second.dist2 <= best.dist2) stack[sp++] = second;
+        if (first.dist2 <= best.dist2) stack[sp++] = first;
+    }
+
+    if (best.seg == UINT32_MAX) return 0;
+    fill_hit(t, best, out);
+    return 1;
+}
+
+// Segments touching the convex volume of six planes (a, b, c, d; inside where
+// a x + b y + c z + d >= 0). Conservative: a segment is dropped only when both endpoints are
+// outside one plane. Writes up to max_segments in tree order and returns the total count.
+int FM_CALL bvh_frustum(fw_handle bvh, const double* planes, fw_bvh_segment* out, uint32_t max_segments)
+{
+    auto* t = handle_to<SegmentBvh>(bvh);
+    if (int rc = query_check(t)) return rc;
+    if (!planes || (max_segments && !out)) { native_set_error("bvh_frustum: null argument"); return FM_E_BADARGS; }
+    if (t->nodes.empty()) return 0;
+
+    uint32_t total = 0;
+    auto emit = [&](uint32_t s) {
+        if (total < max_segments) {
+            const BvhSegment& seg = t->segs[s];
+            out[total] = { seg.polyline, seg.point - t->polylines[seg.polyline].firstPoint };
+        }
+        ++total;
+    };
+
+    uint32_t stack[kStackSize];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+        const uint32_t idx = stack[--sp];
+        const BvhNode& n = t->nodes[idx];
+        double lo[3], hi[3];
+        node_box(t, n, 0.0, lo, hi);
+
+        bool outside = false, inside = true;
+        for (int p = 0; p < 6 && !outside; ++p) {
+            const double* pl = planes + 4 * p;
+            double dmax = pl[3], dmin = pl[3];
+            for (int k = 0; k < 3; ++k) {
+                dmax += pl[k] * (pl[k] >= 0 ? hi[k] : lo[k]);
+                dmin += pl[k] * (pl[k] >= 0 ? lo[k] : hi[k]);
+            }
+            outside = dmax < 0;
+            inside = inside && dmin >= 0;
+        }
+        if (outside) continue;
+
+        if (inside) {
+            // A subtree's segments are contiguous: from its leftmost to its rightmost leaf.
+            uint32_t l = idx, r = idx;
+            while (!t->nodes[l].count) l = t->nodes[l].first;
+            while (!t->nodes[r].count) r = t->nodes[r].first + 1;
+            for (uint32_t s = t->nodes[l].first; s < t->nodes[r].first + t->nodes[r].count; ++s) emit(s);
+            continue;
+        }
+
+        if (!n.count) {
+            stack[sp++] = n.first + 1;
+            stack[sp++] = n.first;
+            continue;
+        }
+        for (uint32_t s = n.first; s < n.first + n.count; ++s) {
+            const double* a = &t->world[3 * (size_t)t->segs[s].point];
+            bool culled = false;
+            for (int p = 0; p < 6 && !culled; ++p) {
+                const double* pl = planes + 4 * p;
+                culled = dot3(pl, a) + pl[3] < 0 && dot3(pl, a + 3) + pl[3] < 0;
+            }
+            if (!culled) emit(s);
+        }
+    }
+    return (int)std::min(total, (uint32_t)INT32_MAX);
+}
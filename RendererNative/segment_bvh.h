@@ -0,0 +1,77 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    CPU bounding-volume hierarchy over registered polylines, for picking and range queries
+    without a device (headless tools, or before the GPU pick result arrives).
+    - Polylines are kept in their own space with a row-major 3x4 transform; the tree is
+      built over world-space segments.
+    - Build: binned SAH (16 bins per axis) over segment centroids. The top levels bin in
+      parallel chunks, the subtrees below kParallelDepth are built as jobs and spliced, as
+      the n-body octree does.
+    - bvh_set_transform only marks the polyline; bvh_update then moves its points and refits
+      the node bounds bottom-up (in parallel per subtree) without rebuilding. Adding or
+      clearing polylines, or update(rebuild=1), rebuilds from scratch.
+    - Node bounds are floats relative to the build centre, rounded outwards; segment tests
+      run on the double world points.
+    - Queries are read-only and may run concurrently; they refuse to run on a tree that has
+      pending changes (FM_E_NOTREADY until bvh_update).
+*/
+
+struct BvhNode
+{
+    float    lo[3];
+    uint32_t first;      // interior: left child (right is first + 1); leaf: first segment
+    float    hi[3];
+    uint32_t count;      // segments in the leaf, 0 for interior nodes
+};
+
+struct BvhPolyline
+{
+    uint32_t firstPoint = 0;
+    uint32_t pointCount = 0;
+    double   m[12]{ 1,0,0,0, 0,1,0,0, 0,0,1,0 };
+    bool     dirty = false;
+};
+
+struct BvhSegment
+{
+    uint32_t point;      // global index of the first endpoint in world (second is point + 1)
+    uint32_t polyline;
+};
+
+struct SegmentBvh
+{
+    std::vector<BvhPolyline> polylines;
+    std::vector<double>      local;       // xyz per point, all polylines back to back
+    std::vector<double>      world;       // same layout, transformed on update
+
+    bool                  rebuild = true;
+    std::vector<uint32_t> dirty;          // polylines whose transform changed since update
+
+    double                   centre[3]{ 0,0,0 };
+    std::vector<BvhNode>     nodes;
+    std::vector<BvhSegment>  segs;        // leaf order
+    uint32_t                 topCount = 0;      // nodes built serially, before the subtrees
+    std::vector<uint32_t>    subtrees;          // (root, first, end) per spliced subtree
+
+    // build scratch, reused between builds
+    std::vector<BvhSegment>  refs;
+    std::vector<float>       primLo, primHi;    // 3 per segment
+    std::vector<uint32_t>    prims;
+};
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL bvh_create(fw_handle* out);
+void FM_CALL bvh_destroy(fw_handle bvh);
+int  FM_CALL bvh_clear(fw_handle bvh);
+int  FM_CALL bvh_add_polyline(fw_handle bvh, const double* xyz, uint32_t count, const double* xform);
+int  FM_CALL bvh_set_transform(fw_handle bvh, uint32_t polyline, const double* xform);
+int  FM_CALL bvh_update(fw_handle bvh, uint32_t rebuild);
+int  FM_CALL bvh_ray(fw_handle bvh, const double* origin, const double* dir, double max_t,
+    double radius, fw_bvh_hit* out);
+int  FM_CALL bvh_nearest(fw_handle bvh, const double* point, double max_dist, fw_bvh_hit* out);
+int  FM_CALL bvh_frustum(fw_handle bvh, const double* planes, fw_bvh_segment* out, uint32_t max_segments);
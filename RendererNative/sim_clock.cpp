@@ -0,0 +1,155 @@
+// sim_clock.cpp
+// Fixed-step accumulator with double-buffered position snapshots (see sim_clock.h)
+
+#include "sim_clock.h"
+#include "nbody.h"
+#include "job_system.h"
+#include "keyframe_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ===== snapshots =====
+static void capture(const SimClock* c, std::vector<double>& dst)
+{
+    const NBody* s = c->body;
+    dst.resize((size_t)s->n * 3);
+    parallel_for(s->n, 8192, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            dst[3 * (size_t)i + 0] = s->x[i];
+            dst[3 * (size_t)i + 1] = s->y[i];
+            dst[3 * (size_t)i + 2] = s->z[i];
+        }
+        });
+}
+
+// Body count changed (or first use): both snapshots become the current state.
+static void prime(SimClock* c)
+{
+    capture(c, c->curr);
+    c->prev = c->curr;
+    c->snapN = c->body->n;
+}
+
+double sim_clock_alpha(const SimClock* c)
+{
+    double a = c->accum / c->fixedDt;
+    return a < 0 ? 0 : (a > 1 ? 1 : a);
+}
+
+void sim_clock_jump(SimClock* c, int64_t step, double sim_time)
+{
+    c->step = step;
+    c->simTime = sim_time;
+    c->accum = c->fixedDt;
+    if (c->body) prime(c);
+}
+
+void sim_clock_write_interpolated(const SimClock* c, float* dst, uint32_t stride_floats,
+    double ox, double oy, double oz)
+{
+    const double a = sim_clock_alpha(c);
+    const double* p = c->prev.data();
+    const double* q = c->curr.data();
+    parallel_for(c->snapN, 8192, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            const size_t k = 3 * (size_t)i;
+            float* o = dst + (size_t)i * stride_floats;
+            o[0] = (float)(p[k + 0] + (q[k + 0] - p[k + 0]) * a - ox);
+            o[1] = (float)(p[k + 1] + (q[k + 1] - p[k + 1]) * a - oy);
+            o[2] = (float)(p[k + 2] + (q[k + 2] - p[k + 2]) * a - oz);
+        }
+        });
+}
+
+// ===== ABI =====
+int FM_CALL sim_clock_create(double fixed_dt, fw_handle* out)
+{
+    if (!out) { native_set_error("sim_clock_create: null out"); return FM_E_BADARGS; }
+    *out = 0;
+    if (!(fixed_dt > 0)) { native_set_error("sim_clock_create: fixed_dt must be > 0"); return FM_E_BADARGS; }
+
+    auto* c = new SimClock();
+    c->fixedDt = fixed_dt;
+    *out = to_handle(c);
+    return FM_OK;
+}
+
+void FM_CALL sim_clock_destroy(fw_handle clock)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (c && c->keyframes) keyframes_detach(c->keyframes);
+    delete c;
+}
+
+int FM_CALL sim_clock_set_rate(fw_handle clock, double time_scale, uint32_t max_steps)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (!c) { native_set_error("sim_clock: null handle"); return FM_E_BADARGS; }
+    if (time_scale < 0) { native_set_error("sim_clock_set_rate: negative time_scale"); return FM_E_BADARGS; }
+    c->timeScale = time_scale;
+    c->maxSteps = max_steps ? max_steps : 1;
+    return FM_OK;
+}
+
+// nbody_sim == 0 detaches; the clock then only keeps time.
+int FM_CALL sim_clock_attach_nbody(fw_handle clock, fw_handle nbody_sim, uint32_t substeps)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (!c) { native_set_error("sim_clock: null handle"); return FM_E_BADARGS; }
+    c->body = handle_to<NBody>(nbody_sim);
+    c->substeps = substeps ? substeps : 1;
+    c->snapN = 0;
+    c->prev.clear(); c->curr.clear();
+    if (c->body) prime(c);
+    if (c->keyframes && c->body) keyframes_reset(to_handle(c->keyframes));
+    return FM_OK;
+}
+
+int FM_CALL sim_clock_advance(fw_handle clock, double real_seconds, uint32_t* out_steps, double* out_alpha)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (!c) { native_set_error("sim_clock: null handle"); return FM_E_BADARGS; }
+    if (real_seconds > 0) c->accum += real_seconds * c->timeScale;
+
+    uint32_t steps = (uint32_t)std::min(std::floor(c->accum / c->fixedDt), (double)UINT32_MAX);
+    if (steps > c->maxSteps) {
+        // Too far behind to catch up: keep the fractional part, drop the backlog.
+        c->accum = std::fmod(c->accum, c->fixedDt) + c->maxSteps * c->fixedDt;
+        steps = c->maxSteps;
+    }
+
+    if (c->body && c->snapN != c->body->n) prime(c);
+
+    for (uint32_t k = 0; k < steps; ++k) {
+        const bool last = (k + 1 == steps);
+        if (c->body && last) {
+            // prev must hold the state right before the final step of this batch.
+            if (steps == 1) std::swap(c->prev, c->curr);
+            else capture(c, c->prev);
+        }
+        if (c->body) nbody_step(to_handle(c->body), c->fixedDt, c->substeps);
+        if (c->body && last) capture(c, c->curr);
+        ++c->step;
+        if (c->keyframes) keyframes_on_step(c->keyframes);
+
+        c->accum -= c->fixedDt;
+        c->simTime += c->fixedDt;
+    }
+
+    if (out_steps) *out_steps = steps;
+    if (out_alpha) *out_alpha = sim_clock_alpha(c);
+    return FM_OK;
+}
+
+int FM_CALL sim_clock_get_time(fw_handle clock, double* out_sim_time, double* out_alpha)
+{
+    auto* c = handle_to<SimClock>(clock);
+    if (!c) { native_set_error("sim_clock: null handle"); return FM_E_BADARGS; }
+    // Interpolated presentation time, consistent with the blended positions
+    // (before the first step both snapshots are the initial state, i.e. t = 0).
+    double t = c->simTime - c->fixedDt + sim_clock_alpha(c) * c->fixedDt;
+    if (out_sim_time) *out_sim_time = t > 0 ? t : 0.0;
+    if (out_alpha) *out_alpha = sim_clock_alpha(c);
+    return FM_OK;
+}
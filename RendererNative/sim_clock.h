@@ -0,0 +1,49 @@
+#pragma once
+#include "native_common.h"
+
+#include <cstdint>
+#include <vector>
+
+struct NBody;
+struct KeyframeCache;
+
+/*
+    Fixed-timestep simulation clock.
+    - Real time is accumulated and consumed in whole fixed steps, so the sim rate is
+      independent of the frame rate and no step is ever partial or wasted.
+    - The attached sim's positions after the last two steps are kept as snapshots; the
+      renderer blends them by alpha = leftover / fixed_dt, hiding the step quantisation.
+*/
+
+struct SimClock
+{
+    double   fixedDt = 1.0 / 60.0;
+    double   accum = 0.0;
+    double   simTime = 0.0;
+    double   timeScale = 1.0;
+    uint32_t maxSteps = 8;      // per advance(); guards against the spiral of death
+
+    NBody*   body = nullptr;
+    uint32_t substeps = 1;
+    int64_t  step = 0;          // fixed steps taken; keyframe_cache indexes states by it
+    KeyframeCache* keyframes = nullptr;
+
+    // Interleaved xyz snapshots before (prev) and after (curr) the most recent step.
+    uint32_t            snapN = 0;
+    std::vector<double> prev, curr;
+};
+
+double sim_clock_alpha(const SimClock* c);
+// Sets the clock to `step` after the attached sim's state was replaced (keyframe seeks): both
+// snapshots become the current state, presented at alpha = 1.
+void   sim_clock_jump(SimClock* c, int64_t step, double sim_time);
+void   sim_clock_write_interpolated(const SimClock* c, float* dst, uint32_t stride_floats,
+    double ox, double oy, double oz);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL sim_clock_create(double fixed_dt, fw_handle* out);
+void FM_CALL sim_clock_destroy(fw_handle clock);
+int  FM_CALL sim_clock_set_rate(fw_handle clock, double time_scale, uint32_t max_steps);
+int  FM_CALL sim_clock_attach_nbody(fw_handle clock, fw_handle nbody_sim, uint32_t substeps);
+int  FM_CALL sim_clock_advance(fw_handle clock, double real_seconds, uint32_t* out_steps, double* out_alpha);
+int  FM_CALL sim_clock_get_time(fw_handle clock, double* out_sim_time, double* out_alpha);
@@ -0,0 +1,142 @@
+// sprite_pass.cpp
+// Screen-space sprites, any mix of bindless textures in one instanced draw (see sprite_pass.h)
+
+#include "sprite_pass.h"
+#include "texture_table.h"
+#include "native_common.h"
+#include "job_system.h"
+
+#include <cstddef>
+#include <cstring>
+
+static const uint32_t VS_SPRITE_SPV[] = {
+#   include "shaders/vs_sprite.spv.inc"
+};
+static const uint32_t FS_SPRITE_SPV[] = {
+#   include "shaders/fs_sprite.spv.inc"
+};
+static_assert((sizeof(VS_SPRITE_SPV) % 4) == 0, "VS_SPRITE_SPV must be dword aligned");
+static_assert((sizeof(FS_SPRITE_SPV) % 4) == 0, "FS_SPRITE_SPV must be dword aligned");
+static_assert(sizeof(SpriteInstance) == 48, "SpriteInstance must match vs_sprite.vert");
+
+static const uint32_t kSpriteGrain = 4096;
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, SpritePass* s, const TextureTable* t)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pcr.offset = 0; pcr.size = sizeof(SpritePush);
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.setLayoutCount = 1; plci.pSetLayouts = &t->dsl;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &s->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription bind{};
+    bind.binding = 0; bind.stride = sizeof(SpriteInstance); bind.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[6]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = offsetof(SpriteInstance, anchor);
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R32_UINT; attrs[1].offset = offsetof(SpriteInstance, pickId);
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32_SFLOAT; attrs[2].offset = offsetof(SpriteInstance, size);
+    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R32_UINT; attrs[3].offset = offsetof(SpriteInstance, texture);
+    attrs[4].location = 4; attrs[4].binding = 0; attrs[4].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[4].offset = offsetof(SpriteInstance, rgba);
+    attrs[5].location = 5; attrs[5].binding = 0; attrs[5].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[5].offset = offsetof(SpriteInstance, uv);
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_SPRITE_SPV; pd.vsBytes = sizeof(VS_SPRITE_SPV);
+    pd.fs = FS_SPRITE_SPV; pd.fsBytes = sizeof(FS_SPRITE_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = attrs; pd.attrCount = 6;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    pd.blend = BLEND_ALPHA;
+    pd.layout = s->layout;
+    return create_graphics_pipeline(d, pd, &s->pipe);
+}
+
+void sprite_release(Device* d)
+{
+    SpritePass* s = d->sprites;
+    if (!s) return;
+    host_buffer_release(d, s->inst);
+    destroy_graphics_pipeline(d, &s->pipe);
+    if (s->layout) vkDestroyPipelineLayout(d->device, s->layout, nullptr);
+    delete s;
+    d->sprites = nullptr;
+}
+
+static SpritePass* ensure_pass(Device* d)
+{
+    if (!d->sprites) {
+        TextureTable* t = texture_table_ensure(d);
+        if (!t) return nullptr;
+        auto* s = new SpritePass();
+        d->sprites = s;
+        if (!create_objects(d, s, t)) {
+            sprite_release(d);
+            native_set_error("sprites: pipeline creation failed");
+            return nullptr;
+        }
+    }
+    return d->sprites;
+}
+
+// ===== frame hook =====
+void sprite_record_draw(Device* d, VkCommandBuffer cb)
+{
+    SpritePass* s = d->sprites;
+    if (!s || !s->count || !d->textures) return;
+
+    SpritePush sp{};
+    std::memcpy(sp.viewProj, d->viewProj, sizeof(sp.viewProj));
+    sp.viewport[0] = d->extent.width ? (float)d->extent.width : 1.0f;
+    sp.viewport[1] = d->extent.height ? (float)d->extent.height : 1.0f;
+
+    VkDeviceSize off = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, s->pipe);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, s->layout, 0, 1, &d->textures->set, 0, nullptr);
+    vkCmdBindVertexBuffers(cb, 0, 1, &s->inst.buf, &off);
+    vkCmdPushConstants(cb, s->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SpritePush), &sp);
+    vkCmdDraw(cb, 4, s->count, 0, 0);
+}
+
+// ===== ABI =====
+// Replaces this frame's sprites. Unknown or destroyed texture IDs draw as plain colour.
+// Returns the sprite count.
+int FM_CALL sprites_upload(fw_handle dev, const fw_sprite* sprites, uint32_t count)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("sprites_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("sprites_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !sprites) { native_set_error("sprites_upload: null sprites"); return FM_E_BADARGS; }
+    if (count > INT32_MAX) { native_set_error("sprites_upload: too many sprites"); return FM_E_BADARGS; }
+    if (!d->bindlessMax) { native_set_error("sprites_upload: descriptor indexing not supported by this device"); return FM_E_UNSUPPORTED; }
+    SpritePass* s = ensure_pass(d);
+    if (!s) return FM_E_DEVICE;
+
+    s->count = 0;
+    if (!count) return 0;
+    if (!host_buffer_reserve(d, s->inst, (size_t)count * sizeof(SpriteInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        return FM_E_NOMEM;
+
+    const TextureTable* t = d->textures;
+    auto* dst = static_cast<SpriteInstance*>(s->inst.mapped);
+    parallel_for(count, kSpriteGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            const fw_sprite& sp = sprites[i];
+            SpriteInstance si;
+            for (int k = 0; k < 3; ++k) si.anchor[k] = (float)(sp.pos[k] - d->origin[k]);
+            si.pickId = pick_id(FW_PICK_SPRITE, i);
+            si.size[0] = sp.size_px[0];
+            si.size[1] = sp.size_px[1];
+            si.texture = texture_live(t, sp.texture) ? sp.texture : 0;
+            si.rgba = sp.rgba;
+            if (sp.uv[0] == 0 && sp.uv[1] == 0 && sp.uv[2] == 0 && sp.uv[3] == 0) {
+                si.uv[0] = 0; si.uv[1] = 0; si.uv[2] = 1; si.uv[3] = 1;
+            }
+            else std::memcpy(si.uv, sp.uv, sizeof(si.uv));
+            dst[i] = si;   // one write per instance into write-combined memory
+        }
+        });
+    s->count = count;
+    return (int)count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "renderer_device.h"
+
+/*
+    Textured screen-space sprites (sprites_upload), the first consumer of the bindless
+    texture table (texture_table.h).
+    - Each sprite carries its texture ID in the instance data; the fragment shader samples
+      the table's array with it, so the whole batch is one instanced strip draw however many
+      textures it mixes. ID 0 is white: plain coloured quads share the draw.
+    - Quads are sized in pixels around the projected, pixel-snapped anchor (as labels are).
+    - Drawn alpha blended after the other scene geometry and before labels; each sprite
+      writes its own pick ID.
+*/
+
+struct SpritePass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;   // set 0 = the texture table
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    HostBuffer       inst;
+    uint32_t         count = 0;                 // sprite instances uploaded for this frame
+};
+
+// Per-instance data of vs_sprite.vert (48 bytes)
+struct SpriteInstance
+{
+    float    anchor[3];    // relative to the camera origin
+    uint32_t pickId;
+    float    size[2];      // pixels
+    uint32_t texture;      // texture table slot
+    uint32_t rgba;
+    float    uv[4];        // u0, v0, u1, v1
+};
+
+// Push block of vs_sprite.vert
+struct SpritePush
+{
+    float    viewProj[16];
+    float    viewport[2];    // pixels
+};
+
+// Frame hooks (renderer_api.cpp)
+void sprite_record_draw(Device* d, VkCommandBuffer cb);
+void sprite_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL sprites_upload(fw_handle dev, const fw_sprite* sprites, uint32_t count);
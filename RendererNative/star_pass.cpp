@@ -0,0 +1,264 @@
+// star_pass.cpp
+// Magnitude-bucketed star catalog drawn as one indirect point-sprite draw (see star_pass.h)
+
+#include "star_pass.h"
+#include "native_common.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static const uint32_t VS_STAR_SPV[] = {
+#   include "shaders/vs_star.spv.inc"
+};
+static const uint32_t FS_STAR_SPV[] = {
+#   include "shaders/fs_star.spv.inc"
+};
+static_assert((sizeof(VS_STAR_SPV) % 4) == 0, "VS_STAR_SPV must be dword aligned");
+static_assert((sizeof(FS_STAR_SPV) % 4) == 0, "FS_STAR_SPV must be dword aligned");
+
+static const uint32_t kStarGrain = 16384;
+static const uint32_t kMaxBuckets = 4096;
+static const float    kNoMagnitude = 1e30f;   // non-finite catalog magnitudes: never drawn
+
+// ===== catalog =====
+// B-V -> effective temperature (Ballesteros 2012) -> sRGB-ish colour (Helland's blackbody fit),
+// scaled so the brightest channel is 1; brightness comes from the magnitude alone.
+static uint32_t star_rgba(float bv)
+{
+    bv = std::min(std::max(std::isfinite(bv) ? bv : 0.65f, -0.4f), 2.0f);
+    const double t = 4600.0 * (1.0 / (0.92 * bv + 1.7) + 1.0 / (0.92 * bv + 0.62)) / 100.0;
+    double r, g, b;
+    if (t <= 66.0) {
+        r = 255.0;
+        g = 99.4708025861 * std::log(t) - 161.1195681661;
+        b = t <= 19.0 ? 0.0 : 138.5177312231 * std::log(t - 10.0) - 305.0447927307;
+    } else {
+        r = 329.698727446 * std::pow(t - 60.0, -0.1332047592);
+        g = 288.1221695283 * std::pow(t - 60.0, -0.0755148492);
+        b = 255.0;
+    }
+    r = std::min(std::max(r, 0.0), 255.0);
+    g = std::min(std::max(g, 0.0), 255.0);
+    b = std::min(std::max(b, 0.0), 255.0);
+    const double s = 255.0 / std::max({ r, g, b, 1.0 });
+    return (uint32_t)(r * s + 0.5) | (uint32_t)(g * s + 0.5) << 8 | (uint32_t)(b * s + 0.5) << 16 | 0xFF000000u;
+}
+
+static inline float star_magnitude(const fw_star& st)
+{
+    return std::isfinite(st.magnitude) ? st.magnitude : kNoMagnitude;
+}
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, StarPass* s)
+{
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pcr.offset = 0; pcr.size = sizeof(StarPush);
+
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &s->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription bind{};
+    bind.binding = 0; bind.stride = sizeof(StarInstance); bind.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[2]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[0].offset = 0;
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[1].offset = offsetof(StarInstance, rgba);
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_STAR_SPV; pd.vsBytes = sizeof(VS_STAR_SPV);
+    pd.fs = FS_STAR_SPV; pd.fsBytes = sizeof(FS_STAR_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = attrs; pd.attrCount = 2;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    pd.blend = BLEND_ADDITIVE;
+    pd.layout = s->layout;
+    if (!create_graphics_pipeline(d, pd, &s->pipe)) return false;
+
+    return host_buffer_reserve(d, s->indirect, sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+}
+
+static void release_catalog(Device* d, StarPass* s)
+{
+    if (s->buf) vkDestroyBuffer(d->device, s->buf, nullptr);
+    if (s->mem) vkFreeMemory(d->device, s->mem, nullptr);
+    s->buf = VK_NULL_HANDLE;
+    s->mem = VK_NULL_HANDLE;
+    s->count = 0;
+    s->bucketEnd.clear();
+}
+
+void star_release(Device* d)
+{
+    StarPass* s = d->stars;
+    if (!s) return;
+    release_catalog(d, s);
+    host_buffer_release(d, s->indirect);
+    destroy_graphics_pipeline(d, &s->pipe);
+    if (s->layout) vkDestroyPipelineLayout(d->device, s->layout, nullptr);
+    delete s;
+    d->stars = nullptr;
+}
+
+static StarPass* ensure_pass(Device* d)
+{
+    if (!d->stars) {
+        auto* s = new StarPass();
+        d->stars = s;
+        if (!create_objects(d, s)) {
+            star_release(d);
+            native_set_error("stars: pipeline creation failed");
+            return nullptr;
+        }
+    }
+    return d->stars;
+}
+
+// ===== frame hook =====
+void star_record_draw(Device* d, VkCommandBuffer cb)
+{
+    StarPass* s = d->stars;
+    if (!s || !s->count) return;
+
+    const float rel = (s->params.limiting_magnitude - s->minMag) / kStarBucketWidth;
+    if (!(rel >= 0.0f)) return;
+    const uint32_t last = (uint32_t)std::min(rel, (float)(s->bucketEnd.size() - 1));
+    const uint32_t visible = s->bucketEnd[last];
+    if (!visible) return;
+
+    // Single frame in flight: the previous frame's draw has retired by the time this is written.
+    auto* cmd = static_cast<VkDrawIndirectCommand*>(s->indirect.mapped);
+    cmd->vertexCount = 1;
+    cmd->instanceCount = visible;
+    cmd->firstVertex = 0;
+    cmd->firstInstance = 0;
+
+    StarPush sp{};
+    std::memcpy(sp.viewProj, d->viewProj, sizeof(sp.viewProj));
+    sp.limit = s->params.limiting_magnitude;
+    sp.size = s->params.point_size;
+    // The shader clamps to maxSize and keeps the flux in alpha, so only the cap follows the device
+    sp.maxSize = std::min(s->params.max_point_size, d->pointSizeMax);
+    sp.intensity = s->params.intensity;
+
+    VkDeviceSize off = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, s->pipe);
+    vkCmdBindVertexBuffers(cb, 0, 1, &s->buf, &off);
+    vkCmdPushConstants(cb, s->layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(StarPush), &sp);
+    vkCmdDrawIndirect(cb, s->indirect.buf, 0, 1, sizeof(VkDrawIndirectCommand));
+}
+
+// ===== ABI =====
+// Replaces the catalog (count 0 clears it). Directions are normalised; the records may come
+// straight from a mapped catalog file. Blocks on the upload. Returns the star count.
+int FM_CALL stars_load(fw_handle dev, const fw_star* stars, uint32_t count)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("stars_load: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) {   // replacing the catalog waits for the device
+        native_set_error("stars_load: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (count && !stars) { native_set_error("stars_load: null stars"); return FM_E_BADARGS; }
+    if (count > INT32_MAX) { native_set_error("stars_load: too many stars"); return FM_E_BADARGS; }
+
+    StarPass* s = ensure_pass(d);
+    if (!s) return FM_E_DEVICE;
+    if (s->buf) vkDeviceWaitIdle(d->device);   // the old catalog may still be read by the GPU
+    release_catalog(d, s);
+    if (!count) return 0;
+
+    // Magnitude range
+    const uint32_t chunks = (count + kStarGrain - 1) / kStarGrain;
+    std::vector<float> lo(chunks, HUGE_VALF), hi(chunks, -HUGE_VALF);
+    parallel_for(count, kStarGrain, [&](uint32_t b, uint32_t e) {
+        const uint32_t c = b / kStarGrain;
+        for (uint32_t i = b; i < e; ++i) {
+            const float m = star_magnitude(stars[i]);
+            if (m == kNoMagnitude) continue;
+            lo[c] = std::min(lo[c], m);
+            hi[c] = std::max(hi[c], m);
+        }
+        });
+    float mn = *std::min_element(lo.begin(), lo.end());
+    float mx = *std::max_element(hi.begin(), hi.end());
+    if (!(mn <= mx)) mn = mx = 0.0f;
+    s->minMag = std::floor(mn / kStarBucketWidth) * kStarBucketWidth;
+    // Clamped in float: a span of huge (or overflowing) magnitudes must not reach the cast.
+    const float span = std::min(std::max((mx - s->minMag) / kStarBucketWidth, 0.0f), (float)kMaxBuckets);
+    const uint32_t buckets = std::min(kMaxBuckets, (uint32_t)span + 2);
+    auto bucket_of = [&](float m) {
+        const float rel = (m - s->minMag) / kStarBucketWidth;
+        return (uint32_t)std::max(0.0f, std::min(rel, (float)(buckets - 1)));
+    };
+
+    // Counting sort, stable: per-chunk histograms, bucket-major prefix, parallel scatter.
+    std::vector<uint32_t> hist((size_t)chunks * buckets, 0);
+    parallel_for(count, kStarGrain, [&](uint32_t b, uint32_t e) {
+        uint32_t* h = &hist[(size_t)(b / kStarGrain) * buckets];
+        for (uint32_t i = b; i < e; ++i) h[bucket_of(star_magnitude(stars[i]))]++;
+        });
+    s->bucketEnd.assign(buckets, 0);
+    uint32_t sum = 0;
+    for (uint32_t k = 0; k < buckets; ++k) {
+        for (uint32_t c = 0; c < chunks; ++c) {
+            uint32_t& h = hist[(size_t)c * buckets + k];
+            const uint32_t n = h;
+            h = sum;
+            sum += n;
+        }
+        s->bucketEnd[k] = sum;
+    }
+
+    std::vector<StarInstance> inst(count);
+    parallel_for(count, kStarGrain, [&](uint32_t b, uint32_t e) {
+        uint32_t* h = &hist[(size_t)(b / kStarGrain) * buckets];
+        for (uint32_t i = b; i < e; ++i) {
+            const fw_star& st = stars[i];
+            const float m = star_magnitude(st);
+            StarInstance& o = inst[h[bucket_of(m)]++];
+            const float len = std::sqrt(st.dir[0] * st.dir[0] + st.dir[1] * st.dir[1] + st.dir[2] * st.dir[2]);
+            const float inv = len > 0 ? 1.0f / len : 0.0f;
+            for (int k = 0; k < 3; ++k) o.dir[k] = st.dir[k] * inv;
+            o.magnitude = len > 0 ? m : kNoMagnitude;
+            o.rgba = star_rgba(st.color_index);
+        }
+        });
+
+    const VkDeviceSize bytes = (VkDeviceSize)count * sizeof(StarInstance);
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &s->buf, &s->mem)) {
+        release_catalog(d, s);
+        native_set_error("stars_load: buffer allocation failed");
+        return FM_E_NOMEM;
+    }
+    if (!upload_buffer(d, s->buf, inst.data(), bytes)) {
+        release_catalog(d, s);
+        native_set_error("stars_load: upload failed");
+        return FM_E_DEVICE;
+    }
+    s->count = count;
+    return (int)count;
+}
+
+int FM_CALL stars_set_params(fw_handle dev, const fw_star_params* params)
+{
+    auto* d = H2D(dev);
+    if (!d || !params) { native_set_error("stars_set_params: null argument"); return FM_E_BADARGS; }
+    if (!std::isfinite(params->limiting_magnitude) || !(params->point_size > 0) ||
+        !(params->max_point_size >= params->point_size) || !(params->intensity >= 0)) {
+        native_set_error("stars_set_params: bad limit/size/intensity");
+        return FM_E_BADARGS;
+    }
+    if (!d->stars && d->inFrame) {
+        // First use creates the pass and its indirect buffer
+        native_set_error("stars_set_params: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    StarPass* s = ensure_pass(d);
+    if (!s) return FM_E_DEVICE;
+    s->params = *params;
+    return FM_OK;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "renderer_device.h"
+
+#include <vector>
+
+/*
+    Background star field from a catalog (stars_load).
+    - On load the stars are counting-sorted into kStarBucketWidth magnitude buckets,
+      brightest first, and uploaded once to device-local memory (20 bytes per star: unit
+      direction, magnitude, RGBA8 colour from B-V).
+    - Each frame the limiting magnitude selects a prefix of whole buckets; its instance count
+      goes into a small indirect buffer and the sky is one vkCmdDrawIndirect of point
+      sprites. The vertex shader drops the stars of the last bucket that are past the limit.
+    - Drawn first, as directions (w = 0) at the far plane, additively blended.
+*/
+
+static const float kStarBucketWidth = 0.1f;   // magnitudes
+
+struct StarPass
+{
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline       pipe = VK_NULL_HANDLE;
+
+    VkBuffer         buf = VK_NULL_HANDLE;    // StarInstance per star, bucket order
+    VkDeviceMemory   mem = VK_NULL_HANDLE;
+    uint32_t         count = 0;
+    HostBuffer       indirect;                // one VkDrawIndirectCommand
+
+    float                 minMag = 0.0f;      // lower edge of bucket 0
+    std::vector<uint32_t> bucketEnd;          // stars in buckets [0, b]
+
+    fw_star_params   params{ 6.5f, 1.5f, 8.0f, 1.0f };
+};
+
+// Per-instance data of vs_star.vert
+struct StarInstance
+{
+    float    dir[3];
+    float    magnitude;
+    uint32_t rgba;       // RGBA8, R in the lowest byte
+};
+
+// Push block of vs_star.vert
+struct StarPush
+{
+    float viewProj[16];
+    float limit;
+    float size;
+    float maxSize;
+    float intensity;
+};
+
+// Frame hooks (renderer_api.cpp)
+void star_record_draw(Device* d, VkCommandBuffer cb);
+void star_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL stars_load(fw_handle dev, const fw_star* stars, uint32_t count);
+int  FM_CALL stars_set_params(fw_handle dev, const fw_star_params* params);
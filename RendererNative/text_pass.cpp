@@ -0,0 +1,408 @@
+// text_pass.cpp
+// MSDF label text: atlas upload, parallel layout into one instanced draw (see text_pass.h)
+
+#include "text_pass.h"
+#include "native_common.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static const uint32_t VS_GLYPH_SPV[] = {
+#   include "shaders/vs_glyph.spv.inc"
+};
+static const uint32_t FS_GLYPH_SPV[] = {
+#   include "shaders/fs_glyph.spv.inc"
+};
+static_assert((sizeof(VS_GLYPH_SPV) % 4) == 0, "VS_GLYPH_SPV must be dword aligned");
+static_assert((sizeof(FS_GLYPH_SPV) % 4) == 0, "FS_GLYPH_SPV must be dword aligned");
+static_assert(sizeof(GlyphInstance) == 64, "GlyphInstance must match vs_glyph.vert");
+
+static const uint32_t kLabelGrain = 256;
+static const float    kDefaultEmPx = 40.0f;
+static const float    kDefaultPxRange = 4.0f;
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, TextPass* t)
+{
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_LINEAR; sci.minFilter = VK_FILTER_LINEAR;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.maxLod = 0.0f;
+    if (vkCreateSampler(d->device, &sci, nullptr, &t->sampler) != VK_SUCCESS) return false;
+
+    VkDescriptorSetLayoutBinding bl{};
+    bl.binding = 0; bl.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bl.descriptorCount = 1; bl.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo dlci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    dlci.bindingCount = 1; dlci.pBindings = &bl;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &t->dsl) != VK_SUCCESS) return false;
+
+    VkDescriptorPoolSize ps{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
+    VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dpci.maxSets = 1; dpci.poolSizeCount = 1; dpci.pPoolSizes = &ps;
+    if (vkCreateDescriptorPool(d->device, &dpci, nullptr, &t->pool) != VK_SUCCESS) return false;
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = t->pool; dsai.descriptorSetCount = 1; dsai.pSetLayouts = &t->dsl;
+    if (vkAllocateDescriptorSets(d->device, &dsai, &t->set) != VK_SUCCESS) return false;
+
+    VkPushConstantRange pcr{};
+    pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcr.offset = 0; pcr.size = sizeof(GlyphPush);
+    VkPipelineLayoutCreateInfo plci{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    plci.setLayoutCount = 1; plci.pSetLayouts = &t->dsl;
+    plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(d->device, &plci, nullptr, &t->layout) != VK_SUCCESS) return false;
+
+    VkVertexInputBindingDescription bind{};
+    bind.binding = 0; bind.stride = sizeof(GlyphInstance); bind.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription attrs[6]{};
+    attrs[0].location = 0; attrs[0].binding = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = offsetof(GlyphInstance, anchor);
+    attrs[1].location = 1; attrs[1].binding = 0; attrs[1].format = VK_FORMAT_R32_UINT; attrs[1].offset = offsetof(GlyphInstance, pickId);
+    attrs[2].location = 2; attrs[2].binding = 0; attrs[2].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[2].offset = offsetof(GlyphInstance, rect);
+    attrs[3].location = 3; attrs[3].binding = 0; attrs[3].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[3].offset = offsetof(GlyphInstance, uv);
+    attrs[4].location = 4; attrs[4].binding = 0; attrs[4].format = VK_FORMAT_R8G8B8A8_UNORM; attrs[4].offset = offsetof(GlyphInstance, rgba);
+    attrs[5].location = 5; attrs[5].binding = 0; attrs[5].format = VK_FORMAT_R32_SFLOAT; attrs[5].offset = offsetof(GlyphInstance, pxRange);
+
+    GfxPipelineDesc pd{};
+    pd.vs = VS_GLYPH_SPV; pd.vsBytes = sizeof(VS_GLYPH_SPV);
+    pd.fs = FS_GLYPH_SPV; pd.fsBytes = sizeof(FS_GLYPH_SPV);
+    pd.bindings = &bind; pd.bindingCount = 1;
+    pd.attrs = attrs; pd.attrCount = 6;
+    pd.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    pd.blend = BLEND_ALPHA;
+    pd.layout = t->layout;
+    return create_graphics_pipeline(d, pd, &t->pipe);
+}
+
+void text_release(Device* d)
+{
+    TextPass* t = d->text;
+    if (!t) return;
+    destroy_image(d, t->atlas);
+    host_buffer_release(d, t->inst);
+    destroy_graphics_pipeline(d, &t->pipe);
+    if (t->layout)  vkDestroyPipelineLayout(d->device, t->layout, nullptr);
+    if (t->pool)    vkDestroyDescriptorPool(d->device, t->pool, nullptr);
+    if (t->dsl)     vkDestroyDescriptorSetLayout(d->device, t->dsl, nullptr);
+    if (t->sampler) vkDestroySampler(d->device, t->sampler, nullptr);
+    delete t;
+    d->text = nullptr;
+}
+
+static TextPass* ensure_pass(Device* d)
+{
+    if (!d->text) {
+        auto* t = new TextPass();
+        d->text = t;
+        if (!create_objects(d, t)) {
+            text_release(d);
+            native_set_error("text: pipeline creation failed");
+            return nullptr;
+        }
+    }
+    return d->text;
+}
+
+// ===== frame hook =====
+void text_record_draw(Device* d, VkCommandBuffer cb)
+{
+    TextPass* t = d->text;
+    if (!t || !t->count || !t->atlas.img) return;
+
+    GlyphPush gp{};
+    std::memcpy(gp.viewProj, d->viewProj, sizeof(gp.viewProj));
+    gp.viewport[0] = d->extent.width ? (float)d->extent.width : 1.0f;
+    gp.viewport[1] = d->extent.height ? (float)d->extent.height : 1.0f;
+    gp.outlineWidth = t->outlineWidth;
+    gp.outlineRgba = t->outlineRgba;
+
+    VkDeviceSize off = 0;
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, t->pipe);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, t->layout, 0, 1, &t->set, 0, nullptr);
+    vkCmdBindVertexBuffers(cb, 0, 1, &t->inst.buf, &off);
+    vkCmdPushConstants(cb, t->layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(GlyphPush), &gp);
+    vkCmdDraw(cb, 4, t->count, 0, 0);
+}
+
+// ===== layout =====
+// Next codepoint of a UTF-8 string; malformed sequences decode to U+FFFD one byte at a time.
+static uint32_t next_codepoint(const char*& s)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+    uint32_t c = *p++;
+    const int extra = c < 0x80 ? 0 : c < 0xC2 ? -1 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : c < 0xF5 ? 3 : -1;
+    if (extra < 0) { s = reinterpret_cast<const char*>(p); return 0xFFFD; }
+    if (extra) c &= 0x3Fu >> extra;
+    for (int i = 0; i < extra; ++i) {
+        if ((*p & 0xC0) != 0x80) { s = reinterpret_cast<const char*>(p); return 0xFFFD; }
+        c = c << 6 | (*p++ & 0x3Fu);
+    }
+    s = reinterpret_cast<const char*>(p);
+    return c;
+}
+
+static inline const FontGlyph* glyph_for(const FontAtlas& f, uint32_t cp, const FontGlyph* fallback)
+{
+    const FontGlyph* g = font_find_glyph(f, cp);
+    return g ? g : (cp == '\r' || cp == '\t') ? nullptr : fallback;
+}
+
+static inline bool label_visible(const fw_label& l)
+{
+    return l.text && l.size_px > 0 && std::isfinite(l.size_px) &&
+        std::isfinite(l.pos[0]) && std::isfinite(l.pos[1]) && std::isfinite(l.pos[2]);
+}
+
+// First baseline of a block of `lines` lines, pixels up from the anchor.
+static float first_baseline(const FontAtlas& f, const fw_label& l, uint32_t lines)
+{
+    const float size = l.size_px, lh = f.lineHeight * size;
+    float baseline = 0.0f;
+    switch (l.align & 12u) {
+    case FW_LABEL_MIDDLE: baseline = 0.5f * (lines * lh) - f.ascender * size; break;
+    case FW_LABEL_TOP:    baseline = -f.ascender * size; break;
+    case FW_LABEL_BOTTOM: baseline = (lines - 1) * lh - f.descender * size; break;
+    default: break;
+    }
+    return baseline + l.offset_px[1];
+}
+
+// Lays out one label into out. With out == null it only measures: the glyph quads it needs
+// (glyphs without ink, such as spaces, advance the pen but emit nothing) and, if ext is set,
+// its text block x0, y0, x1, y1 in pixels from the anchor, y up (empty when nothing draws).
+static uint32_t layout_label(const TextPass* t, const fw_label& l, uint32_t index, const double origin[3],
+    const FontGlyph* fallback, GlyphInstance* out, float* ext = nullptr)
+{
+    if (ext) ext[0] = ext[1] = ext[2] = ext[3] = 0.0f;
+    if (!label_visible(l)) return 0;
+    const FontAtlas& f = t->font;
+    const float size = l.size_px;
+    const float lh = f.lineHeight * size;
+    uint32_t n = 0;
+    if (!out) {
+        uint32_t lines = 1;
+        float width = 0.0f, maxWidth = 0.0f;
+        for (const char* s = l.text; *s;) {
+            const uint32_t cp = next_codepoint(s);
+            if (cp == '\n') { maxWidth = std::max(maxWidth, width); width = 0.0f; ++lines; continue; }
+            const FontGlyph* g = glyph_for(f, cp, fallback);
+            if (!g) continue;
+            width += g->advance * size;
+            if (g->plane[2] > g->plane[0]) ++n;
+        }
+        if (ext && n) {
+            maxWidth = std::max(maxWidth, width);
+            const float a = (l.align & 3u) == FW_LABEL_CENTER ? 0.5f : (l.align & 3u) == FW_LABEL_RIGHT ? 1.0f : 0.0f;
+            const float baseline = first_baseline(f, l, lines);
+            ext[0] = l.offset_px[0] - a * maxWidth;
+            ext[1] = baseline - (lines - 1) * lh + f.descender * size;
+            ext[2] = ext[0] + maxWidth;
+            ext[3] = baseline + f.ascender * size;
+        }
+        return n;
+    }
+
+    uint32_t lines = 1;
+    for (const char* s = l.text; *s; ++s) lines += *s == '\n';
+    float baseline = first_baseline(f, l, lines);
+
+    GlyphInstance proto{};
+    for (int k = 0; k < 3; ++k) proto.anchor[k] = (float)(l.pos[k] - origin[k]);
+    proto.pickId = pick_id(FW_PICK_LABEL, index);
+    proto.rgba = l.rgba;
+    proto.pxRange = f.pxRange * size / f.emPx;
+
+    const char* line = l.text;
+    while (line) {
+        const char* s = line;
+        float width = 0.0f;
+        while (*s && *s != '\n') {
+            const FontGlyph* g = glyph_for(f, next_codepoint(s), fallback);
+            if (g) width += g->advance * size;
+        }
+        float pen = l.offset_px[0];
+        switch (l.align & 3u) {
+        case FW_LABEL_CENTER: pen -= 0.5f * width; break;
+        case FW_LABEL_RIGHT:  pen -= width; break;
+        default: break;
+        }
+        for (s = line; *s && *s != '\n';) {
+            const FontGlyph* g = glyph_for(f, next_codepoint(s), fallback);
+            if (!g) continue;
+            if (g->plane[2] > g->plane[0]) {
+                GlyphInstance& gi = out[n++];
+                gi = proto;
+                gi.rect[0] = pen + g->plane[0] * size;
+                gi.rect[1] = baseline + g->plane[1] * size;
+                gi.rect[2] = pen + g->plane[2] * size;
+                gi.rect[3] = baseline + g->plane[3] * size;
+                std::memcpy(gi.uv, g->uv, sizeof(gi.uv));
+            }
+            pen += g->advance * size;
+        }
+        line = *s ? s + 1 : nullptr;
+        baseline -= lh;
+    }
+    return n;
+}
+
+// ===== ABI =====
+// Builds (or loads from the cache) the atlas and uploads it; labels laid out with the previous
+// font are dropped. Blocking. Returns the glyph count.
+int FM_CALL text_load_font(fw_handle dev, const fw_font_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d || !desc || !desc->font_path) { native_set_error("text_load_font: null argument"); return FM_E_BADARGS; }
+    if (d->inFrame) {   // replacing the atlas waits for the device
+        native_set_error("text_load_font: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    const float em = desc->em_px > 0 ? desc->em_px : kDefaultEmPx;
+    const float range = desc->px_range > 0 ? desc->px_range : kDefaultPxRange;
+    if (!(em <= 256.0f) || !(range < em)) { native_set_error("text_load_font: bad em_px/px_range"); return FM_E_BADARGS; }
+    if (desc->codepoint_count && !desc->codepoints) { native_set_error("text_load_font: null codepoints"); return FM_E_BADARGS; }
+
+    FontAtlas font;
+    const int r = font_atlas_build(desc->font_path, desc->cache_path, em, range, desc->codepoints,
+        desc->codepoints ? desc->codepoint_count : 0, font);
+    if (r != FM_OK) return r;
+    if (font.glyphs.empty()) { native_set_error("text_load_font: no glyphs for the requested codepoints"); return FM_E_BADARGS; }
+
+    TextPass* t = ensure_pass(d);
+    if (!t) return FM_E_DEVICE;
+    if (t->atlas.img) {
+        vkDeviceWaitIdle(d->device);   // the old atlas and its descriptor may still be in use
+        destroy_image(d, t->atlas);
+    }
+    t->count = 0;
+
+    if (!create_image(d, font.width, font.height, VK_FORMAT_R8G8B8A8_UNORM,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, &t->atlas)) {
+        native_set_error("text_load_font: atlas allocation failed");
+        return FM_E_NOMEM;
+    }
+    if (!upload_image(d, t->atlas, font.pixels.data(), (VkDeviceSize)font.pixels.size() * 4)) {
+        destroy_image(d, t->atlas);
+        native_set_error("text_load_font: atlas upload failed");
+        return FM_E_DEVICE;
+    }
+
+    VkDescriptorImageInfo ii{ t->sampler, t->atlas.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    w.dstSet = t->set; w.dstBinding = 0;
+    w.descriptorCount = 1; w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w.pImageInfo = &ii;
+    vkUpdateDescriptorSets(d->device, 1, &w, 0, nullptr);
+
+    font.pixels.clear();
+    font.pixels.shrink_to_fit();
+    t->font = std::move(font);
+    return (int)t->font.glyphs.size();
+}
+
+// Replaces this frame's labels, decluttered through the current camera when enabled.
+// Codepoints missing from the atlas draw as '?'. Returns the number of glyph quads.
+int FM_CALL labels_upload(fw_handle dev, const fw_label* labels, uint32_t count)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("labels_upload: null device"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("labels_upload: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY; }
+    if (count && !labels) { native_set_error("labels_upload: null labels"); return FM_E_BADARGS; }
+    TextPass* t = d->text;
+    if (!t || !t->atlas.img) { native_set_error("labels_upload: no font loaded"); return FM_E_NOTREADY; }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    t->count = 0;
+    t->stats = fw_label_stats{};
+    t->stats.labels = count;
+    if (!count) return 0;
+    const FontGlyph* fallback = font_find_glyph(t->font, '?');
+    const bool declutter = t->declutter.enabled != 0;
+
+    // Glyph quads per label (and text blocks for the declutter), then their offsets
+    t->first.resize(count);
+    if (declutter) t->extent.resize((size_t)count * 4);
+    parallel_for(count, kLabelGrain, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i)
+            t->first[i] = layout_label(t, labels[i], i, d->origin, fallback, nullptr,
+                declutter ? &t->extent[(size_t)i * 4] : nullptr);
+        });
+    const uint8_t* keep = nullptr;
+    if (declutter) {
+        DeclutterParams p;
+        for (int k = 0; k < 3; ++k) p.origin[k] = d->origin[k];
+        std::memcpy(p.viewProj, d->viewProj, sizeof(p.viewProj));
+        p.width = (float)d->extent.width;
+        p.height = (float)d->extent.height;
+        p.padding = t->declutter.padding_px;
+        p.cell = t->declutter.cell_px;
+        t->keep.resize(count);
+        const uint32_t kept = declutter_labels(labels, t->extent.data(), count, p, t->scratch, t->keep.data(),
+            &t->stats.culled);
+        t->stats.hidden = count - t->stats.culled - kept;
+        keep = t->keep.data();
+    }
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t n = (!keep || keep[i]) ? t->first[i] : 0;
+        t->first[i] = (uint32_t)total;
+        total += n;
+        t->stats.drawn += n != 0;
+    }
+    if (total > INT32_MAX) { native_set_error("labels_upload: too many glyphs"); return FM_E_BADARGS; }
+
+    if (total) {
+        if (!host_buffer_reserve(d, t->inst, (size_t)total * sizeof(GlyphInstance), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+            return FM_E_NOMEM;
+        auto* dst = static_cast<GlyphInstance*>(t->inst.mapped);
+        parallel_for(count, kLabelGrain, [&](uint32_t b, uint32_t e) {
+            for (uint32_t i = b; i < e; ++i)
+                if (!keep || keep[i]) layout_label(t, labels[i], i, d->origin, fallback, dst + t->first[i]);
+            });
+    }
+    t->count = (uint32_t)total;
+    t->stats.glyphs = t->count;
+    t->stats.cpu_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return (int)total;
+}
+
+// Outline around every label, in screen pixels (0 = none); it cannot reach further out than
+// half the font's distance range at the label's size.
+int FM_CALL labels_set_outline(fw_handle dev, float width_px, uint32_t rgba)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("labels_set_outline: null device"); return FM_E_BADARGS; }
+    if (!(width_px >= 0) || !std::isfinite(width_px)) { native_set_error("labels_set_outline: bad width"); return FM_E_BADARGS; }
+    TextPass* t = ensure_pass(d);
+    if (!t) return FM_E_DEVICE;
+    t->outlineWidth = width_px;
+    t->outlineRgba = rgba;
+    return FM_OK;
+}
+
+int FM_CALL labels_set_declutter(fw_handle dev, const fw_declutter_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("labels_set_declutter: null device"); return FM_E_BADARGS; }
+    if (desc && (!(desc->padding_px >= 0) || !(desc->cell_px >= 0))) {
+        native_set_error("labels_set_declutter: negative padding/cell");
+        return FM_E_BADARGS;
+    }
+    TextPass* t = ensure_pass(d);
+    if (!t) return FM_E_DEVICE;
+    t->declutter = desc ? *desc : fw_declutter_desc{};
+    return FM_OK;
+}
+
+int FM_CALL labels_get_stats(fw_handle dev, fw_label_stats* out)
+{
+    auto* d = H2D(dev);
+    if (!d || !out) { native_set_error("labels_get_stats: null argument"); return FM_E_BADARGS; }
+    *out = d->text ? d->text->stats : fw_label_stats{};
+    return FM_OK;
+}
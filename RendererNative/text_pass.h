@@ -0,0 +1,79 @@
+#pragma once
+#include "renderer_device.h"
+#include "font_atlas.h"
+#include "label_declutter.h"
+
+#include <vector>
+
+/*
+    Text labels drawn from an MSDF glyph atlas (text_load_font, see font_atlas.h).
+    - The atlas is uploaded once to a sampled RGBA8 image; the glyph table stays on the host.
+    - labels_upload lays every label out in native code (UTF-8, multi-line, alignment) in two
+      parallel passes: glyph counts per label, a prefix sum, then the quads are written
+      straight into the mapped instance buffer. The whole set is one instanced strip draw.
+    - Quads are sized in pixels around the projected, pixel-snapped anchor, so text keeps its
+      screen size at any zoom; the fragment shader takes the median of the three channels and
+      antialiases over the distance range scaled to screen pixels, which keeps edges crisp
+      when glyphs are magnified well past the atlas resolution.
+    - Optional declutter (label_declutter.h) between the two passes keeps the highest
+      priority labels that do not overlap; only those are written and drawn.
+    - Drawn last in the scene, alpha blended; each label writes its own pick ID.
+*/
+
+struct TextPass
+{
+    VkPipelineLayout      layout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout dsl = VK_NULL_HANDLE;
+    VkDescriptorPool      pool = VK_NULL_HANDLE;
+    VkDescriptorSet       set = VK_NULL_HANDLE;
+    VkSampler             sampler = VK_NULL_HANDLE;
+    VkPipeline            pipe = VK_NULL_HANDLE;
+
+    GpuImage              atlas;
+    FontAtlas             font;          // glyph table and metrics (pixels dropped after upload)
+
+    HostBuffer            inst;
+    uint32_t              count = 0;     // glyph instances uploaded for this frame
+    std::vector<uint32_t> first;         // labels_upload scratch: first glyph per label
+    std::vector<float>    extent;        // text block per label (declutter)
+    std::vector<uint8_t>  keep;
+
+    fw_declutter_desc     declutter{};
+    DeclutterScratch      scratch;
+    fw_label_stats        stats{};
+
+    float                 outlineWidth = 0.0f;
+    uint32_t              outlineRgba = 0xFF000000u;
+};
+
+// Per-instance data of vs_glyph.vert (64 bytes)
+struct GlyphInstance
+{
+    float    anchor[3];    // relative to the camera origin
+    uint32_t pickId;
+    float    rect[4];      // quad x0, y0, x1, y1 in pixels from the anchor, y up
+    float    uv[4];        // atlas u, v at (x0, y0) and (x1, y1)
+    uint32_t rgba;
+    float    pxRange;      // distance range in screen pixels at this size
+    float    pad[2];
+};
+
+// Push block of vs_glyph.vert / fs_glyph.frag
+struct GlyphPush
+{
+    float    viewProj[16];
+    float    viewport[2];    // pixels
+    float    outlineWidth;   // pixels
+    uint32_t outlineRgba;
+};
+
+// Frame hooks (renderer_api.cpp)
+void text_record_draw(Device* d, VkCommandBuffer cb);
+void text_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL text_load_font(fw_handle dev, const fw_font_desc* desc);
+int  FM_CALL labels_upload(fw_handle dev, const fw_label* labels, uint32_t count);
+int  FM_CALL labels_set_outline(fw_handle dev, float width_px, uint32_t rgba);
+int  FM_CALL labels_set_declutter(fw_handle dev, const fw_declutter_desc* desc);
+int  FM_CALL labels_get_stats(fw_handle dev, fw_label_stats* out);
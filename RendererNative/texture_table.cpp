@@ -0,0 +1,298 @@
+// texture_table.cpp
+// Bindless texture table: descriptor-indexed sampler array, mip-chained uploads (see texture_table.h)
+
+#include "texture_table.h"
+#include "native_common.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t kMaxTextures = 4096;
+
+// ===== images =====
+// Layout transition of levels [base, base + count).
+static void level_barrier(VkCommandBuffer cb, VkImage img, uint32_t base, uint32_t count,
+    VkImageLayout from, VkImageLayout to, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    b.srcAccessMask = srcAccess; b.dstAccessMask = dstAccess;
+    b.oldLayout = from; b.newLayout = to;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = img;
+    b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    b.subresourceRange.baseMipLevel = base;
+    b.subresourceRange.levelCount = count;
+    b.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cb, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+}
+
+// create_image with a mip chain of `levels`.
+static bool create_texture_image(Device* d, uint32_t w, uint32_t h, VkFormat fmt, uint32_t levels, GpuImage* out)
+{
+    *out = GpuImage{};
+    VkImageCreateInfo ici{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = fmt;
+    ici.extent = { w, h, 1 };
+    ici.mipLevels = levels; ici.arrayLayers = 1;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+        (levels > 1 ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(d->device, &ici, nullptr, &out->img) != VK_SUCCESS) return false;
+
+    VkMemoryRequirements mr{};
+    vkGetImageMemoryRequirements(d->device, out->img, &mr);
+    VkMemoryAllocateInfo mai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = find_memtype(d->phys, mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(d->device, &mai, nullptr, &out->mem) != VK_SUCCESS ||
+        vkBindImageMemory(d->device, out->img, out->mem, 0) != VK_SUCCESS)
+    {
+        destroy_image(d, *out);
+        return false;
+    }
+
+    VkImageViewCreateInfo iv{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    iv.image = out->img;
+    iv.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    iv.format = fmt;
+    iv.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    iv.subresourceRange.levelCount = levels;
+    iv.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(d->device, &iv, nullptr, &out->view) != VK_SUCCESS) {
+        destroy_image(d, *out);
+        return false;
+    }
+    out->fmt = fmt;
+    out->extent = { w, h };
+    return true;
+}
+
+// Blocking upload of level 0 (rows `pitch` bytes apart) and blits of each further level from
+// the one above; every level ends in SHADER_READ_ONLY_OPTIMAL.
+static bool upload_texture(Device* d, const GpuImage& img, uint32_t levels, const void* pixels, uint32_t pitch)
+{
+    const uint32_t w = img.extent.width, h = img.extent.height;
+    const VkDeviceSize bytes = (VkDeviceSize)w * h * 4;
+    VkBuffer stage = VK_NULL_HANDLE; VkDeviceMemory stageMem = VK_NULL_HANDLE;
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stage, &stageMem))
+        return false;
+
+    void* mapped = nullptr;
+    bool ok = vkMapMemory(d->device, stageMem, 0, bytes, 0, &mapped) == VK_SUCCESS;
+    if (ok) {
+        for (uint32_t y = 0; y < h; ++y)
+            std::memcpy(static_cast<uint8_t*>(mapped) + (size_t)y * w * 4,
+                static_cast<const uint8_t*>(pixels) + (size_t)y * pitch, (size_t)w * 4);
+        vkUnmapMemory(d->device, stageMem);
+
+        VkCommandBuffer cb = begin_one_shot(d);
+        ok = cb != VK_NULL_HANDLE;
+        if (ok) {
+            level_barrier(cb, img.img, 0, levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            VkBufferImageCopy cp{};
+            cp.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            cp.imageSubresource.layerCount = 1;
+            cp.imageExtent = { w, h, 1 };
+            vkCmdCopyBufferToImage(cb, stage, img.img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &cp);
+
+            int32_t sw = (int32_t)w, sh = (int32_t)h;
+            for (uint32_t l = 1; l < levels; ++l) {
+                level_barrier(cb, img.img, l - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+                const int32_t dw = std::max(sw / 2, 1), dh = std::max(sh / 2, 1);
+                VkImageBlit blit{};
+                blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, l - 1, 0, 1 };
+                blit.srcOffsets[1] = { sw, sh, 1 };
+                blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, l, 0, 1 };
+                blit.dstOffsets[1] = { dw, dh, 1 };
+                vkCmdBlitImage(cb, img.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, img.img,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+                sw = dw; sh = dh;
+            }
+            if (levels > 1)
+                level_barrier(cb, img.img, 0, levels - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            level_barrier(cb, img.img, levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+            ok = end_one_shot(d, cb);
+        }
+    }
+    vkDestroyBuffer(d->device, stage, nullptr);
+    vkFreeMemory(d->device, stageMem, nullptr);
+    return ok;
+}
+
+// Points slot `id` of the descriptor array at an image. The caller guarantees no submitted
+// frame still reads the slot (update-after-bind only covers recorded, unsubmitted work).
+static void write_slot(Device* d, TextureTable* t, uint32_t id, VkImageView view, VkSampler sampler)
+{
+    VkDescriptorImageInfo ii{ sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    w.dstSet = t->set; w.dstBinding = 0; w.dstArrayElement = id;
+    w.descriptorCount = 1; w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w.pImageInfo = &ii;
+    vkUpdateDescriptorSets(d->device, 1, &w, 0, nullptr);
+}
+
+// ===== creation / teardown =====
+static bool create_objects(Device* d, TextureTable* t)
+{
+    VkSamplerCreateInfo sci{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sci.magFilter = VK_FILTER_LINEAR; sci.minFilter = VK_FILTER_LINEAR;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(d->device, &sci, nullptr, &t->linear) != VK_SUCCESS) return false;
+    sci.magFilter = VK_FILTER_NEAREST; sci.minFilter = VK_FILTER_NEAREST;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    if (vkCreateSampler(d->device, &sci, nullptr, &t->nearest) != VK_SUCCESS) return false;
+
+    t->capacity = std::min(kMaxTextures, d->bindlessMax);
+    VkDescriptorSetLayoutBinding bl{};
+    bl.binding = 0; bl.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bl.descriptorCount = t->capacity; bl.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    const VkDescriptorBindingFlagsEXT flags =
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bfci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+    bfci.bindingCount = 1; bfci.pBindingFlags = &flags;
+    VkDescriptorSetLayoutCreateInfo dlci{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    dlci.pNext = &bfci;
+    dlci.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    dlci.bindingCount = 1; dlci.pBindings = &bl;
+    if (vkCreateDescriptorSetLayout(d->device, &dlci, nullptr, &t->dsl) != VK_SUCCESS) return false;
+
+    VkDescriptorPoolSize ps{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, t->capacity };
+    VkDescriptorPoolCreateInfo dpci{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    dpci.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    dpci.maxSets = 1; dpci.poolSizeCount = 1; dpci.pPoolSizes = &ps;
+    if (vkCreateDescriptorPool(d->device, &dpci, nullptr, &t->pool) != VK_SUCCESS) return false;
+    VkDescriptorSetAllocateInfo dsai{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    dsai.descriptorPool = t->pool; dsai.descriptorSetCount = 1; dsai.pSetLayouts = &t->dsl;
+    if (vkAllocateDescriptorSets(d->device, &dsai, &t->set) != VK_SUCCESS) return false;
+
+    // ID 0: opaque white
+    const uint32_t white = 0xFFFFFFFFu;
+    TextureSlot s;
+    s.levels = 1;
+    if (!create_texture_image(d, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, 1, &s.image)) return false;
+    t->slots.push_back(s);
+    if (!upload_texture(d, s.image, 1, &white, 4)) return false;
+    t->slots[0].live = true;
+    write_slot(d, t, 0, s.image.view, t->nearest);
+    return true;
+}
+
+void texture_table_release(Device* d)
+{
+    TextureTable* t = d->textures;
+    if (!t) return;
+    for (TextureSlot& s : t->slots) destroy_image(d, s.image);
+    if (t->pool)    vkDestroyDescriptorPool(d->device, t->pool, nullptr);
+    if (t->dsl)     vkDestroyDescriptorSetLayout(d->device, t->dsl, nullptr);
+    if (t->linear)  vkDestroySampler(d->device, t->linear, nullptr);
+    if (t->nearest) vkDestroySampler(d->device, t->nearest, nullptr);
+    delete t;
+    d->textures = nullptr;
+}
+
+TextureTable* texture_table_ensure(Device* d)
+{
+    if (!d->bindlessMax) { native_set_error("textures: descriptor indexing not supported by this device"); return nullptr; }
+    if (!d->textures) {
+        auto* t = new TextureTable();
+        d->textures = t;
+        if (!create_objects(d, t)) {
+            texture_table_release(d);
+            native_set_error("textures: table creation failed");
+            return nullptr;
+        }
+    }
+    return d->textures;
+}
+
+// ===== ABI =====
+// Uploads the pixels into a new slot (blocking) and returns its ID in *out_id.
+int FM_CALL texture_create(fw_handle dev, const fw_texture_desc* desc, uint32_t* out_id)
+{
+    auto* d = H2D(dev);
+    if (!d || !desc || !desc->pixels || !out_id) { native_set_error("texture_create: null argument"); return FM_E_BADARGS; }
+    const uint32_t w = desc->width, h = desc->height;
+    const uint32_t pitch = desc->row_pitch ? desc->row_pitch : w * 4;
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(d->phys, &props);
+    if (!w || !h || w > props.limits.maxImageDimension2D || h > props.limits.maxImageDimension2D || pitch < w * 4) {
+        native_set_error("texture_create: bad size/row_pitch");
+        return FM_E_BADARGS;
+    }
+    if (!d->bindlessMax) { native_set_error("texture_create: descriptor indexing not supported by this device"); return FM_E_UNSUPPORTED; }
+    TextureTable* t = texture_table_ensure(d);
+    if (!t) return FM_E_DEVICE;
+
+    uint32_t id;
+    if (!t->freeIds.empty()) id = t->freeIds.back();
+    else if (t->slots.size() < t->capacity) id = (uint32_t)t->slots.size();
+    else { native_set_error("texture_create: texture table full"); return FM_E_NOMEM; }
+
+    // Mips only when the format can be blitted with linear filtering (always, in practice)
+    const VkFormat fmt = (desc->flags & FW_TEXTURE_SRGB) ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    uint32_t levels = 1;
+    if (desc->flags & FW_TEXTURE_MIPMAPS) {
+        VkFormatProperties fp{};
+        vkGetPhysicalDeviceFormatProperties(d->phys, fmt, &fp);
+        const VkFormatFeatureFlags need = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if ((fp.optimalTilingFeatures & need) == need)
+            for (uint32_t m = std::max(w, h); m > 1; m >>= 1) ++levels;
+    }
+
+    TextureSlot s;
+    s.levels = levels;
+    if (!create_texture_image(d, w, h, fmt, levels, &s.image)) {
+        native_set_error("texture_create: image allocation failed");
+        return FM_E_NOMEM;
+    }
+    if (!upload_texture(d, s.image, levels, desc->pixels, pitch)) {
+        destroy_image(d, s.image);
+        native_set_error("texture_create: upload failed");
+        return FM_E_DEVICE;
+    }
+    s.live = true;
+
+    // The upload left the queue idle, so no frame is reading the slot
+    write_slot(d, t, id, s.image.view, (desc->flags & FW_TEXTURE_NEAREST) ? t->nearest : t->linear);
+    if (id == t->slots.size()) t->slots.push_back(s);
+    else { t->slots[id] = s; t->freeIds.pop_back(); }
+    *out_id = id;
+    return FM_OK;
+}
+
+// Frees the texture; its slot draws white until the ID is handed out again. Not inside a
+// frame: begin_frame has recorded draws that may sample the image and the fence that would
+// cover them is not submitted until end_frame.
+int FM_CALL texture_destroy(fw_handle dev, uint32_t id)
+{
+    auto* d = H2D(dev);
+    if (!d) { native_set_error("texture_destroy: null device"); return FM_E_BADARGS; }
+    if (!d->bindlessMax) { native_set_error("texture_destroy: descriptor indexing not supported by this device"); return FM_E_UNSUPPORTED; }
+    TextureTable* t = d->textures;
+    if (!id || !texture_live(t, id)) { native_set_error("texture_destroy: unknown texture"); return FM_E_BADARGS; }
+    if (d->inFrame) { native_set_error("texture_destroy: called inside a frame, call it after end_frame"); return FM_E_NOTREADY; }
+
+    vkWaitForFences(d->device, 1, &d->fence, VK_TRUE, UINT64_MAX);   // the last frame may still sample it
+    write_slot(d, t, id, t->slots[0].image.view, t->nearest);
+    destroy_image(d, t->slots[id].image);
+    t->slots[id] = TextureSlot{};
+    t->freeIds.push_back(id);
+    return FM_OK;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "renderer_device.h"
+
+#include <vector>
+
+/*
+    Bindless texture table (texture_create / texture_destroy), VK_EXT_descriptor_indexing.
+    - One descriptor set holds a fixed-size array of combined image samplers, bound once per
+      draw; shaders index it with a per-instance texture ID (nonuniformEXT), so instances
+      with different textures share a single draw.
+    - The binding is PARTIALLY_BOUND | UPDATE_AFTER_BIND: slots never written are legal as
+      long as no instance reads them, and creating a texture only writes its own slot.
+    - ID 0 is a built-in 1x1 white texture, so untextured instances take the same path.
+    - Freed IDs are rewritten to white and reused; callers re-upload instances that still
+      reference a destroyed ID. texture_destroy waits for the last submitted frame, so it is
+      refused (FM_E_NOTREADY) between begin_frame and end_frame.
+    - Absent on devices without descriptor indexing (d->bindlessMax == 0).
+*/
+
+struct TextureSlot
+{
+    GpuImage image;            // mip chain when created with FW_TEXTURE_MIPMAPS
+    uint32_t levels = 0;
+    bool     live = false;
+};
+
+struct TextureTable
+{
+    VkDescriptorSetLayout dsl = VK_NULL_HANDLE;
+    VkDescriptorPool      pool = VK_NULL_HANDLE;
+    VkDescriptorSet       set = VK_NULL_HANDLE;
+    VkSampler             linear = VK_NULL_HANDLE;   // trilinear, clamped
+    VkSampler             nearest = VK_NULL_HANDLE;
+
+    uint32_t              capacity = 0;              // descriptor array size
+    std::vector<TextureSlot> slots;                  // by ID, [0] = white
+    std::vector<uint32_t> freeIds;
+};
+
+// Creates the table (and the white texture) on first use; null with the error set when the
+// device has no descriptor indexing or creation failed.
+TextureTable* texture_table_ensure(Device* d);
+// True when id names a live texture (0 always does once the table exists).
+static inline bool texture_live(const TextureTable* t, uint32_t id)
+{
+    return t && id < t->slots.size() && t->slots[id].live;
+}
+
+// Teardown (destroy_device)
+void texture_table_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL texture_create(fw_handle dev, const fw_texture_desc* desc, uint32_t* out_id);
+int  FM_CALL texture_destroy(fw_handle dev, uint32_t id);
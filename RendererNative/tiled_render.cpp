@@ -0,0 +1,320 @@
+// tiled_render.cpp
+// Poster-size offscreen rendering in pipelined tiles (see tiled_render.h)
+
+#include "tiled_render.h"
+#include "native_common.h"
+#include "nbody_gpu.h"
+#include "render_graph.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static const uint32_t     kDefaultTile = 2048;
+static const VkDeviceSize kDefaultBudget = VkDeviceSize{ 64 } << 20;
+static const uint32_t     kSlots = 2;
+
+struct TileSlot
+{
+    GpuImage       target;
+    VkFramebuffer  fb = VK_NULL_HANDLE;
+    VkBuffer       buf = VK_NULL_HANDLE;
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    void*          mapped = nullptr;
+    VkCommandBuffer cb = VK_NULL_HANDLE;
+    VkFence        fence = VK_NULL_HANDLE;
+
+    bool           busy = false;
+    uint32_t       x = 0, y = 0, w = 0, h = 0;   // output rectangle
+    bool           lastInBand = false;
+};
+
+struct TiledJob
+{
+    Device*       d = nullptr;
+    VkRenderPass  rp = VK_NULL_HANDLE;
+    TileSlot      slots[kSlots];
+    RenderGraph   graph;
+    TileSlot*     cur = nullptr;        // slot being recorded
+
+    uint32_t      width = 0, height = 0, bandRows = 0;
+    uint32_t      format = FW_CAPTURE_BGRA8;
+    std::vector<uint8_t> strip;         // one band, width * bandRows * 4
+    uint32_t      bandY = 0;
+    fw_rows_fn    sink = nullptr;
+    void*         user = nullptr;
+};
+
+// ===== setup / teardown =====
+// Same attachment format and sample count as the scene pass, so the registered scene
+// pipelines are compatible; the tile ends ready for the copy.
+static bool create_tile_pass(TiledJob* j)
+{
+    Device* d = j->d;
+    VkAttachmentDescription color{};
+    color.format = d->swapFmt;
+    color.samples = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference cref{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription sub{}; sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 1; sub.pColorAttachments = &cref;
+
+    VkRenderPassCreateInfo rpci{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    rpci.attachmentCount = 1; rpci.pAttachments = &color;
+    rpci.subpassCount = 1;    rpci.pSubpasses = &sub;
+    return vkCreateRenderPass(d->device, &rpci, nullptr, &j->rp) == VK_SUCCESS;
+}
+
+static bool create_slot(TiledJob* j, TileSlot& s, uint32_t w, uint32_t h)
+{
+    Device* d = j->d;
+    if (!create_image(d, w, h, d->swapFmt,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, &s.target))
+        return false;
+
+    VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+    fbci.renderPass = j->rp;
+    fbci.attachmentCount = 1; fbci.pAttachments = &s.target.view;
+    fbci.width = w; fbci.height = h; fbci.layers = 1;
+    if (vkCreateFramebuffer(d->device, &fbci, nullptr, &s.fb) != VK_SUCCESS) return false;
+
+    const VkDeviceSize bytes = (VkDeviceSize)w * h * 4;
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &s.buf, &s.mem) &&
+        !create_buffer(d, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host, &s.buf, &s.mem))
+        return false;
+    if (vkMapMemory(d->device, s.mem, 0, VK_WHOLE_SIZE, 0, &s.mapped) != VK_SUCCESS) return false;
+
+    VkFenceCreateInfo fci{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    return vkCreateFence(d->device, &fci, nullptr, &s.fence) == VK_SUCCESS;
+}
+
+static void destroy_job(TiledJob* j)
+{
+    Device* d = j->d;
+    for (TileSlot& s : j->slots) {
+        if (s.busy)   vkWaitForFences(d->device, 1, &s.fence, VK_TRUE, UINT64_MAX);
+        if (s.cb)     vkFreeCommandBuffers(d->device, d->cmdPool, 1, &s.cb);
+        if (s.fence)  vkDestroyFence(d->device, s.fence, nullptr);
+        if (s.mapped) vkUnmapMemory(d->device, s.mem);
+        if (s.buf)    vkDestroyBuffer(d->device, s.buf, nullptr);
+        if (s.mem)    vkFreeMemory(d->device, s.mem, nullptr);
+        if (s.fb)     vkDestroyFramebuffer(d->device, s.fb, nullptr);
+        destroy_image(d, s.target);
+    }
+    if (j->rp) vkDestroyRenderPass(d->device, j->rp, nullptr);
+}
+
+// ===== per tile =====
+// Clip-space crop C * VP mapping the tile's NDC sub-rectangle of the full output onto
+// [-1, 1]: x' = sx * (x - cx * w), same for y; z and w untouched.
+static void crop_view_proj(const float* vp, double W, double H, const TileSlot& s, float* out)
+{
+    const double sx = W / s.w, sy = H / s.h;
+    const double cx = (2.0 * s.x + s.w) / W - 1.0;
+    const double cy = (2.0 * s.y + s.h) / H - 1.0;
+    for (int c = 0; c < 4; ++c) {
+        out[c * 4 + 0] = (float)(sx * ((double)vp[c * 4 + 0] - cx * vp[c * 4 + 3]));
+        out[c * 4 + 1] = (float)(sy * ((double)vp[c * 4 + 1] - cy * vp[c * 4 + 3]));
+        out[c * 4 + 2] = vp[c * 4 + 2];
+        out[c * 4 + 3] = vp[c * 4 + 3];
+    }
+}
+
+static void record_tile_scene(Device* d, VkCommandBuffer cb, void* user)
+{
+    auto* j = static_cast<TiledJob*>(user);
+    const TileSlot& s = *j->cur;
+
+    VkClearValue clear{}; clear.color = { { kClearColor[0], kClearColor[1], kClearColor[2], kClearColor[3] } };
+    VkRenderPassBeginInfo rbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    rbi.renderPass = j->rp; rbi.framebuffer = s.fb;
+    rbi.renderArea = { {0,0}, { s.w, s.h } };
+    rbi.clearValueCount = 1; rbi.pClearValues = &clear;
+    vkCmdBeginRenderPass(cb, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport vp{ 0.f, 0.f, (float)s.w, (float)s.h, 0.f, 1.f };
+    VkRect2D   sc{ {0,0}, { s.w, s.h } };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    // The NDC overlay belongs to the window, not to the poster.
+    record_scene_draws(d, cb, false);
+    vkCmdEndRenderPass(cb);
+}
+
+static void record_tile_copy(Device*, VkCommandBuffer cb, void* user)
+{
+    auto* j = static_cast<TiledJob*>(user);
+    const TileSlot& s = *j->cur;
+
+    VkBufferImageCopy r{};
+    r.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    r.imageExtent = { s.w, s.h, 1 };
+    vkCmdCopyImageToBuffer(cb, s.target.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, s.buf, 1, &r);
+
+    VkBufferMemoryBarrier bb{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+    bb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bb.srcQueueFamilyIndex = bb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bb.buffer = s.buf; bb.offset = 0; bb.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bb, 0, nullptr);
+}
+
+static bool submit_tile(TiledJob* j, TileSlot& s)
+{
+    Device* d = j->d;
+    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    ai.commandPool = d->cmdPool; ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; ai.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(d->device, &ai, &s.cb) != VK_SUCCESS) { s.cb = VK_NULL_HANDLE; return false; }
+    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(s.cb, &bi);
+
+    // Scene -> copy: the render pass leaves the tile in TRANSFER_SRC, the graph adds the
+    // colour-write -> transfer-read dependency.
+    RenderGraph* g = &j->graph;
+    rg_reset(g);
+    const RgRes target = rg_import_image(g, s.target.img, s.target.view, s.target.fmt, { s.w, s.h },
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, false);
+    const RgRes out = rg_import_buffer(g, s.buf, (VkDeviceSize)s.w * s.h * 4, true);
+    rg_add_pass(g, "tile", &record_tile_scene, j);
+    rg_use(g, target, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    rg_add_pass(g, "tile copy", &record_tile_copy, j);
+    rg_use(g, target, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    rg_use(g, out, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    j->cur = &s;
+    const bool ok = rg_execute(d, g, s.cb);
+    vkEndCommandBuffer(s.cb);
+    if (!ok) return false;
+
+    vkResetFences(d->device, 1, &s.fence);
+    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    si.commandBufferCount = 1; si.pCommandBuffers = &s.cb;
+    if (vkQueueSubmit(d->gfxQ, 1, &si, s.fence) != VK_SUCCESS) return false;
+    s.busy = true;
+    return true;
+}
+
+// Waits for the slot's tile, copies it into the band strip and, if it completes the band,
+// hands the band to the sink. Returns false if the sink asked to stop.
+static bool drain_tile(TiledJob* j, TileSlot& s)
+{
+    Device* d = j->d;
+    vkWaitForFences(d->device, 1, &s.fence, VK_TRUE, UINT64_MAX);
+    vkFreeCommandBuffers(d->device, d->cmdPool, 1, &s.cb);
+    s.cb = VK_NULL_HANDLE;
+    s.busy = false;
+
+    const uint8_t* src = static_cast<const uint8_t*>(s.mapped);
+    const size_t rowBytes = (size_t)j->width * 4, tileRow = (size_t)s.w * 4;
+    for (uint32_t r = 0; r < s.h; ++r)
+        std::memcpy(&j->strip[r * rowBytes + (size_t)s.x * 4], src + r * tileRow, tileRow);
+    if (!s.lastInBand) return true;
+
+    fw_row_block rb{};
+    rb.data = j->strip.data();
+    rb.first_row = s.y;
+    rb.row_count = s.h;
+    rb.width = j->width;
+    rb.row_pitch = (uint32_t)rowBytes;
+    rb.format = j->format;
+    return j->sink(&rb, j->user) == 0;
+}
+
+// ===== ABI =====
+int FM_CALL render_tiled(fw_handle dev, const fw_tiled_desc* desc)
+{
+    auto* d = H2D(dev);
+    if (!d || !desc || !desc->sink || !desc->width || !desc->height) {
+        native_set_error("render_tiled: null device/sink or empty output"); return FM_E_BADARGS;
+    }
+    if (d->inFrame) {
+        // The frame fence only signals once end_frame submits; waiting on it here would hang.
+        native_set_error("render_tiled: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (!d->swapRp) { native_set_error("render_tiled: no scene pass"); return FM_E_UNSUPPORTED; }
+    if (d->rp != d->swapRp) {
+        // Bloom's blur would seam at tile edges, and tiles have no pick IDs: posters are
+        // rendered on the direct path.
+        native_set_error("render_tiled: disable bloom and picking before rendering tiles"); return FM_E_UNSUPPORTED;
+    }
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(d->phys, &props);
+    uint32_t tile = desc->tile_size ? desc->tile_size : kDefaultTile;
+    tile = std::max(1u, std::min(tile, props.limits.maxImageDimension2D));
+
+    // Band height from the budget: every band row costs a strip row plus a target row and a
+    // readback row in each slot. Never less than one row.
+    const uint32_t tileW = std::min(tile, desc->width);
+    const VkDeviceSize budget = desc->memory_budget ? desc->memory_budget : kDefaultBudget;
+    const VkDeviceSize rowBytes = (VkDeviceSize)desc->width * 4;
+    const VkDeviceSize bandRowBytes = rowBytes + (VkDeviceSize)kSlots * 2 * tileW * 4;
+    const uint32_t bandRows = (uint32_t)std::max<VkDeviceSize>(1,
+        std::min<VkDeviceSize>({ (VkDeviceSize)tile, (VkDeviceSize)desc->height, budget / bandRowBytes }));
+
+    TiledJob j;
+    j.d = d;
+    j.width = desc->width; j.height = desc->height; j.bandRows = bandRows;
+    j.format = (d->swapFmt == VK_FORMAT_R8G8B8A8_UNORM || d->swapFmt == VK_FORMAT_R8G8B8A8_SRGB)
+        ? FW_CAPTURE_RGBA8 : FW_CAPTURE_BGRA8;
+    j.sink = desc->sink; j.user = desc->user;
+    try { j.strip.resize((size_t)rowBytes * bandRows); }
+    catch (...) { native_set_error("render_tiled: band strip allocation failed"); return FM_E_NOMEM; }
+
+    // Tiles go between frames: let the frame in flight finish first.
+    vkWaitForFences(d->device, 1, &d->fence, VK_TRUE, UINT64_MAX);
+    bool ok = create_tile_pass(&j);
+    for (TileSlot& s : j.slots) ok = ok && create_slot(&j, s, tileW, bandRows);
+    if (!ok) {
+        destroy_job(&j);
+        native_set_error("render_tiled: tile target/readback allocation failed");
+        return FM_E_DEVICE;
+    }
+
+    // Per-tile camera and extent; GPU sims drawn once per frame are drawn in every tile.
+    float viewProj[16];
+    std::memcpy(viewProj, d->viewProj, sizeof(viewProj));
+    const VkExtent2D extent = d->extent;
+    std::vector<uint8_t> simDraw(d->gpuSims.size());
+    for (size_t i = 0; i < simDraw.size(); ++i) simDraw[i] = d->gpuSims[i]->drawThisFrame;
+
+    int rc = FM_OK;
+    uint32_t k = 0;
+    for (uint32_t y = 0; y < j.height && rc == FM_OK; y += bandRows) {
+        const uint32_t h = std::min(bandRows, j.height - y);
+        for (uint32_t x = 0; x < j.width; x += tileW, ++k) {
+            TileSlot& s = j.slots[k % kSlots];
+            if (s.busy && !drain_tile(&j, s)) {
+                native_set_error("render_tiled: aborted by sink"); rc = FM_E_UNSPECIFIED; break;
+            }
+            s.x = x; s.y = y; s.w = std::min(tileW, j.width - x); s.h = h;
+            s.lastInBand = x + s.w >= j.width;
+
+            crop_view_proj(viewProj, j.width, j.height, s, d->viewProj);
+            d->extent = { s.w, s.h };
+            for (size_t i = 0; i < simDraw.size(); ++i) d->gpuSims[i]->drawThisFrame = simDraw[i] != 0;
+            if (!submit_tile(&j, s)) {
+                native_set_error("render_tiled: tile submission failed"); rc = FM_E_DEVICE; break;
+            }
+        }
+    }
+    // Remaining tiles in submission order, so bands still reach the sink top to bottom.
+    for (uint32_t n = 0; n < kSlots && rc == FM_OK; ++n) {
+        TileSlot& s = j.slots[(k + n) % kSlots];
+        if (s.busy && !drain_tile(&j, s)) { native_set_error("render_tiled: aborted by sink"); rc = FM_E_UNSPECIFIED; }
+    }
+
+    std::memcpy(d->viewProj, viewProj, sizeof(viewProj));
+    d->extent = extent;
+    for (size_t i = 0; i < simDraw.size(); ++i) d->gpuSims[i]->drawThisFrame = simDraw[i] != 0;
+    destroy_job(&j);
+    return rc;
+}
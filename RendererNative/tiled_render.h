@@ -0,0 +1,23 @@
+#pragma once
+#include "renderer_device.h"
+
+/*
+    Tiled offscreen rendering for outputs larger than any swapchain or image limit.
+    - The output is cut into bands of rows; each band into tiles no wider than the tile
+      size. A tile renders the normal scene with the camera's view-projection narrowed to
+      its sub-rectangle (an off-centre crop in clip space), so pixel-sized widths, points
+      and line patterns come out exactly as in one huge frame.
+    - Two tile slots (target + host readback buffer + fence) alternate: while the GPU
+      renders tile k the host copies tile k-1 out of its buffer into the band strip.
+    - A band is handed to the sink as soon as its last tile has been copied, which is
+      while the GPU already works on the next band.
+    - Memory is two tiles (target + readback each) plus one band strip; the band height is
+      chosen so all of it fits memory_budget regardless of the output size (at least one
+      row, however small the budget).
+    - Runs between frames: after the scene's uploads, before begin_frame. Inside a frame
+      (begin_frame .. end_frame) it returns FM_E_NOTREADY instead of waiting on a fence
+      that has nothing submitted behind it.
+*/
+
+// ABI entry point (see fw_renderer_api)
+int  FM_CALL render_tiled(fw_handle dev, const fw_tiled_desc* desc);
@@ -0,0 +1,258 @@
+// window_target.cpp
+// Extra windows sharing one Device (see window_target.h)
+
+#include "window_target.h"
+#include "native_common.h"
+#include "nbody_gpu.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ===== swapchain =====
+static void destroy_swapchain(Device* d, WindowTarget* w)
+{
+    for (auto fb : w->fbs) if (fb) vkDestroyFramebuffer(d->device, fb, nullptr);
+    w->fbs.clear();
+    for (auto v : w->views) if (v) vkDestroyImageView(d->device, v, nullptr);
+    w->views.clear();
+    w->images.clear();
+    if (w->swap) { vkDestroySwapchainKHR(d->device, w->swap, nullptr); w->swap = VK_NULL_HANDLE; }
+}
+
+// The format must be the main swapchain's: framebuffers are made for d->swapRp and the
+// scene pipelines are built against it.
+static bool create_swapchain(Device* d, WindowTarget* w)
+{
+    VkSurfaceCapabilitiesKHR caps{};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(d->phys, w->surface, &caps);
+
+    uint32_t fmtCount = 0, pmCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(d->phys, w->surface, &fmtCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(fmtCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(d->phys, w->surface, &fmtCount, formats.data());
+    const auto sf = std::find_if(formats.begin(), formats.end(), [d](const VkSurfaceFormatKHR& f) {
+        return f.format == d->swapFmt && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR; });
+    if (sf == formats.end()) { native_set_error("window: surface lacks the main swapchain format"); return false; }
+
+    vkGetPhysicalDeviceSurfacePresentModesKHR(d->phys, w->surface, &pmCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(pmCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(d->phys, w->surface, &pmCount, modes.data());
+
+    const VkExtent2D ex = choose_extent(caps, w->hwnd);
+    if (ex.width == 0 || ex.height == 0) { native_set_error("window: empty client area"); return false; }
+
+    uint32_t imgCount = caps.minImageCount + 1;
+    if (caps.maxImageCount && imgCount > caps.maxImageCount) imgCount = caps.maxImageCount;
+
+    VkSwapchainCreateInfoKHR sci{ VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR };
+    sci.surface = w->surface;
+    sci.minImageCount = imgCount;
+    sci.imageFormat = sf->format;
+    sci.imageColorSpace = sf->colorSpace;
+    sci.imageExtent = ex;
+    sci.imageArrayLayers = 1;
+    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    sci.preTransform = caps.currentTransform;
+    sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    sci.presentMode = choose_present_mode(modes);
+    sci.clipped = VK_TRUE;
+    if (vkCreateSwapchainKHR(d->device, &sci, nullptr, &w->swap) != VK_SUCCESS) {
+        w->swap = VK_NULL_HANDLE;
+        native_set_error("window: vkCreateSwapchainKHR failed");
+        return false;
+    }
+    w->extent = ex;
+
+    uint32_t ic = 0; vkGetSwapchainImagesKHR(d->device, w->swap, &ic, nullptr);
+    w->images.resize(ic);
+    vkGetSwapchainImagesKHR(d->device, w->swap, &ic, w->images.data());
+
+    w->views.assign(ic, VK_NULL_HANDLE);
+    w->fbs.assign(ic, VK_NULL_HANDLE);
+    for (uint32_t i = 0; i < ic; ++i) {
+        VkImageViewCreateInfo iv{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        iv.image = w->images[i];
+        iv.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        iv.format = sf->format;
+        iv.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        iv.subresourceRange.levelCount = 1;
+        iv.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(d->device, &iv, nullptr, &w->views[i]) != VK_SUCCESS) {
+            native_set_error("window: vkCreateImageView failed"); return false;
+        }
+
+        VkFramebufferCreateInfo fbci{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+        fbci.renderPass = d->swapRp;
+        fbci.attachmentCount = 1; fbci.pAttachments = &w->views[i];
+        fbci.width = ex.width; fbci.height = ex.height; fbci.layers = 1;
+        if (vkCreateFramebuffer(d->device, &fbci, nullptr, &w->fbs[i]) != VK_SUCCESS) {
+            native_set_error("window: vkCreateFramebuffer failed"); return false;
+        }
+    }
+    return true;
+}
+
+static bool recreate_swapchain(Device* d, WindowTarget* w)
+{
+    vkDeviceWaitIdle(d->device);
+    destroy_swapchain(d, w);
+    if (!create_swapchain(d, w)) return false;
+    w->needsRecreate = false;
+    return true;
+}
+
+static void destroy_window(Device* d, WindowTarget* w)
+{
+    destroy_swapchain(d, w);
+    if (w->semAcquire) vkDestroySemaphore(d->device, w->semAcquire, nullptr);
+    if (w->surface)    vkDestroySurfaceKHR(d->instance, w->surface, nullptr);
+    delete w;
+}
+
+// ===== frame hooks =====
+void windows_acquire(Device* d)
+{
+    for (WindowTarget* w : d->windows) {
+        w->acquired = false;
+        const VkExtent2D ce = client_extent(w->hwnd);
+        if (ce.width == 0 || ce.height == 0) continue;
+        if (ce.width != w->extent.width || ce.height != w->extent.height) w->needsRecreate = true;
+        if (w->needsRecreate && !recreate_swapchain(d, w)) continue;
+
+        // SUBOPTIMAL still hands out an image (and signals the semaphore): use it this frame.
+        const VkResult r = vkAcquireNextImageKHR(d->device, w->swap, UINT64_MAX, w->semAcquire, VK_NULL_HANDLE, &w->curImg);
+        if (r == VK_SUBOPTIMAL_KHR) w->needsRecreate = true;
+        else if (r == VK_ERROR_OUT_OF_DATE_KHR) { w->needsRecreate = true; continue; }
+        else if (r != VK_SUCCESS) continue;
+        w->acquired = true;
+    }
+}
+
+static void record_window(Device* d, VkCommandBuffer cb, void* user)
+{
+    auto* w = static_cast<WindowTarget*>(user);
+
+    // Passes read the camera and extent while recording: swap the window's in.
+    float viewProj[16];
+    std::memcpy(viewProj, d->viewProj, sizeof(viewProj));
+    const VkExtent2D extent = d->extent;
+    if (w->ownCamera) std::memcpy(d->viewProj, w->viewProj, sizeof(viewProj));
+    d->extent = w->extent;
+    for (size_t i = 0; i < w->simDraw.size() && i < d->gpuSims.size(); ++i)
+        d->gpuSims[i]->drawThisFrame = w->simDraw[i] != 0;
+
+    VkClearValue clear{}; clear.color = { { kClearColor[0], kClearColor[1], kClearColor[2], kClearColor[3] } };
+    VkRenderPassBeginInfo rbi{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    rbi.renderPass = d->swapRp; rbi.framebuffer = w->fbs[w->curImg];
+    rbi.renderArea = { {0,0}, w->extent };
+    rbi.clearValueCount = 1; rbi.pClearValues = &clear;
+    vkCmdBeginRenderPass(cb, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport vp{ 0.f, 0.f, (float)w->extent.width, (float)w->extent.height, 0.f, 1.f };
+    VkRect2D   sc{ {0,0}, w->extent };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    // The NDC overlay is laid out for the main window.
+    record_scene_draws(d, cb, false);
+    vkCmdEndRenderPass(cb);
+
+    std::memcpy(d->viewProj, viewProj, sizeof(viewProj));
+    d->extent = extent;
+}
+
+void windows_add_passes(Device* d, RenderGraph* g)
+{
+    for (WindowTarget* w : d->windows) {
+        if (!w->acquired) continue;
+        // The main scene pass consumes the per-frame sim draws; remember them for this window.
+        w->simDraw.resize(d->gpuSims.size());
+        for (size_t i = 0; i < d->gpuSims.size(); ++i) w->simDraw[i] = d->gpuSims[i]->drawThisFrame;
+
+        const RgRes img = rg_import_image(g, w->images[w->curImg], w->views[w->curImg], d->swapFmt, w->extent,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, true);
+        rg_add_pass(g, "window", &record_window, w);
+        rg_use(g, img, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    }
+}
+
+void windows_release(Device* d)
+{
+    if (d->windows.empty()) return;
+    vkDeviceWaitIdle(d->device);
+    for (WindowTarget* w : d->windows) destroy_window(d, w);
+    d->windows.clear();
+}
+
+// ===== ABI =====
+int FM_CALL window_create(fw_handle dev, const fw_window_desc* desc, fw_handle* out)
+{
+    if (!out) { native_set_error("window_create: null out"); return FM_E_BADARGS; }
+    *out = 0;
+    auto* d = H2D(dev);
+    if (!d || !desc || !desc->hwnd) { native_set_error("window_create: null device or HWND"); return FM_E_BADARGS; }
+    if (d->inFrame) {   // end_frame presents exactly the windows begin_frame acquired
+        native_set_error("window_create: called inside a frame, call it before begin_frame"); return FM_E_NOTREADY;
+    }
+    if (d->rp != d->swapRp) {
+        native_set_error("window_create: not available while bloom or picking is on"); return FM_E_UNSUPPORTED;
+    }
+
+    auto* w = new WindowTarget();
+    w->dev = d;
+    w->hwnd = (HWND)desc->hwnd;
+
+    VkWin32SurfaceCreateInfoKHR sci{ VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR };
+    sci.hinstance = (HINSTANCE)GetModuleHandleW(nullptr);
+    sci.hwnd = w->hwnd;
+    if (vkCreateWin32SurfaceKHR(d->instance, &sci, nullptr, &w->surface) != VK_SUCCESS) {
+        w->surface = VK_NULL_HANDLE;
+        destroy_window(d, w);
+        native_set_error("window_create: vkCreateWin32SurfaceKHR failed");
+        return FM_E_DEVICE;
+    }
+    if (!supports_present(d->phys, d->gfxFam, w->surface)) {
+        destroy_window(d, w);
+        native_set_error("window_create: the device queue cannot present to this window");
+        return FM_E_UNSUPPORTED;
+    }
+
+    VkSemaphoreCreateInfo sem{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    if (vkCreateSemaphore(d->device, &sem, nullptr, &w->semAcquire) != VK_SUCCESS) {
+        w->semAcquire = VK_NULL_HANDLE;
+        destroy_window(d, w);
+        native_set_error("window_create: vkCreateSemaphore failed");
+        return FM_E_DEVICE;
+    }
+    if (!create_swapchain(d, w)) {
+        destroy_window(d, w);   // error set by create_swapchain
+        return FM_E_DEVICE;
+    }
+
+    d->windows.push_back(w);
+    *out = to_handle(w);
+    return FM_OK;
+}
+
+void FM_CALL window_destroy(fw_handle win)
+{
+    auto* w = handle_to<WindowTarget>(win); if (!w) return;
+    Device* d = w->dev;
+    if (d->inFrame) {   // the open frame renders into and presents this window; it stays alive
+        native_set_error("window_destroy: called inside a frame, call it before begin_frame"); return;
+    }
+    vkDeviceWaitIdle(d->device);
+    d->windows.erase(std::remove(d->windows.begin(), d->windows.end(), w), d->windows.end());
+    destroy_window(d, w);
+}
+
+int FM_CALL window_set_camera(fw_handle win, const float* view_proj)
+{
+    auto* w = handle_to<WindowTarget>(win);
+    if (!w) { native_set_error("window_set_camera: null handle"); return FM_E_BADARGS; }
+    w->ownCamera = view_proj != nullptr;
+    if (view_proj) std::memcpy(w->viewProj, view_proj, sizeof(w->viewProj));
+    return FM_OK;
+}
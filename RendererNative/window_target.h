@@ -0,0 +1,50 @@
+#pragma once
+#include "renderer_device.h"
+#include "render_graph.h"
+
+/*
+    Extra windows rendered by one Device.
+    - A window is a surface + swapchain on the device's instance and queue; pipelines,
+      geometry buffers, passes and the frame's command buffer are the device's.
+    - Each frame every window gets its own scene pass (its camera and extent, the shared
+      origin) in the device's frame graph, after the main window.
+    - end_frame submits once, waiting on every acquired image, and presents the main
+      swapchain and all windows with a single vkQueuePresentKHR.
+    - The main window drives the frame: while it is minimised nothing is drawn.
+    - Windows share the swapchain render pass, so they need the main window's surface
+      format and are not available while the bloom post chain is on.
+*/
+
+struct WindowTarget
+{
+    Device*          dev = nullptr;
+    HWND             hwnd = nullptr;
+
+    VkSurfaceKHR     surface = VK_NULL_HANDLE;
+    VkSwapchainKHR   swap = VK_NULL_HANDLE;
+    VkExtent2D       extent{ 0,0 };
+    std::vector<VkImage>       images;
+    std::vector<VkImageView>   views;
+    std::vector<VkFramebuffer> fbs;          // for d->swapRp
+    VkSemaphore      semAcquire = VK_NULL_HANDLE;
+
+    uint32_t         curImg = 0;
+    bool             acquired = false;       // image held for this frame's submit/present
+    bool             needsRecreate = false;
+
+    // Own view*proj relative to the device origin; otherwise the device camera.
+    float            viewProj[16]{ 1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1 };
+    bool             ownCamera = false;
+    std::vector<uint8_t> simDraw;            // GPU sims pending a draw when the frame began
+};
+
+// Frame hooks (renderer_api.cpp). acquire runs after the frame fence wait once the main
+// image is acquired; add_passes appends one scene pass per acquired window.
+void windows_acquire(Device* d);
+void windows_add_passes(Device* d, RenderGraph* g);
+void windows_release(Device* d);
+
+// ABI entry points (see fw_renderer_api)
+int  FM_CALL window_create(fw_handle dev, const fw_window_desc* desc, fw_handle* out_win);
+void FM_CALL window_destroy(fw_handle win);
+int  FM_CALL window_set_camera(fw_handle win, const float* view_proj);